@@ -139,18 +139,19 @@ static void T_(insert)(struct t_(bmp) *const a,
 	if(!n) return;
 	move.hi = n / BMP_CHUNK, move.lo = n % BMP_CHUNK;
 	first.hi = x / BMP_CHUNK, first.lo = x % BMP_CHUNK;
-	i = BMP_CHUNKS - move.hi - (move.lo ? 1 : 0); store = a->chunk[first.hi];
+	store = a->chunk[first.hi];
 	/* Zero the bits that are not involved on the last iteration. */
 	a->chunk[first.hi] &= BMP_MAX >> first.lo;
 	/* Copy a superset aligned with `<PM>chunk` bits, backwards. */
-	for( ; ; ) {
+	if(first.hi + move.hi < BMP_CHUNKS) for(i = BMP_CHUNKS - 1 - move.hi; ; ) {
 		temp = a->chunk[i] >> move.lo;
 		if(i == first.hi) { a->chunk[i + move.hi] = temp; break; }
 		if(move.lo) temp |= a->chunk[i - 1] << BMP_CHUNK - move.lo;
 		a->chunk[i-- + move.hi] = temp;
 	}
 	/* Zero intervening, restore the bits that are not involved, and clip. */
-	for(i = 0; i < move.hi; i++) a->chunk[first.hi + i] = 0;
+	for(i = 0; i < move.hi && first.hi + i < BMP_CHUNKS; i++)
+		a->chunk[first.hi + i] = 0;
 	a->chunk[first.hi] |= ~(BMP_MAX >> first.lo) & store;
 	a->chunk[BMP_CHUNKS - 1]
 		&= ~((1u << sizeof a->chunk * CHAR_BIT - BMP_BITS) - 1);
@@ -169,7 +170,7 @@ static void T_(remove)(struct t_(bmp) *const a,
 	first.hi = x / BMP_CHUNK, first.lo = x % BMP_CHUNK;
 	i = first.hi + move.hi; store = a->chunk[first.hi];
 	/* Copy a superset aligned with `<PM>chunk` bits. */
-	for( ; ; ) {
+	if(i < BMP_CHUNKS) for( ; ; ) {
 		temp = a->chunk[i] << move.lo;
 		if(i >= BMP_CHUNKS - 1) { a->chunk[i - move.hi] = temp; break; }
 		if(move.lo) temp |= a->chunk[i + 1] >> BMP_CHUNK - move.lo;
@@ -412,6 +412,10 @@ no_free0:
 			assert(f0p && *f0p < slot->size);
 			bmp[*f0p] = 1;
 		}
+#			ifdef POOL_FREE_LIST
+		for(j = pool->free_head; j; j = pT_(free_next)(pool, j - 1))
+			assert(j - 1 < slot->size), bmp[j - 1] = 1;
+#			endif
 		for(j = 0; j < slot->size; j++) {
 			const char *const bgc = j & 1 ? " bgcolor=\"Grey95\"" : "";
 			fprintf(fp, "\t<tr><td port=\"%lu\" align=\"left\"%s>",
@@ -797,7 +801,7 @@ static const char *pT_(leaf_to_dir)(const struct pT_(bough) *const bough,
 	const char *shape = "";
 	t.br0 = 0, t.br1 = bough->leaves - 1, t.lf = 0;
 	while(t.br0 < t.br1) {
-		left = bough->branch[t.br0].left;
+		left = pT_(branch)(bough)[t.br0].left;
 		if(lf <= t.lf + left) t.br1 = ++t.br0 + left, shape = "r";
 		else t.br0 += left + 1, t.lf += left + 1, shape = "l";
 	}
@@ -811,7 +815,7 @@ static unsigned pT_(right)(const struct pT_(bough) *const bough,
 	unsigned left, right, total = bough->leaves - 1, b0 = 0;
 	assert(bough && branch < bough->leaves - 1);
 	for( ; ; ) {
-		right = total - (left = bough->branch[b0].left) - 1;
+		right = total - (left = pT_(branch)(bough)[b0].left) - 1;
 		assert(left < total && right < total);
 		if(b0 >= branch) break;
 		if(branch <= b0 + left) total = left, b0++;
@@ -827,7 +831,7 @@ static unsigned pT_(left_leaf)(const struct pT_(bough) *const bough,
 	unsigned left, right, total = bough->leaves - 1, i = 0, b0 = 0;
 	assert(bough && branch < bough->leaves - 1);
 	for( ; ; ) {
-		right = total - (left = bough->branch[b0].left) - 1;
+		right = total - (left = pT_(branch)(bough)[b0].left) - 1;
 		assert(left < bough->leaves - 1 && right < bough->leaves - 1);
 		if(b0 >= branch) break;
 		if(branch <= b0 + left) total = left, b0++;
@@ -862,8 +866,9 @@ static void pT_(graph_tree_bits)(const struct pT_(bough) *const bough,
 	for(i = 0; i < bough->leaves; i++) {
 		const char *const key = pT_(sample)(bough, i), *keylabel = key;
 		unsigned is_keylabel = 1;
-		const struct trie_branch *branch = bough->branch;
-		size_t next_branch = treebit + branch->skip;
+		const struct trie_branch *branch = pT_(branch)(bough);
+		/* The branches are only as many as there are. */
+		size_t next_branch = bough->leaves > 1 ? treebit + branch->skip : 0;
 		const char *params, *start, *end;
 		struct { unsigned br0, br1; } in_tree;
 		const unsigned is_link = !!trie_bmp_test(&bough->bmp, i);
@@ -901,7 +906,8 @@ static void pT_(graph_tree_bits)(const struct pT_(bough) *const bough,
 						= " bgcolor=\"Black\" color=\"White\" border=\"1\"";
 					start = "<font color=\"White\">", end = "</font>";
 				}
-				next_branch = (branch = bough->branch + in_tree.br0)->skip;
+				if(in_tree.br0 < in_tree.br1) next_branch
+					= (branch = pT_(branch)(bough) + in_tree.br0)->skip;
 			}
 			if(b && !(b & 7)) fprintf(fp, "\t\t<td>&nbsp;</td>\n");
 			fprintf(fp, "\t\t<td%s>%s%u%s</td>\n", params, start, bit, end);
@@ -913,7 +919,7 @@ static void pT_(graph_tree_bits)(const struct pT_(bough) *const bough,
 	for(i = 0; i < bough->leaves; i++) if(trie_bmp_test(&bough->bmp, i))
 		fprintf(fp, "\ttree%pbranch0:%u -> tree%pbranch0 "
 		"[style = dashed, arrowhead = %snormal];\n", (const void *)bough, i,
-		(const void *)bough->leaf[i].as_link, pT_(leaf_to_dir)(bough, i));
+		(const void *)pT_(leaf)(bough)[i].as_link, pT_(leaf_to_dir)(bough, i));
 	/* Recurse. */
 	for(i = 0; i < bough->leaves; i++) {
 		struct { unsigned br0, br1, lf; } in_tree;
@@ -921,7 +927,7 @@ static void pT_(graph_tree_bits)(const struct pT_(bough) *const bough,
 		if(!trie_bmp_test(&bough->bmp, i)) continue;
 		in_tree.br0 = 0, in_tree.br1 = bough->leaves - 1, in_tree.lf = 0;
 		while(in_tree.br0 < in_tree.br1) {
-			const struct trie_branch *branch = bough->branch + in_tree.br0;
+			const struct trie_branch *branch = pT_(branch)(bough) + in_tree.br0;
 			bit += branch->skip;
 			if(i <= in_tree.lf + branch->left)
 				in_tree.br1 = ++in_tree.br0 + branch->left;
@@ -929,7 +935,7 @@ static void pT_(graph_tree_bits)(const struct pT_(bough) *const bough,
 				in_tree.br0 += branch->left + 1, in_tree.lf += branch->left + 1;
 			bit++;
 		}
-		pT_(graph_tree_bits)(bough->leaf[i].as_link, bit, fp);
+		pT_(graph_tree_bits)(pT_(leaf)(bough)[i].as_link, bit, fp);
 	}
 }
 
@@ -967,7 +973,7 @@ static void pT_(graph_tree_mem)(const struct pT_(bough) *const bough,
 #		endif
 
 		if(i < bough->leaves - 1) {
-			branch = bough->branch + i;
+			branch = pT_(branch)(bough) + i;
 			fprintf(fp, "\t<tr>\n"
 				"\t\t<td align=\"right\"%s>%u</td>\n"
 				"\t\t<td align=\"right\"%s>%u</td>\n",
@@ -994,7 +1000,7 @@ static void pT_(graph_tree_mem)(const struct pT_(bough) *const bough,
 	for(i = 0; i < bough->leaves; i++) if(trie_bmp_test(&bough->bmp, i))
 		fprintf(fp, "\ttree%pbranch0:%u -> tree%pbranch0 "
 		"[style = dashed, arrowhead = %snormal];\n", (const void *)bough, i,
-		(const void *)bough->leaf[i].as_link, pT_(leaf_to_dir)(bough, i));
+		(const void *)pT_(leaf)(bough)[i].as_link, pT_(leaf_to_dir)(bough, i));
 	/* Recurse. */
 	for(i = 0; i < bough->leaves; i++) {
 		struct { unsigned br0, br1, lf; } in_tree;
@@ -1002,7 +1008,7 @@ static void pT_(graph_tree_mem)(const struct pT_(bough) *const bough,
 		if(!trie_bmp_test(&bough->bmp, i)) continue;
 		in_tree.br0 = 0, in_tree.br1 = bough->leaves - 1, in_tree.lf = 0;
 		while(in_tree.br0 < in_tree.br1) {
-			branch = bough->branch + in_tree.br0;
+			branch = pT_(branch)(bough) + in_tree.br0;
 			bit += branch->skip;
 			if(i <= in_tree.lf + branch->left)
 				in_tree.br1 = ++in_tree.br0 + branch->left;
@@ -1010,7 +1016,7 @@ static void pT_(graph_tree_mem)(const struct pT_(bough) *const bough,
 				in_tree.br0 += branch->left + 1, in_tree.lf += branch->left + 1;
 			bit++;
 		}
-		pT_(graph_tree_mem)(bough->leaf[i].as_link, bit, fp);
+		pT_(graph_tree_mem)(pT_(leaf)(bough)[i].as_link, bit, fp);
 	}
 }
 
@@ -1026,7 +1032,7 @@ static void pT_(graph_tree_logic)(const struct pT_(bough) *const bough,
 	if(bough->leaves > 1) {
 		fprintf(fp, "\t// branches\n");
 		for(b = 0; b < bough->leaves - 1; b++) { /* Branches. */
-			branch = bough->branch + b;
+			branch = pT_(branch)(bough) + b;
 			left = branch->left, right = pT_(right)(bough, b);
 			fprintf(fp, "\ttree%pbranch%u [label=\"%u\", shape=circle,"
 				" style=filled, fillcolor=Grey95];\n"
@@ -1039,7 +1045,7 @@ static void pT_(graph_tree_logic)(const struct pT_(bough) *const bough,
 				unsigned leaf = pT_(left_leaf)(bough, b);
 				if(trie_bmp_test(&bough->bmp, leaf)) {
 					const struct pT_(bough) *const child
-						= bough->leaf[leaf].as_link;
+						= pT_(leaf)(bough)[leaf].as_link;
 					const char *root_str
 						= child->leaves > 1 ? "branch" : "leaf";
 					fprintf(fp,
@@ -1058,7 +1064,8 @@ static void pT_(graph_tree_logic)(const struct pT_(bough) *const bough,
 			} else {
 				unsigned leaf = pT_(left_leaf)(bough, b) + left + 1;
 				if(trie_bmp_test(&bough->bmp, leaf)) {
-					const struct pT_(bough) *const child =bough->leaf[leaf].as_link;
+					const struct pT_(bough) *const child
+						= pT_(leaf)(bough)[leaf].as_link;
 					const char *root_str
 						= child->leaves > 1 ? "branch" : "leaf";
 					fprintf(fp,
@@ -1096,7 +1103,7 @@ static void pT_(graph_tree_logic)(const struct pT_(bough) *const bough,
 	}
 
 	for(lf = 0; lf < bough->leaves; lf++) if(trie_bmp_test(&bough->bmp, lf))
-		pT_(graph_tree_logic)(bough->leaf[lf].as_link, 0, fp);
+		pT_(graph_tree_logic)(pT_(leaf)(bough)[lf].as_link, 0, fp);
 }
 
 typedef void (*pT_(bough_file_fn))(const struct pT_(bough) *, size_t, FILE *);
@@ -23,6 +23,45 @@
  `<t>` that satisfies `C` naming conventions when mangled and a valid tag type,
  <typedef:<pT>type>, associated therewith; required.
 
+ @param[POOL_FREE_LIST]
+ Optional. Instead of the free-heap, which keeps slab-zero compact, removed
+ items in slab-zero are threaded into a list through the items themselves;
+ reuse and removal are \O(1) and don't allocate. Slab-zero is only reset when
+ all of it is removed. <typedef:<pT>type> must be at least the size of
+ `size_t`, or it will not compile.
+
+ @param[POOL_ALIGNED]
+ Optional power-of-two number of bytes, at least 64. Every slab is that size
+ and at an address that is a multiple of it, with a small header, so the slab
+ of an item is found by masking the pointer, instead of a binary search of the
+ slabs.
+ The slabs don't grow, and they are not in order. They are cut out of blocks of
+ about 64 slabs, each one `malloc` of one more slab to align them; a slab that
+ is freed is kept for the next, and the block is freed when all of its slabs
+ are. One can't reserve more than a slab at a time.
+
+ @param[POOL_BITMAP]
+ Optional. Every slab has a bitmap of which items are live, in chunks of
+ `unsigned`, most-significant bit first, like <../../src/bmp.h>. The cursor then
+ goes over all the live items in all the slabs, instead of only the ones in
+ slab-zero, skipping a chunk of removed items at a time.
+
+ @param[POOL_MMAP]
+ Optional. Slabs are mapped from the operating system in whole pages instead
+ of `malloc`. A secondary slab counts the live items on each of its pages, and
+ a page is given back with `madvise` as soon as nothing on it is live;
+ slab-zero gives back the pages past its end when it shrinks by enough. The
+ resident memory follows the live items, rather than the high-water. Requires
+ POSIX `mmap` and `madvise`, (_eg_, `_DEFAULT_SOURCE`,) and can't be used with
+ `POOL_ALIGNED`.
+
+ @param[POOL_MAGAZINE]
+ Optional, adds <tag:<T>depot>, a pool that is shared between POSIX threads,
+ and <tag:<T>magazine>, a cache of free slots that belongs to one thread. The
+ magazine only takes the lock of the depot to refill or drain half of it at a
+ time, instead of on every allocation; a slot may be removed by any magazine.
+ Requires `pthread`.
+
  @param[POOL_DECLARE_ONLY]
  For headers in different compilation units.
 
@@ -36,7 +75,8 @@
  results on all systems. */
 
 /* `POOL_TO_STRING` is undocumented because this container is only iterable in
- the first slab, so this is not very useful except for debugging. */
+ the first slab, (without `POOL_BITMAP`,) so this is not very useful except for
+ debugging. */
 
 #if !defined POOL_NAME || !defined POOL_TYPE
 #	error Name or tag type undefined.
@@ -56,9 +96,11 @@ static int poolfree_less(const size_t a, const size_t b) { return a < b; }
 #if !defined(__STDC__) || !defined(__STDC_VERSION__) \
 	|| __STDC_VERSION__ < 199901L /* < C99 */
 #	define POOL_CAST (const void *)
+#	define POOL_UINT size_t
 #else /* < C99 --><!-- >= C99 */
 #	include <stdint.h>
 #	define POOL_CAST (const uintptr_t)(const void *)
+#	define POOL_UINT uintptr_t
 #endif /* >= C99 --> */
 
 #ifdef POOL_NON_STATIC
@@ -71,8 +113,27 @@ static int poolfree_less(const size_t a, const size_t b) { return a < b; }
 #include "box.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <errno.h>
+#ifdef POOL_ALIGNED
+#	include <stddef.h>
+#endif
+#ifdef POOL_MAGAZINE
+#	include <pthread.h>
+#endif
+#ifdef POOL_BITMAP
+#	include <limits.h>
+#endif
+#ifdef POOL_MMAP
+#	include <sys/mman.h>
+#	include <unistd.h>
+#	ifdef MAP_ANONYMOUS
+#		define POOL_MAP_ANON MAP_ANONYMOUS
+#	else
+#		define POOL_MAP_ANON MAP_ANON
+#	endif
+#endif
 
 #define BOX_MINOR POOL_NAME
 #define BOX_MAJOR pool
@@ -84,12 +145,84 @@ static int poolfree_less(const size_t a, const size_t b) { return a < b; }
 #if POOL_SLAB_MIN_CAPACITY < 2
 #	error Pool slab capacity error.
 #endif
+#if defined POOL_ALIGNED && (POOL_ALIGNED < 64 \
+	|| POOL_ALIGNED & (POOL_ALIGNED - 1))
+#	error Pool alignment must be a power of two of at least 64.
+#endif
+#ifdef POOL_ALIGNED
+/* Undocumented: how many slabs are cut out of one allocation. */
+#	ifndef POOL_ALIGNED_BLOCK
+#		define POOL_ALIGNED_BLOCK 64
+#	endif
+#	if POOL_ALIGNED_BLOCK < 2
+#		error Pool aligned block must have at least two slabs.
+#	endif
+#endif
+#ifdef POOL_BITMAP
+/* <http://c-faq.com/misc/bitsets.html>, except reversed for msb-first. */
+#	define POOL_CHUNK (sizeof(unsigned) * CHAR_BIT)
+#	define POOL_CHUNKS(n) (((n) + POOL_CHUNK - 1) / POOL_CHUNK)
+#	define POOL_MASK(x) ((1u << (POOL_CHUNK - 1)) >> (x) % POOL_CHUNK)
+#	define POOL_AT(a, x) ((a)[(x) / POOL_CHUNK] & POOL_MASK(x))
+#	define POOL_SET(a, x) ((a)[(x) / POOL_CHUNK] |= POOL_MASK(x))
+#	define POOL_CLEAR(a, x) ((a)[(x) / POOL_CHUNK] &= ~POOL_MASK(x))
+#endif
+#ifdef POOL_MMAP
+#	ifdef POOL_ALIGNED
+#		error Pool mmap and aligned are mutually exclusive.
+#	endif
+/* Undocumented: how many pages past the end slab-zero keeps before giving them
+ back; so it doesn't thrash. */
+#	ifndef POOL_MMAP_RELEASE
+#		define POOL_MMAP_RELEASE 16
+#	endif
+#endif
+#ifdef POOL_MAGAZINE
+/* Undocumented: the number of free slots a thread keeps. */
+#	ifndef POOL_MAGAZINE_CAPACITY
+#		define POOL_MAGAZINE_CAPACITY 64
+#	endif
+#	if POOL_MAGAZINE_CAPACITY < 2
+#		error Pool magazine capacity error.
+#	endif
+#endif
 
 /** A valid tag type set by `POOL_TYPE`. */
 typedef POOL_TYPE pT_(type);
+#ifdef POOL_FREE_LIST
+/* Fails to compile if a removed item can't hold the link of the free-list. */
+typedef char pT_(free_list_fits)[sizeof(pT_(type)) >= sizeof(size_t) ? 1 : -1];
+#endif
 
 /* Goes into a slab-sorted array. */
-struct pT_(slot) { size_t size; pT_(type) *slab; };
+struct pT_(slot) {
+	size_t size;
+	pT_(type) *slab;
+#if defined POOL_BITMAP || defined POOL_MMAP
+	size_t capacity; /* Of the slab. */
+#endif
+#ifdef POOL_BITMAP
+	unsigned *bmp; /* Which items are live. */
+#endif
+#ifdef POOL_MMAP
+	unsigned *page; /* Live items on each page of a secondary slab, or null. */
+#endif
+};
+
+#ifdef POOL_ALIGNED
+/* An allocation, `memory`, that `slabs` are cut out of; `spares` are not in
+ use. It is apart so that the alignment before the first slab is not touched. */
+struct pT_(block) { void *memory; size_t slabs, spares; };
+/* At the start of every slab; the items follow. `slot` is where it is in the
+ array of slots, and `block` is the allocation it was cut from. While it is
+ spare, it is in a list through `prev` and `next`. */
+struct pT_(header) {
+	struct pT_(block) *block;
+	size_t slot;
+	struct pT_(header) *prev, *next;
+};
+struct pT_(aligned) { struct pT_(header) header; pT_(type) item[1]; };
+#endif
 
 /* Temporary. Avoid recursion. This must match <box.h>. */
 #undef BOX_MINOR
@@ -110,13 +243,40 @@ struct t_(pool) {
 	struct pT_(slot_array) slots;
 	struct poolfree_heap free0; /* Free-heap in slab-zero. */
 	size_t capacity0; /* Capacity of slab-zero. */
+#ifdef POOL_FREE_LIST
+	size_t free_head, free_size; /* Free-list in slab-zero; index plus one. */
+#endif
+#ifdef POOL_MMAP
+	size_t resident0; /* Bytes of slab-zero that may be resident. */
+#endif
+#ifdef POOL_ALIGNED
+	struct pT_(header) *spare; /* Slabs cut from blocks but not in use. */
+#endif
 };
 typedef struct t_(pool) pT_(box);
 
+#ifdef POOL_BITMAP
+/* Goes over the live items of every slot from `slot` to before `end`. */
+struct T_(cursor) { struct pT_(slot) *slot, *end; size_t i; };
+#else
 /* It is very useful in debugging, is required contract, but only iterates on
  `slot0` and ignores the free-heap. This is a memory-manager, we don't have
  enough information to do otherwise. */
 struct T_(cursor) { struct pT_(slot) *slot0; size_t i; };
+#endif
+
+#ifdef POOL_MAGAZINE
+/** Only with `POOL_MAGAZINE`. A pool that is shared between threads; set up
+ with <fn:<T>depot>. */
+struct T_(depot) { struct t_(pool) pool; pthread_mutex_t lock; };
+/** Only with `POOL_MAGAZINE`. Free slots of `depot` that are for one thread;
+ see <fn:<T>magazine>. */
+struct T_(magazine) {
+	struct T_(depot) *depot;
+	size_t size;
+	pT_(type) *round[POOL_MAGAZINE_CAPACITY];
+};
+#endif
 
 #ifdef BOX_NON_STATIC
 struct T_(cursor) T_(begin)(const struct t_(pool) *);
@@ -129,9 +289,170 @@ int T_(buffer)(struct t_(pool) *, size_t);
 pT_(type) *T_(new)(struct t_(pool) *);
 int T_(remove)(struct t_(pool) *, pT_(type) *);
 void T_(clear)(struct t_(pool) *);
+#	ifdef POOL_MAGAZINE
+int T_(depot)(struct T_(depot) *);
+void T_(depot_)(struct T_(depot) *);
+struct T_(magazine) T_(magazine)(struct T_(depot) *);
+void T_(magazine_)(struct T_(magazine) *);
+pT_(type) *T_(magazine_new)(struct T_(magazine) *);
+int T_(magazine_remove)(struct T_(magazine) *, pT_(type) *);
+#	endif
 #endif
 #ifndef BOX_DECLARE_ONLY
 
+#ifdef POOL_ALIGNED
+/** @return The number of items in every slab. */
+static size_t pT_(slab_capacity)(void) {
+	return (POOL_ALIGNED - offsetof(struct pT_(aligned), item))
+		/ sizeof(pT_(type));
+}
+/** @return The header of the slab that has `x`, by masking. */
+static struct pT_(header) *pT_(header)(const pT_(type) *const x) {
+	return (struct pT_(header) *)((POOL_UINT)(const void *)x
+		& ~(POOL_UINT)(POOL_ALIGNED - 1));
+}
+/** @return The first slab that is cut from `block`. */
+static struct pT_(header) *pT_(block_first)(const struct pT_(block) *const
+	block) {
+	return (struct pT_(header) *)(((POOL_UINT)block->memory
+		+ POOL_ALIGNED - 1) & ~(POOL_UINT)(POOL_ALIGNED - 1));
+}
+/** Puts `h` at the front of the spares of `pool`. */
+static void pT_(spare_push)(struct t_(pool) *const pool,
+	struct pT_(header) *const h) {
+	h->prev = 0, h->next = pool->spare;
+	if(pool->spare) pool->spare->prev = h;
+	pool->spare = h;
+}
+/** Takes `h` out of the spares of `pool`. */
+static void pT_(spare_remove)(struct t_(pool) *const pool,
+	struct pT_(header) *const h) {
+	if(h->prev) h->prev->next = h->next; else pool->spare = h->next;
+	if(h->next) h->next->prev = h->prev;
+}
+/** @return A slab aligned to `POOL_ALIGNED` from the spares of `pool`; if
+ there are none, a block of `POOL_ALIGNED_BLOCK` slabs and one more to align
+ them is allocated, and the rest are spare. @throws[malloc] */
+static pT_(type) *pT_(slab)(struct t_(pool) *const pool) {
+	struct pT_(header) *h;
+	if(!pool->spare) {
+		const size_t bytes = (POOL_ALIGNED_BLOCK + 1) * POOL_ALIGNED;
+		struct pT_(block) *const block = malloc(sizeof *block);
+		char *slab, *end;
+		if(!block) return 0;
+		if(!(block->memory = malloc(bytes))) { free(block); return 0; }
+		block->slabs = 0;
+		for(slab = (char *)pT_(block_first)(block),
+			end = (char *)block->memory + bytes;
+			(size_t)(end - slab) >= POOL_ALIGNED; slab += POOL_ALIGNED) {
+			h = (struct pT_(header) *)(void *)slab;
+			h->block = block, pT_(spare_push)(pool, h), block->slabs++;
+		}
+		block->spares = block->slabs;
+	}
+	h = pool->spare, assert(h && h->block->spares);
+	pT_(spare_remove)(pool, h), h->block->spares--;
+	return ((struct pT_(aligned) *)(void *)h)->item;
+}
+/** Gives the slab of `slot` back to the spares of `pool`; when all of its
+ block is spare, frees the block. */
+static void pT_(slab_free)(struct t_(pool) *const pool,
+	const struct pT_(slot) *const slot) {
+	struct pT_(header) *const h = pT_(header)(slot->slab);
+	struct pT_(block) *const block = h->block;
+	pT_(spare_push)(pool, h);
+	if(++block->spares == block->slabs) {
+		char *slab = (char *)pT_(block_first)(block);
+		size_t i;
+		for(i = 0; i < block->slabs; i++, slab += POOL_ALIGNED)
+			pT_(spare_remove)(pool, (struct pT_(header) *)(void *)slab);
+		free(block->memory), free(block);
+	}
+#	ifdef POOL_BITMAP
+	free(slot->bmp);
+#	endif
+}
+#else
+#	ifdef POOL_MMAP
+/** @return The size of a page. */
+static size_t pT_(page)(void) {
+	const long page = sysconf(_SC_PAGESIZE);
+	return page > 0 ? (size_t)page : 4096;
+}
+/** @return `bytes` rounded up to a whole page. */
+static size_t pT_(round)(const size_t bytes) {
+	const size_t page = pT_(page)();
+	return (bytes + page - 1) / page * page;
+}
+/** @return A new slab of `capacity` mapped from the operating system.
+ @throws[ERANGE, mmap] */
+static pT_(type) *pT_(slab)(const size_t capacity) {
+	const size_t bytes = capacity * sizeof(pT_(type));
+	void *slab;
+	if(bytes > (size_t)-1 - pT_(page)()) return errno = ERANGE, (void *)0;
+	slab = mmap(0, pT_(round)(bytes), PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | POOL_MAP_ANON, -1, 0);
+	return slab == MAP_FAILED ? 0 : slab;
+}
+/** Unmaps the slab of `slot`. */
+static void pT_(slab_free)(struct t_(pool) *const pool,
+	const struct pT_(slot) *const slot) {
+	(void)pool;
+	munmap(slot->slab, pT_(round)(slot->capacity * sizeof *slot->slab));
+	free(slot->page);
+#		ifdef POOL_BITMAP
+	free(slot->bmp);
+#		endif
+}
+/** Gives back the pages of `slab` from byte `a` to `b`; they stay mapped and
+ come back zeroed. */
+static void pT_(release)(pT_(type) *const slab, const size_t a,
+	const size_t b) {
+	assert(slab && a <= b);
+	if(a < b) madvise((char *)slab + a, b - a, MADV_DONTNEED);
+}
+/** Adds `delta` to the count of the pages of `slot` that `idx` touches. */
+static void pT_(tally)(struct pT_(slot) *const slot, const size_t idx,
+	const int delta) {
+	const size_t page = pT_(page)(), end = (idx + 1) * sizeof *slot->slab;
+	size_t p;
+	assert(slot && slot->page && idx < slot->capacity);
+	for(p = idx * sizeof *slot->slab / page; p * page < end; p++)
+		assert(delta > 0 || slot->page[p]), slot->page[p] += (unsigned)delta;
+}
+/** `idx` in the secondary `slot` is removed; gives back the pages that have
+ nothing live on them anymore. */
+static void pT_(uncount)(struct pT_(slot) *const slot, const size_t idx) {
+	const size_t page = pT_(page)(), end = (idx + 1) * sizeof *slot->slab;
+	size_t p;
+	assert(slot && slot->page && idx < slot->capacity);
+	for(p = idx * sizeof *slot->slab / page; p * page < end; p++)
+		if(assert(slot->page[p]), !--slot->page[p])
+		pT_(release)(slot->slab, p * page, (p + 1) * page);
+}
+/** Gives back the pages past the end of slab-zero of `pool` when there are
+ enough of them. */
+static void pT_(trim)(struct t_(pool) *const pool) {
+	const struct pT_(slot) *const slot0 = pool->slots.data;
+	size_t end;
+	assert(pool && pool->slots.size && slot0);
+	end = pT_(round)(slot0->size * sizeof *slot0->slab);
+	if(pool->resident0 < end + POOL_MMAP_RELEASE * pT_(page)()) return;
+	pT_(release)(slot0->slab, end, pool->resident0);
+	pool->resident0 = end;
+}
+#	else
+/** Frees the slab of `slot`. */
+static void pT_(slab_free)(struct t_(pool) *const pool,
+	const struct pT_(slot) *const slot) {
+	(void)pool;
+	free(slot->slab);
+#		ifdef POOL_BITMAP
+	free(slot->bmp);
+#		endif
+}
+#	endif
+
 /** @return Index of slot that is higher than `x` in `slots`, but treating zero
  as special. @order \O(\log `slots`) */
 static size_t pT_(upper)(const struct pT_(slot_array) *const slots,
@@ -155,10 +476,54 @@ static size_t pT_(upper)(const struct pT_(slot_array) *const slots,
 	}
 	return b0 + ((const void *)x >= (const void *)base[slots->size - 1].slab);
 }
+#endif
+#ifdef POOL_BITMAP
+/** @return The number of zeros before the first set bit of `x`, not zero. */
+static unsigned pT_(clz)(unsigned x) {
+	assert(x);
+#	if defined __GNUC__ || defined __clang__
+	return (unsigned)__builtin_clz(x);
+#	else
+	{
+		unsigned n = 0;
+		while(!(x & POOL_MASK(0))) x <<= 1, n++;
+		return n;
+	}
+#	endif
+}
+/** Moves `cur` to the first live item at or after it, a chunk at a time, or
+ to nothing. */
+static void pT_(seek)(struct T_(cursor) *const cur) {
+	assert(cur && cur->slot);
+	for( ; cur->slot < cur->end; cur->slot++, cur->i = 0) {
+		const unsigned *const bmp = cur->slot->bmp;
+		const size_t chunks = POOL_CHUNKS(cur->slot->capacity);
+		size_t c = cur->i / POOL_CHUNK;
+		unsigned chunk;
+		if(c >= chunks) continue;
+		/* Mask off the ones before. */
+		chunk = bmp[c] & (~0u >> cur->i % POOL_CHUNK);
+		while(!chunk && ++c < chunks) chunk = bmp[c];
+		if(!chunk) continue;
+		cur->i = c * POOL_CHUNK + pT_(clz)(chunk);
+		assert(cur->i < cur->slot->capacity);
+		return;
+	}
+	cur->slot = 0;
+}
+#endif
 /** Which slot contains the slab that has `x` in `pool`?
- @order \O(\log `slots`), \O(\log \log `size`)? */
+ @order \O(\log `slots`), \O(\log \log `size`)? With `POOL_ALIGNED`,
+ \O(1). */
 static size_t pT_(slot_idx)(const struct t_(pool) *const pool,
 	const pT_(type) *const x) {
+#ifdef POOL_ALIGNED
+	const size_t c = pT_(header)(x)->slot;
+	(void)pool;
+	assert(pool && x && c < pool->slots.size
+		&& pT_(header)(pool->slots.data[c].slab) == pT_(header)(x));
+	return c;
+#else
 	struct pT_(slot) *const base = pool->slots.data;
 	size_t up;
 	assert(pool && pool->slots.size && base && x);
@@ -171,16 +536,67 @@ static size_t pT_(slot_idx)(const struct t_(pool) *const pool,
 		&& (const void *)x < (const void *)(base[0].slab + pool->capacity0)), 0;
 	up = pT_(upper)(&pool->slots, x);
 	return assert(up), up - 1;
+#endif
 }
+/** @return The number of removed items that can be reused in slab-zero of
+ `pool`. */
+static size_t pT_(free0_size)(const struct t_(pool) *const pool) {
+#ifdef POOL_FREE_LIST
+	return pool->free_size;
+#else
+	return pool->free0.as_array.size;
+#endif
+}
+#ifdef POOL_FREE_LIST
+/** @return The link stored in the removed item `idx` of slab-zero of `pool`. */
+static size_t pT_(free_next)(const struct t_(pool) *const pool,
+	const size_t idx) {
+	size_t next;
+	memcpy(&next, pool->slots.data[0].slab + idx, sizeof next);
+	return next;
+}
+#endif
+#ifdef POOL_MMAP
+/** `slot` is slab-zero of `pool` being evicted, with `size` items counting the
+ ones that were removed. Counts the live items on each page and gives back the
+ pages with none. If it can't count, the pages are kept. */
+static void pT_(count)(const struct t_(pool) *const pool,
+	struct pT_(slot) *const slot, const size_t size) {
+	const size_t page = pT_(page)(),
+		pages = pT_(round)(slot->capacity * sizeof *slot->slab) / page;
+	size_t i, run;
+	assert(pool && slot && slot->slab == pool->slots.data[0].slab
+		&& size <= slot->capacity);
+	if(!(slot->page = calloc(pages, sizeof *slot->page))) return;
+	for(i = 0; i < size; i++) pT_(tally)(slot, i, 1);
+#	ifdef POOL_FREE_LIST
+	for(i = pool->free_head; i; i = pT_(free_next)(pool, i - 1))
+		pT_(tally)(slot, i - 1, -1);
+#	else
+	for(i = 0; i < pool->free0.as_array.size; i++)
+		pT_(tally)(slot, pool->free0.as_array.data[i], -1);
+#	endif
+	/* Release runs of empty pages at once. */
+	for(run = i = 0; i <= pages; i++) {
+		if(i < pages && !slot->page[i]) continue;
+		pT_(release)(slot->slab, run * page, i * page);
+		run = i + 1;
+	}
+}
+#endif
 /** Makes sure there are space for `n` further items in `pool`.
- @return Success. */
-static int pT_(buffer)(struct t_(pool) *const pool, const size_t n) {
+ @return Success. @throws[ERANGE] With `POOL_ALIGNED`, `n` is more than a
+ slab. @throws[malloc] */
+static int pT_(buffer)(struct t_(pool) *const pool, size_t n) {
 	const size_t min_size = POOL_SLAB_MIN_CAPACITY,
 		max_size = (size_t)-1 / sizeof(pT_(type));
 	struct pT_(slot) *base = pool->slots.data, *slot;
 	pT_(type) *slab;
 	size_t c, insert;
 	int is_recycled = 0;
+#ifdef POOL_BITMAP
+	unsigned *bmp;
+#endif
 	assert(pool && min_size <= max_size && pool->capacity0 <= max_size &&
 		(!pool->slots.size && !pool->free0.as_array.size
 		|| pool->slots.size && base /* !slots[0] -> !free0 */
@@ -188,14 +604,31 @@ static int pT_(buffer)(struct t_(pool) *const pool, const size_t n) {
 		&& (!pool->free0.as_array.size
 		|| pool->free0.as_array.size < base[0].size
 		&& pool->free0.as_array.data[0] < base[0].size)));
+#ifdef POOL_ALIGNED
+	assert(pT_(slab_capacity)() >= 2);
+	if(n > pT_(slab_capacity)()) return errno = ERANGE, 0;
+#endif
 
 	/* Ensure space for new slot. */
 	if(!n || pool->slots.size && n <= pool->capacity0
-		- base[0].size + pool->free0.as_array.size) return 1; /* Enough. */
+		- base[0].size + pT_(free0_size)(pool)) return 1; /* Enough. */
 	if(max_size < n) return errno = ERANGE, 1; /* Request unsatisfiable. */
 	if(!pT_(slot_array_buffer)(&pool->slots, 1)) return 0;
 	base = pool->slots.data; /* It may have moved! */
 
+#ifdef POOL_ALIGNED
+	/* The slabs are all the same, so the current one is not empty. */
+	assert(!pool->slots.size || base[0].size);
+	(void)min_size, (void)is_recycled;
+	c = pT_(slab_capacity)();
+#	ifdef POOL_BITMAP
+	if(!(bmp = calloc(POOL_CHUNKS(c), sizeof *bmp))) return 0;
+#	endif
+	if(!(slab = pT_(slab)(pool))) goto catch;
+	pool->capacity0 = c;
+	/* Evict slot 0 to the end; the order doesn't matter. */
+	insert = pool->slots.size;
+#else
 	/* Figure out the capacity of the next slab. */
 	c = pool->capacity0;
 	if(pool->slots.size && base[0].size) { /* ~Golden ratio. */
@@ -204,24 +637,76 @@ static int pT_(buffer)(struct t_(pool) *const pool, const size_t n) {
 	}
 	if(c < min_size) c = min_size;
 	if(c < n) c = n;
+#	ifdef POOL_BITMAP
+	if(!(bmp = calloc(POOL_CHUNKS(c), sizeof *bmp))) return 0;
+#	endif
 
 	/* Allocate it; check if the current one is empty. */
+#	ifdef POOL_MMAP
+	if(!(slab = pT_(slab)(c))) goto catch;
+	if(pool->slots.size && !base[0].size)
+		is_recycled = 1, pT_(slab_free)(pool, base + 0);
+	pool->capacity0 = c;
+	if(is_recycled) {
+#		ifdef POOL_BITMAP
+		base[0].bmp = bmp;
+#		endif
+		return base[0].size = 0, base[0].slab = slab,
+			base[0].capacity = c, pool->resident0 = 0, 1;
+	}
+#	else
 	if(pool->slots.size && !base[0].size)
 		is_recycled = 1, slab = realloc(base[0].slab, c * sizeof *slab);
 	else slab = malloc(c * sizeof *slab);
-	if(!slab) { if(!errno) errno = ERANGE; return 0; }
+	if(!slab) goto catch;
 	pool->capacity0 = c; /* We only need to store the capacity of slab 0. */
-	if(is_recycled) return base[0].size = 0, base[0].slab = slab, 1;
+	if(is_recycled) {
+#		ifdef POOL_BITMAP
+		free(base[0].bmp), base[0].bmp = bmp, base[0].capacity = c;
+#		endif
+		return base[0].size = 0, base[0].slab = slab, 1;
+	}
+#	endif
 
 	/* Evict slot 0. */
 	if(!pool->slots.size) insert = 0;
 	else insert = pT_(upper)(&pool->slots, base[0].slab);
+#endif
 	assert(insert <= pool->slots.size);
 	slot = pT_(slot_array_insert)(&pool->slots, 1, insert);
 	assert(slot); /* Made space for it before. */
-	slot->slab = base[0].slab, slot->size = base[0].size;
+	/* Removed items of the old slab-zero are not in use; don't reuse them. */
+	slot->slab = base[0].slab, slot->size = base[0].size - pT_(free0_size)(pool);
+	assert(slot == base || slot->size); /* The first is the same. */
+#if defined POOL_BITMAP || defined POOL_MMAP
+	if(slot != base) slot->capacity = base[0].capacity;
+	base[0].capacity = c;
+#endif
+#ifdef POOL_BITMAP
+	if(slot != base) slot->bmp = base[0].bmp;
+	base[0].bmp = bmp;
+#endif
+#ifdef POOL_MMAP
+	if(slot != base) slot->page = 0, pT_(count)(pool, slot, base[0].size);
+	base[0].page = 0, pool->resident0 = 0;
+#endif
 	base[0].slab = slab, base[0].size = 0;
+#ifdef POOL_ALIGNED
+	if(slot != base) pT_(header)(slot->slab)->slot = insert;
+	pT_(header)(slab)->slot = 0;
+#endif
+#ifdef POOL_FREE_LIST
+	pool->free_head = pool->free_size = 0;
+#else
+	poolfree_heap_clear(&pool->free0);
+#endif
 	return 1;
+catch:
+#ifdef POOL_BITMAP
+	free(bmp);
+#endif
+	if(!errno) errno = ERANGE;
+	return 0;
 }
 /** Either `data` in `pool` is in a secondary slab, in which case it decrements
  the size, or it's the zero-slab, where it gets added to the free-heap.
@@ -232,10 +717,29 @@ static int pT_(remove)(struct t_(pool) *const pool,
 	size_t c = pT_(slot_idx)(pool, data);
 	struct pT_(slot) *slot = pool->slots.data + c;
 	assert(pool && pool->slots.size && data);
+#ifdef POOL_BITMAP
+	/* Slab-zero only after it can't fail. */
+	if(c) assert(POOL_AT(slot->bmp, (size_t)(data - slot->slab))),
+		POOL_CLEAR(slot->bmp, (size_t)(data - slot->slab));
+#endif
 	if(!c) { /* It's in the zero-slot, we need to deal with the free-heap. */
 		const size_t idx = (size_t)(data - slot->slab);
 		assert(pool->capacity0 && slot->size <= pool->capacity0
 			&& idx < slot->size);
+#ifdef POOL_BITMAP
+		assert(POOL_AT(slot->bmp, idx));
+#endif
+#ifdef POOL_FREE_LIST
+		if(idx + 1 == slot->size) {
+			slot->size--;
+		} else {
+			memcpy(slot->slab + idx, &pool->free_head, sizeof pool->free_head);
+			pool->free_head = idx + 1, pool->free_size++;
+		}
+		/* Everything is removed; start over instead of going though it. */
+		if(pool->free_size == slot->size)
+			slot->size = pool->free_head = pool->free_size = 0;
+#else
 		if(idx + 1 == slot->size) {
 			/* Keep shrinking going while item on the free-heap are exposed. */
 			while(--slot->size && poolfree_heap_size(&pool->free0)) {
@@ -245,17 +749,52 @@ static int pT_(remove)(struct t_(pool) *const pool,
 				poolfree_heap_pop(&pool->free0);
 			}
 		} else if(!poolfree_heap_add(&pool->free0, idx)) return 0;
+#endif
+#ifdef POOL_BITMAP
+		POOL_CLEAR(slot->bmp, idx);
+#endif
+#ifdef POOL_MMAP
+		pT_(trim)(pool);
+#endif
 	} else if(assert(slot->size), !--slot->size) {
-		pT_(type) *const slab = slot->slab;
+		const struct pT_(slot) dead = *slot;
+#ifdef POOL_ALIGNED
+		/* The last slot takes its place. */
+		pT_(slot_array_lazy_remove)(&pool->slots, slot);
+		if(c < pool->slots.size) pT_(header)(slot->slab)->slot = c;
+#else
 		pT_(slot_array_remove)(&pool->slots, pool->slots.data + c);
-		free(slab);
+#endif
+		pT_(slab_free)(pool, &dead);
 	}
+#ifdef POOL_MMAP
+	else if(slot->page) pT_(uncount)(slot, (size_t)(data - slot->slab));
+#endif
 	return 1;
 }
 
 #	define BOX_PUBLIC_OVERRIDE
 #	include "box.h"
 
+#ifdef POOL_BITMAP
+/** @return A cursor at the first live item of `p` or to nothing. */
+static struct T_(cursor) T_(begin)(const struct t_(pool) *const p) {
+	struct T_(cursor) cur;
+	cur.slot = p && p->slots.data ? p->slots.data : 0, cur.i = 0;
+	if(cur.slot) cur.end = cur.slot + p->slots.size, pT_(seek)(&cur);
+	else cur.end = 0;
+	return cur;
+}
+/** @return Is `cur` valid? */
+static int T_(exists)(const struct T_(cursor) *const cur)
+	{ return cur && cur->slot; }
+/** @return A pointer to a valid `cur`. */
+static pT_(type) *T_(entry)(struct T_(cursor) *const cur)
+	{ return cur->slot->slab + cur->i; }
+/** Next live item of `cur`, in order of slot. */
+static void T_(next)(struct T_(cursor) *const cur)
+	{ cur->i++, pT_(seek)(cur); }
+#else
 /** @return A cursor at slot0 of `p` or to nothing. */
 static struct T_(cursor) T_(begin)(const struct t_(pool) *const p)
 	{ struct T_(cursor) cur; cur.slot0 = p && p->slots.data
@@ -270,10 +809,20 @@ static pT_(type) *T_(entry)(struct T_(cursor) *const cur)
 /** Next valid `cur`. */
 static void T_(next)(struct T_(cursor) *const cur)
 	{ if(cur->i == (size_t)~0) cur->slot0 = 0; else cur->i++; }
+#endif
 
 /** @return An idle pool is zeroed. @order \Theta(1) @allow */
 static struct t_(pool) t_(pool)(void) { struct t_(pool) p;
 	p.slots = pT_(slot_array)(), p.free0 = poolfree_heap(), p.capacity0 = 0;
+#ifdef POOL_FREE_LIST
+	p.free_head = p.free_size = 0;
+#endif
+#ifdef POOL_MMAP
+	p.resident0 = 0;
+#endif
+#ifdef POOL_ALIGNED
+	p.spare = 0;
+#endif
 	return p; }
 
 /** Destroys `pool` and returns it to idle. @order \O(\log `data`) @allow */
@@ -281,7 +830,7 @@ static void t_(pool_)(struct t_(pool) *const pool) {
 	struct pT_(slot) *s, *s_end;
 	if(!pool) return;
 	for(s = pool->slots.data, s_end = s + pool->slots.size; s < s_end; s++)
-		assert(s->slab), free(s->slab);
+		assert(s->slab), pT_(slab_free)(pool, s);
 	pT_(slot_array_)(&pool->slots);
 	poolfree_heap_(&pool->free0);
 	*pool = t_(pool)();
@@ -289,7 +838,8 @@ static void t_(pool_)(struct t_(pool) *const pool) {
 
 /** Ensure capacity of at least `n` further items in `pool`. Pre-sizing is
  better for contiguous blocks, but takes up that memory.
- @return Success. @throws[ERANGE, malloc] @allow */
+ @return Success. @throws[ERANGE] With `POOL_ALIGNED`, `n` is more than fits
+ in a slab. @throws[malloc] @allow */
 static int T_(buffer)(struct t_(pool) *const pool, const size_t n) {
 	return assert(pool), pT_(buffer)(pool, n);
 }
@@ -299,21 +849,42 @@ static int T_(buffer)(struct t_(pool) *const pool, const size_t n) {
  @throws[ERANGE, malloc] @order amortised O(1) @allow */
 static pT_(type) *T_(new)(struct t_(pool) *const pool) {
 	struct pT_(slot) *slot0;
+	size_t idx;
 	assert(pool);
 	if(!pT_(buffer)(pool, 1)) return 0;
-	assert(pool->slots.size && (pool->free0.as_array.size ||
+	assert(pool->slots.size && (pT_(free0_size)(pool) ||
 		pool->slots.data[0].size < pool->capacity0));
+	slot0 = pool->slots.data + 0;
+#ifdef POOL_FREE_LIST
+	if(pool->free_head) {
+		idx = pool->free_head - 1;
+		assert(pool->free_size && idx < slot0->size);
+		pool->free_head = pT_(free_next)(pool, idx), pool->free_size--;
+	} else
+#else
 	if(poolfree_heap_size(&pool->free0)) {
 		/* Cheating: we prefer the minimum index from a max-heap, but it
 		 doesn't really matter, so take the one off the array used for heap. */
 		size_t *free;
 		free = private_poolfree_heap_priority_array_pop(&pool->free0.as_array);
-		return assert(free), pool->slots.data[0].slab + *free;
+		assert(free), idx = *free;
+	} else
+#endif
+	{
+		/* The free-heap is empty; guaranteed by <fn:<pT>buffer>. */
+		assert(slot0 && slot0->size < pool->capacity0);
+#ifdef POOL_MMAP
+		if((slot0->size + 1) * sizeof *slot0->slab > pool->resident0)
+			pool->resident0
+			= pT_(round)((slot0->size + 1) * sizeof *slot0->slab);
+#endif
+		idx = slot0->size++;
 	}
-	/* The free-heap is empty; guaranteed by <fn:<pT>buffer>. */
-	slot0 = pool->slots.data + 0;
-	assert(slot0 && slot0->size < pool->capacity0);
-	return slot0->slab + slot0->size++;
+#ifdef POOL_BITMAP
+	assert(!POOL_AT(slot0->bmp, idx));
+	POOL_SET(slot0->bmp, idx);
+#endif
+	return slot0->slab + idx;
 }
 
 /** Deletes `data` from `pool`. (Do not remove data that is not in `pool`.)
@@ -330,12 +901,118 @@ static void T_(clear)(struct t_(pool) *const pool) {
 	assert(pool);
 	if(!pool->slots.size) { assert(!pool->free0.as_array.size); return; }
 	for(s = pool->slots.data + 1, s_end = s - 1 + pool->slots.size;
-		s < s_end; s++) assert(s->slab && s->size), free(s->slab);
+		s < s_end; s++) assert(s->slab && s->size), pT_(slab_free)(pool, s);
 	pool->slots.data[0].size = 0;
 	pool->slots.size = 1;
+#ifdef POOL_BITMAP
+	memset(pool->slots.data[0].bmp, 0,
+		sizeof *pool->slots.data[0].bmp * POOL_CHUNKS(pool->capacity0));
+#endif
+#ifdef POOL_MMAP
+	pT_(trim)(pool);
+#endif
 	poolfree_heap_clear(&pool->free0);
+#ifdef POOL_FREE_LIST
+	pool->free_head = pool->free_size = 0;
+#endif
+}
+
+#	ifdef POOL_MAGAZINE /* <!-- magazine */
+#		define BOX_PRIVATE_AGAIN
+#		include "box.h"
+/** Gives all but the newest `keep` of `m` back to the depot.
+ @return Whether it has `keep`; it may fail on the free-heap of the pool.
+ @throws[realloc] */
+static int pT_(drain)(struct T_(magazine) *const m, const size_t keep) {
+	size_t i = 0;
+	assert(m && m->depot && keep <= m->size);
+	pthread_mutex_lock(&m->depot->lock);
+	while(i < m->size - keep && pT_(remove)(&m->depot->pool, m->round[i])) i++;
+	pthread_mutex_unlock(&m->depot->lock);
+	/* The oldest are gone; the rest are more likely to be in cache. */
+	memmove(m->round, m->round + i, sizeof *m->round * (m->size - i));
+	m->size -= i;
+	return m->size == keep;
+}
+#		define BOX_PUBLIC_OVERRIDE
+#		include "box.h"
+
+/** Sets up `depot`, an empty pool that is shared between threads.
+ @return Success, otherwise `depot` is not initialized.
+ @throws[pthread_mutex_init] @allow */
+static int T_(depot)(struct T_(depot) *const depot) {
+	int e;
+	assert(depot);
+	depot->pool = t_(pool)();
+	if(e = pthread_mutex_init(&depot->lock, 0)) return errno = e, 0;
+	return 1;
+}
+
+/** Destroys `depot`, which can be null, and everything in it. The magazines
+ must be done with it. @allow */
+static void T_(depot_)(struct T_(depot) *const depot) {
+	if(!depot) return;
+	t_(pool_)(&depot->pool);
+	pthread_mutex_destroy(&depot->lock);
 }
 
+/** @return An empty magazine of `depot`; only one thread may use it.
+ @order \Theta(1) @allow */
+static struct T_(magazine) T_(magazine)(struct T_(depot) *const depot) {
+	struct T_(magazine) m;
+	assert(depot);
+	m.depot = depot, m.size = 0;
+	return m;
+}
+
+/** Gives the free slots in `m` back to its depot, as when the thread is done.
+ If the pool can't take them, they stay in the depot until it's destroyed.
+ @allow */
+static void T_(magazine_)(struct T_(magazine) *const m) {
+	if(!m || !m->depot) return;
+	if(m->size) pT_(drain)(m, 0);
+	m->depot = 0, m->size = 0;
+}
+
+/** This pointer is constant until it is removed by any magazine of the same
+ depot. When `m` is empty, it takes half a magazine from the depot at once.
+ @return A pointer to a new uninitialized element from `m`.
+ @throws[ERANGE, malloc] @order amortised O(1) @allow */
+static pT_(type) *T_(magazine_new)(struct T_(magazine) *const m) {
+	assert(m && m->depot);
+	if(!m->size) {
+		struct t_(pool) *const pool = &m->depot->pool;
+		size_t refill = POOL_MAGAZINE_CAPACITY / 2;
+		pT_(type) *data;
+#		ifdef POOL_ALIGNED
+		if(refill > pT_(slab_capacity)()) refill = pT_(slab_capacity)();
+#		endif
+		pthread_mutex_lock(&m->depot->lock);
+		if(pT_(buffer)(pool, refill))
+			while(m->size < refill && (data = T_(new)(pool)))
+			m->round[m->size++] = data;
+		pthread_mutex_unlock(&m->depot->lock);
+		if(!m->size) return 0;
+	}
+	return m->round[--m->size];
+}
+
+/** Puts `data` in `m` to be used again. It need not have come from `m`, but
+ it must be from the same depot. When `m` is full, the older half goes back
+ to the depot at once.
+ @return Success. @throws[malloc] The pool can demand memory on removal.
+ @order amortised O(1) @allow */
+static int T_(magazine_remove)(struct T_(magazine) *const m,
+	pT_(type) *const data) {
+	assert(m && m->depot && data);
+	if(m->size == POOL_MAGAZINE_CAPACITY
+		&& !pT_(drain)(m, POOL_MAGAZINE_CAPACITY / 2)
+		&& m->size == POOL_MAGAZINE_CAPACITY) return 0;
+	m->round[m->size++] = data;
+	return 1;
+}
+#	endif /* magazine --> */
+
 #	define BOX_PRIVATE_AGAIN
 #	include "box.h"
 
@@ -343,7 +1020,12 @@ static void pT_(unused_base_coda)(void);
 static void pT_(unused_base)(void) {
 	T_(begin)(0); T_(exists)(0); T_(entry)(0); T_(next)(0);
 	t_(pool)(); t_(pool_)(0); T_(buffer)(0, 0); T_(new)(0);
-	T_(remove)(0, 0); T_(clear)(0); pT_(unused_base_coda)();
+	T_(remove)(0, 0); T_(clear)(0);
+#	ifdef POOL_MAGAZINE
+	T_(depot)(0); T_(depot_)(0); T_(magazine)(0); T_(magazine_)(0);
+	T_(magazine_new)(0); T_(magazine_remove)(0, 0);
+#	endif
+	pT_(unused_base_coda)();
 }
 static void pT_(unused_base_coda)(void) { pT_(unused_base)(); }
 #endif /* Produce code. */
@@ -357,7 +1039,11 @@ typedef void (*pT_(to_string_fn))(const pT_(type) *, char (*)[12]);
 /** Thunk(`cur`, `a`). One must implement `<tr>to_string`. */
 static void pTR_(to_string)(const struct T_(cursor) *const cur,
 	char (*const a)[12])
+#		ifdef POOL_BITMAP
+	{ tr_(to_string)(&cur->slot->slab[cur->i], a); }
+#		else
 	{ tr_(to_string)(&cur->slot0->slab[cur->i], a); }
+#		endif
 #	endif
 #	define TO_STRING_LEFT '['
 #	define TO_STRING_RIGHT ']'
@@ -380,6 +1066,27 @@ static void pTR_(to_string)(const struct T_(cursor) *const cur,
 #undef POOL_NAME
 #undef POOL_TYPE
 #undef POOL_SLAB_MIN_CAPACITY
+#ifdef POOL_FREE_LIST
+#	undef POOL_FREE_LIST
+#endif
+#ifdef POOL_MAGAZINE
+#	undef POOL_MAGAZINE
+#	undef POOL_MAGAZINE_CAPACITY
+#endif
+#ifdef POOL_BITMAP
+#	undef POOL_BITMAP
+#	undef POOL_CHUNK
+#	undef POOL_CHUNKS
+#	undef POOL_MASK
+#	undef POOL_AT
+#	undef POOL_SET
+#	undef POOL_CLEAR
+#endif
+#ifdef POOL_MMAP
+#	undef POOL_MMAP
+#	undef POOL_MMAP_RELEASE
+#	undef POOL_MAP_ANON
+#endif
 #ifdef POOL_HAS_TO_STRING
 #	undef POOL_HAS_TO_STRING
 #endif
@@ -387,5 +1094,10 @@ static void pTR_(to_string)(const struct T_(cursor) *const cur,
 #	undef POOL_DECLARE_ONLY
 #endif
 #undef POOL_CAST
+#undef POOL_UINT
+#ifdef POOL_ALIGNED
+#	undef POOL_ALIGNED
+#	undef POOL_ALIGNED_BLOCK
+#endif
 #define BOX_END
 #include "box.h"
@@ -29,6 +29,34 @@
  should be okay for most variations. 4 is isomorphic to left-leaning red-black
  tree, <Sedgewick, 2008, LLRB>. The above illustration is 5.
 
+ @param[TREE_PREFIX]
+ Optional unsigned integral type, <typedef:<pT>prefix>, of a fixed-size
+ prefix of the key that is stored inline next to each key; requires
+ <typedef:<pT>prefix_fn> `<t>prefix`. The prefix must be order-preserving, and
+ comparisons in a bough are first resolved on it, falling back to `<t>less`
+ only on a tie. This is a poor man's normalized key, as
+ <Graefe, Larson, 2001, Caches>, and is useful when `<t>less` is indirect, such
+ as `strcmp` on string keys.
+
+ @param[TREE_AUGMENT]
+ Optional type, <typedef:<pT>summary>, of a monoid that every bough caches
+ for its sub-tree; requires <typedef:<pT>identity_fn> `<t>identity`,
+ <typedef:<pT>augment_fn> `<t>augment`, and <typedef:<pT>merge_fn>
+ `<t>merge`. Summaries are marked stale by modifications and recomputed
+ lazily by the queries <fn:<T>summary>, <fn:<T>summarize>, and
+ <fn:<T>overlap>. For example, an interval tree keyed on the start with
+ summary the maximum end, as <Cormen, Leiserson, Rivest, Stein, 2009, Intro>.
+
+ @param[TREE_PARALLEL]
+ Optional, adds <fn:<T>parallel_clone>, <fn:<T>parallel_clear>, and parallel
+ versions of the merges, <fn:<T>parallel_union>, for example, which split the
+ work on big trees between POSIX threads; requires `pthread`.
+
+ @param[TREE_IMAGE]
+ Optional, adds <fn:<T>image_save>, which writes the tree as fixed-size pages,
+ and <tag:<T>image>, which is a read-only view of those pages in memory, such
+ as from `mmap`, without deserializing; requires `stdio.h`.
+
  @param[TREE_DEFAULT]
  Default trait which must be set to a <typedef:<pT>value>, used in
  <fn:<T>tree<R>get>.
@@ -111,6 +139,12 @@ struct tree_node_count { size_t branches, leaves; };
 #	include <errno.h>
 #	include <assert.h>
 #	include <limits.h>
+#	ifdef TREE_PARALLEL
+#		include <pthread.h>
+#	endif
+#	ifdef TREE_IMAGE
+#		include <stdio.h>
+#	endif
 
 #	ifndef TREE_ORDER
 #		define TREE_ORDER 65 /* Maximum branching factor. Sets granularity. */
@@ -131,6 +165,17 @@ typedef TREE_KEY pT_(key);
 typedef TREE_VALUE pT_(value);
 #	endif
 
+#	ifdef TREE_PREFIX
+/** On `TREE_PREFIX`, an unsigned integer that is cached in the bough for every
+ key. */
+typedef TREE_PREFIX pT_(prefix);
+#	endif
+
+#	ifdef TREE_AUGMENT
+/** On `TREE_AUGMENT`, a summary of a sub-tree that is cached in the bough. */
+typedef TREE_AUGMENT pT_(summary);
+#	endif
+
 /* These rules are lazier than the original—described in <Knuth, 1998 Art 3>—so
  as to not exhibit worst-case behaviour in small trees, as
  <Johnson, Shasha, 1993, Free-at-Empty>.
@@ -150,6 +195,13 @@ typedef TREE_VALUE pT_(value);
  * Bulk-loading always is ascending. */
 struct pT_(bough) {
 	unsigned size;
+#	ifdef TREE_AUGMENT
+	unsigned stale; /* Then `summary` has to be recomputed. */
+	pT_(summary) summary; /* Of the entire sub-tree. */
+#	endif
+#	ifdef TREE_PREFIX
+	pT_(prefix) prefix[TREE_MAX]; /* Mostly decides without `key`. */
+#	endif
 	pT_(key) key[TREE_MAX]; /* Cache-friendly lookup. */
 #	ifdef TREE_VALUE
 	pT_(value) value[TREE_MAX];
@@ -197,6 +249,33 @@ struct pT_(ref) {
 /* Enough to address a specific key and move keys. */
 struct T_(cursor) { struct pT_(subtree) *trunk; struct pT_(ref) ref; };
 
+#	ifdef TREE_AUGMENT
+/** Only with `TREE_AUGMENT`, used in <fn:<T>overlap>. Given a summary and the
+ parameter, returns false if no entry that contributed to it could be
+ wanted. It is also called with the summary of single entries. */
+typedef int (*pT_(keep_fn))(const pT_(summary) *, void *);
+/** Only with `TREE_AUGMENT`, used in <fn:<T>overlap>. Given the cursor of an
+ entry that was kept and the parameter. */
+typedef void (*pT_(visit_fn))(const struct T_(cursor) *, void *);
+#	endif
+
+#	ifdef TREE_IMAGE
+/* A fixed-size page of an image; the children are page numbers. */
+struct pT_(page) { struct pT_(bough) bough; size_t child[TREE_ORDER]; };
+/* The last page of the image says what it is. */
+struct pT_(image_trailer)
+	{ char magic[8]; size_t page_size, pages, root; unsigned height; };
+union pT_(image_page)
+	{ struct pT_(page) page; struct pT_(image_trailer) trailer; };
+/** Only with `TREE_IMAGE`. A read-only view of a tree that was saved with
+ <fn:<T>image_save>, set up by <fn:<T>image>. */
+struct T_(image)
+	{ const union pT_(image_page) *page; size_t pages; struct pT_(ref) trunk; };
+/** Only with `TREE_IMAGE`. Addresses a key in an image. */
+struct T_(image_cursor)
+	{ const struct T_(image) *image; struct pT_(ref) ref; };
+#	endif
+
 #	ifdef BOX_NON_STATIC /* Public functions. */
 struct T_(cursor) T_(begin)(const struct t_(tree) *);
 int T_(exists)(struct T_(cursor) *);
@@ -229,6 +308,45 @@ enum tree_result T_(bulk_add)(struct t_(tree) *, pT_(key));
 int T_(bulk_finish)(struct t_(tree) *);
 int T_(remove)(struct t_(tree) *, pT_(key));
 int T_(clone)(struct t_(tree) *restrict, const struct t_(tree) *restrict);
+int T_(union)(struct t_(tree) *, const struct t_(tree) *,
+	const struct t_(tree) *);
+int T_(intersection)(struct t_(tree) *, const struct t_(tree) *,
+	const struct t_(tree) *);
+int T_(difference)(struct t_(tree) *, const struct t_(tree) *,
+	const struct t_(tree) *);
+#		ifdef TREE_PARALLEL
+int T_(parallel_union)(struct t_(tree) *, const struct t_(tree) *,
+	const struct t_(tree) *, unsigned);
+int T_(parallel_intersection)(struct t_(tree) *, const struct t_(tree) *,
+	const struct t_(tree) *, unsigned);
+int T_(parallel_difference)(struct t_(tree) *, const struct t_(tree) *,
+	const struct t_(tree) *, unsigned);
+int T_(parallel_clone)(struct t_(tree) *restrict,
+	const struct t_(tree) *restrict, unsigned);
+void T_(parallel_clear)(struct t_(tree) *, unsigned);
+#		endif
+#		ifdef TREE_IMAGE
+int T_(image_save)(const struct t_(tree) *, FILE *);
+int T_(image)(struct T_(image) *, const void *, size_t);
+int T_(image_contains)(const struct T_(image) *, pT_(key));
+pT_(value) T_(image_get_or)(const struct T_(image) *, pT_(key), pT_(value));
+struct T_(image_cursor) T_(image_begin)(const struct T_(image) *);
+struct T_(image_cursor) T_(image_less)(const struct T_(image) *, pT_(key));
+struct T_(image_cursor) T_(image_more)(const struct T_(image) *, pT_(key));
+int T_(image_exists)(const struct T_(image_cursor) *);
+pT_(key) T_(image_key)(const struct T_(image_cursor) *);
+#			ifdef TREE_VALUE
+const pT_(value) *T_(image_value)(const struct T_(image_cursor) *);
+#			endif
+void T_(image_next)(struct T_(image_cursor) *);
+#		endif
+#		ifdef TREE_AUGMENT
+void T_(invalidate)(struct t_(tree) *, pT_(key));
+const pT_(summary) *T_(summary)(struct t_(tree) *);
+void T_(summarize)(struct t_(tree) *, pT_(key), pT_(key), pT_(summary) *);
+size_t T_(overlap)(struct t_(tree) *, pT_(key), pT_(keep_fn),
+	pT_(visit_fn), void *);
+#		endif
 #	endif
 #	ifndef BOX_DECLARE_ONLY /* <!-- body */
 
@@ -239,6 +357,29 @@ int T_(clone)(struct t_(tree) *restrict, const struct t_(tree) *restrict);
  `return strcmp(a, b)` would give an ascending tree. */
 typedef int (*pT_(less_fn))(const pT_(key) a, const pT_(key) b);
 
+#		ifdef TREE_PREFIX
+/** Only with `TREE_PREFIX`. Must be monotonic with <typedef:<pT>less_fn>: if
+ `<t>less(a, b) <= 0` then `<t>prefix(a) <= <t>prefix(b)`. For example, the
+ first `sizeof(unsigned long)` bytes of a string packed big-endian. */
+typedef pT_(prefix) (*pT_(prefix_fn))(const pT_(key));
+#		endif
+
+#		ifdef TREE_AUGMENT
+/** Only with `TREE_AUGMENT`. Sets the argument to the summary of nothing. */
+typedef void (*pT_(identity_fn))(pT_(summary) *);
+/** Only with `TREE_AUGMENT`. Accumulates one entry into the summary. Entries
+ are accumulated in order; the value is omitted when it's a set. */
+#			ifdef TREE_VALUE
+typedef void (*pT_(augment_fn))(pT_(summary) *, const pT_(key),
+	const pT_(value) *);
+#			else
+typedef void (*pT_(augment_fn))(pT_(summary) *, const pT_(key));
+#			endif
+/** Only with `TREE_AUGMENT`. Accumulates the summary of a sub-tree that is
+ entirely in order after the first argument into the first argument. */
+typedef void (*pT_(merge_fn))(pT_(summary) *, const pT_(summary) *);
+#		endif
+
 /** @return Downcasts `as_leaf` to a branch. */
 static struct pT_(branch_bough) *pT_(as_branch)(struct pT_(bough) *const bough)
 	{ return (struct pT_(branch_bough) *)(void *)
@@ -261,6 +402,20 @@ static pT_(value) *pT_(ref_to_valuep)(const struct pT_(ref) ref)
 /** Finds greatest lower-bound of `x` in `lo` only in one bough. */
 static void pT_(node_lb)(struct pT_(ref) *const lo, const pT_(key) x) {
 	unsigned hi = lo->bough->size; lo->idx = 0;
+#		ifdef TREE_PREFIX
+	{
+		/* Make sure one has declared <typedef:<pT>prefix_fn> `<t>prefix`. */
+		const pT_(prefix) p = t_(prefix)(x);
+		assert(lo && lo->bough && hi);
+		do {
+			const unsigned mid = (lo->idx + hi) / 2;
+			const pT_(prefix) q = lo->bough->prefix[mid];
+			if(q < p || q == p && t_(less)(x, lo->bough->key[mid]) > 0)
+				lo->idx = mid + 1;
+			else hi = mid;
+		} while(lo->idx < hi);
+	}
+#		else
 	assert(lo && lo->bough && hi);
 	do {
 		const unsigned mid = (lo->idx + hi) / 2; /* Will not overflow. */
@@ -268,28 +423,50 @@ static void pT_(node_lb)(struct pT_(ref) *const lo, const pT_(key) x) {
 		if(t_(less)(x, lo->bough->key[mid]) > 0) lo->idx = mid + 1;
 		else hi = mid;
 	} while(lo->idx < hi);
+#		endif
 }
 /** Finds `idx` of 'least upper-bound' (C++ parlance) majorant of `x` in `hi`
  only in one node at a time. */
 static void pT_(node_ub)(struct pT_(ref) *const hi, const pT_(key) x) {
 	unsigned lo = 0;
+#		ifdef TREE_PREFIX
+	const pT_(prefix) p = t_(prefix)(x);
+	assert(hi->bough && hi->idx);
+	do {
+		const unsigned mid = (lo + hi->idx) / 2;
+		const pT_(prefix) q = hi->bough->prefix[mid];
+		if(q < p || q == p && t_(less)(hi->bough->key[mid], x) <= 0)
+			lo = mid + 1;
+		else hi->idx = mid;
+	} while(lo < hi->idx);
+#		else
 	assert(hi->bough && hi->idx);
 	do {
 		const unsigned mid = (lo + hi->idx) / 2;
 		if(t_(less)(hi->bough->key[mid], x) <= 0) lo = mid + 1;
 		else hi->idx = mid;
 	} while(lo < hi->idx);
+#		endif
 }
+/** Gets the child `idx` of the branch `bough` that is in `source`. */
+typedef struct pT_(bough) *(*pT_(child_fn))(const void *source,
+	const struct pT_(bough) *bough, unsigned idx);
+/** The child `idx` of `bough` in memory; `source` is unused.
+ @implements <typedef:<pT>child_fn> */
+static struct pT_(bough) *pT_(child)(const void *const source,
+	const struct pT_(bough) *const bough, const unsigned idx)
+	{ return (void)source, pT_(as_branch_c)(bough)->child[idx]; }
 /** @return A reference to the greatest key at or less than `x` in `tree`, or
- the reference will be empty if the `x` is less than all `tree`. */
-static struct pT_(ref) pT_(less)(const struct pT_(subtree) tree,
-	const pT_(key) x) {
+ the reference will be empty if the `x` is less than all `tree`. The boughs
+ are in `source`, got by `child`. */
+static struct pT_(ref) pT_(less_in)(const struct pT_(subtree) tree,
+	const pT_(key) x, const pT_(child_fn) child, const void *const source) {
 	struct pT_(ref) hi, found;
 	found.bough = 0;
 	if(!tree.height) return found;
-	assert(tree.bough);
+	assert(tree.bough && child);
 	for(hi.bough = tree.bough, hi.height = tree.height; ;
-		hi.bough = pT_(as_branch_c)(hi.bough)->child[hi.idx], hi.height--) {
+		hi.bough = child(source, hi.bough, hi.idx), hi.height--) {
 		if(!(hi.idx = hi.bough->size)) continue;
 		pT_(node_ub)(&hi, x);
 		if(hi.idx) { /* Within bounds to record the current predecessor. */
@@ -302,15 +479,16 @@ static struct pT_(ref) pT_(less)(const struct pT_(subtree) tree,
 	return found;
 }
 /** @return A reference to the smallest key at or more than `x` in `tree`, or
- the reference will be empty if the `x` is more than all `tree`. */
-static struct pT_(ref) pT_(more)(const struct pT_(subtree) tree,
-	const pT_(key) x) {
+ the reference will be empty if the `x` is more than all `tree`. The boughs
+ are in `source`, got by `child`. */
+static struct pT_(ref) pT_(more_in)(const struct pT_(subtree) tree,
+	const pT_(key) x, const pT_(child_fn) child, const void *const source) {
 	struct pT_(ref) lo, found;
 	found.bough = 0;
 	if(!tree.height) return found;
-	assert(tree.bough);
+	assert(tree.bough && child);
 	for(lo.bough = tree.bough, lo.height = tree.height; ;
-		lo.bough = pT_(as_branch_c)(lo.bough)->child[lo.idx], lo.height--) {
+		lo.bough = child(source, lo.bough, lo.idx), lo.height--) {
 		unsigned hi = lo.bough->size; lo.idx = 0;
 		if(!hi) continue;
 		pT_(node_lb)(&lo, x);
@@ -322,6 +500,12 @@ static struct pT_(ref) pT_(more)(const struct pT_(subtree) tree,
 	}
 	return found;
 }
+/** <fn:<pT>less_in> in memory. */
+static struct pT_(ref) pT_(less)(const struct pT_(subtree) tree,
+	const pT_(key) x) { return pT_(less_in)(tree, x, &pT_(child), 0); }
+/** <fn:<pT>more_in> in memory. */
+static struct pT_(ref) pT_(more)(const struct pT_(subtree) tree,
+	const pT_(key) x) { return pT_(more_in)(tree, x, &pT_(child), 0); }
 /** Finds an exact key `x` in non-empty `tree`. */
 static struct pT_(ref) pT_(lookup_find)(const struct pT_(subtree) tree,
 	const pT_(key) x) {
@@ -360,6 +544,115 @@ static struct pT_(ref) pT_(lookup_hole)(struct pT_(subtree) tree,
 	}
 	return lo;
 }
+#		ifdef TREE_AUGMENT
+/** Marks `sub` stale along with the edge that faces the path in
+ <fn:<pT>stale>; on `is_less`, that is the right edge. */
+static void pT_(stale_edge)(struct pT_(subtree) sub, const int is_less) {
+	for( ; ; sub.bough = pT_(as_branch)(sub.bough)
+		->child[is_less ? sub.bough->size : 0], sub.height--) {
+		sub.bough->stale = 1;
+		if(sub.height <= 1) break;
+	}
+}
+/** Marks the boughs on the path to `x` in `sub` and their siblings on either
+ side as stale. This is every bough that a modification of `x` could have
+ changed: balancing involves adjacent siblings, and a split can leave the
+ split-off part of the level below on the facing edge of a sibling. If `x` is
+ found in a branch, both sides are descended; its predecessor or successor
+ were involved. */
+static void pT_(stale)(const struct pT_(subtree) sub, const pT_(key) x) {
+	struct pT_(ref) lo;
+	if(!sub.height) return;
+	assert(sub.bough);
+	for(lo.bough = sub.bough, lo.height = sub.height; ;
+		lo.bough = pT_(as_branch)(lo.bough)->child[lo.idx], lo.height--) {
+		struct pT_(branch_bough) *branch;
+		struct pT_(subtree) sibling;
+		lo.bough->stale = 1;
+		if(lo.height <= 1) break;
+		branch = pT_(as_branch)(lo.bough);
+		if(lo.bough->size) pT_(node_lb)(&lo, x); else lo.idx = 0;
+		sibling.height = lo.height - 1;
+		if(lo.idx) sibling.bough = branch->child[lo.idx - 1],
+			pT_(stale_edge)(sibling, 1);
+		if(lo.idx >= lo.bough->size) continue;
+		if(t_(less)(lo.bough->key[lo.idx], x) <= 0) { /* Equal. */
+			sibling.bough = branch->child[lo.idx + 1];
+			pT_(stale)(sibling, x); /* Only once: `x` is unique. */
+			if(lo.idx + 1 < lo.bough->size) sibling.bough
+				= branch->child[lo.idx + 2], pT_(stale_edge)(sibling, 0);
+		} else {
+			sibling.bough = branch->child[lo.idx + 1],
+				pT_(stale_edge)(sibling, 0);
+		}
+	}
+}
+/** Recomputes the summary of `sub` if it is stale. All the boughs below a
+ bough that is not stale are also not stale. */
+static void pT_(summary_r)(const struct pT_(subtree) sub) {
+	struct pT_(bough) *const bough = sub.bough;
+	unsigned i;
+	assert(bough && sub.height);
+	if(!bough->stale) return;
+	/* Make sure one has declared <typedef:<pT>identity_fn> `<t>identity`,
+	 <typedef:<pT>augment_fn> `<t>augment`, and <typedef:<pT>merge_fn>
+	 `<t>merge`. */
+	t_(identity)(&bough->summary);
+	for(i = 0; ; i++) {
+		if(sub.height > 1) {
+			struct pT_(subtree) child;
+			child.bough = pT_(as_branch)(bough)->child[i];
+			child.height = sub.height - 1;
+			pT_(summary_r)(child);
+			t_(merge)(&bough->summary, &child.bough->summary);
+		}
+		if(i >= bough->size) break;
+#			ifdef TREE_VALUE
+		t_(augment)(&bough->summary, bough->key[i], bough->value + i);
+#			else
+		t_(augment)(&bough->summary, bough->key[i]);
+#			endif
+	}
+	bough->stale = 0;
+}
+/** Accumulates the entries of `sub` in `[lo, hi]` into `s`. The bits of `open`
+ say that `sub` is already known to be above `lo`, `1`, and below `hi`, `2`. */
+static void pT_(summarize_r)(const struct pT_(subtree) sub,
+	const pT_(key) lo, const pT_(key) hi, const unsigned open,
+	pT_(summary) *const s) {
+	struct pT_(ref) ref;
+	unsigned i0, i1, i;
+	assert(sub.bough && sub.height && s);
+	if(open == 3) {
+		pT_(summary_r)(sub);
+		t_(merge)(s, &sub.bough->summary);
+		return;
+	}
+	ref.bough = sub.bough, ref.height = sub.height;
+	if(!sub.bough->size) { i0 = i1 = 0; } else {
+		if(open & 1) i0 = 0; else pT_(node_lb)(&ref, lo), i0 = ref.idx;
+		if(open & 2) i1 = sub.bough->size;
+		else ref.idx = sub.bough->size, pT_(node_ub)(&ref, hi), i1 = ref.idx;
+	}
+	if(i0 > i1) return; /* `lo > hi`. */
+	for(i = i0; ; i++) {
+		if(sub.height > 1) {
+			struct pT_(subtree) child;
+			child.bough = pT_(as_branch)(sub.bough)->child[i];
+			child.height = sub.height - 1;
+			pT_(summarize_r)(child, lo, hi,
+				open | (i > i0 ? 1 : 0) | (i < i1 ? 2 : 0), s);
+		}
+		if(i >= i1) break;
+#			ifdef TREE_VALUE
+		t_(augment)(s, sub.bough->key[i], sub.bough->value + i);
+#			else
+		t_(augment)(s, sub.bough->key[i]);
+#			endif
+	}
+}
+#		endif
+
 /** Finds exact key `x` in non-empty `tree`. If `node` is found, temporarily,
  the nodes that have `TREE_MIN` keys have
  `as_branch(node).child[TREE_MAX] = parent` or, for leaves, `leaf_parent`,
@@ -460,6 +753,9 @@ no_succ:
 		= chosen.leaf.bough->key[chosen.leaf.idx];
 #		ifdef TREE_VALUE
 	rm.bough->value[rm.idx] = chosen.leaf.bough->value[chosen.leaf.idx];
+#		endif
+#		ifdef TREE_PREFIX
+	rm.bough->prefix[rm.idx] = chosen.leaf.bough->prefix[chosen.leaf.idx];
 #		endif
 	rm = chosen.leaf;
 	if(chosen.leaf.bough->size <= TREE_MIN) parent.bough = chosen.parent;
@@ -512,6 +808,16 @@ balance_less: {
 	memcpy(rm.bough->value, sibling.less->value + more,
 		sizeof *sibling.less->value * transfer);
 	parent.bough->value[parent.idx - 1] = sibling.less->value[promote];
+#		endif
+#		ifdef TREE_PREFIX
+	memmove(rm.bough->prefix + rm.idx + 1 + transfer, rm.bough->prefix + rm.idx + 1,
+		sizeof *rm.bough->prefix * (rm.bough->size - rm.idx - 1));
+	memmove(rm.bough->prefix + transfer + 1, rm.bough->prefix,
+		sizeof *rm.bough->prefix * rm.idx);
+	rm.bough->prefix[transfer] = parent.bough->prefix[parent.idx - 1];
+	memcpy(rm.bough->prefix, sibling.less->prefix + more,
+		sizeof *sibling.less->prefix * transfer);
+	parent.bough->prefix[parent.idx - 1] = sibling.less->prefix[promote];
 #		endif
 	if(rm.height > 1) {
 		struct pT_(branch_bough) *const lessb = pT_(as_branch)(sibling.less),
@@ -556,6 +862,16 @@ balance_less: {
 	parent.bough->value[parent.idx] = sibling.more->value[promote];
 	memmove(sibling.more->value, sibling.more->value + promote + 1,
 		sizeof *sibling.more->value * (sibling.more->size - promote - 1));
+#		endif
+#		ifdef TREE_PREFIX
+	memmove(rm.bough->prefix + rm.idx, rm.bough->prefix + rm.idx + 1,
+		sizeof *rm.bough->prefix * (rm.bough->size - rm.idx - 1));
+	rm.bough->prefix[rm.bough->size - 1] = parent.bough->prefix[parent.idx];
+	memcpy(rm.bough->prefix + rm.bough->size, sibling.more->prefix,
+		sizeof *sibling.more->prefix * promote);
+	parent.bough->prefix[parent.idx] = sibling.more->prefix[promote];
+	memmove(sibling.more->prefix, sibling.more->prefix + promote + 1,
+		sizeof *sibling.more->prefix * (sibling.more->size - promote - 1));
 #		endif
 	if(rm.height > 1) {
 		struct pT_(branch_bough) *const moreb = pT_(as_branch)(sibling.more),
@@ -592,6 +908,14 @@ balance_less: {
 	memcpy(sibling.less->value + sibling.less->size + 1 + rm.idx,
 		rm.bough->value + rm.idx + 1,
 		sizeof *rm.bough->value * (rm.bough->size - rm.idx - 1));
+#		endif
+#		ifdef TREE_PREFIX
+	sibling.less->prefix[sibling.less->size] = parent.bough->prefix[parent.idx];
+	memcpy(sibling.less->prefix + sibling.less->size + 1, rm.bough->prefix,
+		sizeof *rm.bough->prefix * rm.idx);
+	memcpy(sibling.less->prefix + sibling.less->size + 1 + rm.idx,
+		rm.bough->prefix + rm.idx + 1,
+		sizeof *rm.bough->prefix * (rm.bough->size - rm.idx - 1));
 #		endif
 	if(rm.height > 1) { /* The `parent` links will have one less. Copying twice. */
 		struct pT_(branch_bough) *const lessb = pT_(as_branch)(sibling.less),
@@ -626,6 +950,13 @@ merge_more:
 	rm.bough->value[rm.bough->size - 1] = parent.bough->value[parent.idx];
 	memcpy(rm.bough->value + rm.bough->size, sibling.more->value,
 		sizeof *sibling.more->value * sibling.more->size);
+#		endif
+#		ifdef TREE_PREFIX
+	memmove(rm.bough->prefix + rm.idx, rm.bough->prefix + rm.idx + 1,
+		sizeof *rm.bough->prefix * (rm.bough->size - rm.idx - 1));
+	rm.bough->prefix[rm.bough->size - 1] = parent.bough->prefix[parent.idx];
+	memcpy(rm.bough->prefix + rm.bough->size, sibling.more->prefix,
+		sizeof *sibling.more->prefix * sibling.more->size);
 #		endif
 	if(rm.height > 1) { /* The `parent` links will have one less. */
 		struct pT_(branch_bough) *const rmb = pT_(as_branch)(rm.bough),
@@ -663,6 +994,10 @@ space: /* Node is root or has more than `TREE_MIN`; branches taken care of. */
 #		ifdef TREE_VALUE
 	memmove(rm.bough->value + rm.idx, rm.bough->value + rm.idx + 1,
 		sizeof *rm.bough->value * (rm.bough->size - rm.idx - 1));
+#		endif
+#		ifdef TREE_PREFIX
+	memmove(rm.bough->prefix + rm.idx, rm.bough->prefix + rm.idx + 1,
+		sizeof *rm.bough->prefix * (rm.bough->size - rm.idx - 1));
 #		endif
 	if(!--rm.bough->size) {
 		assert(rm.bough == tree->bough);
@@ -676,9 +1011,52 @@ space: /* Node is root or has more than `TREE_MIN`; branches taken care of. */
 	}
 	goto end;
 end:
+#		ifdef TREE_AUGMENT
+	pT_(stale)(*tree, provisional_x);
+#		endif
 	return 1;
 }
 
+#		ifdef TREE_AUGMENT
+/** Visits, in order, the entries of `sub` up to `hi` whose summary `keep`
+ accepts with `param`, pruning sub-trees that it doesn't; `count` is
+ incremented and `visit` is called with the `cur`, which is the cursor on
+ `trunk`. @return Whether it is past `hi`. */
+static int pT_(overlap_r)(const struct pT_(subtree) sub, const pT_(key) hi,
+	const pT_(keep_fn) keep, const pT_(visit_fn) visit, void *const param,
+	struct T_(cursor) *const cur, size_t *const count) {
+	unsigned i;
+	assert(sub.bough && sub.height && keep && cur && count);
+	pT_(summary_r)(sub);
+	if(!keep(&sub.bough->summary, param)) return 0;
+	for(i = 0; ; i++) {
+		pT_(summary) one;
+		if(sub.height > 1) {
+			struct pT_(subtree) child;
+			child.bough = pT_(as_branch)(sub.bough)->child[i];
+			child.height = sub.height - 1;
+			if(pT_(overlap_r)(child, hi, keep, visit, param, cur, count))
+				return 1;
+		}
+		if(i >= sub.bough->size) break;
+		if(t_(less)(sub.bough->key[i], hi) > 0) return 1;
+		t_(identity)(&one);
+#			ifdef TREE_VALUE
+		t_(augment)(&one, sub.bough->key[i], sub.bough->value + i);
+#			else
+		t_(augment)(&one, sub.bough->key[i]);
+#			endif
+		if(!keep(&one, param)) continue;
+		(*count)++;
+		if(!visit) continue;
+		cur->ref.bough = sub.bough, cur->ref.height = sub.height,
+			cur->ref.idx = i;
+		visit(cur, param);
+	}
+	return 0;
+}
+#		endif
+
 /** Private: frees non-empty `sub` and it's children recursively.
  @param[keep] Keep one leaf-bough if non-null (**); set the pointer to null
  before calling it (*). */
@@ -807,9 +1185,15 @@ descend: /* Record last node that has space. */
 			if(eject) {
 				*eject = add.bough->key[add.idx];
 				add.bough->key[add.idx] = key;
+#		ifdef TREE_PREFIX
+				add.bough->prefix[add.idx] = t_(prefix)(key);
+#		endif
 			}
 #		ifdef TREE_VALUE
 			if(value) *value = pT_(ref_to_valuep)(add);
+#		endif
+#		ifdef TREE_AUGMENT
+			pT_(stale)(*trunk, key);
 #		endif
 			return TREE_PRESENT;
 		}
@@ -822,11 +1206,21 @@ insert: /* Leaf has space to spare; usually end up here. */
 #		ifdef TREE_VALUE
 	memmove(add.bough->value + add.idx + 1, add.bough->value + add.idx,
 		sizeof *add.bough->value * (add.bough->size - add.idx));
+#		endif
+#		ifdef TREE_PREFIX
+	memmove(add.bough->prefix + add.idx + 1, add.bough->prefix + add.idx,
+		sizeof *add.bough->prefix * (add.bough->size - add.idx));
 #		endif
 	add.bough->size++;
 	add.bough->key[add.idx] = key;
+#		ifdef TREE_PREFIX
+	add.bough->prefix[add.idx] = t_(prefix)(key);
+#		endif
 #		ifdef TREE_VALUE
 	if(value) *value = pT_(ref_to_valuep)(add);
+#		endif
+#		ifdef TREE_AUGMENT
+	pT_(stale)(*trunk, key);
 #		endif
 	return TREE_ABSENT;
 grow: /* Leaf is full. */ {
@@ -851,6 +1245,10 @@ grow: /* Leaf is full. */ {
 #		ifdef TREE_VALUE
 		memmove(hole.bough->value + hole.idx + 1, hole.bough->value + hole.idx,
 			sizeof *hole.bough->value * (hole.bough->size - hole.idx));
+#		endif
+#		ifdef TREE_PREFIX
+		memmove(hole.bough->prefix + hole.idx + 1, hole.bough->prefix + hole.idx,
+			sizeof *hole.bough->prefix * (hole.bough->size - hole.idx));
 #		endif
 		memmove(holeb->child + hole.idx + 2, holeb->child + hole.idx + 1,
 			sizeof *holeb->child * (hole.bough->size - hole.idx));
@@ -881,10 +1279,17 @@ grow: /* Leaf is full. */ {
 #		ifdef TREE_VALUE
 		memcpy(sibling->value, cur.bough->value + TREE_SPLIT,
 			sizeof *sibling->value * (TREE_MAX - TREE_SPLIT));
+#		endif
+#		ifdef TREE_PREFIX
+		memcpy(sibling->prefix, cur.bough->prefix + TREE_SPLIT,
+			sizeof *sibling->prefix * (TREE_MAX - TREE_SPLIT));
 #		endif
 		hole.bough->key[hole.idx] = cur.bough->key[TREE_SPLIT - 1];
 #		ifdef TREE_VALUE
 		hole.bough->value[hole.idx] = cur.bough->value[TREE_SPLIT - 1];
+#		endif
+#		ifdef TREE_PREFIX
+		hole.bough->prefix[hole.idx] = cur.bough->prefix[TREE_SPLIT - 1];
 #		endif
 		memmove(cur.bough->key + cur.idx + 1,
 			cur.bough->key + cur.idx,
@@ -893,6 +1298,11 @@ grow: /* Leaf is full. */ {
 		memmove(cur.bough->value + cur.idx + 1,
 			cur.bough->value + cur.idx,
 			sizeof *cur.bough->value * (TREE_SPLIT - 1 - cur.idx));
+#		endif
+#		ifdef TREE_PREFIX
+		memmove(cur.bough->prefix + cur.idx + 1,
+			cur.bough->prefix + cur.idx,
+			sizeof *cur.bough->prefix * (TREE_SPLIT - 1 - cur.idx));
 #		endif
 		if(cur.height > 1) {
 			struct pT_(branch_bough) *const cb = pT_(as_branch)(cur.bough),
@@ -909,6 +1319,9 @@ grow: /* Leaf is full. */ {
 		hole.bough->key[hole.idx] = cur.bough->key[TREE_SPLIT];
 #		ifdef TREE_VALUE
 		hole.bough->value[hole.idx] = cur.bough->value[TREE_SPLIT];
+#		endif
+#		ifdef TREE_PREFIX
+		hole.bough->prefix[hole.idx] = cur.bough->prefix[TREE_SPLIT];
 #		endif
 		hole.bough = sibling, hole.height = cur.height,
 			hole.idx = cur.idx - TREE_SPLIT - 1;
@@ -921,6 +1334,12 @@ grow: /* Leaf is full. */ {
 			sizeof *sibling->value * hole.idx);
 		memcpy(sibling->value + hole.idx + 1, cur.bough->value
 			+ cur.idx, sizeof *sibling->value * (TREE_MAX - cur.idx));
+#		endif
+#		ifdef TREE_PREFIX
+		memcpy(sibling->prefix, cur.bough->prefix + TREE_SPLIT + 1,
+			sizeof *sibling->prefix * hole.idx);
+		memcpy(sibling->prefix + hole.idx + 1, cur.bough->prefix
+			+ cur.idx, sizeof *sibling->prefix * (TREE_MAX - cur.idx));
 #		endif
 		if(cur.height > 1) {
 			struct pT_(branch_bough) *const cb = pT_(as_branch)(cur.bough),
@@ -938,6 +1357,10 @@ grow: /* Leaf is full. */ {
 #		ifdef TREE_VALUE
 		memcpy(sibling->value, cur.bough->value + TREE_SPLIT,
 			sizeof *sibling->value * (TREE_MAX - TREE_SPLIT));
+#		endif
+#		ifdef TREE_PREFIX
+		memcpy(sibling->prefix, cur.bough->prefix + TREE_SPLIT,
+			sizeof *sibling->prefix * (TREE_MAX - TREE_SPLIT));
 #		endif
 		if(cur.height > 1) {
 			struct pT_(branch_bough) *const cb = pT_(as_branch)(cur.bough),
@@ -950,10 +1373,16 @@ grow: /* Leaf is full. */ {
 	cur.bough->size = TREE_SPLIT, sibling->size = TREE_MAX - TREE_SPLIT;
 	if(cur.height > 1) goto split; /* Loop max `\log_{TREE_MIN} size`. */
 	hole.bough->key[hole.idx] = key;
+#		ifdef TREE_PREFIX
+	hole.bough->prefix[hole.idx] = t_(prefix)(key);
+#		endif
 #		ifdef TREE_VALUE
 	if(value) *value = pT_(ref_to_valuep)(hole);
 #		endif
 	assert(!new_head);
+#		ifdef TREE_AUGMENT
+	pT_(stale)(*trunk, key);
+#		endif
 	return TREE_ABSENT;
 } catch: /* Didn't work. Reset. */
 	while(new_head) {
@@ -1050,6 +1479,264 @@ static struct pT_(subtree) pT_(clone)(const struct pT_(subtree) *const src,
 	return sub;
 }
 
+#		ifdef TREE_PARALLEL /* <!-- parallel */
+/* A sub-tree that is a unit of work for a thread; `at` is the offset in the
+ scaffold of branches and leaves. */
+struct pT_(job) { struct pT_(subtree) sub; struct tree_node_count no, at; };
+enum pT_(task) { pT_(COUNT), pT_(ALLOCATE), pT_(CLONE), pT_(CLEAR) };
+/* The work that a thread does on `[begin, end)` of `job` or `sc->data`. */
+struct pT_(work) {
+	enum pT_(task) task;
+	struct pT_(job) *job;
+	size_t begin, end;
+	struct pT_(scaffold) *sc;
+	struct pT_(bough) **keep;
+	int is_error;
+	pthread_t thread;
+};
+/** Does the `param` work. Thread entry point. */
+static void *pT_(work)(void *const param) {
+	struct pT_(work) *const w = param;
+	size_t i;
+	switch(w->task) {
+	case pT_(COUNT):
+		for(i = w->begin; i < w->end; i++) {
+			struct pT_(job) *const job = w->job + i;
+			job->no.branches = job->no.leaves = 0;
+			if(!pT_(nodes_r)(job->sub, &job->no)) { w->is_error = 1; break; }
+		}
+		break;
+	case pT_(ALLOCATE):
+		for(i = w->begin; i < w->end; i++) {
+			if(w->sc->data + i < w->sc->leaf.head) {
+				struct pT_(branch_bough) *branch;
+				if(!(branch = malloc(sizeof *branch)))
+					{ w->is_error = 1; break; }
+				branch->base.size = 0;
+				branch->child[0] = 0;
+				w->sc->data[i] = &branch->base;
+			} else {
+				struct pT_(bough) *leaf;
+				if(!(leaf = malloc(sizeof *leaf))) { w->is_error = 1; break; }
+				leaf->size = 0;
+				w->sc->data[i] = leaf;
+			}
+		}
+		break;
+	case pT_(CLONE):
+		for(i = w->begin; i < w->end; i++) {
+			struct pT_(job) *const job = w->job + i;
+			struct pT_(scaffold) sc = *w->sc;
+			sc.branch.iterator = sc.branch.head + job->at.branches;
+			sc.leaf.iterator = sc.leaf.head + job->at.leaves;
+			pT_(clone_r)(job->sub, &sc);
+		}
+		break;
+	case pT_(CLEAR):
+		for(i = w->begin; i < w->end; i++)
+			pT_(clear_r)(w->job[i].sub, i ? 0 : w->keep);
+		break;
+	}
+	return 0;
+}
+/** Splits `[0, size)` of `task` evenly between `threads` copies of `w` and
+ waits for them. If a thread can not be started, the work is done in this
+ one. @return Success of all the work. */
+static int pT_(parallel)(struct pT_(work) *const w, const unsigned threads,
+	const size_t size) {
+	unsigned t;
+	int is_error = 0;
+	assert(w && threads);
+	for(t = 0; t < threads; t++) {
+		w[t] = w[0];
+		w[t].begin = size * t / threads, w[t].end = size * (t + 1) / threads;
+		w[t].is_error = 0;
+	}
+	for(t = 1; t < threads; t++) if(pthread_create(&w[t].thread, 0,
+		&pT_(work), w + t)) pT_(work)(w + t), w[t].end = w[t].begin;
+	pT_(work)(w);
+	for(t = 1; t < threads; t++) {
+		if(w[t].end != w[t].begin) pthread_join(w[t].thread, 0);
+		if(w[t].is_error) is_error = 1;
+	}
+	return !is_error && !w->is_error;
+}
+/** Collects the sub-trees at the first depth of `trunk` that have at least
+ `want` boughs, as long as they are branches, in order. `trunk` has height of
+ at least two. @return The sub-trees, or null. The number is in `size`, at
+ `depth` below `upper` branches. */
+static struct pT_(job) *pT_(frontier)(const struct pT_(subtree) trunk,
+	const size_t want, size_t *const size, unsigned *const depth,
+	size_t *const upper) {
+	struct pT_(job) *front, *next;
+	size_t i, j, n;
+	assert(trunk.bough && trunk.height > 1 && size && depth && upper);
+	if(!(front = malloc(sizeof *front))) return 0;
+	front->sub = trunk, *size = 1, *depth = 0, *upper = 0;
+	while(*size < want && front->sub.height > 2) {
+		for(n = 0, i = 0; i < *size; i++) n += front[i].sub.bough->size + 1;
+		if(!(next = malloc(sizeof *next * n))) { free(front); return 0; }
+		for(j = 0, i = 0; i < *size; i++) {
+			const struct pT_(subtree) s = front[i].sub;
+			unsigned c;
+			for(c = 0; c <= s.bough->size; c++, j++)
+				next[j].sub.bough = pT_(as_branch)(s.bough)->child[c],
+				next[j].sub.height = s.height - 1;
+		}
+		*upper += *size;
+		free(front), front = next, *size = n, ++*depth;
+	}
+	return front;
+}
+/** Copies the boughs of `src` down to `depth`, in the pre-order of
+ <fn:<pT>clone_r>, from `sc`, and gives the `job` their position. */
+static struct pT_(bough) *pT_(clone_upper_r)(const struct pT_(subtree) src,
+	const unsigned depth, struct pT_(scaffold) *const sc,
+	struct pT_(job) **const job) {
+	struct pT_(bough) *node;
+	if(!depth) {
+		struct pT_(job) *const j = (*job)++;
+		assert(j->sub.bough == src.bough && src.height > 1);
+		j->at.branches = (size_t)(sc->branch.iterator - sc->branch.head);
+		j->at.leaves = (size_t)(sc->leaf.iterator - sc->leaf.head);
+		node = *sc->branch.iterator;
+		sc->branch.iterator += j->no.branches;
+		sc->leaf.iterator += j->no.leaves;
+	} else {
+		struct pT_(branch_bough) *const srcb = pT_(as_branch)(src.bough),
+			*const branch = pT_(as_branch)(node = *sc->branch.iterator++);
+		struct pT_(subtree) child;
+		unsigned i;
+		*node = *src.bough;
+		child.height = src.height - 1;
+		for(i = 0; i <= src.bough->size; i++) {
+			child.bough = srcb->child[i];
+			branch->child[i] = pT_(clone_upper_r)(child, depth - 1, sc, job);
+		}
+	}
+	return node;
+}
+/** Frees the branches of `sub` down to, but not including, `depth`. */
+static void pT_(free_upper_r)(const struct pT_(subtree) sub,
+	const unsigned depth) {
+	struct pT_(subtree) child;
+	unsigned i;
+	if(!depth) return;
+	child.height = sub.height - 1;
+	for(i = 0; i <= sub.bough->size; i++)
+		child.bough = pT_(as_branch)(sub.bough)->child[i],
+		pT_(free_upper_r)(child, depth - 1);
+	free(pT_(as_branch)(sub.bough));
+}
+/** Private: frees non-empty `tree` with `threads` as <fn:<pT>clear_r>;
+ `keep` as that function. @return Success; otherwise, nothing happened. */
+static int pT_(parallel_clear)(const struct pT_(subtree) tree,
+	struct pT_(bough) **const keep, const unsigned threads) {
+	struct pT_(work) *work = 0;
+	struct pT_(job) *job = 0;
+	size_t size, upper;
+	unsigned depth;
+	int success = 0;
+	if(!(work = malloc(sizeof *work * threads)) || !(job
+		= pT_(frontier)(tree, 4 * threads, &size, &depth, &upper))) goto catch;
+	work->task = pT_(CLEAR), work->job = job, work->keep = keep, work->sc = 0;
+	pT_(parallel)(work, threads < size ? threads : (unsigned)size, size);
+	pT_(free_upper_r)(tree, depth);
+	success = 1;
+catch:
+	free(job), free(work);
+	return success;
+}
+#		endif /* parallel --> */
+
+#		ifdef TREE_IMAGE /* <!-- image */
+/** Writes `sub` to `fp` in post-order, so every child is before its parent.
+ `next` is the page number. @return Success. The page number of `sub` is
+ stored in `page_no`. */
+static int pT_(image_save_r)(const struct pT_(subtree) sub, FILE *const fp,
+	size_t *const next, size_t *const page_no) {
+	union pT_(image_page) p;
+	struct pT_(bough) *const b = &p.page.bough;
+	assert(sub.bough && sub.height && fp && next && page_no);
+	memset(&p, 0, sizeof p); /* Don't write uninitialized memory. */
+	if(sub.height > 1) {
+		struct pT_(subtree) child;
+		unsigned i;
+		child.height = sub.height - 1;
+		for(i = 0; i <= sub.bough->size; i++) {
+			child.bough = pT_(as_branch_c)(sub.bough)->child[i];
+			if(!pT_(image_save_r)(child, fp, next, p.page.child + i)) return 0;
+		}
+	}
+	b->size = sub.bough->size;
+	memcpy(b->key, sub.bough->key, sizeof *b->key * b->size);
+#			ifdef TREE_VALUE
+	memcpy(b->value, sub.bough->value, sizeof *b->value * b->size);
+#			endif
+#			ifdef TREE_PREFIX
+	memcpy(b->prefix, sub.bough->prefix, sizeof *b->prefix * b->size);
+#			endif
+	if(fwrite(&p, sizeof p, 1, fp) != 1) return 0;
+	*page_no = (*next)++;
+	return 1;
+}
+/** Checks the sub-tree of `height` at page `no` of `image`, where `left` is
+ the number of pages not checked. The pages are in post-order, so going from
+ the root, then the children from the right, has to meet every page in order
+ from the last. @return Whether it is an image. */
+static int pT_(image_valid_r)(const struct T_(image) *const image,
+	const size_t no, const unsigned height, size_t *const left) {
+	const struct pT_(page) *const page = &image->page[no].page;
+	unsigned i;
+	assert(image && height && left);
+	if(!*left || no != *left - 1 || page->bough.size > TREE_MAX) return 0;
+	--*left;
+	if(height > 1) for(i = page->bough.size + 1; i; i--)
+		if(!*left || page->child[i - 1] != *left - 1
+		|| !pT_(image_valid_r)(image, page->child[i - 1], height - 1, left))
+		return 0;
+	return 1;
+}
+/** @return The child `idx` of `bough`, which is a branch in `image`. */
+static struct pT_(bough) *pT_(image_child)(const struct T_(image) *const image,
+	const struct pT_(bough) *const bough, const unsigned idx) {
+	/* The bough is at the start of the page. */
+	const size_t no = ((const struct pT_(page) *)(const void *)bough)->child[idx];
+	union { const struct pT_(bough) *readonly; struct pT_(bough) *promise; } sly;
+	assert(image && bough && idx <= bough->size && no < image->pages);
+	sly.readonly = &image->page[no].page.bough;
+	return sly.promise; /* We only read it, but share <fn:<pT>node_lb>. */
+}
+/** <fn:<pT>image_child> with `source` an image.
+ @implements <typedef:<pT>child_fn> */
+static struct pT_(bough) *pT_(image_source_child)(const void *const source,
+	const struct pT_(bough) *const bough, const unsigned idx)
+	{ return pT_(image_child)(source, bough, idx); }
+/** @return The trunk of `image`, or an empty subtree. */
+static struct pT_(subtree) pT_(image_trunk)(const struct T_(image) *const
+	image) {
+	struct pT_(subtree) trunk;
+	trunk.bough = image->trunk.bough;
+	trunk.height = trunk.bough ? image->trunk.height : 0;
+	return trunk;
+}
+/** <fn:<pT>more_in> in `image`. */
+static struct pT_(ref) pT_(image_more)(const struct T_(image) *const image,
+	const pT_(key) x) { return pT_(more_in)(pT_(image_trunk)(image), x,
+	&pT_(image_source_child), image); }
+/** <fn:<pT>less_in> in `image`. */
+static struct pT_(ref) pT_(image_less)(const struct T_(image) *const image,
+	const pT_(key) x) { return pT_(less_in)(pT_(image_trunk)(image), x,
+	&pT_(image_source_child), image); }
+/** <fn:<pT>lookup_find> in `image`. */
+static struct pT_(ref) pT_(image_find)(const struct T_(image) *const image,
+	const pT_(key) x) {
+	struct pT_(ref) lo = pT_(image_more)(image, x);
+	if(lo.bough && t_(less)(lo.bough->key[lo.idx], x) > 0) lo.bough = 0;
+	return lo;
+}
+#		endif /* image --> */
+
 #		define BOX_PUBLIC_OVERRIDE
 #		include "box.h"
 
@@ -1332,6 +2019,9 @@ static enum tree_result T_(bulk_add)(struct t_(tree) *const tree, pT_(key) key)
 				max_ref.bough = last, max_ref.idx = last->size - 1;
 				*put_value_here = pT_(ref_to_valuep)(max_ref);
 			}
+#		endif
+#		ifdef TREE_AUGMENT
+			pT_(stale)(tree->trunk, key);
 #		endif
 			return TREE_PRESENT;
 		}
@@ -1371,6 +2061,9 @@ static enum tree_result T_(bulk_add)(struct t_(tree) *const tree, pT_(key) key)
 	}
 	assert(bough && bough->size < TREE_MAX);
 	bough->key[bough->size] = key;
+#		ifdef TREE_PREFIX
+	bough->prefix[bough->size] = t_(prefix)(key);
+#		endif
 #		ifdef TREE_VALUE
 	if(put_value_here) {
 		struct pT_(ref) max_ref;
@@ -1379,6 +2072,9 @@ static enum tree_result T_(bulk_add)(struct t_(tree) *const tree, pT_(key) key)
 	}
 #		endif
 	bough->size++;
+#		ifdef TREE_AUGMENT
+	pT_(stale)(tree->trunk, key);
+#		endif
 	return TREE_ABSENT;
 catch: /* Didn't work. Reset. */
 	free(bough);
@@ -1409,6 +2105,9 @@ static int T_(bulk_finish)(struct t_(tree) *const tree) {
 		struct pT_(bough) *sibling = (assert(parent->base.size),
 			parent->child[parent->base.size - 1]);
 		right = parent->child[parent->base.size];
+#		ifdef TREE_AUGMENT
+		s.bough->stale = sibling->stale = right->stale = 1;
+#		endif
 		/* Should this be increased to max/2 instead of max/3 to make a more
 		 balanced tree? Otoh, why? */
 		if(TREE_MIN <= right->size) continue; /* Has enough. */
@@ -1428,6 +2127,10 @@ static int T_(bulk_finish)(struct t_(tree) *const tree) {
 #		ifdef TREE_VALUE
 		memmove(right->value + right_move, right->value,
 			sizeof *right->value * right->size);
+#		endif
+#		ifdef TREE_PREFIX
+		memmove(right->prefix + right_move, right->prefix,
+			sizeof *right->prefix * right->size);
 #		endif
 		if(s.height > 2) { /* (Parent height.) */
 			struct pT_(branch_bough) *rbranch = pT_(as_branch)(right),
@@ -1444,6 +2147,10 @@ static int T_(bulk_finish)(struct t_(tree) *const tree) {
 #		ifdef TREE_VALUE
 		memcpy(right->value + take_sibling,
 			parent->base.value + parent->base.size - 1, sizeof *right->value);
+#		endif
+#		ifdef TREE_PREFIX
+		memcpy(right->prefix + take_sibling,
+			parent->base.prefix + parent->base.size - 1, sizeof *right->prefix);
 #		endif
 		/* Move the others from the sibling. */
 		memcpy(right->key, sibling->key + sibling->size - take_sibling,
@@ -1451,6 +2158,10 @@ static int T_(bulk_finish)(struct t_(tree) *const tree) {
 #		ifdef TREE_VALUE
 		memcpy(right->value, sibling->value + sibling->size - take_sibling,
 			sizeof *right->value * take_sibling);
+#		endif
+#		ifdef TREE_PREFIX
+		memcpy(right->prefix, sibling->prefix + sibling->size - take_sibling,
+			sizeof *right->prefix * take_sibling);
 #		endif
 		sibling->size -= take_sibling;
 		/* Sibling's key is now the parent's. */
@@ -1459,6 +2170,10 @@ static int T_(bulk_finish)(struct t_(tree) *const tree) {
 #		ifdef TREE_VALUE
 		memcpy(parent->base.value + parent->base.size - 1,
 			sibling->value + sibling->size - 1, sizeof *right->value);
+#		endif
+#		ifdef TREE_PREFIX
+		memcpy(parent->base.prefix + parent->base.size - 1,
+			sibling->prefix + sibling->size - 1, sizeof *right->prefix);
 #		endif
 		sibling->size--;
 	}
@@ -1591,6 +2306,755 @@ finally:
 	return success;
 }
 
+#		ifdef TREE_PARALLEL /* <!-- parallel */
+/** Only with `TREE_PARALLEL`. Equivalent to <fn:<T>clone>, but the work is
+ split between up to `threads` POSIX threads at the first level of branches
+ that has enough sub-trees. Instead of re-using the boughs of `tree`, new
+ boughs are allocated and the old ones freed, both in parallel.
+ @return Success, otherwise `tree` is not modified. @throws[malloc]
+ @throws[EDOM] `tree` is null. @throws[ERANGE] The size of `source` nodes
+ doesn't fit into `size_t`.
+ @order \O((|`source`| + |`tree`|) / `threads`) @allow */
+static int T_(parallel_clone)(struct t_(tree) *const restrict tree,
+	const struct t_(tree) *const restrict source, const unsigned threads) {
+	struct pT_(scaffold) sc;
+	struct pT_(work) *work = 0;
+	struct pT_(job) *job = 0, *j;
+	size_t size, upper, i;
+	unsigned depth, t;
+	int success = 1;
+	sc.data = 0;
+	if(!tree) { errno = EDOM; goto catch; }
+	/* Small trees are not worth it. */
+	if(threads <= 1 || !source || source->trunk.height < 3)
+		return T_(clone)(tree, source);
+	if(!(work = malloc(sizeof *work * threads)) || !(job = pT_(frontier)
+		(source->trunk, 4 * threads, &size, &depth, &upper))) goto catch;
+	t = threads < size ? threads : (unsigned)size;
+	/* Count the sub-trees. */
+	work->task = pT_(COUNT), work->job = job, work->keep = 0, work->sc = &sc;
+	if(!pT_(parallel)(work, t, size)) { errno = ERANGE; goto catch; }
+	for(sc.source.branches = upper, sc.source.leaves = 0, i = 0; i < size; i++) {
+		if(sc.source.branches + job[i].no.branches < sc.source.branches
+			|| sc.source.leaves + job[i].no.leaves < sc.source.leaves)
+			{ errno = ERANGE; goto catch; }
+		sc.source.branches += job[i].no.branches;
+		sc.source.leaves += job[i].no.leaves;
+	}
+	if((sc.no = sc.source.branches + sc.source.leaves) < sc.source.branches)
+		{ errno = ERANGE; goto catch; }
+	if(!(sc.data = malloc(sizeof *sc.data * sc.no))) goto catch;
+	for(i = 0; i < sc.no; i++) sc.data[i] = 0;
+	sc.branch.head = sc.data, sc.leaf.head = sc.data + sc.source.branches;
+	/* Allocate all the boughs. */
+	work->task = pT_(ALLOCATE);
+	if(!pT_(parallel)(work, threads < sc.no ? threads : (unsigned)sc.no, sc.no))
+		goto catch;
+	/* Resources acquired; now we don't care about tree. */
+	if(!tree->trunk.bough) { /* Idle. */
+	} else if(!tree->trunk.height) { /* Empty. */
+		free(tree->trunk.bough);
+	} else if(tree->trunk.height < 3
+		|| !pT_(parallel_clear)(tree->trunk, 0, threads)) {
+		pT_(clear_r)(tree->trunk, 0);
+	}
+	/* Lay out the top and fill in the sub-trees. */
+	sc.branch.iterator = sc.branch.head, sc.leaf.iterator = sc.leaf.head, j = job;
+	tree->trunk.bough = pT_(clone_upper_r)(source->trunk, depth, &sc, &j);
+	tree->trunk.height = source->trunk.height;
+	assert(j == job + size && sc.branch.iterator == sc.leaf.head
+		&& sc.leaf.iterator == sc.data + sc.no);
+	work->task = pT_(CLONE);
+	pT_(parallel)(work, t, size);
+	goto finally;
+catch:
+	success = 0;
+	if(!errno) errno = ERANGE; /* Non-POSIX OSs not mandated to set errno. */
+	if(sc.data) for(i = 0; i < sc.no; i++) {
+		if(!sc.data[i]) continue;
+		if(sc.data + i < sc.leaf.head) free(pT_(as_branch)(sc.data[i]));
+		else free(sc.data[i]);
+	}
+finally:
+	free(sc.data), free(job), free(work);
+	return success;
+}
+
+/** Only with `TREE_PARALLEL`. Equivalent to <fn:<T>clear>, but the boughs are
+ freed by up to `threads` POSIX threads. Use <fn:<t>tree_> after to also free
+ the last bough. @order \O(|`tree`| / `threads`) @allow */
+static void T_(parallel_clear)(struct t_(tree) *const tree,
+	const unsigned threads) {
+	struct pT_(bough) *lazy = 0;
+	assert(tree);
+	if(threads <= 1 || tree->trunk.height < 3
+		|| !pT_(parallel_clear)(tree->trunk, &lazy, threads))
+		{ pT_(clear)(tree); return; }
+	assert(lazy);
+	tree->trunk.bough = lazy;
+	tree->trunk.height = 0;
+}
+#		endif /* parallel --> */
+
+#		define BOX_PRIVATE_AGAIN
+#		include "box.h"
+/* Which keys of two trees are kept in a merge. */
+enum pT_(algebra) { pT_(UNION), pT_(INTERSECTION), pT_(DIFFERENCE) };
+/** @return A cursor in `tree`, (which can be null,) that is on the smallest
+ key greater-than-or-equal-to `lo`, or, if `lo` is null, at the start. */
+static struct T_(cursor) pT_(cursor_from)(const struct t_(tree) *const tree,
+	const pT_(key) *const lo) {
+	struct T_(cursor) cur;
+	if(!tree) { cur.trunk = 0, cur.ref.bough = 0; return cur; }
+	cur = T_(begin)(tree);
+	if(lo && !(cur.ref = pT_(more)(tree->trunk, *lo)).bough) cur.trunk = 0;
+	return cur;
+}
+/** @return Whether `cur` exists and is less than `hi`, (null is unbounded.) */
+static int pT_(cursor_below)(struct T_(cursor) *const cur,
+	const pT_(key) *const hi) {
+	return T_(exists)(cur) && (!hi || t_(less)(*hi, T_(key)(cur)) > 0);
+}
+/** Appends the key at `cur` to the right of `tree` in bulk. @return Success.
+ @throws[malloc] */
+static int pT_(append)(struct t_(tree) *const tree,
+	const struct T_(cursor) *const cur) {
+#		ifdef TREE_VALUE
+	pT_(value) *v;
+	if(!T_(bulk_assign)(tree, T_(key)(cur), &v)) return 0;
+	*v = *T_(value)(cur);
+	return 1;
+#		else
+	return !!T_(bulk_add)(tree, T_(key)(cur));
+#		endif
+}
+/** Walks `a` and `b` together over the keys in `[lo, hi)`, (null is
+ unbounded,) and appends to `result` in bulk the ones that `op` keeps. Where a
+ key is in both, the value is from `a`. Needs <fn:<T>bulk_finish> after.
+ @return Success. @throws[malloc] */
+static int pT_(merge)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b,
+	const pT_(key) *const lo, const pT_(key) *const hi,
+	const enum pT_(algebra) op) {
+	struct T_(cursor) ca = pT_(cursor_from)(a, lo), cb = pT_(cursor_from)(b, lo);
+	int in_a = pT_(cursor_below)(&ca, hi), in_b = pT_(cursor_below)(&cb, hi);
+	assert(result && result != a && result != b);
+	while(in_a || in_b) {
+		const struct T_(cursor) *keep = 0;
+		int next_a = 0, next_b = 0;
+		if(!in_a && op != pT_(UNION) || !in_b && op == pT_(INTERSECTION)) break;
+		if(!in_b || in_a && t_(less)(T_(key)(&cb), T_(key)(&ca)) > 0) {
+			if(op != pT_(INTERSECTION)) keep = &ca; /* Only in `a`. */
+			next_a = 1;
+		} else if(!in_a || t_(less)(T_(key)(&ca), T_(key)(&cb)) > 0) {
+			if(op == pT_(UNION)) keep = &cb; /* Only in `b`. */
+			next_b = 1;
+		} else {
+			if(op != pT_(DIFFERENCE)) keep = &ca; /* In both. */
+			next_a = next_b = 1;
+		}
+		if(keep && !pT_(append)(result, keep)) return 0;
+		if(next_a) T_(next)(&ca), in_a = pT_(cursor_below)(&ca, hi);
+		if(next_b) T_(next)(&cb), in_b = pT_(cursor_below)(&cb, hi);
+	}
+	return 1;
+}
+/** Replaces the contents of `result` with `a` `op` `b`. @return Success,
+ otherwise `result` is empty. @throws[malloc] */
+static int pT_(algebra)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b,
+	const enum pT_(algebra) op) {
+	int success;
+	assert(result && result != a && result != b);
+	pT_(clear)(result);
+	success = pT_(merge)(result, a, b, 0, 0, op);
+	T_(bulk_finish)(result);
+	if(!success) pT_(clear)(result);
+	return success;
+}
+#		ifdef TREE_PARALLEL /* <!-- parallel */
+/** Moves `n` keys, with their values and prefixes, from `s` of `src` to `d` of
+ `dst`; they may overlap. */
+static void pT_(move)(struct pT_(bough) *const dst, const unsigned d,
+	const struct pT_(bough) *const src, const unsigned s, const unsigned n) {
+	memmove(dst->key + d, src->key + s, sizeof *dst->key * n);
+#			ifdef TREE_VALUE
+	memmove(dst->value + d, src->value + s, sizeof *dst->value * n);
+#			endif
+#			ifdef TREE_PREFIX
+	memmove(dst->prefix + d, src->prefix + s, sizeof *dst->prefix * n);
+#			endif
+}
+/** Moves `n` children from `s` of `src` to `d` of `dst`, which are branches;
+ they may overlap. */
+static void pT_(move_child)(struct pT_(bough) *const dst, const unsigned d,
+	struct pT_(bough) *const src, const unsigned s, const unsigned n) {
+	memmove(pT_(as_branch)(dst)->child + d, pT_(as_branch)(src)->child + s,
+		sizeof *pT_(as_branch)(dst)->child * n);
+}
+/** Puts the key in `carry` at `idx` of `bough` at `height`, and, in a branch,
+ `child` at `cidx`, which is `idx` or one more. If `bough` is full, its upper
+ half goes in the empty `sibling`, and the key between the halves in `carry`.
+ @return Whether it split. */
+static int pT_(insert_split)(struct pT_(bough) *const bough,
+	const unsigned height, const unsigned idx, struct pT_(bough) *const carry,
+	struct pT_(bough) *const child, const unsigned cidx,
+	struct pT_(bough) *const sibling) {
+	assert(bough && idx <= bough->size && carry && (height <= 1
+		|| child && (cidx == idx || cidx == idx + 1)));
+	if(bough->size < TREE_MAX) {
+		pT_(move)(bough, idx + 1, bough, idx, bough->size - idx);
+		pT_(move)(bough, idx, carry, 0, 1);
+		if(height > 1) {
+			pT_(move_child)(bough, cidx + 1, bough, cidx, bough->size + 1 - cidx);
+			pT_(as_branch)(bough)->child[cidx] = child;
+		}
+		bough->size++;
+		return 0;
+	}
+	assert(sibling);
+	if(idx <= TREE_SPLIT) {
+		pT_(move)(sibling, 0, bough, TREE_SPLIT, TREE_MAX - TREE_SPLIT);
+		if(idx < TREE_SPLIT) {
+			pT_(move)(bough, idx + 1, bough, idx, TREE_SPLIT - idx);
+			pT_(move)(bough, idx, carry, 0, 1);
+			pT_(move)(carry, 0, bough, TREE_SPLIT, 1);
+		}
+	} else {
+		const unsigned lower = idx - TREE_SPLIT - 1;
+		pT_(move)(sibling, 0, bough, TREE_SPLIT + 1, lower);
+		pT_(move)(sibling, lower, carry, 0, 1);
+		pT_(move)(sibling, lower + 1, bough, idx, TREE_MAX - idx);
+		pT_(move)(carry, 0, bough, TREE_SPLIT, 1);
+	}
+	if(height > 1) {
+		if(cidx <= TREE_SPLIT) {
+			pT_(move_child)(sibling, 0, bough, TREE_SPLIT,
+				TREE_ORDER - TREE_SPLIT);
+			pT_(move_child)(bough, cidx + 1, bough, cidx, TREE_SPLIT - cidx);
+			pT_(as_branch)(bough)->child[cidx] = child;
+		} else {
+			const unsigned lower = cidx - TREE_SPLIT - 1;
+			pT_(move_child)(sibling, 0, bough, TREE_SPLIT + 1, lower);
+			pT_(as_branch)(sibling)->child[lower] = child;
+			pT_(move_child)(sibling, lower + 1, bough, cidx, TREE_ORDER - cidx);
+		}
+	}
+	bough->size = TREE_SPLIT, sibling->size = TREE_MAX - TREE_SPLIT;
+	return 1;
+}
+/** Evens out the children `i` and `i + 1` of the branch `parent`, which are at
+ `height` and have more than `TREE_MAX` keys between them, through the key `i`,
+ so both have at least `TREE_MIN`. */
+static void pT_(even)(struct pT_(bough) *const parent, const unsigned i,
+	const unsigned height) {
+	struct pT_(bough) *const l = pT_(as_branch)(parent)->child[i],
+		*const r = pT_(as_branch)(parent)->child[i + 1];
+	const unsigned a = (l->size + r->size) / 2;
+	unsigned m;
+	assert(i < parent->size && l->size + r->size >= TREE_MAX);
+	if(l->size < a) {
+		m = a - l->size;
+		pT_(move)(l, l->size, parent, i, 1);
+		pT_(move)(l, l->size + 1, r, 0, m - 1);
+		pT_(move)(parent, i, r, m - 1, 1);
+		pT_(move)(r, 0, r, m, r->size - m);
+		if(height > 1) pT_(move_child)(l, l->size + 1, r, 0, m),
+			pT_(move_child)(r, 0, r, m, r->size + 1 - m);
+		l->size += m, r->size -= m;
+	} else if(l->size > a) {
+		m = l->size - a;
+		pT_(move)(r, m, r, 0, r->size);
+		pT_(move)(r, m - 1, parent, i, 1);
+		pT_(move)(r, 0, l, a + 1, m - 1);
+		pT_(move)(parent, i, l, a, 1);
+		if(height > 1) pT_(move_child)(r, m, r, 0, r->size + 1),
+			pT_(move_child)(r, 0, l, a + 1, m);
+		l->size = a, r->size += m;
+	}
+}
+/** Joins `sub`, the key in `carry`, and `tree` in order, with `sub` on the
+ left if `is_left`, otherwise on the right. `sub`, which can be empty, is no
+ higher than `tree`, which is not empty; its boughs are taken. Only the side of
+ `tree` is walked. @return Success, otherwise nothing has changed.
+ @throws[malloc] @order \O(\log |`tree`|) */
+static int pT_(join)(struct pT_(subtree) *const tree,
+	struct pT_(bough) *const carry, const struct pT_(subtree) sub,
+	const int is_left) {
+	struct pT_(bough) *side[sizeof(size_t) * CHAR_BIT],
+		*spare[sizeof(size_t) * CHAR_BIT + 1], *child = 0, *bough;
+	const unsigned top = tree->height, height = sub.height + 1;
+	unsigned j, full = 0, idx, cidx;
+	assert(tree && tree->bough && top && top < sizeof side / sizeof *side
+		&& carry && sub.height <= top && (!sub.height || sub.bough));
+	/* `side[j]` is the bough at height `top - j` on the side. */
+	for(side[j = 0] = tree->bough; j + 1 < top; j++)
+		side[j + 1] = pT_(as_branch)(side[j])->child[is_left ? 0 : side[j]->size];
+	if(sub.height) { /* Goes straight into the bough beside it if it fits. */
+		struct pT_(bough) *const beside = side[top - sub.height];
+		const unsigned s = sub.bough->size;
+		if(beside->size + 1 + s <= TREE_MAX) {
+			if(is_left) {
+				pT_(move)(beside, s + 1, beside, 0, beside->size);
+				pT_(move)(beside, 0, sub.bough, 0, s);
+				pT_(move)(beside, s, carry, 0, 1);
+				if(sub.height > 1) pT_(move_child)(beside, s + 1, beside, 0,
+					beside->size + 1), pT_(move_child)(beside, 0, sub.bough, 0, s + 1);
+			} else {
+				pT_(move)(beside, beside->size, carry, 0, 1);
+				pT_(move)(beside, beside->size + 1, sub.bough, 0, s);
+				if(sub.height > 1) pT_(move_child)(beside, beside->size + 1,
+					sub.bough, 0, s + 1);
+			}
+			beside->size += s + 1;
+			if(sub.height > 1) free(pT_(as_branch)(sub.bough));
+			else free(sub.bough);
+			goto stale;
+		}
+		child = sub.bough;
+	}
+	/* Allocate the boughs that split, and maybe a new trunk, before. */
+	if(height > top) {
+		full = 1;
+	} else {
+		for(j = top - height; side[j]->size == TREE_MAX; j--)
+			if(full++, !j) { full++; break; }
+	}
+	for(j = 0; j < full; j++) {
+		const unsigned at = height + j; /* Height of the split, or the trunk. */
+		struct pT_(branch_bough) *branch;
+		if(at > 1 && j + 1 == full && (height > top || at > top)) {
+			if(!(branch = malloc(sizeof *branch))) goto catch;
+			branch->base.size = 0, branch->child[0] = tree->bough;
+			spare[j] = &branch->base;
+		} else if(at > 1) {
+			if(!(branch = malloc(sizeof *branch))) goto catch;
+			spare[j] = &branch->base;
+		} else if(!(spare[j] = malloc(sizeof *spare[j]))) goto catch;
+		spare[j]->size = 0;
+#			ifdef TREE_AUGMENT
+		spare[j]->stale = 1;
+#			endif
+	}
+	/* Put the key in the side, and split up as needed. */
+	if(height > top) { /* A new trunk over both. */
+		bough = spare[0];
+		pT_(insert_split)(bough, height, 0, carry, child, is_left ? 0 : 1, 0);
+		tree->bough = bough, tree->height++;
+		goto even;
+	}
+	idx = is_left ? 0 : side[top - height]->size;
+	cidx = is_left ? 0 : idx + 1;
+	for(j = 0, bough = side[top - height]; ; ) {
+		const unsigned at = height + j;
+		if(!pT_(insert_split)(bough, at, idx, carry, child, cidx,
+			j < full ? spare[j] : 0)) break;
+		child = spare[j++];
+		if(at == top) { /* The trunk split. */
+			assert(j + 1 == full);
+			bough = spare[j];
+			pT_(insert_split)(bough, at + 1, 0, carry, child, 1, 0);
+			tree->bough = bough, tree->height++;
+			break;
+		}
+		bough = side[top - at - 1];
+		idx = is_left ? 0 : bough->size, cidx = idx + 1;
+	}
+even:
+	if(sub.height) { /* The root of `sub` may be short. */
+		unsigned h;
+		for(bough = tree->bough, h = tree->height; h > height; h--)
+			bough = pT_(as_branch)(bough)->child[is_left ? 0 : bough->size];
+		j = is_left ? 0 : bough->size - 1;
+		if(pT_(as_branch)(bough)->child[j]->size < TREE_MIN
+			|| pT_(as_branch)(bough)->child[j + 1]->size < TREE_MIN)
+			pT_(even)(bough, j, sub.height);
+#			ifdef TREE_AUGMENT
+		pT_(as_branch)(bough)->child[j]->stale
+			= pT_(as_branch)(bough)->child[j + 1]->stale = 1;
+#			endif
+	}
+stale:
+#			ifdef TREE_AUGMENT
+	{
+		unsigned h;
+		for(bough = tree->bough, h = tree->height; ; h--) {
+			bough->stale = 1;
+			if(h <= height - 1 || h <= 1) break;
+			bough = pT_(as_branch)(bough)->child[is_left ? 0 : bough->size];
+		}
+	}
+#			endif
+	return 1;
+catch:
+	while(j) free(spare[--j]);
+	if(!errno) errno = ERANGE;
+	return 0;
+}
+/* A range of keys of a merge for one thread, which goes in `part`. */
+struct pT_(range) {
+	const struct t_(tree) *a, *b;
+	enum pT_(algebra) op;
+	const pT_(key) *lo, *hi;
+	struct t_(tree) part;
+	struct pT_(bough) carry; /* The least key, held back, if `has_carry`. */
+	int is_error, has_carry;
+	pthread_t thread;
+};
+/** Merges the `param` range. Thread entry point. */
+static void *pT_(range)(void *const param) {
+	struct pT_(range) *const r = param;
+	if(!pT_(merge)(&r->part, r->a, r->b, r->lo, r->hi, r->op)) r->is_error = 1;
+	T_(bulk_finish)(&r->part);
+	/* After the first, the least key goes between this part and the last. */
+	if(r->lo && !r->is_error && r->part.trunk.height) {
+		struct pT_(subtree) s = r->part.trunk;
+		while(s.height > 1)
+			s.bough = pT_(as_branch)(s.bough)->child[0], s.height--;
+		pT_(move)(&r->carry, 0, s.bough, 0, 1), r->has_carry = 1;
+		if(!T_(remove)(&r->part, r->carry.key[0])) r->is_error = 1;
+	}
+	return 0;
+}
+/** <fn:<pT>algebra> with the key-range split between up to `threads` at the
+ first level of the bigger tree with enough sub-trees. Each thread merges into
+ its own tree, and the parts are joined in order at their sides, with the
+ least key of each part between. @return Success, otherwise `result` is empty.
+ @throws[malloc] */
+static int pT_(parallel_algebra)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b,
+	const enum pT_(algebra) op, const unsigned threads) {
+	const struct t_(tree) *const big = !b || a && a->trunk.height
+		>= b->trunk.height ? a : b;
+	struct t_(tree) joined = t_(tree)();
+	struct pT_(range) *range = 0;
+	struct pT_(job) *job = 0;
+	pT_(key) *pivot = 0;
+	size_t size, upper;
+	unsigned depth, t = 0, i;
+	int success = 0;
+	assert(result && result != a && result != b);
+	/* Small trees are not worth it. */
+	if(threads <= 1 || !big || big->trunk.height < 3)
+		return pT_(algebra)(result, a, b, op);
+	if(!(job = pT_(frontier)(big->trunk, threads, &size, &depth, &upper)))
+		goto catch;
+	t = threads < size ? threads : (unsigned)size;
+	if(!(range = malloc(sizeof *range * t))
+		|| t > 1 && !(pivot = malloc(sizeof *pivot * (t - 1)))) goto catch;
+	/* The pivots are the left-most keys of sub-trees. */
+	for(i = 1; i < t; i++) {
+		struct pT_(subtree) s = job[size * i / t].sub;
+		while(s.height > 1)
+			s.bough = pT_(as_branch)(s.bough)->child[0], s.height--;
+		assert(s.bough->size);
+		pivot[i - 1] = s.bough->key[0];
+	}
+	for(i = 0; i < t; i++) {
+		struct pT_(range) *const r = range + i;
+		r->a = a, r->b = b, r->op = op;
+		r->lo = i ? pivot + i - 1 : 0, r->hi = i + 1 < t ? pivot + i : 0;
+		r->part = t_(tree)(), r->is_error = r->has_carry = 0;
+	}
+	for(i = 1; i < t; i++) if(pthread_create(&range[i].thread, 0,
+		&pT_(range), range + i)) pT_(range)(range + i), range[i].lo = 0;
+	pT_(range)(range);
+	for(i = 1; i < t; i++) if(range[i].lo) pthread_join(range[i].thread, 0);
+	for(i = 0; i < t; i++) if(range[i].is_error) goto catch;
+	/* Serial, but only along the sides of the parts. */
+	for(i = 0; i < t; i++) {
+		struct pT_(range) *const r = range + i;
+		struct pT_(subtree) *const part = &r->part.trunk, *const all
+			= &joined.trunk;
+		if(!r->has_carry) { /* The first, or it's empty. */
+			if(part->height) *all = *part, part->bough = 0, part->height = 0;
+			continue;
+		}
+		if(!all->height && !part->height) { /* Only the carry. */
+			if(!(all->bough = malloc(sizeof *all->bough))) goto catch;
+			all->bough->size = 0, all->height = 1;
+#			ifdef TREE_AUGMENT
+			all->bough->stale = 1;
+#			endif
+			pT_(insert_split)(all->bough, 1, 0, &r->carry, 0, 0, 0);
+		} else if(all->height >= part->height) {
+			if(!pT_(join)(all, &r->carry, *part, 0)) goto catch;
+			if(part->height) part->bough = 0, part->height = 0;
+		} else {
+			if(!pT_(join)(part, &r->carry, *all, 1)) goto catch;
+			*all = *part, part->bough = 0, part->height = 0;
+		}
+	}
+	t_(tree_)(result), *result = joined, joined = t_(tree)();
+	success = 1;
+catch:
+	if(!success) t_(tree_)(&joined), pT_(clear)(result);
+	if(range) for(i = 0; i < t; i++) t_(tree_)(&range[i].part);
+	free(pivot), free(range), free(job);
+	return success;
+}
+#		endif /* parallel --> */
+#		define BOX_PUBLIC_OVERRIDE
+#		include "box.h"
+
+/** Replaces the contents of `result` with the keys that are in either `a` or
+ `b`, (either can be null,) in one pass that merges them and appends in bulk.
+ If a key is in both, the value is from `a`. `result` can not be `a` or `b`.
+ @return Success, otherwise `result` is empty. @throws[malloc]
+ @order \O(|`a`| + |`b`|) @allow */
+static int T_(union)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b)
+	{ return pT_(algebra)(result, a, b, pT_(UNION)); }
+
+/** Replaces the contents of `result` with the keys that are in both `a` and
+ `b`, (either can be null,) with the values from `a`, as <fn:<T>union>.
+ @return Success, otherwise `result` is empty. @throws[malloc]
+ @order \O(|`a`| + |`b`|) @allow */
+static int T_(intersection)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b)
+	{ return pT_(algebra)(result, a, b, pT_(INTERSECTION)); }
+
+/** Replaces the contents of `result` with the keys that are in `a` but not in
+ `b`, (either can be null,) as <fn:<T>union>.
+ @return Success, otherwise `result` is empty. @throws[malloc]
+ @order \O(|`a`| + |`b`|) @allow */
+static int T_(difference)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b)
+	{ return pT_(algebra)(result, a, b, pT_(DIFFERENCE)); }
+
+#		ifdef TREE_PARALLEL /* <!-- parallel */
+/** Only with `TREE_PARALLEL`. Equivalent to <fn:<T>union>, but the key-range
+ is split between up to `threads` POSIX threads by the keys of the bigger
+ tree. The parts are joined in order at their sides.
+ @return Success, otherwise `result` is empty. @throws[malloc]
+ @order \O((|`a`| + |`b`|) / `threads` + `threads` \log |`result`|) @allow */
+static int T_(parallel_union)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b,
+	const unsigned threads)
+	{ return pT_(parallel_algebra)(result, a, b, pT_(UNION), threads); }
+
+/** Only with `TREE_PARALLEL`. <fn:<T>intersection> as
+ <fn:<T>parallel_union>. @return Success, otherwise `result` is empty.
+ @throws[malloc]
+ @order \O((|`a`| + |`b`|) / `threads` + `threads` \log |`result`|) @allow */
+static int T_(parallel_intersection)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b,
+	const unsigned threads)
+	{ return pT_(parallel_algebra)(result, a, b, pT_(INTERSECTION), threads); }
+
+/** Only with `TREE_PARALLEL`. <fn:<T>difference> as <fn:<T>parallel_union>.
+ @return Success, otherwise `result` is empty. @throws[malloc]
+ @order \O((|`a`| + |`b`|) / `threads` + `threads` \log |`result`|) @allow */
+static int T_(parallel_difference)(struct t_(tree) *const result,
+	const struct t_(tree) *const a, const struct t_(tree) *const b,
+	const unsigned threads)
+	{ return pT_(parallel_algebra)(result, a, b, pT_(DIFFERENCE), threads); }
+#		endif /* parallel --> */
+
+#		ifdef TREE_IMAGE /* <!-- image */
+/** Only with `TREE_IMAGE`. Writes `tree`, (which can be null,) to `fp` as
+ fixed-size pages: one bough per page, children before their parents, with
+ references to children as page numbers, and a trailer page. Keys and values
+ are copied bitwise; they can not usefully contain pointers, and the image is
+ only for the same instantiation on the same platform.
+ @return Success. @throws[fwrite] @order \Theta(|`tree`|) @allow */
+static int T_(image_save)(const struct t_(tree) *const tree, FILE *const fp) {
+	union pT_(image_page) p;
+	size_t next = 0, root = 0;
+	unsigned height = 0;
+	assert(fp);
+	if(tree && tree->trunk.bough && (height = tree->trunk.height)
+		&& !pT_(image_save_r)(tree->trunk, fp, &next, &root)) return 0;
+	memset(&p, 0, sizeof p);
+	memcpy(p.trailer.magic, "boxtree", sizeof p.trailer.magic);
+	p.trailer.page_size = sizeof p;
+	p.trailer.pages = next, p.trailer.root = root, p.trailer.height = height;
+	return fwrite(&p, sizeof p, 1, fp) == 1;
+}
+
+/** Only with `TREE_IMAGE`. Sets up `image` to read the tree in `data` of
+ `size` bytes that was written by <fn:<T>image_save>; for example, a file
+ that is `mmap`ed. Nothing is copied: `data` must stay valid and be aligned
+ for a pointer, and the image is read in-place. Every page is checked, so the
+ reads that follow stay in `data`, whatever is in it.
+ @return Success. @throws[EILSEQ] `data` is not an image of this type.
+ @order \Theta(|`image`|) @allow */
+static int T_(image)(struct T_(image) *const image, const void *const data,
+	const size_t size) {
+	const struct pT_(image_trailer) *trailer;
+	size_t left;
+	assert(image);
+	if(!data || size < sizeof *image->page || size % sizeof *image->page)
+		goto catch;
+	image->page = data;
+	image->pages = size / sizeof *image->page - 1;
+	trailer = &image->page[image->pages].trailer;
+	if(memcmp(trailer->magic, "boxtree", sizeof trailer->magic)
+		|| trailer->page_size != sizeof *image->page
+		|| trailer->pages != image->pages
+		|| (trailer->height ? trailer->root + 1 != image->pages
+		/* Any more than the bits, and it's not a tree; keeps the stack. */
+		|| trailer->height > sizeof(size_t) * CHAR_BIT : !!image->pages))
+		goto catch;
+	left = image->pages;
+	if(trailer->height && !pT_(image_valid_r)(image, trailer->root,
+		trailer->height, &left)) goto catch;
+	assert(!left);
+	image->trunk.bough = 0, image->trunk.height = trailer->height;
+	image->trunk.idx = 0;
+	if(trailer->height) {
+		union { const struct pT_(bough) *readonly; struct pT_(bough) *promise; }
+			sly;
+		sly.readonly = &image->page[trailer->root].page.bough;
+		if(trailer->height > 1 || sly.readonly->size)
+			image->trunk.bough = sly.promise;
+	}
+	return 1;
+catch:
+	errno = EILSEQ;
+	return 0;
+}
+
+/** Only with `TREE_IMAGE`. @return Is `x` in `image`?
+ @order \O(\log |`image`|) @allow */
+static int T_(image_contains)(const struct T_(image) *const image,
+	const pT_(key) x)
+	{ assert(image); return !!pT_(image_find)(image, x).bough; }
+
+/** Only with `TREE_IMAGE`. @return The value of `key` in `image`, or if no
+ key, `default_value`. @order \O(\log |`image`|) @allow */
+static pT_(value) T_(image_get_or)(const struct T_(image) *const image,
+	const pT_(key) key, const pT_(value) default_value) {
+	struct pT_(ref) ref;
+	assert(image);
+	return (ref = pT_(image_find)(image, key)).bough
+		? *pT_(ref_to_valuep)(ref) : default_value;
+}
+
+/** Only with `TREE_IMAGE`. @return Cursor on the first key in `image`.
+ @order \O(\log |`image`|) @allow */
+static struct T_(image_cursor) T_(image_begin)(const struct T_(image) *const
+	image) {
+	struct T_(image_cursor) cur;
+	assert(image);
+	cur.image = image, cur.ref = image->trunk;
+	if(cur.ref.bough) while(cur.ref.height > 1) cur.ref.bough
+		= pT_(image_child)(image, cur.ref.bough, 0), cur.ref.height--;
+	if(cur.ref.bough && !cur.ref.bough->size) cur.ref.bough = 0;
+	return cur;
+}
+
+/** Only with `TREE_IMAGE`. @return Cursor on the greatest key in `image` that
+ is less-than-or-equal-to `x`. @order \O(\log |`image`|) @allow */
+static struct T_(image_cursor) T_(image_less)(const struct T_(image) *const
+	image, const pT_(key) x) {
+	struct T_(image_cursor) cur;
+	assert(image);
+	cur.image = image, cur.ref = pT_(image_less)(image, x);
+	return cur;
+}
+
+/** Only with `TREE_IMAGE`. @return Cursor on the smallest key in `image` that
+ is greater-than-or-equal-to `x`. @order \O(\log |`image`|) @allow */
+static struct T_(image_cursor) T_(image_more)(const struct T_(image) *const
+	image, const pT_(key) x) {
+	struct T_(image_cursor) cur;
+	assert(image);
+	cur.image = image, cur.ref = pT_(image_more)(image, x);
+	return cur;
+}
+
+/** Only with `TREE_IMAGE`. @return Whether `cur` points to a key. @allow */
+static int T_(image_exists)(const struct T_(image_cursor) *const cur)
+	{ return assert(cur), !!cur->ref.bough; }
+
+/** Only with `TREE_IMAGE`. @return The key at `cur` that
+ <fn:<T>image_exists>. @allow */
+static pT_(key) T_(image_key)(const struct T_(image_cursor) *const cur)
+	{ return cur->ref.bough->key[cur->ref.idx]; }
+
+#			ifdef TREE_VALUE
+/** Only with `TREE_IMAGE` and `TREE_VALUE`. @return The read-only value at
+ `cur` that <fn:<T>image_exists>. @allow */
+static const pT_(value) *T_(image_value)(const struct T_(image_cursor) *const
+	cur) { return cur->ref.bough->value + cur->ref.idx; }
+#			endif
+
+/** Only with `TREE_IMAGE`. Moves `cur` that <fn:<T>image_exists> to the next
+ key. @order \O(\log |`image`|) @allow */
+static void T_(image_next)(struct T_(image_cursor) *const cur) {
+	struct pT_(ref) next;
+	assert(cur && cur->image && cur->ref.bough);
+	next = cur->ref, next.idx++;
+	if(next.height > 1) { /* Fall from branch. */
+		do next.bough = pT_(image_child)(cur->image, next.bough, next.idx),
+			next.idx = 0, next.height--; while(next.height > 1);
+	} else if(next.idx >= next.bough->size) { /* Re-descend. */
+		const pT_(key) x = next.bough->key[next.bough->size - 1];
+		struct pT_(ref) descend;
+		for(next.bough = 0, descend = cur->image->trunk; descend.height > 1;
+			descend.bough = pT_(image_child)(cur->image, descend.bough,
+			descend.idx), descend.height--) {
+			pT_(node_lb)(&descend, x);
+			if(descend.idx < descend.bough->size) next = descend;
+		}
+	}
+	cur->ref = next;
+}
+#		endif /* image --> */
+
+#		ifdef TREE_AUGMENT /* <!-- augment */
+/** Only with `TREE_AUGMENT`. Modifying the tree does this automatically;
+ this is needed when a value that contributes to the summary is changed in
+ place outside of the function call that returned it. Marks the summaries
+ that `key` in `tree` contributes to as stale.
+ @order \O(\log |`tree`|) @allow */
+static void T_(invalidate)(struct t_(tree) *const tree, const pT_(key) key)
+	{ assert(tree); pT_(stale)(tree->trunk, key); }
+
+/** Only with `TREE_AUGMENT`. @return The summary of all the entries of
+ `tree`, or null if it is empty. Recomputes the stale summaries.
+ @order \O(\log |`tree`|) amortized over modifications @allow */
+static const pT_(summary) *T_(summary)(struct t_(tree) *const tree) {
+	if(!tree || !tree->trunk.height) return 0;
+	pT_(summary_r)(tree->trunk);
+	return &tree->trunk.bough->summary;
+}
+
+/** Only with `TREE_AUGMENT`. Sets `s` to the summary of the entries of `tree`
+ that are in the closed range `[lo, hi]`. Sub-trees that are entirely
+ contained in the range use the cached summary.
+ @order \O(\log |`tree`|) amortized over modifications @allow */
+static void T_(summarize)(struct t_(tree) *const tree, const pT_(key) lo,
+	const pT_(key) hi, pT_(summary) *const s) {
+	assert(tree && s);
+	t_(identity)(s);
+	if(!tree->trunk.height) return;
+	pT_(summarize_r)(tree->trunk, lo, hi, 0, s);
+}
+
+/** Only with `TREE_AUGMENT`. Finds all the entries in `tree` that are
+ at-or-less than `hi` and whose summary is accepted by `keep`. Sub-trees whose
+ summary `keep` rejects are skipped. For example, in an interval tree ordered
+ by the start with a summary of maximum end, the intervals that overlap
+ `[a, b]` have start `<= b` and `keep` the ones with end `>= a`.
+ @param[visit] If not-null, called in order on each entry found.
+ @param[param] Passed to `keep` and `visit`.
+ @return The number of entries found.
+ @order \O(k \log |`tree`|) for `k` entries found, amortized over
+ modifications @allow */
+static size_t T_(overlap)(struct t_(tree) *const tree, const pT_(key) hi,
+	const pT_(keep_fn) keep, const pT_(visit_fn) visit, void *const param) {
+	struct T_(cursor) cur;
+	size_t count = 0;
+	assert(tree && keep);
+	if(!tree->trunk.height) return 0;
+	cur.trunk = &tree->trunk;
+	pT_(overlap_r)(tree->trunk, hi, keep, visit, param, &cur, &count);
+	return count;
+}
+#		endif /* augment --> */
+
 #		define BOX_PRIVATE_AGAIN
 #		include "box.h"
 
@@ -1608,6 +3072,25 @@ static void pT_(unused_base)(void) {
 	T_(bulk_add)(0, k); T_(add)(0, k); T_(update)(0, k, 0);
 #		endif
 	T_(bulk_finish)(0); T_(remove)(0, k); T_(clone)(0, 0);
+	T_(union)(0, 0, 0); T_(intersection)(0, 0, 0); T_(difference)(0, 0, 0);
+#		ifdef TREE_PARALLEL
+	T_(parallel_clone)(0, 0, 0); T_(parallel_clear)(0, 0);
+	T_(parallel_union)(0, 0, 0, 0); T_(parallel_intersection)(0, 0, 0, 0);
+	T_(parallel_difference)(0, 0, 0, 0);
+#		endif
+#		ifdef TREE_IMAGE
+	T_(image_save)(0, 0); T_(image)(0, 0, 0); T_(image_contains)(0, k);
+	T_(image_get_or)(0, k, v); T_(image_begin)(0); T_(image_less)(0, k);
+	T_(image_more)(0, k); T_(image_exists)(0); T_(image_key)(0);
+	T_(image_next)(0);
+#			ifdef TREE_VALUE
+	T_(image_value)(0);
+#			endif
+#		endif
+#		ifdef TREE_AUGMENT
+	T_(invalidate)(0, k); T_(summary)(0); T_(summarize)(0, k, k, 0);
+	T_(overlap)(0, k, 0, 0, 0);
+#		endif
 	pT_(unused_base_coda)();
 }
 static void pT_(unused_base_coda)(void) { pT_(unused_base)(); }
@@ -1693,6 +3176,18 @@ static void pTR_(unused_default_coda)(void) { pTR_(unused_default)(); }
 #	ifdef TREE_VALUE
 #		undef TREE_VALUE
 #	endif
+#	ifdef TREE_PREFIX
+#		undef TREE_PREFIX
+#	endif
+#	ifdef TREE_AUGMENT
+#		undef TREE_AUGMENT
+#	endif
+#	ifdef TREE_PARALLEL
+#		undef TREE_PARALLEL
+#	endif
+#	ifdef TREE_IMAGE
+#		undef TREE_IMAGE
+#	endif
 #	ifdef TREE_LESS
 #		undef TREE_LESS
 #	endif
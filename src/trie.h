@@ -45,6 +45,69 @@
  the entry is the key. Requires <typedef:<pT>key_fn> `<t>key`, that picks out
  <typedef:<pT>key> from <typedef:<pT>entry>.
 
+ @param[TRIE_KEY_BYTES]
+ Optional fixed width of the keys in bytes, such as integers in big-endian
+ order or network addresses. Requires `TRIE_KEY`, the first `TRIE_KEY_BYTES`
+ of which are the key; likewise, with `TRIE_ENTRY`, the key must be the first
+ member. The bits are looked at directly, so there is no `<t>string` or
+ `<t>key`, no null-terminator, and the key is stored inline. The `const char *`
+ of the functions points to `TRIE_KEY_BYTES` and there is no <fn:<T>prefix>.
+ A `TRIE_KEY` smaller than `TRIE_KEY_BYTES` does not compile.
+
+ @param[TRIE_COUNT]
+ Optional count of the entries under each leaf, kept by adding and removing,
+ for <fn:<T>count>, <fn:<T>prefix_count>, <fn:<T>rank>, and <fn:<T>select>
+ without going through the entries. The counts of a bough are an array beside
+ its leaves, so these add up to `TRIE_ORDER` counts that are together in
+ memory in each bough on the path without looking at the boughs that are
+ linked. It costs a `size_t` for every leaf and another walk down the path of
+ the key on each modification.
+
+ @param[TRIE_SCORE]
+ Optional type, <typedef:<pT>score>, of a weight of each entry, ordered by `<`;
+ requires <typedef:<pT>score_fn> `<t>score`. Each bough caches the score of
+ every leaf beside the leaves, which is the best score under it for a link,
+ marked stale by modifications and recomputed lazily, like `TREE_AUGMENT` in
+ <src/tree.h>. Adds <fn:<T>top>, a best-first search of the highest scores
+ under a prefix that does not look at a bough until it opens it, and
+ <fn:<T>invalidate>. Requires <src/heap.h> and <src/array.h>.
+
+ @param[TRIE_OWN]
+ Optional, only with the default `const char *` keys. The trie copies the keys
+ that are added into an arena of its own, so they need not be kept elsewhere,
+ and they are together in memory instead of all over. Removed keys are garbage
+ until they are half the arena, when the keys are copied, in order, into one
+ block; this invalidates the pointers to keys that were returned before.
+
+ @param[TRIE_PARALLEL]
+ Optional, adds <fn:<T>parallel_from_array>, which builds the partitions of
+ <fn:<T>partition> between POSIX threads, and puts them together with
+ <fn:<T>join>; requires `pthread`.
+
+ @param[TRIE_CONCURRENT]
+ Optional, not with `TRIE_OWN`, adds <tag:<T>concurrent>, where one writer
+ makes changes while any number of POSIX threads read. The writer copies the
+ boughs on the path of a key before changing them, once between publishes,
+ and <fn:<T>publish> puts out the new trunk as a version. A reader holds a
+ version from <fn:<T>acquire> to <fn:<T>release>; the boughs that were
+ replaced are freed when no one holds a version that can see them. Requires
+ `pthread`; with C11 atomics, or `__atomic` in GCC and Clang, readers count
+ themselves without a lock.
+
+ @param[TRIE_IMAGE]
+ Optional, adds <fn:<T>image_save>, which writes the trie as a file, and
+ <tag:<T>image>, which is a read-only view of it in memory, such as from
+ `mmap`, without deserializing; requires `stdio.h`. The boughs are laid out
+ children first, with 32-bit relative offsets instead of links, and the key
+ strings are together after them. Only the keys are in the image.
+
+ @param[TRIE_AUTOMATON]
+ Optional, not with `TRIE_KEY_BYTES`, adds <fn:<T>automaton>, which compiles
+ the keys of a trie into an Aho-Corasick automaton, and <fn:<T>scan_next>,
+ which finds all of them in text that is supplied in pieces. The states near
+ the root, where the most time is spent, have a table of every transition;
+ the rest have their children in order, and fall back on failure links.
+
  @param[TRIE_TO_STRING, TRIE_KEY_TO_STRING]
  To string trait contained in <src/to_string.h>. For `TRIE_TO_STRING`, see
  <typedef:<pT>to_string_fn>; alternately, for `TRIE_KEY_TO_STRING`, the key is
@@ -73,6 +136,19 @@
 #if defined TRIE_TO_STRING && defined TRIE_KEY_TO_STRING
 #	error Exclusive.
 #endif
+#if defined TRIE_KEY_BYTES && (!defined TRIE_KEY || TRIE_KEY_BYTES < 1 \
+	|| defined TRIE_KEY_TO_STRING)
+#	error Fixed-width keys need a type, and are not strings.
+#endif
+#if defined TRIE_AUTOMATON && defined TRIE_KEY_BYTES
+#	error The automaton finds strings.
+#endif
+#if defined TRIE_OWN && (defined TRIE_KEY || defined TRIE_ENTRY)
+#	error Owned keys are only the default strings.
+#endif
+#if defined TRIE_CONCURRENT && defined TRIE_OWN
+#	error Readers can not see an arena that moves.
+#endif
 #if defined TRIE_TEST && (!defined TRIE_TRAIT \
 	&& !(defined TRIE_TO_STRING || defined TRIE_KEY_TO_STRING) \
 	|| defined TRIE_TRAIT && !defined TRIE_HAS_TO_STRING)
@@ -97,6 +173,7 @@
 #ifndef TRIE_H /* Idempotent. */
 #	define TRIE_H
 #	include <stdlib.h>
+#	include <stddef.h>
 #	include <string.h>
 #	include <errno.h>
 #	include <assert.h>
@@ -107,6 +184,30 @@
 #	define TRIE_QUERY(a, n) ((a)[TRIE_SLOT(n)] & TRIE_MASK(n))
 #	define TRIE_DIFF(a, b, n) \
 		(((a)[TRIE_SLOT(n)] ^ (b)[TRIE_SLOT(n)]) & TRIE_MASK(n))
+#	if !defined(__STDC__) || !defined(__STDC_VERSION__) \
+	|| __STDC_VERSION__ < 199901L /* < C99 */
+#		define TRIE_UINT size_t
+#	else /* < C99 --><!-- >= C99 */
+#		include <stdint.h>
+#		define TRIE_UINT uintptr_t
+#	endif /* >= C99 --> */
+/* Whether a word has a zero byte,
+ <https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord>. */
+#	define TRIE_ONES ((size_t)-1 / UCHAR_MAX)
+#	define TRIE_HAS_NULL(w) \
+		(((w) - TRIE_ONES) & ~(w) & TRIE_ONES * (UCHAR_MAX / 2 + 1))
+/* The bytes of the masks of a word; fails to compile if a word is longer. */
+#	define TRIE_WORD_MAX 16
+typedef char trie_word_fits[sizeof(size_t) <= TRIE_WORD_MAX ? 1 : -1];
+/* Reading the rest of the word after the null is outside the string, which
+ the address sanitizer reports; it goes a byte at a time. */
+#	if defined __SANITIZE_ADDRESS__
+#		define TRIE_BYTEWISE
+#	elif defined __has_feature
+#		if __has_feature(address_sanitizer)
+#			define TRIE_BYTEWISE
+#		endif
+#	endif
 /* Maximum branching factor/leaves. Prefer alignment `4n`; cache `32n`. */
 #	define TRIE_ORDER 256
 #	if TRIE_ORDER - 2 < 1 || TRIE_ORDER - 2 > UCHAR_MAX /* Max left. */
@@ -114,6 +215,15 @@
 #	endif
 /* `⌈(2n-1)/3⌉` nodes. */
 #	define TRIE_SPLIT ((2 * (TRIE_ORDER + TRIE_ORDER - 1) - 1 + 2) / 3)
+/* A child in <fn:<T>from_array> that is a key and not another branch. */
+#	define TRIE_LEAF ((size_t)-1)
+/* Boughs are joined on removal when they fit in this; a quarter short of
+ full leaves room to grow before splitting again. */
+#	define TRIE_JOIN (TRIE_ORDER * 3 / 4)
+/* Rounds `n` up to a multiple of `m`. */
+#	define TRIE_ROUND(n, m) (((n) + (m) - 1) / (m) * (m))
+/* The bits in a chunk of the bitmap of links. */
+#	define TRIE_CHUNK (sizeof(bmpchunk) * CHAR_BIT)
 
 #	define TRIE_RESULT X(ERROR), X(ABSENT), X(PRESENT)
 #	define X(n) TRIE_##n
@@ -131,11 +241,76 @@ static const char *const trie_result_str[] = { TRIE_RESULT };
 #	undef TRIE_RESULT
 
 struct trie_branch { unsigned char left, skip; };
+/* The alignment of the counts, which are after the leaves. */
+struct trie_size_align { char c; size_t size; };
+/* The states of an automaton, breadth-first, that have a table of every
+ transition; at a kilobyte each, they are about the size of a cache. */
+#	define TRIE_DENSE 1024u
+/* An image is in words of at least 32 bits. */
+#	if UINT_MAX >= 0xffffffff
+typedef unsigned trie_image_uint;
+#	else
+typedef unsigned long trie_image_uint;
+#	endif
+/* A leaf of a bough in an image that is a link has this set; the rest of the
+ offsets must fit under. */
+#	define TRIE_IMAGE_LINK 0x80000000ul
+/* The words that the branches of a bough of `leaves` take up in an image. */
+#	define TRIE_IMAGE_BRANCHES(leaves) (((leaves) - 1u) \
+		* sizeof(struct trie_branch) + sizeof(trie_image_uint) - 1) \
+		/ sizeof(trie_image_uint)
 #	ifndef TRIE_DECLARE_ONLY
 /* Construct `struct trie_bmp`. */
 #		define BMP_NAME trie
 #		define BMP_BITS TRIE_ORDER
 #		include "bmp.h"
+#		ifndef TRIE_BYTEWISE
+/* Masks the bytes of a word outside of a run, whatever the byte order; at
+ `TRIE_WORD_MAX - n`, the first `n` bytes are set, and at
+ `2 TRIE_WORD_MAX - n`, all but the first `n` bytes are set. */
+static const unsigned char trie_word_mask[3 * TRIE_WORD_MAX] = {
+	255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255 };
+#		endif
+/** @return Whether `string` has no null in the bytes from `*cur` to before
+ `next`, in which case `*cur` is moved up to `next`. With common text in keys,
+ this is a long way between branches, so it reads the aligned words that
+ cover it, with the bytes outside masked. */
+static int trie_is_long(const char *const string, size_t *const cur,
+	const size_t next) {
+	const char *s = string + *cur, *const end = string + next;
+#		ifndef TRIE_BYTEWISE
+	size_t word, mask, n;
+#		endif
+	if(*cur >= next) return 1;
+#		ifndef TRIE_BYTEWISE
+	if(next - *cur > sizeof word) {
+		/* Aligned words never cross a page, even past the null. */
+		n = (size_t)((TRIE_UINT)(const void *)s % sizeof word), s -= n;
+		memcpy(&word, s, sizeof word);
+		memcpy(&mask, trie_word_mask + TRIE_WORD_MAX - n, sizeof mask);
+		for(word |= mask; ; ) {
+			if((n = (size_t)(end - s)) < sizeof word) {
+				memcpy(&mask, trie_word_mask + 2 * TRIE_WORD_MAX - n,
+					sizeof mask);
+				word |= mask;
+			}
+			if(TRIE_HAS_NULL(word)) return 0;
+			if(n <= sizeof word) break;
+			s += sizeof word;
+			memcpy(&word, s, sizeof word);
+		}
+		*cur = next;
+		return 1;
+	}
+#		endif
+	for( ; s < end; s++) if(*s == '\0') return 0;
+	*cur = next;
+	return 1;
+}
 /** @return Whether `prefix` is the prefix of `word`.
  Used in <fn:<T>prefix>. */
 static int trie_is_prefix(const char *prefix, const char *word) {
@@ -146,6 +321,33 @@ static int trie_is_prefix(const char *prefix, const char *word) {
 }
 #	endif
 #endif
+#if defined TRIE_PARALLEL || defined TRIE_CONCURRENT
+#	include <pthread.h>
+#endif
+#if defined TRIE_CONCURRENT && !defined TRIE_ATOMIC_H /* Idempotent. */
+#	define TRIE_ATOMIC_H
+/* Readers only count themselves in a version, without the lock, when there
+ are atomics; otherwise, they take the lock to count. */
+#	if defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L \
+	&& !defined __STDC_NO_ATOMICS__
+#		include <stdatomic.h>
+#		define TRIE_ATOMIC(type) _Atomic(type)
+#		define TRIE_LOAD(a) atomic_load(a)
+#		define TRIE_STORE(a, x) atomic_store(a, x)
+#		define TRIE_ADD(a, x) atomic_fetch_add(a, x)
+#		define TRIE_SUB(a, x) atomic_fetch_sub(a, x)
+#	elif defined __clang__ || defined __GNUC__ \
+	&& (__GNUC__ > 4 || __GNUC__ == 4 && __GNUC_MINOR__ >= 7)
+#		define TRIE_ATOMIC(type) type
+#		define TRIE_LOAD(a) __atomic_load_n(a, __ATOMIC_SEQ_CST)
+#		define TRIE_STORE(a, x) __atomic_store_n(a, x, __ATOMIC_SEQ_CST)
+#		define TRIE_ADD(a, x) __atomic_fetch_add(a, x, __ATOMIC_SEQ_CST)
+#		define TRIE_SUB(a, x) __atomic_fetch_sub(a, x, __ATOMIC_SEQ_CST)
+#	endif
+#endif
+#ifdef TRIE_IMAGE
+#	include <stdio.h>
+#endif
 
 #ifndef TRIE_TRAIT /* <!-- base trie */
 
@@ -173,12 +375,42 @@ typedef pT_(entry) *pT_(remit);
 typedef pT_(key) pT_(entry);
 typedef pT_(key) pT_(remit);
 #	endif
+#	ifdef TRIE_KEY_BYTES
+/* Fails to compile if the key is shorter than the bytes read from it. */
+typedef char pT_(key_fits)[sizeof(pT_(key)) >= TRIE_KEY_BYTES
+	&& sizeof(pT_(entry)) >= TRIE_KEY_BYTES ? 1 : -1];
+#	endif
+
+#	ifndef TRIE_KEY_BYTES
+/** Used in <fn:<T>fuzzy>; given a key that is close, its edit distance, and
+ the parameter. */
+typedef void (*pT_(fuzzy_fn))(pT_(remit), unsigned, void *);
+#	endif
+
+#	ifdef TRIE_AUTOMATON
+/** Used in <fn:<T>scan_next>; given a key that is in the text, the offset of
+ the start of it from the start of the scan, and the parameter. */
+typedef void (*pT_(scan_fn))(const char *, size_t, void *);
+#	endif
+
+#	ifdef TRIE_SCORE
+/** On `TRIE_SCORE`, the weight of an entry, where higher is better. */
+typedef TRIE_SCORE pT_(score);
+/* The score of a leaf, and for a link, the best score under it; `stale` is
+ set when it has to be recomputed, and then so are the leaves on the path to
+ it. */
+struct pT_(best) { pT_(score) score; unsigned stale; };
+/* The alignment of the scores, which are after the leaves. */
+struct pT_(best_align) { char c; struct pT_(best) best; };
+#	endif
 
 #	if 0 /* <!-- documentation */
 /** Transforms a <typedef:<pT>key> into a `const char *`. */
 typedef const char *(*pT_(string_fn))(pT_(key));
 /** Extracts <typedef:<pT>key> from <typedef:<pT>entry>. */
 typedef pT_(key) (*pT_(key_fn))(const pT_(entry) *);
+/** Only with `TRIE_SCORE`. Gets the <typedef:<pT>score> of the entry. */
+typedef pT_(score) (*pT_(score_fn))(const pT_(entry) *);
 #	endif /* documentation --> */
 
 /* A leaf in a bough can either be an entry or a link to another bough. */
@@ -191,19 +423,51 @@ union pT_(leaf) { pT_(entry) as_entry; struct pT_(bough) *as_link; };
  empty—but not idle—trie to provide hysteresis. That is, switching from 0 to 1
  entry repeatedly should not release and `malloc` resources every time (it is
  lazy.) As a full binary tree, the branches is `leaves - 1`, with the exception
- being empty. */
+ being empty. Only the first `capacity` of `leaf` are allocated; this is a
+ power-of-two size class, so a trie with a few keys is not taking up
+ `TRIE_ORDER` leaves. The bitmap of which leaves are links and the branches
+ are sized by the class too; the branches and leaves follow the chunks of the
+ bitmap that cover `capacity`, <fn:<pT>branch> and <fn:<pT>leaf>. Then a walk
+ down the branches starts in the same cache line. With `TRIE_COUNT`, the
+ entries under each leaf follow, <fn:<pT>size>, and with `TRIE_SCORE`, the
+ scores, <fn:<pT>best>. */
 struct pT_(bough) {
-	unsigned short leaves;
-	struct trie_branch branch[TRIE_ORDER - 1];
-	struct trie_bmp bmp;
-	union pT_(leaf) leaf[TRIE_ORDER];
+	unsigned short leaves, capacity;
+#	ifdef TRIE_CONCURRENT
+	size_t generation; /* Of the writer that made it; zero is unknown. */
+#	endif
+	struct trie_bmp bmp; /* Then the branches and leaves. */
 };
+/* The alignment of the leaves, which are after the branches. */
+struct pT_(leaf_align) { char c; union pT_(leaf) leaf; };
 /** To initialize it to an idle state, see <fn:<t>trie>, `{0}`, or being
  `static`.
 
  ![States.](../doc/trie/states.png) */
 struct t_(trie);
-struct t_(trie) { struct pT_(bough) *trunk; };
+#	ifdef TRIE_OWN
+/** Only with `TRIE_OWN`. A block of the arena that holds copies of the keys;
+ the characters follow it. */
+struct pT_(block) { struct pT_(block) *prev; size_t size, capacity; };
+#	endif
+#	ifdef TRIE_CONCURRENT
+/* Boughs that readers may still see, so they are not freed yet. */
+struct pT_(retire) { struct pT_(bough) **data; size_t size, capacity; };
+/* The writer of a concurrent trie. Boughs that have its `generation` were
+ made since the last publish, so no reader has seen them; they are changed in
+ place. The boughs it replaced that readers may have seen are in `retired`. */
+struct pT_(writer) { struct pT_(retire) retired; size_t generation; };
+#	endif
+struct t_(trie) {
+	struct pT_(bough) *trunk;
+#	ifdef TRIE_OWN
+	struct pT_(block) *block; /* The latest of the arena of keys. */
+	size_t used, garbage; /* Bytes of keys in the arena; of those, removed. */
+#	endif
+#	ifdef TRIE_CONCURRENT
+	struct pT_(writer) *writer; /* Only while the writer is changing it. */
+#	endif
+};
 typedef struct t_(trie) pT_(box);
 
 struct pT_(ref) { struct pT_(bough) *bough; unsigned lf; };
@@ -213,13 +477,113 @@ struct T_(cursor) { /* fixme: This is very wasteful? at least re-arrange? */
 	struct pT_(bough) *root;
 	struct pT_(ref) start, end;
 };
+#	ifndef TRIE_KEY_BYTES
+/* The keys that are prefixes of `string`, shortest first; the walk down the
+ trie is saved between them. */
+struct T_(prefixes_cursor) {
+	const char *string;
+	struct pT_(bough) *bough; /* Null when the walk is done. */
+	unsigned br0, br1, lf;
+	size_t bit, byte;
+	struct pT_(ref) ref; /* Null bough when there are no more. */
+};
+#	endif
+#	ifdef TRIE_IMAGE
+/* A bough in an image is the number of leaves, the branches packed, and a word
+ for every leaf: the offset of a key in `keys`, or of a link backwards. */
+struct pT_(image_ref) { const trie_image_uint *bough; unsigned lf; };
+/* The last of an image says what it is. */
+struct pT_(image_trailer)
+	{ char magic[8]; trie_image_uint words, keys, root, key_bytes; };
+/** Only with `TRIE_IMAGE`. A read-only view of a trie that was saved with
+ <fn:<T>image_save>, set up by <fn:<T>image>. */
+struct T_(image) { const trie_image_uint *root; const char *keys; };
+/** Only with `TRIE_IMAGE`. A range of keys in an image. */
+struct T_(image_cursor) {
+	const struct T_(image) *image; /* Null when done. */
+	struct pT_(image_ref) start, end;
+};
+#	endif
+#	ifdef TRIE_AUTOMATON
+/* A state of the automaton is a prefix of the keys; the children of a state
+ are consecutive, in order. A zero `pattern` or `output` is none. */
+struct pT_(state) {
+	unsigned fail, output, child, pattern, depth;
+	unsigned short children;
+	unsigned char label; /* The byte from the parent. */
+};
+/** Only with `TRIE_AUTOMATON`. The keys of a trie compiled by
+ <fn:<T>automaton>. The states are breadth-first; the first `dense` have a
+ complete row of transitions in `delta`. */
+struct T_(automaton) {
+	struct pT_(state) *state;
+	unsigned states, dense;
+	unsigned *delta;
+	const char **pattern;
+};
+/** Only with `TRIE_AUTOMATON`. Where a scan of text is, between pieces. */
+struct T_(scan) {
+	const struct T_(automaton) *automaton;
+	unsigned state;
+	size_t offset;
+};
+#	endif
+#	ifdef TRIE_CONCURRENT
+/* A trunk that was published. The boughs in `retired` were replaced by the
+ next version; they are freed when no reader has this or an earlier one. A
+ reader may count itself in one that is not current any more, and then let
+ go; so they are kept as spares, never freed while `c` is up. */
+struct pT_(version) {
+	struct t_(trie) trie; /* First: readers are given a pointer to it. */
+#		ifdef TRIE_ATOMIC
+	TRIE_ATOMIC(size_t) readers;
+#		else
+	size_t readers;
+#		endif
+	struct pT_(version) *next;
+	struct pT_(retire) retired;
+};
+/** Only with `TRIE_CONCURRENT`. A trie with one writer and many readers; set
+ up with <fn:<T>concurrent>. `lock` is held to take versions off `oldest`
+ and to put them in `spare`; with atomics, readers don't take it. */
+struct T_(concurrent) {
+	struct t_(trie) trie; /* The writer's. */
+	struct pT_(writer) writer;
+	struct pT_(version) *oldest, *spare;
+#		ifdef TRIE_ATOMIC
+	TRIE_ATOMIC(struct pT_(version) *) current;
+#		else
+	struct pT_(version) *current;
+#		endif
+	pthread_mutex_t lock;
+};
+#	endif
 
 #	ifdef BOX_NON_STATIC /* Public functions. */
 struct T_(cursor) T_(begin)(const struct t_(trie) *);
 int T_(exists)(const struct T_(cursor) *);
 pT_(remit) T_(entry)(const struct T_(cursor) *);
 void T_(next)(struct T_(cursor) *);
+struct T_(cursor) T_(lower)(const struct t_(trie) *, const char *);
+struct T_(cursor) T_(upper)(const struct t_(trie) *, const char *);
+struct T_(cursor) T_(range)(const struct t_(trie) *, const char *,
+	const char *);
+#		ifndef TRIE_KEY_BYTES
 struct T_(cursor) T_(prefix)(struct t_(trie) *, const char *);
+struct T_(prefixes_cursor) T_(prefixes)(const struct t_(trie) *,
+	const char *);
+int T_(prefixes_exists)(const struct T_(prefixes_cursor) *);
+pT_(remit) T_(prefixes_entry)(const struct T_(prefixes_cursor) *);
+void T_(prefixes_next)(struct T_(prefixes_cursor) *);
+#			if defined(TREE_ENTRY) || !defined(TRIE_KEY)
+pT_(remit) T_(longest)(const struct t_(trie) *, const char *);
+#			else
+enum trie_result T_(longest)(const struct t_(trie) *, const char *,
+	pT_(remit) *);
+#			endif
+size_t T_(fuzzy)(const struct t_(trie) *, const char *, unsigned,
+	pT_(fuzzy_fn), void *);
+#		endif
 struct t_(trie) t_(trie)(void);
 void t_(trie_)(struct t_(trie) *);
 void T_(clear)(struct t_(trie) *);
@@ -236,6 +600,61 @@ enum trie_result T_(add)(struct t_(trie) *, pT_(key));
 enum trie_result T_(add)(struct t_(trie) *, pT_(key), pT_(entry) **);
 #		endif
 int T_(remove)(struct t_(trie) *, const char *);
+int T_(from_array)(struct t_(trie) *, pT_(entry) *, size_t);
+void T_(partition)(pT_(entry) *, size_t, size_t *);
+int T_(join)(struct t_(trie) *, struct t_(trie) *, size_t);
+#		ifdef TRIE_PARALLEL
+int T_(parallel_from_array)(struct t_(trie) *, pT_(entry) *, size_t,
+	unsigned);
+#		endif
+#		ifdef TRIE_CONCURRENT
+int T_(concurrent)(struct T_(concurrent) *);
+void T_(concurrent_)(struct T_(concurrent) *);
+#			ifndef TRIE_ENTRY
+enum trie_result T_(concurrent_add)(struct T_(concurrent) *, pT_(key));
+#			else
+enum trie_result T_(concurrent_add)(struct T_(concurrent) *, pT_(key),
+	pT_(entry) **);
+#			endif
+int T_(concurrent_remove)(struct T_(concurrent) *, const char *);
+int T_(publish)(struct T_(concurrent) *);
+const struct t_(trie) *T_(acquire)(struct T_(concurrent) *);
+void T_(release)(struct T_(concurrent) *, const struct t_(trie) *);
+#		endif
+#		ifdef TRIE_COUNT
+size_t T_(count)(const struct t_(trie) *);
+#			ifndef TRIE_KEY_BYTES
+size_t T_(prefix_count)(const struct t_(trie) *, const char *);
+#			endif
+size_t T_(rank)(const struct t_(trie) *, const char *);
+struct T_(cursor) T_(select)(const struct t_(trie) *, size_t);
+#		endif
+#		ifdef TRIE_IMAGE
+int T_(image_save)(const struct t_(trie) *, FILE *);
+int T_(image)(struct T_(image) *, const void *, size_t);
+const char *T_(image_get)(const struct T_(image) *, const char *);
+struct T_(image_cursor) T_(image_begin)(const struct T_(image) *);
+#			ifndef TRIE_KEY_BYTES
+struct T_(image_cursor) T_(image_prefix)(const struct T_(image) *,
+	const char *);
+#			endif
+int T_(image_exists)(const struct T_(image_cursor) *);
+const char *T_(image_key)(const struct T_(image_cursor) *);
+void T_(image_next)(struct T_(image_cursor) *);
+#		endif
+#		ifdef TRIE_SCORE
+void T_(invalidate)(struct t_(trie) *, const char *);
+#			ifndef TRIE_KEY_BYTES
+size_t T_(top)(struct t_(trie) *, const char *, pT_(remit) *, size_t);
+#			endif
+#		endif
+#		ifdef TRIE_AUTOMATON
+int T_(automaton)(struct T_(automaton) *, const struct t_(trie) *);
+void T_(automaton_)(struct T_(automaton) *);
+struct T_(scan) T_(scan)(const struct T_(automaton) *);
+size_t T_(scan_next)(struct T_(scan) *, const char *, size_t, pT_(scan_fn),
+	void *);
+#		endif
 #	endif
 #	ifndef BOX_DECLARE_ONLY /* <!-- body */
 
@@ -245,37 +664,191 @@ int T_(remove)(struct t_(trie) *, const char *);
 static const char *t_(string)(const char *const key) { return key; }
 #		endif
 
+/** @return The size class that holds `leaves`. */
+static unsigned pT_(capacity)(const unsigned leaves) {
+	unsigned capacity = 2;
+	while(capacity < leaves) capacity <<= 1;
+	return capacity < TRIE_ORDER ? capacity : TRIE_ORDER;
+}
+/** @return The bytes of the links in a bough with room for `capacity`. */
+static size_t pT_(bmp_size)(const unsigned capacity)
+	{ return sizeof(bmpchunk) * TRIE_ROUND(capacity, TRIE_CHUNK) / TRIE_CHUNK; }
+/** @return The offset of the branches in a bough with room for `capacity`. */
+static size_t pT_(branch_offset)(const unsigned capacity) {
+	assert(capacity && capacity <= TRIE_ORDER);
+	return offsetof(struct pT_(bough), bmp) + pT_(bmp_size)(capacity);
+}
+/** @return The offset of the leaves in a bough with room for `capacity`. */
+static size_t pT_(leaf_offset)(const unsigned capacity) {
+	return TRIE_ROUND(pT_(branch_offset)(capacity) + sizeof(struct trie_branch)
+		* (capacity - 1), offsetof(struct pT_(leaf_align), leaf));
+}
+#		ifdef TRIE_COUNT
+/** @return The offset of the counts in a bough with room for `capacity`. */
+static size_t pT_(size_offset)(const unsigned capacity) {
+	return TRIE_ROUND(pT_(leaf_offset)(capacity) + sizeof(union pT_(leaf))
+		* capacity, offsetof(struct trie_size_align, size));
+}
+#		endif
+/** @return The end of the leaves, and what is kept beside them before the
+ scores, in a bough with room for `capacity`. */
+static size_t pT_(leaf_end)(const unsigned capacity) {
+#		ifdef TRIE_COUNT
+	return pT_(size_offset)(capacity) + sizeof(size_t) * capacity;
+#		else
+	return pT_(leaf_offset)(capacity) + sizeof(union pT_(leaf)) * capacity;
+#		endif
+}
+#		ifdef TRIE_SCORE
+/** @return The offset of the scores in a bough with room for `capacity`. */
+static size_t pT_(best_offset)(const unsigned capacity) {
+	return TRIE_ROUND(pT_(leaf_end)(capacity),
+		offsetof(struct pT_(best_align), best));
+}
+#		endif
+/** @return The bytes in a bough with room for `capacity` leaves. */
+static size_t pT_(bough_size)(const unsigned capacity) {
+#		ifdef TRIE_SCORE
+	return pT_(best_offset)(capacity) + sizeof(struct pT_(best)) * capacity;
+#		else
+	return pT_(leaf_end)(capacity);
+#		endif
+}
+/** @return The branches of `bough`, after the links. */
+static struct trie_branch *pT_(branch)(const struct pT_(bough) *const bough) {
+	union { const struct pT_(bough) *readonly; struct pT_(bough) *promise; }
+		slybox;
+	slybox.readonly = bough;
+	return (struct trie_branch *)(void *)((char *)slybox.promise
+		+ pT_(branch_offset)(bough->capacity));
+}
+/** @return The leaves of `bough`, after the branches. */
+static union pT_(leaf) *pT_(leaf)(const struct pT_(bough) *const bough) {
+	union { const struct pT_(bough) *readonly; struct pT_(bough) *promise; }
+		slybox;
+	slybox.readonly = bough;
+	return (union pT_(leaf) *)(void *)((char *)slybox.promise
+		+ pT_(leaf_offset)(bough->capacity));
+}
+#		ifdef TRIE_COUNT
+/** @return The entries under each leaf of `bough`, after the leaves: one for
+ an entry, and the count of the bough for a link. */
+static size_t *pT_(size)(const struct pT_(bough) *const bough) {
+	union { const struct pT_(bough) *readonly; struct pT_(bough) *promise; }
+		slybox;
+	slybox.readonly = bough;
+	return (size_t *)(void *)((char *)slybox.promise
+		+ pT_(size_offset)(bough->capacity));
+}
+#		endif
+#		ifdef TRIE_SCORE
+/** @return The scores of each leaf of `bough`, after the leaves. */
+static struct pT_(best) *pT_(best)(const struct pT_(bough) *const bough) {
+	union { const struct pT_(bough) *readonly; struct pT_(bough) *promise; }
+		slybox;
+	slybox.readonly = bough;
+	return (struct pT_(best) *)(void *)((char *)slybox.promise
+		+ pT_(best_offset)(bough->capacity));
+}
+#		endif
+/** Moves `n` leaves of `bough` from `from` to `to`, with what is kept beside
+ them. */
+static void pT_(leaf_move)(struct pT_(bough) *const bough,
+	const unsigned to, const unsigned from, const unsigned n) {
+	memmove(pT_(leaf)(bough) + to, pT_(leaf)(bough) + from,
+		sizeof(union pT_(leaf)) * n);
+#		ifdef TRIE_COUNT
+	memmove(pT_(size)(bough) + to, pT_(size)(bough) + from, sizeof(size_t) * n);
+#		endif
+#		ifdef TRIE_SCORE
+	memmove(pT_(best)(bough) + to, pT_(best)(bough) + from,
+		sizeof(struct pT_(best)) * n);
+#		endif
+}
+/** Copies `n` leaves of `src` from `from` to `to` in `dst`, with what is kept
+ beside them. */
+static void pT_(leaf_copy)(struct pT_(bough) *const dst, const unsigned to,
+	const struct pT_(bough) *const src, const unsigned from, const unsigned n) {
+	memcpy(pT_(leaf)(dst) + to, pT_(leaf)(src) + from,
+		sizeof(union pT_(leaf)) * n);
+#		ifdef TRIE_COUNT
+	memcpy(pT_(size)(dst) + to, pT_(size)(src) + from, sizeof(size_t) * n);
+#		endif
+#		ifdef TRIE_SCORE
+	memcpy(pT_(best)(dst) + to, pT_(best)(src) + from,
+		sizeof(struct pT_(best)) * n);
+#		endif
+}
+/** Sets all the leaves of `bough` to entries. */
+static void pT_(links_clear)(struct pT_(bough) *const bough)
+	{ memset(&bough->bmp, 0, pT_(bmp_size)(bough->capacity)); }
+/** Calls `move`, which is `trie_bmp_insert` or `trie_bmp_remove`, with `x`
+ and `n` on the links of `bough`; the chunks past its capacity are zero. */
+static void pT_(links_move)(struct pT_(bough) *const bough,
+	void (*const move)(struct trie_bmp *, unsigned, unsigned),
+	const unsigned x, const unsigned n) {
+	struct trie_bmp bmp;
+	const size_t size = pT_(bmp_size)(bough->capacity);
+	if(size == sizeof bmp) { move(&bough->bmp, x, n); return; }
+	memcpy(&bmp, &bough->bmp, size);
+	memset((char *)&bmp + size, 0, sizeof bmp - size);
+	move(&bmp, x, n);
+	memcpy(&bough->bmp, &bmp, size);
+}
+
 /* fixme: This is terrible! */
 /** @return Given `ref`, get the remit, which is either a pointer or the entry
  itself. */
 static pT_(remit) pT_(ref_to_remit)(const struct pT_(ref) *const ref) {
 #		ifdef TRIE_ENTRY
-	return &ref->bough->leaf[ref->lf].as_entry;
+	return &pT_(leaf)(ref->bough)[ref->lf].as_entry;
 #		else
-	return ref->bough->leaf[ref->lf].as_entry;
+	return pT_(leaf)(ref->bough)[ref->lf].as_entry;
 #		endif
 }
 /** @return Given `ref`, get the string. */
 static const char *pT_(ref_to_string)(const struct pT_(ref) *const ref) {
-#		ifdef TRIE_ENTRY
+#		ifdef TRIE_KEY_BYTES
+	/* The key is at the start of the entry. */
+	return (const char *)&pT_(leaf)(ref->bough)[ref->lf].as_entry;
+#		elif defined TRIE_ENTRY
 	/* <fn:<t>string> defined by the user iff `TRIE_KEY`, but <fn:<t>key> must
 	 be defined by the user. */
-	return t_(string)(t_(key)(&ref->bough->leaf[ref->lf].as_entry));
+	return t_(string)(t_(key)(&pT_(leaf)(ref->bough)[ref->lf].as_entry));
+#		else
+	return t_(string)(pT_(leaf)(ref->bough)[ref->lf].as_entry);
+#		endif
+}
+/** @return Whether `string` has bytes before `next`, which is stored in
+ `*cur`. Fixed-width keys only branch on bits that are in all keys. */
+static int pT_(is_long)(const char *const string, size_t *const cur,
+	const size_t next) {
+#		ifdef TRIE_KEY_BYTES
+	(void)string, (void)cur, (void)next, assert(next < TRIE_KEY_BYTES);
+	return 1;
 #		else
-	return t_(string)(ref->bough->leaf[ref->lf].as_entry);
+	return trie_is_long(string, cur, next);
+#		endif
+}
+/** @return Lexicographic order of the keys `a` and `b`. */
+static int pT_(key_compare)(const char *const a, const char *const b) {
+#		ifdef TRIE_KEY_BYTES
+	return memcmp(a, b, TRIE_KEY_BYTES);
+#		else
+	return strcmp(a, b);
 #		endif
 }
 /** Fall through `ref` until hit the first entry. Must be pointing at
  something. */
 static void pT_(lower_entry)(struct pT_(ref) *ref) {
 	while(trie_bmp_test(&ref->bough->bmp, ref->lf))
-		ref->bough = ref->bough->leaf[ref->lf].as_link, ref->lf = 0;
+		ref->bough = pT_(leaf)(ref->bough)[ref->lf].as_link, ref->lf = 0;
 }
 /** Fall through `ref` until hit the last entry. Must be pointing at
  something. */
 static void pT_(higher_entry)(struct pT_(ref) *ref) {
 	while(trie_bmp_test(&ref->bough->bmp, ref->lf))
-		ref->bough = ref->bough->leaf[ref->lf].as_link,
+		ref->bough = pT_(leaf)(ref->bough)[ref->lf].as_link,
 		ref->lf = ref->bough->leaves - 1;
 }
 /** This is a convince function for <fn:<pT>match_prefix>.
@@ -290,25 +863,24 @@ static const char *pT_(sample)(const struct pT_(bough) *const tree,
 	return pT_(ref_to_string)(&ref);
 }
 
-/** @return Looks at only the index of `trie` (non-null) for potential `prefix`
- matches. */
-static struct T_(cursor) pT_(match_prefix)
-	(const struct t_(trie) *const trie, const char *const prefix) {
-	struct T_(cursor) cur;
+/** Looks at only the index of `trie` (non-null) for potential `prefix` matches.
+ @return Whether there are any, in which case they are all in the leaves from
+ `*lf0` to `*lf1` of `*bough`. */
+static int pT_(prefix_leaves)(const struct t_(trie) *const trie,
+	const char *const prefix, struct pT_(bough) **const bough_out,
+	unsigned *const lf0, unsigned *const lf1) {
 	struct pT_(bough) *bough;
 	size_t bit;
-	struct { size_t cur, next; } byte;
-	assert(trie && prefix);
-	cur.root = 0;
-	if(!(bough = trie->trunk) || !bough->leaves) return cur;
-	for(bit = 0, byte.cur = 0; ; ) {
+	size_t byte; /* `prefix` null checks up to here. */
+	assert(trie && prefix && bough_out && lf0 && lf1);
+	if(!(bough = trie->trunk) || !bough->leaves) return 0;
+	for(bit = 0, byte = 0; ; ) {
 		unsigned br0 = 0, br1 = bough->leaves - 1, lf = 0;
 		while(br0 < br1) {
-			const struct trie_branch *const branch = bough->branch + br0;
+			const struct trie_branch *const branch = pT_(branch)(bough) + br0;
 			/* _Sic_; '\0' is _not_ included for partial match. */
-			for(byte.next = (bit += branch->skip) / CHAR_BIT;
-				byte.cur <= byte.next; byte.cur++)
-				if(prefix[byte.cur] == '\0') goto finally;
+			if(!trie_is_long(prefix, &byte,
+				(bit += branch->skip) / CHAR_BIT + 1)) goto finally;
 			if(!TRIE_QUERY(prefix, bit))
 				br1 = ++br0 + branch->left;
 			else
@@ -316,26 +888,127 @@ static struct T_(cursor) pT_(match_prefix)
 			bit++;
 		}
 		if(trie_bmp_test(&bough->bmp, lf))
-			{ bough = bough->leaf[lf].as_link; continue; } /* Link. */
+			{ bough = pT_(leaf)(bough)[lf].as_link; continue; } /* Link. */
 finally:
 		assert(br0 <= br1 && lf - br0 + br1 < bough->leaves);
-		cur.root = trie->trunk;
-		cur.start.bough = cur.end.bough = bough;
-		/* Such that <fn:<T>next> is the first and end is greater than. */
-		cur.start.lf = lf, pT_(lower_entry)(&cur.start);
-		cur.end.lf = lf + br1 - br0, pT_(higher_entry)(&cur.end);
-		break;
+		*bough_out = bough, *lf0 = lf, *lf1 = lf + br1 - br0;
+		return 1;
 	}
+}
+
+/** @return Looks at only the index of `trie` (non-null) for potential `prefix`
+ matches. */
+static struct T_(cursor) pT_(match_prefix)
+	(const struct t_(trie) *const trie, const char *const prefix) {
+	struct T_(cursor) cur;
+	struct pT_(bough) *bough;
+	unsigned lf0, lf1;
+	cur.root = 0;
+	if(!pT_(prefix_leaves)(trie, prefix, &bough, &lf0, &lf1)) return cur;
+	cur.root = trie->trunk;
+	cur.start.bough = cur.end.bough = bough;
+	/* Such that <fn:<T>next> is the first and end is greater than. */
+	cur.start.lf = lf0, pT_(lower_entry)(&cur.start);
+	cur.end.lf = lf1, pT_(higher_entry)(&cur.end);
 	return cur;
 }
 
+/** Looks at the index of non-empty `trie` for a key that would be next to
+ `string`, and compares them. @return The first bit where `string` differs from
+ all the keys on its side of the difference, or `(size_t)-1` if `string` is in
+ `trie`. */
+static size_t pT_(diff)(const struct t_(trie) *const trie,
+	const char *const string) {
+	struct pT_(bough) *bough;
+	struct pT_(ref) ref;
+	const char *sample;
+	size_t bit, byte, diff;
+	unsigned br0, br1, lf;
+	assert(trie && trie->trunk && trie->trunk->leaves && string);
+	for(bough = trie->trunk, bit = 0, byte = 0; ;
+		bough = pT_(leaf)(bough)[lf].as_link) {
+		br0 = 0, br1 = bough->leaves - 1, lf = 0;
+		while(br0 < br1) {
+			const struct trie_branch *const branch = pT_(branch)(bough) + br0;
+			if(!pT_(is_long)(string, &byte, (bit += branch->skip) / CHAR_BIT))
+				goto exemplar; /* Any from here will do. */
+			if(!TRIE_QUERY(string, bit))
+				br1 = ++br0 + branch->left;
+			else
+				br0 += branch->left + 1, lf += branch->left + 1;
+			bit++;
+		}
+		if(!trie_bmp_test(&bough->bmp, lf)) break;
+	}
+exemplar:
+	ref.bough = bough, ref.lf = lf, pT_(lower_entry)(&ref);
+	sample = pT_(ref_to_string)(&ref);
+#		ifdef TRIE_KEY_BYTES
+	for(diff = 0; diff < TRIE_KEY_BYTES && string[diff] == sample[diff]; diff++);
+	if(diff == TRIE_KEY_BYTES) return (size_t)-1;
+#		else
+	for(diff = 0; string[diff] == sample[diff]; diff++)
+		if(string[diff] == '\0') return (size_t)-1;
+#		endif
+	for(diff *= CHAR_BIT; !TRIE_DIFF(string, sample, diff); diff++);
+	return diff;
+}
+
+/** Finds where `string` would go in the order of `trie`, putting the last
+ entry before in `before` and the first entry after in `after`, either of which
+ has a null bough if there isn't one. If `string` is in `trie`, `is_upper`
+ decides which side it is on. This is the same walk as <fn:<T>rank>, but
+ remembering the last turns. */
+static void pT_(bound)(const struct t_(trie) *const trie,
+	const char *const string, const int is_upper,
+	struct pT_(ref) *const before, struct pT_(ref) *const after) {
+	struct pT_(bough) *bough;
+	size_t bit, diff;
+	unsigned br0, br1, lf;
+	assert(trie && string && before && after);
+	before->bough = after->bough = 0;
+	if(!(bough = trie->trunk) || !bough->leaves) return;
+	diff = pT_(diff)(trie, string);
+	for(bit = 0; ; bough = pT_(leaf)(bough)[lf].as_link) {
+		br0 = 0, br1 = bough->leaves - 1, lf = 0;
+		while(br0 < br1) {
+			const struct trie_branch *const branch = pT_(branch)(bough) + br0;
+			if(diff <= (bit += branch->skip)) goto subtree;
+			if(!TRIE_QUERY(string, bit)) {
+				after->bough = bough, after->lf = lf + branch->left + 1;
+				br1 = ++br0 + branch->left;
+			} else {
+				before->bough = bough, before->lf = lf + branch->left;
+				br0 += branch->left + 1, lf += branch->left + 1;
+			}
+			bit++;
+		}
+		if(!trie_bmp_test(&bough->bmp, lf)) break;
+	}
+	if(diff == (size_t)-1) { /* The key at `lf` is `string`. */
+		assert(br0 == br1);
+		if(is_upper) before->bough = bough, before->lf = lf;
+		else after->bough = bough, after->lf = lf;
+		goto finally;
+	}
+subtree: /* The keys under here are all on one side of `string`. */
+	if(TRIE_QUERY(string, diff))
+		before->bough = bough, before->lf = lf + br1 - br0;
+	else
+		after->bough = bough, after->lf = lf;
+finally:
+	if(before->bough) pT_(higher_entry)(before);
+	if(after->bough) pT_(lower_entry)(after);
+}
+
 /** Destroys `bough`'s children and sets invalid state.
  @order \O(|`bough`|) both time and space. */
 static void pT_(clear_r)(struct pT_(bough) *const bough) {
 	unsigned i;
 	assert(bough && bough->leaves);
 	for(i = 0; i < bough->leaves; i++) if(trie_bmp_test(&bough->bmp, i))
-		pT_(clear_r)(bough->leaf[i].as_link), free(bough->leaf[i].as_link);
+		pT_(clear_r)(pT_(leaf)(bough)[i].as_link),
+		free(pT_(leaf)(bough)[i].as_link);
 }
 
 /** @return Is a candidate match for `string` in `trie`, (which must both be
@@ -343,18 +1016,19 @@ static void pT_(clear_r)(struct pT_(bough) *const bough) {
 static int pT_(match)(const struct t_(trie) *const trie,
 	const char *const string, struct pT_(ref) *const ref) {
 	size_t bit; /* In bits of `key`. */
-	struct { size_t cur, next; } byte; /* `key` null checks. */
+	size_t byte; /* `key` null checks up to here. */
 	assert(trie && string && ref);
 	/* Empty. */
 	if(!(ref->bough = trie->trunk) || !ref->bough->leaves) return 0;
-	for(bit = 0, byte.cur = 0; ; ref->bough = ref->bough->leaf[ref->lf].as_link) {
+	for(bit = 0, byte = 0; ;
+		ref->bough = pT_(leaf)(ref->bough)[ref->lf].as_link) {
 		unsigned br0 = 0, br1 = ref->bough->leaves - 1;
 		ref->lf = 0;
 		while(br0 < br1) {
-			const struct trie_branch *const branch = ref->bough->branch + br0;
-			for(byte.next = (bit += branch->skip) / CHAR_BIT;
-				byte.cur < byte.next; byte.cur++)
-				if(string[byte.cur] == '\0') return 0; /* Too short. */
+			const struct trie_branch *const branch
+				= pT_(branch)(ref->bough) + br0;
+			if(!pT_(is_long)(string, &byte, (bit += branch->skip) / CHAR_BIT))
+				return 0; /* Too short. */
 			if(!TRIE_QUERY(string, bit))
 				br1 = ++br0 + branch->left;
 			else
@@ -371,20 +1045,148 @@ static int pT_(get)(const struct t_(trie) *const trie,
 	const char *const string, struct pT_(ref) *const ref) {
 	assert(trie && string && ref);
 	return pT_(match)(trie, string, ref)
-		&& !strcmp(pT_(ref_to_string)(ref), string);
+		&& !pT_(key_compare)(pT_(ref_to_string)(ref), string);
 }
 
-/** Splits `bough` into two. Used in <fn:<pT>add>. @throws[malloc] */
-static int pT_(split)(struct pT_(bough) *const bough) {
-	unsigned br0, br1, lf;
+/** @return A new bough in the size class of `leaves`, with `leaves` unset.
+ @throws[malloc] */
+static struct pT_(bough) *pT_(new_bough)(const unsigned leaves) {
+	const unsigned capacity = pT_(capacity)(leaves);
+	struct pT_(bough) *const bough = malloc(pT_(bough_size)(capacity));
+	if(bough) bough->capacity = (unsigned short)capacity;
+#		ifdef TRIE_CONCURRENT
+	if(bough) bough->generation = 0;
+#		endif
+	return bough;
+}
+
+#		ifdef TRIE_CONCURRENT
+/** While writing concurrently, `bough` was made by the writer of `trie`. */
+static void pT_(stamp)(const struct t_(trie) *const trie,
+	struct pT_(bough) *const bough)
+	{ bough->generation = trie->writer ? trie->writer->generation : 0; }
+#		endif
+
+/** Moves the branches and leaves of `bough`, which has room for both, from
+ where they are in the size class `from` to where they are in `to`. */
+static void pT_(move_tail)(struct pT_(bough) *const bough,
+	const unsigned from, const unsigned to) {
+	char *const base = (char *)bough;
+	const size_t branch0 = pT_(branch_offset)(from),
+		branch1 = pT_(branch_offset)(to),
+		leaf0 = pT_(leaf_offset)(from), leaf1 = pT_(leaf_offset)(to),
+#		ifdef TRIE_COUNT
+		size0 = pT_(size_offset)(from), size1 = pT_(size_offset)(to),
+		sizes = sizeof(size_t) * bough->leaves,
+#		endif
+#		ifdef TRIE_SCORE
+		best0 = pT_(best_offset)(from), best1 = pT_(best_offset)(to),
+		bests = sizeof(struct pT_(best)) * bough->leaves,
+#		endif
+		branches = bough->leaves
+		? sizeof(struct trie_branch) * (bough->leaves - 1u) : 0,
+		leaves = sizeof(union pT_(leaf)) * bough->leaves;
+	if(from < to) { /* Backwards, and the new chunks have no links. */
+#		ifdef TRIE_SCORE
+		memmove(base + best1, base + best0, bests);
+#		endif
+#		ifdef TRIE_COUNT
+		memmove(base + size1, base + size0, sizes);
+#		endif
+		memmove(base + leaf1, base + leaf0, leaves);
+		memmove(base + branch1, base + branch0, branches);
+		memset(base + branch0, 0, branch1 - branch0);
+	} else {
+		memmove(base + branch1, base + branch0, branches);
+		memmove(base + leaf1, base + leaf0, leaves);
+#		ifdef TRIE_COUNT
+		memmove(base + size1, base + size0, sizes);
+#		endif
+#		ifdef TRIE_SCORE
+		memmove(base + best1, base + best0, bests);
+#		endif
+	}
+	bough->capacity = (unsigned short)to;
+}
+
+/** Moves the bough in `slot`, which is the trunk or a link, to the size class
+ of `leaves`. @return Success, otherwise it's unchanged. @throws[realloc] */
+static int pT_(resize)(struct pT_(bough) **const slot, const unsigned leaves) {
+	const unsigned capacity = pT_(capacity)(leaves);
+	struct pT_(bough) *bough = *slot;
+	assert(slot && bough && bough->leaves <= capacity);
+	if(capacity == bough->capacity) return 1;
+	if(capacity < bough->capacity) {
+		/* If it can't give back the memory, it's still in the smaller class. */
+		pT_(move_tail)(bough, bough->capacity, capacity);
+		if(bough = realloc(bough, pT_(bough_size)(capacity))) *slot = bough;
+		return 1;
+	}
+	if(!(bough = realloc(bough, pT_(bough_size)(capacity)))) return 0;
+	pT_(move_tail)(bough, bough->capacity, capacity), *slot = bough;
+	return 1;
+}
+
+#		if defined TRIE_COUNT || defined TRIE_SCORE
+/** Goes down the path of `string`, which is in `trie`. Each link counts
+ `change`, one more, one less, or the same, and the score of each leaf on the
+ path is stale. */
+static void pT_(touch_path)(struct t_(trie) *const trie,
+	const char *const string, const int change) {
+	struct pT_(bough) *bough = trie->trunk;
+	size_t bit = 0;
+	assert(trie && string && bough && change >= -1 && change <= 1);
+	(void)change;
+	for( ; ; ) {
+		unsigned br0 = 0, br1 = bough->leaves - 1, lf = 0;
+		while(br0 < br1) {
+			const struct trie_branch *const branch = pT_(branch)(bough) + br0;
+			bit += branch->skip;
+			if(!TRIE_QUERY(string, bit))
+				br1 = ++br0 + branch->left;
+			else
+				br0 += branch->left + 1, lf += branch->left + 1;
+			bit++;
+		}
+#			ifdef TRIE_SCORE
+		pT_(best)(bough)[lf].stale = 1;
+#			endif
+		if(!trie_bmp_test(&bough->bmp, lf)) break;
+#			ifdef TRIE_COUNT
+		if(change > 0) pT_(size)(bough)[lf]++;
+		else if(change < 0)
+			assert(pT_(size)(bough)[lf] > 1), pT_(size)(bough)[lf]--;
+#			endif
+		bough = pT_(leaf)(bough)[lf].as_link;
+	}
+}
+#		endif
+
+#		ifdef TRIE_COUNT
+/** @return The number of entries under the leaves `lf0` to `lf1` of `bough`,
+ from the counts, without looking at the boughs linked.
+ @order \O(`lf1` - `lf0`) */
+static size_t pT_(sum)(const struct pT_(bough) *const bough,
+	const unsigned lf0, const unsigned lf1) {
+	const size_t *const size = pT_(size)(bough);
+	size_t sum = 0;
+	unsigned lf;
+	assert(bough && lf0 <= lf1 && lf1 < bough->leaves);
+	for(lf = lf0; lf <= lf1; lf++) sum += size[lf];
+	return sum;
+}
+#		endif
+
+/** Splits `bough` of `trie` into two. Used in <fn:<pT>add>. @throws[malloc] */
+static int pT_(split)(struct t_(trie) *const trie,
+	struct pT_(bough) *const bough) {
+	unsigned br0, br1, lf, i;
 	struct pT_(bough) *kid;
 	assert(bough && bough->leaves == TRIE_ORDER);
-	/* Mitosis; more info added on error in <fn:<PT>add_unique>. */
-	if(!(kid = malloc(sizeof *kid))) return 0;
 	/* Where should we split it? <https://cs.stackexchange.com/q/144928> */
 	br0 = 0, br1 = bough->leaves - 1, lf = 0;
 	do {
-		const struct trie_branch *const branch = bough->branch + br0;
+		const struct trie_branch *const branch = pT_(branch)(bough) + br0;
 		const unsigned right = br1 - br0 - 1 - branch->left;
 		assert(br0 < br1);
 		if(branch->left > right) /* Prefer right; it's less work copying. */
@@ -392,15 +1194,22 @@ static int pT_(split)(struct pT_(bough) *const bough) {
 		else
 			br0 += branch->left + 1, lf += branch->left + 1;
 	} while(2 * (br1 - br0) + 1 > TRIE_SPLIT);
+	/* Mitosis; more info added on error in <fn:<PT>add_unique>. */
+	if(!(kid = pT_(new_bough)(br1 - br0 + 1))) return 0;
+#		ifdef TRIE_CONCURRENT
+	pT_(stamp)(trie, kid);
+#		else
+	(void)trie;
+#		endif
 	/* Copy data rooted at the current node. */
-	kid->leaves = (unsigned char)(br1 - br0) + 1;
-	memcpy(kid->branch, bough->branch + br0,
-		sizeof *bough->branch * (kid->leaves - 1));
-	memcpy(kid->leaf, bough->leaf + lf, sizeof *bough->leaf * kid->leaves);
+	kid->leaves = (unsigned short)(br1 - br0 + 1);
+	memcpy(pT_(branch)(kid), pT_(branch)(bough) + br0,
+		sizeof(struct trie_branch) * (kid->leaves - 1));
+	pT_(leaf_copy)(kid, 0, bough, lf, kid->leaves);
 	/* Subtract `tree` left branches; (right branches are implicit.) */
 	br0 = 0, br1 = bough->leaves - 1, lf = 0;
 	do {
-		struct trie_branch *const branch = bough->branch + br0;
+		struct trie_branch *const branch = pT_(branch)(bough) + br0;
 		const unsigned right = br1 - br0 - 1 - branch->left;
 		assert(br0 < br1);
 		if(branch->left > right)
@@ -409,19 +1218,24 @@ static int pT_(split)(struct pT_(bough) *const bough) {
 			br0 += branch->left + 1, lf += branch->left + 1;
 	} while(2 * (br1 - br0) + 1 > TRIE_SPLIT);
 	/* Delete from `tree`. */
-	memmove(bough->branch + br0, bough->branch + br1,
-		sizeof *bough->branch * (bough->leaves - 1 - br1));
-	memmove(bough->leaf + lf + 1, bough->leaf + lf + kid->leaves,
-		sizeof *bough->leaf * (bough->leaves - lf - kid->leaves));
-	/* Move the bits. */
-	memcpy(&kid->bmp, &bough->bmp, sizeof bough->bmp);
-	trie_bmp_remove(&kid->bmp, 0, lf);
-	trie_bmp_remove(&kid->bmp, kid->leaves,
+	memmove(pT_(branch)(bough) + br0, pT_(branch)(bough) + br1,
+		sizeof(struct trie_branch) * (bough->leaves - 1 - br1));
+	pT_(leaf_move)(bough, lf + 1, lf + kid->leaves,
 		bough->leaves - lf - kid->leaves);
-	trie_bmp_remove(&bough->bmp, lf + 1, kid->leaves - 1);
+	/* Move the bits. */
+	pT_(links_clear)(kid);
+	for(i = 0; i < kid->leaves; i++) if(trie_bmp_test(&bough->bmp, lf + i))
+		trie_bmp_set(&kid->bmp, i);
+	pT_(links_move)(bough, &trie_bmp_remove, lf + 1, kid->leaves - 1u);
 	trie_bmp_set(&bough->bmp, lf);
-	bough->leaf[lf].as_link = kid;
+	pT_(leaf)(bough)[lf].as_link = kid;
 	bough->leaves -= kid->leaves - 1;
+#		ifdef TRIE_COUNT
+	pT_(size)(bough)[lf] = pT_(sum)(kid, 0, kid->leaves - 1u);
+#		endif
+#		ifdef TRIE_SCORE
+	pT_(best)(bough)[lf].stale = 1;
+#		endif
 	return 1;
 }
 
@@ -433,14 +1247,13 @@ static unsigned pT_(open)(struct pT_(bough) *const bough,
 	size_t bough_bit, const char *const key, size_t diff_bit) {
 	unsigned br0, br1, lf;
 	struct trie_branch *branch;
-	union pT_(leaf) *leaf;
 	size_t bit1;
 	unsigned is_right;
 	assert(key && bough && bough->leaves && bough->leaves < TRIE_ORDER);
 	/* Modify the tree's left branches to account for the new leaf. */
 	br0 = 0, br1 = bough->leaves - 1, lf = 0;
 	while(br0 < br1) {
-		branch = bough->branch + br0;
+		branch = pT_(branch)(bough) + br0;
 		bit1 = bough_bit + branch->skip;
 		/* Decision bits can never be the site of a difference. */
 		if(diff_bit <= bit1) { assert(diff_bit < bit1); break; }
@@ -455,11 +1268,10 @@ static unsigned pT_(open)(struct pT_(bough) *const bough,
 	if(is_right = !!TRIE_QUERY(key, diff_bit)) lf += br1 - br0 + 1;
 	/* Make room in leaves. */
 	assert(lf <= bough->leaves);
-	leaf = bough->leaf + lf;
-	memmove(leaf + 1, leaf, sizeof *leaf * (bough->leaves - lf));
-	trie_bmp_insert(&bough->bmp, lf, 1);
+	pT_(leaf_move)(bough, lf + 1, lf, bough->leaves - lf);
+	pT_(links_move)(bough, &trie_bmp_insert, lf, 1);
 	/* Add a branch. */
-	branch = bough->branch + br0;
+	branch = pT_(branch)(bough) + br0;
 	if(br0 != br1) { /* Split with existing branch. */
 		assert(br0 < br1 && diff_bit + 1 <= bough_bit + branch->skip);
 		branch->skip -= diff_bit - bough_bit + 1;
@@ -476,35 +1288,43 @@ static unsigned pT_(open)(struct pT_(bough) *const bough,
 static enum trie_result pT_(add)(struct t_(trie) *const trie, pT_(key) key,
 	struct pT_(ref) *const found) {
 	unsigned br0, br1;
-	struct { size_t cur, next; } byte; /* `key` null checks. */
+	size_t byte; /* `key` null checks up to here. */
 	struct pT_(ref) exemplar, ref;
+	struct pT_(bough) **slot; /* Where `ref.bough` is, for resizing. */
+#		ifdef TRIE_KEY_BYTES
+	const char *const key_string = (const char *)&key, *exemplar_string;
+#		else
 	const char *const key_string = t_(string)(key), *exemplar_string;
+#		endif
 	size_t bit1, diff, bough_bit1;
 	assert(trie && key_string);
 	if(!(ref.bough = trie->trunk)) { /* Idle. */
-		if(!(ref.bough = malloc(sizeof *ref.bough))) goto catch;
+		if(!(ref.bough = pT_(new_bough)(1))) goto catch;
+#		ifdef TRIE_CONCURRENT
+		pT_(stamp)(trie, ref.bough);
+#		endif
 		ref.bough->leaves = 0;
 		trie->trunk = ref.bough;
 	} /* Fall-through. */
 	if(!ref.bough->leaves) { /* Empty: special case. */
 		ref.bough->leaves = 1, ref.lf = 0;
-		trie_bmp_clear_all(&ref.bough->bmp);
+		pT_(links_clear)(ref.bough);
 		goto assign;
 	}
 	/* Otherwise we will be able to find an exemplar: a neighbouring key to the
 	 new key up to the difference, (after that, it doesn't matter.) */
-	for(bit1 = 0, byte.cur = 0; ;
-		ref.bough = ref.bough->leaf[ref.lf].as_link) {
+	for(bit1 = 0, byte = 0; ;
+		ref.bough = pT_(leaf)(ref.bough)[ref.lf].as_link) {
 		br0 = 0, br1 = ref.bough->leaves - 1, ref.lf = 0; /* Leaf. */
 		while(br0 < br1) {
-			const struct trie_branch *const branch = ref.bough->branch + br0;
-			for(byte.next = (bit1 += branch->skip) / CHAR_BIT;
-				byte.cur < byte.next; byte.cur++)
-				if(key_string[byte.cur] == '\0') {
-					bit1++;
-					pT_(lower_entry)(&ref); /* Arbitrarily pick the first. */
-					goto found_exemplar;
-				}
+			const struct trie_branch *const branch
+				= pT_(branch)(ref.bough) + br0;
+			if(!pT_(is_long)(key_string, &byte,
+				(bit1 += branch->skip) / CHAR_BIT)) {
+				bit1++;
+				pT_(lower_entry)(&ref); /* Arbitrarily pick the first. */
+				goto found_exemplar;
+			}
 			if(!TRIE_QUERY(key_string, bit1))
 				br1 = ++br0 + branch->left;
 			else
@@ -520,7 +1340,12 @@ found_exemplar:
 	{
 		const char *k = key_string, *e = exemplar_string;
 		for(diff = 0; *k == *e; k++, e++) {
-			if(*k == '\0') { if(found) *found = exemplar; return TRIE_PRESENT; }
+#		ifdef TRIE_KEY_BYTES
+			if(k + 1 == key_string + TRIE_KEY_BYTES)
+#		else
+			if(*k == '\0')
+#		endif
+				{ if(found) *found = exemplar; return TRIE_PRESENT; }
 			diff += CHAR_BIT;
 			/* Both one ahead at this point, (they might not exist.) */
 			if(bit1 + UCHAR_MAX < diff) return errno = EILSEQ, TRIE_ERROR;
@@ -532,13 +1357,14 @@ found_exemplar:
 	/* Too much similarity to fit in a limited skip, (~32 characters.) */
 	if((bit1 ? bit1 - 1 : 0) + UCHAR_MAX < diff) { errno = EILSEQ; goto catch; }
 	/* Restart and go to the difference. */
-	for(bit1 = 0, ref.bough = trie->trunk; ;
-		ref.bough = ref.bough->leaf[ref.lf].as_link) {
+	for(bit1 = 0, slot = &trie->trunk, ref.bough = *slot; ;
+		slot = &pT_(leaf)(ref.bough)[ref.lf].as_link, ref.bough = *slot) {
 		bough_bit1 = bit1;
 tree:
 		br0 = 0, br1 = ref.bough->leaves - 1, ref.lf = 0;
 		while(br0 < br1) {
-			const struct trie_branch *const branch = ref.bough->branch + br0;
+			const struct trie_branch *const branch
+				= pT_(branch)(ref.bough) + br0;
 			if(diff <= (bit1 += branch->skip)) goto found_diff;
 			if(!TRIE_QUERY(key_string, bit1))
 				br1 = ++br0 + branch->left;
@@ -556,17 +1382,27 @@ found_diff:
 	 `TREE_ORDER` be more makes this matter less. */
 	assert(ref.bough->leaves <= TRIE_ORDER);
 	if(ref.bough->leaves == TRIE_ORDER) {
-		if(!pT_(split)(ref.bough)) goto catch; /* Takes memory. */
+		if(!pT_(split)(trie, ref.bough)) goto catch; /* Takes memory. */
 		bit1 = bough_bit1;
 		goto tree; /* Start again from the top of the first tree. */
 	}
-	/* Tree is not full. */
+	/* Tree is not full, but it might need to go up a size class. */
+	if(ref.bough->leaves == ref.bough->capacity) {
+		if(!pT_(resize)(slot, ref.bough->leaves + 1u)) goto catch;
+		ref.bough = *slot;
+	}
 	ref.lf = pT_(open)(ref.bough, bough_bit1, key_string, diff);
 assign:
 #		ifndef TRIE_ENTRY
-	ref.bough->leaf[ref.lf].as_entry = key;
+	pT_(leaf)(ref.bough)[ref.lf].as_entry = key;
 #		else
 	/* Do not have enough information; rely on user to do it. */
+#		endif
+#		ifdef TRIE_COUNT
+	pT_(size)(ref.bough)[ref.lf] = 1;
+#		endif
+#		if defined TRIE_COUNT || defined TRIE_SCORE
+	pT_(touch_path)(trie, key_string, 1);
 #		endif
 	if(found) *found = ref;
 	return TRIE_ABSENT;
@@ -575,26 +1411,179 @@ catch:
 	return TRIE_ERROR;
 }
 
-/** Try to remove `string` from `trie`. @fixme Join when combined-half is less
- than a quarter? Probably crucial to performance in some corner cases. */
+#		ifdef TRIE_CONCURRENT /* <!-- retire */
+/** Makes room in the boughs `trie` is retiring, if any, for one more.
+ @return Success. @throws[realloc] */
+static int pT_(retire_reserve)(struct t_(trie) *const trie) {
+	struct pT_(retire) *const r = trie->writer ? &trie->writer->retired : 0;
+	struct pT_(bough) **data;
+	size_t capacity;
+	if(!r || r->size < r->capacity) return 1;
+	capacity = r->capacity ? r->capacity * 2 : 32;
+	if(!(data = realloc(r->data, sizeof *data * capacity))) return 0;
+	r->data = data, r->capacity = capacity;
+	return 1;
+}
+
+/** `bough` is not in `trie` any more; it is freed, or, while writing
+ concurrently and readers may have seen it, retired to be freed later. It must
+ have reserved space. */
+static void pT_(retire)(struct t_(trie) *const trie,
+	struct pT_(bough) *const bough) {
+	struct pT_(writer) *const w = trie->writer;
+	if(!w || bough->generation == w->generation) { free(bough); return; }
+	assert(w->retired.size < w->retired.capacity);
+	w->retired.data[w->retired.size++] = bough;
+}
+
+/** While writing concurrently, replaces the bough in `slot` of `trie` with a
+ copy, so that readers of the original don't see the change; one that was
+ made since the last publish is already the writer's.
+ @return Success, otherwise it's unchanged. @throws[malloc] */
+static int pT_(copy)(struct t_(trie) *const trie,
+	struct pT_(bough) **const slot) {
+	struct pT_(bough) *copy;
+	size_t size;
+	assert(trie && slot && *slot);
+	if(!trie->writer || (*slot)->generation == trie->writer->generation)
+		return 1;
+	size = pT_(bough_size)((*slot)->capacity);
+	if(!pT_(retire_reserve)(trie) || !(copy = malloc(size))) return 0;
+	memcpy(copy, *slot, size), pT_(stamp)(trie, copy);
+	pT_(retire)(trie, *slot), *slot = copy;
+	return 1;
+}
+
+/** Copies every bough on the path of `string` in `trie`, which is all that
+ <fn:<pT>add> and <fn:<pT>remove> change. @return Success, otherwise the
+ path is partly copied, which is the same trie. @throws[malloc] */
+static int pT_(copy_path)(struct t_(trie) *const trie,
+	const char *const string) {
+	struct pT_(bough) **slot = &trie->trunk;
+	size_t bit = 0, byte = 0;
+	assert(trie && string && trie->writer);
+	if(!*slot) return 1; /* Idle. */
+	for( ; ; ) {
+		struct pT_(bough) *bough;
+		unsigned br0 = 0, br1, lf = 0;
+		if(!pT_(copy)(trie, slot)) return 0;
+		if(!(bough = *slot)->leaves) return 1; /* Empty. */
+		for(br1 = bough->leaves - 1; br0 < br1; bit++) {
+			const struct trie_branch *const branch = pT_(branch)(bough) + br0;
+			if(!pT_(is_long)(string, &byte, (bit += branch->skip) / CHAR_BIT))
+				return 1;
+			if(!TRIE_QUERY(string, bit))
+				br1 = ++br0 + branch->left;
+			else
+				br0 += branch->left + 1, lf += branch->left + 1;
+		}
+		if(!trie_bmp_test(&bough->bmp, lf)) return 1;
+		slot = &pT_(leaf)(bough)[lf].as_link;
+	}
+}
+#		endif /* retire --> */
+
+/** Moves the bough linked at `lf` of the bough in `slot` into it; the leaves
+ together must be at most `TRIE_ORDER`. The child may be seen by readers of
+ `trie`. Used in <fn:<pT>compact>.
+ @return Success, otherwise it's unchanged. @throws[realloc] */
+static int pT_(join)(struct t_(trie) *const trie,
+	struct pT_(bough) **const slot, const unsigned lf) {
+	struct pT_(bough) *bough = *slot;
+	struct pT_(bough) *const child = pT_(leaf)(bough)[lf].as_link;
+	const unsigned more = child->leaves - 1u;
+	unsigned br0 = 0, br1 = bough->leaves - 1u, i = lf;
+	assert(trie && trie_bmp_test(&bough->bmp, lf) && child->leaves > 1
+		&& bough->leaves + more <= TRIE_ORDER);
+#		ifdef TRIE_CONCURRENT
+	if(!pT_(retire_reserve)(trie)) return 0;
+#		endif
+	if(bough->leaves + more > bough->capacity) {
+		if(!pT_(resize)(slot, bough->leaves + more)) return 0;
+		bough = *slot;
+	}
+	/* The link is a leaf; branches on the path to it get more on the left. */
+	while(br0 < br1) {
+		struct trie_branch *const branch = pT_(branch)(bough) + br0;
+		if(i <= branch->left)
+			br1 = ++br0 + branch->left, branch->left += more;
+		else
+			br0 += branch->left + 1u, i -= branch->left + 1u;
+	}
+	/* The child's root skip is already relative to the link's parent. */
+	memmove(pT_(branch)(bough) + br0 + more, pT_(branch)(bough) + br0,
+		sizeof(struct trie_branch) * (bough->leaves - 1u - br0));
+	memcpy(pT_(branch)(bough) + br0, pT_(branch)(child),
+		sizeof(struct trie_branch) * more);
+	pT_(leaf_move)(bough, lf + child->leaves, lf + 1, bough->leaves - lf - 1u);
+	pT_(leaf_copy)(bough, lf, child, 0, child->leaves);
+	pT_(links_move)(bough, &trie_bmp_insert, lf + 1, more);
+	for(i = 0; i < child->leaves; i++) {
+		if(trie_bmp_test(&child->bmp, i)) trie_bmp_set(&bough->bmp, lf + i);
+		else trie_bmp_clear(&bough->bmp, lf + i);
+	}
+	bough->leaves += more;
+#		ifdef TRIE_CONCURRENT
+	pT_(retire)(trie, child);
+#		else
+	(void)trie, free(child);
+#		endif
+	return 1;
+}
+
+/** Going down the path of `string` in `trie`, boughs that are less than
+ `TRIE_JOIN` take in the boughs they link to while it fits. Used in
+ <fn:<pT>remove>. */
+static void pT_(compact)(struct t_(trie) *const trie, const char *const string)
+{
+	struct pT_(bough) **slot = &trie->trunk, *bough;
+	size_t bit; /* In bits of `key`. */
+	size_t byte; /* `key` null checks up to here. */
+	assert(trie && string);
+	if(!(bough = *slot) || bough->leaves < 2) return;
+	for(bit = 0, byte = 0; ; ) {
+		unsigned br0 = 0, br1, lf = 0;
+		if(bough->leaves < TRIE_JOIN) while(lf < bough->leaves) {
+			/* On joining, look at the new `lf`; it's fine if it can't. */
+			if(trie_bmp_test(&bough->bmp, lf) && bough->leaves
+				+ pT_(leaf)(bough)[lf].as_link->leaves - 1 <= TRIE_JOIN
+				&& pT_(join)(trie, slot, lf)) bough = *slot;
+			else
+				lf++;
+		}
+		for(br1 = bough->leaves - 1, lf = 0; br0 < br1; bit++) {
+			const struct trie_branch *const branch = pT_(branch)(bough) + br0;
+			if(!pT_(is_long)(string, &byte, (bit += branch->skip) / CHAR_BIT))
+				return;
+			if(!TRIE_QUERY(string, bit))
+				br1 = ++br0 + branch->left;
+			else
+				br0 += branch->left + 1, lf += branch->left + 1;
+		}
+		if(!trie_bmp_test(&bough->bmp, lf)) return;
+		slot = &pT_(leaf)(bough)[lf].as_link, bough = *slot;
+	}
+}
+
+/** Try to remove `string` from `trie`. Boughs are joined going down its path
+ with <fn:<pT>compact>, so the trie doesn't keep sparse boughs after churn. */
 static int pT_(remove)(struct t_(trie) *const trie, const char *const string) {
 	struct pT_(bough) *bough;
 	size_t bit; /* In bits of `key`. */
-	struct { size_t cur, next; } byte; /* `key` null checks. */
+	size_t byte; /* `key` null checks up to here. */
 	struct { unsigned br0, br1, lf; } ye, no, up;
 	unsigned parent_br = 0; /* Same tree. Useless initialization. */
 	struct pT_(ref) prev = { 0, 0 } /* Diff. */, rm;
 	assert(trie && string);
 	/* Same as match, except keep track of more stuff. */
 	if(!(bough = trie->trunk) || !bough->leaves) return 0; /* Empty. */
-	for(bit = 0, byte.cur = 0; ; ) {
+	for(bit = 0, byte = 0; ; ) {
 		ye.br0 = no.br0 = 0, ye.br1 = no.br1 = bough->leaves - 1, ye.lf = no.lf = 0;
 		while(ye.br0 < ye.br1) {
 			const struct trie_branch *const branch
-				= bough->branch + (parent_br = ye.br0);
-			for(byte.next = (bit += branch->skip) / CHAR_BIT;
-				byte.cur < byte.next; byte.cur++)
-				if(string[byte.cur] == '\0') return 0; /* `key` too short. */
+				= pT_(branch)(bough) + (parent_br = ye.br0);
+			if(!pT_(is_long)(string, &byte, (bit += branch->skip) / CHAR_BIT))
+				return 0; /* `key` too short. */
 			if(!TRIE_QUERY(string, bit))
 				no.lf = ye.lf + branch->left + 1,
 				no.br1 = ye.br1,
@@ -607,14 +1596,14 @@ static int pT_(remove)(struct t_(trie) *const trie, const char *const string) {
 		}
 		if(!trie_bmp_test(&bough->bmp, ye.lf)) break;
 		prev.bough = bough, prev.lf = ye.lf;
-		bough = bough->leaf[ye.lf].as_link; /* Jumped trees. */
+		bough = pT_(leaf)(bough)[ye.lf].as_link; /* Jumped trees. */
 	}
 	rm.bough = bough, rm.lf = ye.lf;
-	if(strcmp(pT_(ref_to_string)(&rm), string)) return 0;
+	if(pT_(key_compare)(pT_(ref_to_string)(&rm), string)) return 0;
 	/* If a branch, branch not taken's skip merges with the parent. */
 	if(no.br0 < no.br1) {
-		struct trie_branch *const parent = bough->branch + parent_br,
-			*const no_child = bough->branch + no.br0;
+		struct trie_branch *const parent = pT_(branch)(bough) + parent_br,
+			*const no_child = pT_(branch)(bough) + no.br0;
 		/* Would cause overflow. */
 		if(parent->skip == UCHAR_MAX
 			|| no_child->skip > UCHAR_MAX - parent->skip - 1)
@@ -622,24 +1611,33 @@ static int pT_(remove)(struct t_(trie) *const trie, const char *const string) {
 		no_child->skip += parent->skip + 1;
 	} else if(no.br0 == no.br1 && trie_bmp_test(&bough->bmp, no.lf)) {
 		/* Branch not taken is a link leaf. */
-		struct trie_branch *const parent = bough->branch + parent_br;
-		struct pT_(bough) *const downstream = bough->leaf[no.lf].as_link;
+		struct trie_branch *const parent = pT_(branch)(bough) + parent_br;
+		struct pT_(bough) *downstream = pT_(leaf)(bough)[no.lf].as_link;
 		assert(downstream);
 		if(downstream->leaves > 1) {
 			if(parent->skip == UCHAR_MAX
-				|| downstream->branch[0].skip > UCHAR_MAX - parent->skip - 1)
+				|| pT_(branch)(downstream)[0].skip
+				> UCHAR_MAX - parent->skip - 1)
 				return errno = EILSEQ, 0;
-			downstream->branch[0].skip += parent->skip + 1;
+#		ifdef TRIE_CONCURRENT
+			/* Off the path, so it wasn't copied. */
+			if(!pT_(copy)(trie, &pT_(leaf)(bough)[no.lf].as_link)) return 0;
+			downstream = pT_(leaf)(bough)[no.lf].as_link;
+#		endif
+			pT_(branch)(downstream)[0].skip += parent->skip + 1;
 		} else {
 			/* Don't allow links to be the single entry in a tree. */
 			assert(!trie_bmp_test(&downstream->bmp, 0));
 		}
 	}
+#		if defined TRIE_COUNT || defined TRIE_SCORE
+	pT_(touch_path)(trie, string, -1); /* It can't fail from here. */
+#		endif
 	/* Update `left` values for the path to the deleted branch. */
 	up.br0 = 0, up.br1 = bough->leaves - 1, up.lf = ye.lf;
 	if(!up.br1) goto erased_bough;
 	for( ; ; ) {
-		struct trie_branch *const branch = bough->branch + up.br0;
+		struct trie_branch *const branch = pT_(branch)(bough) + up.br0;
 		if(branch->left >= up.lf) {
 			if(!branch->left) break;
 			up.br1 = ++up.br0 + branch->left;
@@ -650,28 +1648,35 @@ static int pT_(remove)(struct t_(trie) *const trie, const char *const string) {
 		}
 	}
 	/* Remove the actual memory. */
-	memmove(bough->branch + parent_br, bough->branch
-		+ parent_br + 1, sizeof *bough->branch
+	memmove(pT_(branch)(bough) + parent_br, pT_(branch)(bough)
+		+ parent_br + 1, sizeof(struct trie_branch)
 		* (bough->leaves - 1 - parent_br - 1));
-	memmove(bough->leaf + ye.lf, bough->leaf + ye.lf + 1,
-		sizeof *bough->leaf * (bough->leaves - 1 - ye.lf));
+	pT_(leaf_move)(bough, ye.lf, ye.lf + 1, bough->leaves - 1u - ye.lf);
 	bough->leaves--;
 	/* Remove the bit. */
-	trie_bmp_remove(&bough->bmp, ye.lf, 1);
-	if(bough->leaves > 1) return 1; /* We are done. */
+	pT_(links_move)(bough, &trie_bmp_remove, ye.lf, 1);
+	if(bough->leaves > 1) {
+		/* Down a size class at a quarter; it doesn't matter if it can't. */
+		if(bough->leaves <= bough->capacity / 4) pT_(resize)(prev.bough
+			? &pT_(leaf)(prev.bough)[prev.lf].as_link : &trie->trunk,
+			bough->leaves);
+		pT_(compact)(trie, string);
+		return 1;
+	}
 	/* Just making sure. */
 	assert(!prev.bough || trie_bmp_test(&prev.bough->bmp, prev.lf));
 	if(trie_bmp_test(&bough->bmp, 0)) { /* A single link on it's own tree. */
-		struct pT_(bough) *const next = bough->leaf[0].as_link;
-		if(prev.bough) prev.bough->leaf[prev.lf].as_link = next;
+		struct pT_(bough) *const next = pT_(leaf)(bough)[0].as_link;
+		if(prev.bough) pT_(leaf)(prev.bough)[prev.lf].as_link = next;
 		else assert(trie->trunk == bough), trie->trunk = next;
 	} else if(prev.bough) { /* Single entry might as well go to previous tree. */
-		prev.bough->leaf[prev.lf].as_entry = bough->leaf[0].as_entry;
+		pT_(leaf)(prev.bough)[prev.lf].as_entry = pT_(leaf)(bough)[0].as_entry;
 		trie_bmp_clear(&prev.bough->bmp, prev.lf);
 	} else {
 		return 1; /* Just one entry; leave it be. */
 	}
 	free(bough);
+	pT_(compact)(trie, string);
 	return 1;
 erased_bough:
 	assert(trie->trunk == bough && bough->leaves == 1 && !trie_bmp_test(&bough->bmp, 0));
@@ -679,8 +1684,267 @@ erased_bough:
 	return 1;
 }
 
-#		define BOX_PUBLIC_OVERRIDE
-#		include "box.h"
+/** @return The string of `entry`. */
+static const char *pT_(entry_string)(const pT_(entry) *const entry) {
+#		ifdef TRIE_KEY_BYTES
+	return (const char *)entry;
+#		elif defined TRIE_ENTRY
+	return t_(string)(t_(key)(entry));
+#		else
+	return t_(string)(*entry);
+#		endif
+}
+/** @implements qsort on <typedef:<pT>entry>. */
+static int pT_(compare)(const void *const a, const void *const b)
+	{ return pT_(key_compare)(pT_(entry_string)(a), pT_(entry_string)(b)); }
+/* A branch of the binary tree of keys that are being bulk-loaded; `left` and
+ `right` are other branches, or `TRIE_LEAF` for the keys on either side. */
+struct pT_(build) { size_t bit, left, right; unsigned leaves, is_bough; };
+/** Bytes, then bits, where `a` and `b` differ is stored in `diff`.
+ @return Whether they differ, otherwise they are the same key. */
+static int pT_(build_diff)(const char *const a, const char *const b,
+	size_t *const diff) {
+	size_t byte;
+#		ifdef TRIE_KEY_BYTES
+	for(byte = 0; byte < TRIE_KEY_BYTES && a[byte] == b[byte]; byte++);
+	if(byte == TRIE_KEY_BYTES) return 0;
+#		else
+	for(byte = 0; a[byte] == b[byte]; byte++) if(a[byte] == '\0') return 0;
+#		endif
+	for(*diff = byte * CHAR_BIT; !TRIE_DIFF(a, b, *diff); (*diff)++);
+	return 1;
+}
+/** The `n - 1` branches of `build`, of which the `bit` is set, form a
+ Cartesian tree on the bits, in order, using `stack`, which has room for `n`.
+ @return The root branch. */
+static size_t pT_(build_tree)(struct pT_(build) *const build, const size_t n,
+	size_t *const stack) {
+	size_t top, i;
+	assert(n > 1);
+	for(top = 0, i = 0; i + 1 < n; i++) {
+		size_t last = TRIE_LEAF;
+		while(top && build[stack[top - 1]].bit > build[i].bit)
+			last = stack[--top];
+		build[i].left = last, build[i].right = TRIE_LEAF, build[i].is_bough = 0;
+		if(top) build[stack[top - 1]].right = i;
+		stack[top++] = i;
+	}
+	return stack[0];
+}
+/** In the post-order of the `b` branch of `build`, cuts the children off into
+ their own boughs until the leaves fit in one. `bit` is the first bit that the
+ branch can be on. @return Success, otherwise the key is too long and the skip
+ doesn't fit. */
+static int pT_(build_cut_r)(struct pT_(build) *const build, const size_t b,
+	const size_t bit) {
+	struct pT_(build) *const branch = build + b;
+	unsigned left = 1, right = 1;
+	if(branch->bit - bit > UCHAR_MAX) return 0;
+	if(branch->left != TRIE_LEAF) {
+		if(!pT_(build_cut_r)(build, branch->left, branch->bit + 1)) return 0;
+		left = build[branch->left].leaves;
+	}
+	if(branch->right != TRIE_LEAF) {
+		if(!pT_(build_cut_r)(build, branch->right, branch->bit + 1)) return 0;
+		right = build[branch->right].leaves;
+	}
+	/* The bigger child is at least half, so it's never a single leaf. */
+	while(left + right > TRIE_ORDER) {
+		if(left >= right) build[branch->left].is_bough = 1, left = 1;
+		else build[branch->right].is_bough = 1, right = 1;
+	}
+	branch->leaves = left + right;
+	return 1;
+}
+/* Where the next branch and leaf go in a bough that is being built. */
+struct pT_(cursor_build) { struct pT_(bough) *bough; unsigned br, lf; };
+static struct pT_(bough) *pT_(build_bough_r)(const struct pT_(build) *,
+	const pT_(entry) *, const size_t *, size_t, size_t);
+static int pT_(build_branch_r)(const struct pT_(build) *, const pT_(entry) *,
+	const size_t *, size_t, size_t, struct pT_(cursor_build) *);
+/** Places the child of a branch; either `entry`, a new bough `b`, or more
+ branches `b` of the same bough. @return Success. @throws[malloc] */
+static int pT_(build_child)(const struct pT_(build) *const build,
+	const pT_(entry) *const array, const size_t *const unique,
+	const size_t b, const size_t entry, const size_t bit,
+	struct pT_(cursor_build) *const c) {
+	if(b == TRIE_LEAF) {
+#		ifdef TRIE_COUNT
+		pT_(size)(c->bough)[c->lf] = 1;
+#		endif
+#		ifdef TRIE_SCORE
+		pT_(best)(c->bough)[c->lf].stale = 1;
+#		endif
+		pT_(leaf)(c->bough)[c->lf++].as_entry = array[unique[entry]];
+	} else if(build[b].is_bough) {
+		struct pT_(bough) *const link
+			= pT_(build_bough_r)(build, array, unique, b, bit);
+		if(!link) return 0;
+		trie_bmp_set(&c->bough->bmp, c->lf);
+#		ifdef TRIE_COUNT
+		pT_(size)(c->bough)[c->lf] = pT_(sum)(link, 0, link->leaves - 1u);
+#		endif
+#		ifdef TRIE_SCORE
+		pT_(best)(c->bough)[c->lf].stale = 1;
+#		endif
+		pT_(leaf)(c->bough)[c->lf++].as_link = link;
+	} else if(!pT_(build_branch_r)(build, array, unique, b, bit, c)) {
+		return 0;
+	}
+	return 1;
+}
+/** Writes the branch `b` of `build` and its children, in pre-order, in `c`;
+ `bit` is the first bit that the branch can be on. @return Success.
+ @throws[malloc] */
+static int pT_(build_branch_r)(const struct pT_(build) *const build,
+	const pT_(entry) *const array, const size_t *const unique, const size_t b,
+	const size_t bit, struct pT_(cursor_build) *const c) {
+	const struct pT_(build) *const branch = build + b;
+	struct trie_branch *const write = pT_(branch)(c->bough) + c->br++;
+	const unsigned br0 = c->br;
+	assert(branch->bit >= bit && branch->bit - bit <= UCHAR_MAX);
+	write->skip = (unsigned char)(branch->bit - bit);
+	/* The leaves on either side of branch `b` are `b` and `b + 1`. */
+	if(!pT_(build_child)(build, array, unique, branch->left, b,
+		branch->bit + 1, c)) return 0;
+	write->left = (unsigned char)(c->br - br0);
+	return pT_(build_child)(build, array, unique, branch->right, b + 1,
+		branch->bit + 1, c);
+}
+/** @return A new bough that holds the branch `b` of `build` and what is below
+ it; `bit` is the first bit that the branch can be on. @throws[malloc] */
+static struct pT_(bough) *pT_(build_bough_r)(const struct pT_(build) *const
+	build, const pT_(entry) *const array, const size_t *const unique,
+	const size_t b, const size_t bit) {
+	struct pT_(cursor_build) c;
+	if(!(c.bough = pT_(new_bough)(build[b].leaves))) return 0;
+	c.br = 0, c.lf = 0;
+	pT_(links_clear)(c.bough);
+	if(!pT_(build_branch_r)(build, array, unique, b, bit, &c)) {
+		/* Only what has been written. */
+		if((c.bough->leaves = (unsigned short)c.lf)) pT_(clear_r)(c.bough);
+		free(c.bough);
+		return 0;
+	}
+	assert(c.lf == build[b].leaves && c.br + 1 == c.lf);
+	c.bough->leaves = (unsigned short)c.lf;
+	return c.bough;
+}
+/** The entries of `bough`, that was just built, in order, are replaced with
+ `link`, `*j` being the first, where it is non-null. */
+static void pT_(join_link_r)(struct pT_(bough) *const bough,
+	struct pT_(bough) *const *const link, size_t *const j) {
+	unsigned lf;
+	for(lf = 0; lf < bough->leaves; lf++) {
+		struct pT_(bough) *child;
+		if(trie_bmp_test(&bough->bmp, lf))
+			pT_(join_link_r)(child = pT_(leaf)(bough)[lf].as_link, link, j);
+		else if(child = link[(*j)++])
+			trie_bmp_set(&bough->bmp, lf), pT_(leaf)(bough)[lf].as_link = child;
+		else
+			continue;
+#		ifdef TRIE_COUNT
+		pT_(size)(bough)[lf] = pT_(sum)(child, 0, child->leaves - 1u);
+#		endif
+	}
+}
+
+#		ifdef TRIE_SCORE /* <!-- score */
+static pT_(score) pT_(best_r)(struct pT_(bough) *);
+/** Recomputes the score of leaf `lf` of `bough` if it is stale. A link that
+ is not stale has nothing stale under it, so it's not looked at.
+ @return The score of the entry, or the best score under the link. */
+static pT_(score) pT_(leaf_score)(struct pT_(bough) *const bough,
+	const unsigned lf) {
+	struct pT_(best) *const best = pT_(best)(bough) + lf;
+	assert(bough && lf < bough->leaves);
+	if(!best->stale) return best->score;
+	/* Make sure one has declared <typedef:<pT>score_fn> `<t>score`. */
+	best->score = trie_bmp_test(&bough->bmp, lf)
+		? pT_(best_r)(pT_(leaf)(bough)[lf].as_link)
+		: t_(score)(&pT_(leaf)(bough)[lf].as_entry);
+	best->stale = 0;
+	return best->score;
+}
+/** Recomputes the scores of non-empty `bough` that are stale. @return The
+ best score. */
+static pT_(score) pT_(best_r)(struct pT_(bough) *const bough) {
+	pT_(score) best;
+	unsigned lf;
+	assert(bough && bough->leaves);
+	for(best = pT_(leaf_score)(bough, 0), lf = 1; lf < bough->leaves; lf++) {
+		const pT_(score) score = pT_(leaf_score)(bough, lf);
+		if(best < score) best = score;
+	}
+	return best;
+}
+#			ifndef TRIE_KEY_BYTES
+/* A leaf waiting in <fn:<T>top>; for a link, the best score under it. */
+struct pT_(top) { pT_(score) score; struct pT_(bough) *bough; unsigned lf; };
+/** @return `a` has a lower score than `b`; a maximum-heap. */
+static int pT_(top_less)(const struct pT_(top) a, const struct pT_(top) b)
+	{ return a.score < b.score; }
+/** @return `a` has a higher score than `b`; a minimum-heap. */
+static int pT_(floor_less)(const pT_(score) a, const pT_(score) b)
+	{ return b < a; }
+/* Temporary. Avoid recursion. This must match <box.h>. */
+#				undef BOX_MINOR
+#				undef BOX_MAJOR
+#				define BOX_END
+#				include "box.h"
+#				define pTtrie_(n) \
+	BOX_CAT(private, BOX_CAT(TRIE_NAME, BOX_CAT(trie, n)))
+#				define HEAP_NAME pTtrie_(top)
+#				define HEAP_TYPE struct pTtrie_(top)
+/* Must be in the same directory. */
+#				include "heap.h"
+#				define HEAP_NAME pTtrie_(floor)
+#				define HEAP_TYPE pTtrie_(score)
+#				include "heap.h"
+#				undef pTtrie_
+#				define BOX_START
+#				include "box.h"
+#				define BOX_MINOR TRIE_NAME
+#				define BOX_MAJOR trie
+/* The search frontier, and the best `k` entry scores that have been on it,
+ the lowest first; anything not above a full floor can never make the top. */
+struct pT_(top_search) {
+	struct pT_(top_heap) heap;
+	struct pT_(floor_heap) floor;
+	size_t k;
+};
+/** Puts the leaves `lf0` to `lf1` of `bough` in `search`, except those that
+ can not be in the top: the score beside the leaf, which for a link is the best
+ under it, doesn't beat the `k`-th best entry seen. Links are not followed
+ unless they are stale. @return Success. @throws[realloc] */
+static int pT_(top_push)(struct pT_(top_search) *const search,
+	struct pT_(bough) *const bough, const unsigned lf0, const unsigned lf1) {
+	const struct pT_(best) *const best = pT_(best)(bough);
+	struct pT_(top) top;
+	unsigned lf;
+	assert(search && bough && lf0 <= lf1 && lf1 < bough->leaves);
+	top.bough = bough;
+	for(lf = lf0; lf <= lf1; lf++) {
+		const int is_full = pT_(floor_heap_size)(&search->floor) == search->k;
+		top.score = best[lf].stale
+			? pT_(leaf_score)(bough, lf) : best[lf].score;
+		if(is_full && !(*pT_(floor_heap_peek)(&search->floor) < top.score))
+			continue;
+		top.lf = lf;
+		/* A link is only an upper bound; its entries will be counted later. */
+		if(!trie_bmp_test(&bough->bmp, lf)) {
+			if(is_full) pT_(floor_heap_pop)(&search->floor);
+			if(!pT_(floor_heap_add)(&search->floor, top.score)) return 0;
+		}
+		if(!pT_(top_heap_add)(&search->heap, top)) return 0;
+	}
+	return 1;
+}
+#			endif
+#		endif /* score --> */
+
+#		define BOX_PUBLIC_OVERRIDE
+#		include "box.h"
 
 /** @return The first element of a non-null `trie`. */
 static struct T_(cursor) T_(begin)(const struct t_(trie) *const trie)
@@ -721,7 +1985,8 @@ static void T_(next)(struct T_(cursor) *const cur) {
 		while(next != old) {
 			unsigned br0 = 0, br1 = next->leaves - 1, lf = 0;
 			while(br0 < br1) {
-				const struct trie_branch *const branch = next->branch + br0;
+				const struct trie_branch *const branch
+					= pT_(branch)(next) + br0;
 				bit += branch->skip;
 				if(!TRIE_QUERY(sample, bit))
 					br1 = ++br0 + branch->left;
@@ -731,7 +1996,7 @@ static void T_(next)(struct T_(cursor) *const cur) {
 			}
 			if(lf < next->leaves - 1) cur->start.bough = next, cur->start.lf = lf + 1;
 			assert(trie_bmp_test(&next->bmp, lf)); /* The old. */
-			next = next->leaf[lf].as_link;
+			next = pT_(leaf)(next)[lf].as_link;
 		}
 		/* End of iteration. Should not get here—all ranged iterators. */
 		if(!cur->start.bough)
@@ -739,6 +2004,58 @@ static void T_(next)(struct T_(cursor) *const cur) {
 	}
 	pT_(lower_entry)(&cur->start);
 }
+/** @return A cursor from `after` to the end of `trie`. */
+static struct T_(cursor) pT_(to_end)(const struct t_(trie) *const trie,
+	const struct pT_(ref) after) {
+	struct T_(cursor) cur;
+	if(!(cur.root = after.bough ? trie->trunk : 0)) return cur;
+	cur.start = after;
+	cur.end.bough = trie->trunk, cur.end.lf = trie->trunk->leaves - 1;
+	pT_(higher_entry)(&cur.end);
+	return cur;
+}
+
+/** @return A cursor on the keys in `trie` that are greater than or equal to
+ `string`, in order, to the end. It is valid until a topological change to
+ `trie`. @order \O(|`string`|) @allow */
+static struct T_(cursor) T_(lower)(const struct t_(trie) *const trie,
+	const char *const string) {
+	struct pT_(ref) before, after;
+	assert(trie && string);
+	pT_(bound)(trie, string, 0, &before, &after);
+	return pT_(to_end)(trie, after);
+}
+
+/** @return A cursor on the keys in `trie` that are greater than `string`, in
+ order, to the end. It is valid until a topological change to `trie`.
+ @order \O(|`string`|) @allow */
+static struct T_(cursor) T_(upper)(const struct t_(trie) *const trie,
+	const char *const string) {
+	struct pT_(ref) before, after;
+	assert(trie && string);
+	pT_(bound)(trie, string, 1, &before, &after);
+	return pT_(to_end)(trie, after);
+}
+
+/** @return A cursor on the keys in `trie` that are in the half-open range
+ [`low`, `high`), in order. It is valid until a topological change to `trie`.
+ @order \O(|`low`| + |`high`|) @allow */
+static struct T_(cursor) T_(range)(const struct t_(trie) *const trie,
+	const char *const low, const char *const high) {
+	struct T_(cursor) cur;
+	struct pT_(ref) before;
+	assert(trie && low && high);
+	cur.root = 0;
+	pT_(bound)(trie, low, 0, &before, &cur.start);
+	pT_(bound)(trie, high, 0, &cur.end, &before);
+	/* Empty unless the first at or after `low` is before `high`. */
+	if(cur.start.bough && cur.end.bough
+		&& pT_(key_compare)(pT_(ref_to_string)(&cur.start), high) < 0)
+		cur.root = trie->trunk;
+	return cur;
+}
+
+#		ifndef TRIE_KEY_BYTES
 /** @return A set to strings that start with `prefix` in `trie`.
  It is valid until a topological change to `trie`. Calling <fn:<T>next> will
  iterate them in order.
@@ -755,26 +2072,312 @@ static struct T_(cursor) T_(prefix)(struct t_(trie) *const trie,
 	return cur;
 }
 
+/** Continues the walk of `cur` down the trie to the next key that is a prefix
+ of the string. Where the walk goes right at a bit in byte `n`, the only key on
+ the left that could be a prefix has length `n`, and it is the first, so it's
+ one check. @return Whether it found one, which is in `cur->ref`. */
+static int pT_(prefixes_walk)(struct T_(prefixes_cursor) *const cur) {
+	struct pT_(bough) *bough;
+	assert(cur && cur->string);
+	if(!(bough = cur->bough)) return 0;
+	for( ; ; ) {
+		while(cur->br0 < cur->br1) {
+			const struct trie_branch *const branch
+				= pT_(branch)(bough) + cur->br0;
+			const size_t bit = cur->bit + branch->skip, n = bit / CHAR_BIT;
+			if(!trie_is_long(cur->string, &cur->byte, n)) goto last;
+			cur->bit = bit + 1;
+			if(!TRIE_QUERY(cur->string, bit)) {
+				cur->br1 = ++cur->br0 + branch->left;
+			} else {
+				const char *key;
+				cur->ref.bough = bough, cur->ref.lf = cur->lf;
+				cur->br0 += branch->left + 1, cur->lf += branch->left + 1;
+				pT_(lower_entry)(&cur->ref);
+				key = pT_(ref_to_string)(&cur->ref);
+				if(key[n] == '\0' && !memcmp(key, cur->string, n)) return 1;
+			}
+		}
+		if(!trie_bmp_test(&bough->bmp, cur->lf)) break;
+		bough = cur->bough = pT_(leaf)(bough)[cur->lf].as_link;
+		cur->br0 = 0, cur->br1 = bough->leaves - 1, cur->lf = 0;
+	}
+last: /* The string ran out or it's at a leaf; either way, the first. */
+	cur->ref.bough = bough, cur->ref.lf = cur->lf, cur->bough = 0;
+	pT_(lower_entry)(&cur->ref);
+	return trie_is_prefix(pT_(ref_to_string)(&cur->ref), cur->string);
+}
+
+/** @return A cursor on the keys in `trie` that are prefixes of `string`, (the
+ opposite of <fn:<T>prefix>,) starting at the shortest. It is valid until a
+ topological change to `trie`.
+ @order \O(|`string`|) in all, with one comparison per key found. @allow */
+static struct T_(prefixes_cursor) T_(prefixes)(const struct t_(trie) *const
+	trie, const char *const string) {
+	struct T_(prefixes_cursor) cur;
+	cur.string = string, cur.ref.bough = 0;
+	if(!trie || !string || !(cur.bough = trie->trunk) || !cur.bough->leaves)
+		{ cur.bough = 0; return cur; }
+	cur.br0 = 0, cur.br1 = cur.bough->leaves - 1, cur.lf = 0;
+	cur.bit = 0, cur.byte = 0;
+	if(!pT_(prefixes_walk)(&cur)) cur.ref.bough = 0;
+	return cur;
+}
+/** @return Is `cur` on a key. @allow */
+static int T_(prefixes_exists)(const struct T_(prefixes_cursor) *const cur)
+	{ return cur && cur->ref.bough; }
+/** @return The entry at a valid, non-null `cur`. @allow */
+static pT_(remit) T_(prefixes_entry)(const struct T_(prefixes_cursor) *const
+	cur) { return pT_(ref_to_remit)(&cur->ref); }
+/** Advances `cur` to the next longer key that is a prefix. @allow */
+static void T_(prefixes_next)(struct T_(prefixes_cursor) *const cur) {
+	if(!cur || !cur->ref.bough) return;
+	if(!pT_(prefixes_walk)(cur)) cur->ref.bough = 0;
+}
+/** @return Whether there is a key in `trie` that is a prefix of `string`, the
+ longest of which is stored in `ref`. */
+static int pT_(longest)(const struct t_(trie) *const trie,
+	const char *const string, struct pT_(ref) *const ref) {
+	struct T_(prefixes_cursor) cur = T_(prefixes)(trie, string);
+	int is = 0;
+	for( ; T_(prefixes_exists)(&cur); T_(prefixes_next)(&cur))
+		*ref = cur.ref, is = 1;
+	return is;
+}
+#			if defined(TREE_ENTRY) || !defined(TRIE_KEY)
+/** Longest-prefix match, for example, of routing or rule tables.
+ @return The longest key in `trie` that is a prefix of `string`, or null, (both
+ can be null.) @order \O(|`string`|) @allow */
+static pT_(remit) T_(longest)(const struct t_(trie) *const trie,
+	const char *const string) {
+	struct pT_(ref) ref;
+	return pT_(longest)(trie, string, &ref) ? pT_(ref_to_remit)(&ref) : 0;
+}
+#			else
+/** Longest-prefix match `string` for `trie` -> `remit`. */
+static enum trie_result T_(longest)(const struct t_(trie) *const trie,
+	const char *const string, pT_(remit) *const remit) {
+	struct pT_(ref) ref;
+	if(pT_(longest)(trie, string, &ref)) {
+		if(remit) *remit = pT_(ref_to_remit)(&ref);
+		return TRIE_PRESENT;
+	}
+	return TRIE_ABSENT;
+}
+#			endif
+
+/* The state of <fn:<T>fuzzy>. Row `i` of `rows` is the edit distances between
+ the first `i` bytes of a key and every prefix of `string`. */
+struct pT_(fuzzy) {
+	const char *string;
+	size_t length; /* Of `string`; a row is one more. */
+	unsigned distance, *rows;
+	size_t rows_capacity, count;
+	pT_(fuzzy_fn) visit;
+	void *param;
+};
+
+/** Makes sure there is space in `f` for rows up to `i`. @return Success.
+ @throws[realloc, ERANGE] */
+static int pT_(fuzzy_reserve)(struct pT_(fuzzy) *const f, const size_t i) {
+	const size_t row = f->length + 1;
+	size_t c = f->rows_capacity;
+	unsigned *rows;
+	assert(f && c);
+	if(i < c) return 1;
+	while(c <= i) {
+		if(c > (size_t)-1 / 2 / row / sizeof *rows)
+			{ errno = ERANGE; return 0; }
+		c <<= 1;
+	}
+	if(!(rows = realloc(f->rows, sizeof *rows * row * c)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	f->rows = rows, f->rows_capacity = c;
+	return 1;
+}
+
+/** Extends the rows of `f` from `i0` to `i1`, which have been reserved, with
+ the bytes of `key`. @return Whether some prefix of `string` is still within
+ the distance; if not, no key that starts with these bytes can be. */
+static int pT_(fuzzy_rows)(struct pT_(fuzzy) *const f, const char *const key,
+	size_t i0, const size_t i1) {
+	const size_t row = f->length + 1;
+	assert(f && key && i0 <= i1 && i1 < f->rows_capacity);
+	for( ; i0 < i1; i0++) {
+		const unsigned *const r0 = f->rows + row * i0;
+		unsigned *const r1 = f->rows + row * (i0 + 1), low;
+		size_t j;
+		low = r1[0] = r0[0] + 1;
+		for(j = 1; j < row; j++) {
+			unsigned d = r0[j - 1] + (f->string[j - 1] != key[i0]);
+			if(r0[j] + 1 < d) d = r0[j] + 1;
+			if(r1[j - 1] + 1 < d) d = r1[j - 1] + 1;
+			if((r1[j] = d) < low) low = d;
+		}
+		if(low > f->distance) return 0;
+	}
+	return 1;
+}
+
+/** Visits the keys of the subtree `br0`, `br1`, `lf` of `bough` in `f` that
+ are within the distance. The keys share the first `bit` bits, and the first
+ `i` bytes are in the rows already. @return Success. @throws[realloc] */
+static int pT_(fuzzy_r)(struct pT_(fuzzy) *const f,
+	const struct pT_(bough) *const bough, unsigned br0, const unsigned br1,
+	const unsigned lf, const size_t bit, const size_t i) {
+	union { const struct pT_(bough) *readonly; struct pT_(bough) *promise; }
+		slybox;
+	struct pT_(ref) ref;
+	const char *key;
+	size_t n;
+	assert(f && bough && br0 <= br1 && lf + br1 - br0 < bough->leaves);
+	if(br0 < br1) {
+		const struct trie_branch *const branch = pT_(branch)(bough) + br0;
+		const size_t b = bit + branch->skip;
+		/* All the keys have the same bytes before the one that differs. */
+		key = pT_(sample)(bough, lf), n = b / CHAR_BIT;
+		if(!pT_(fuzzy_reserve)(f, n)) return 0;
+		if(!pT_(fuzzy_rows)(f, key, i, n)) return 1;
+		br0++;
+		return pT_(fuzzy_r)(f, bough, br0, br0 + branch->left, lf, b + 1, n)
+			&& pT_(fuzzy_r)(f, bough, br0 + branch->left, br1,
+			lf + branch->left + 1, b + 1, n);
+	}
+	if(trie_bmp_test(&bough->bmp, lf)) {
+		const struct pT_(bough) *const link = pT_(leaf)(bough)[lf].as_link;
+		return pT_(fuzzy_r)(f, link, 0, link->leaves - 1u, 0, bit, i);
+	}
+	slybox.readonly = bough, ref.bough = slybox.promise, ref.lf = lf;
+	key = pT_(ref_to_string)(&ref), n = i + strlen(key + i);
+	if(!pT_(fuzzy_reserve)(f, n)) return 0;
+	if(pT_(fuzzy_rows)(f, key, i, n)) {
+		const unsigned d = f->rows[(f->length + 1) * n + f->length];
+		if(d <= f->distance) {
+			f->count++;
+			if(f->visit) f->visit(pT_(ref_to_remit)(&ref), d, f->param);
+		}
+	}
+	return 1;
+}
+
+/** Finds the keys in `trie` within Levenshtein `distance` of `string`, that
+ is, the fewest insertions, deletions, and substitutions of bytes. It walks the
+ trie keeping the table of distances for the prefix that it's on, and does not
+ go into a subtree if all of the prefixes of `string` are already too far.
+ @param[visit] If non-null, called in order on every key found.
+ @param[param] Passed to `visit`.
+ @return The number of keys found. If there was an error, zero and `errno`
+ is set. @throws[realloc, ERANGE]
+ @order \O(|`string`| |`trie`|), but the pruning makes it much less for
+ small `distance` @allow */
+static size_t T_(fuzzy)(const struct t_(trie) *const trie,
+	const char *const string, const unsigned distance,
+	const pT_(fuzzy_fn) visit, void *const param) {
+	struct pT_(fuzzy) f;
+	size_t j;
+	int success;
+	if(!trie || !string || !trie->trunk || !trie->trunk->leaves) return 0;
+	f.string = string, f.length = strlen(string), f.distance = distance;
+	f.count = 0, f.visit = visit, f.param = param;
+	f.rows_capacity = 16;
+	if(!(f.rows = malloc(sizeof *f.rows * (f.length + 1) * f.rows_capacity)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	for(j = 0; j <= f.length; j++) f.rows[j] = (unsigned)j;
+	success = pT_(fuzzy_r)(&f, trie->trunk, 0, trie->trunk->leaves - 1, 0,
+		0, 0);
+	free(f.rows);
+	return success ? f.count : 0;
+}
+#		endif
+
+#		ifdef TRIE_OWN /* <!-- own */
+/** @return The characters that follow `block`. */
+static char *pT_(block_data)(struct pT_(block) *const block)
+	{ return (char *)(block + 1); }
+/** Frees the arena of keys of `trie`. */
+static void pT_(own_free)(struct t_(trie) *const trie) {
+	struct pT_(block) *block, *prev;
+	assert(trie);
+	for(block = trie->block; block; block = prev)
+		prev = block->prev, free(block);
+	trie->block = 0, trie->used = trie->garbage = 0;
+}
+/** @return Space for `size` bytes at the end of the arena of `trie`; it is
+ not used until the latest block's size is increased. @throws[malloc] */
+static char *pT_(own_reserve)(struct t_(trie) *const trie, const size_t size) {
+	struct pT_(block) *block = trie->block;
+	size_t capacity;
+	assert(trie && size);
+	if(block && block->capacity - block->size >= size)
+		return pT_(block_data)(block) + block->size;
+	if(size > (size_t)-1 - sizeof *block) { errno = ERANGE; return 0; }
+	capacity = block ? block->capacity : 128; /* Geometric. */
+	if(capacity <= ((size_t)-1 - sizeof *block) / 2) capacity *= 2;
+	if(capacity < size) capacity = size;
+	if(!(block = malloc(sizeof *block + capacity)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	block->prev = trie->block, block->size = 0, block->capacity = capacity;
+	trie->block = block;
+	return pT_(block_data)(block);
+}
+/** @return The bytes of the keys under `bough`. */
+static size_t pT_(own_size_r)(const struct pT_(bough) *const bough) {
+	size_t size = 0;
+	unsigned i;
+	for(i = 0; i < bough->leaves; i++) size += trie_bmp_test(&bough->bmp, i)
+		? pT_(own_size_r)(pT_(leaf)(bough)[i].as_link)
+		: strlen(pT_(leaf)(bough)[i].as_entry) + 1;
+	return size;
+}
+/** Copies the keys under `bough`, in order, to `data`, which is advanced, and
+ the leaves point to the copies. */
+static void pT_(own_copy_r)(struct pT_(bough) *const bough, char **const data) {
+	unsigned i;
+	for(i = 0; i < bough->leaves; i++) {
+		size_t size;
+		if(trie_bmp_test(&bough->bmp, i))
+			{ pT_(own_copy_r)(pT_(leaf)(bough)[i].as_link, data); continue; }
+		size = strlen(pT_(leaf)(bough)[i].as_entry) + 1;
+		memcpy(*data, pT_(leaf)(bough)[i].as_entry, size);
+		pT_(leaf)(bough)[i].as_entry = *data, *data += size;
+	}
+}
+/** Replaces the arena of `trie` with one block that has the keys in order and
+ no garbage. @return Success, otherwise `trie` is unchanged. @throws[malloc] */
+static int pT_(own_compact)(struct t_(trie) *const trie) {
+	struct pT_(block) *block;
+	size_t size;
+	char *data;
+	assert(trie);
+	if(!trie->trunk || !trie->trunk->leaves
+		|| !(size = pT_(own_size_r)(trie->trunk)))
+		{ pT_(own_free)(trie); return 1; }
+	if(size > (size_t)-1 - sizeof *block) { errno = ERANGE; return 0; }
+	if(!(block = malloc(sizeof *block + size)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	data = pT_(block_data)(block);
+	pT_(own_copy_r)(trie->trunk, &data);
+	assert(data == pT_(block_data)(block) + size);
+	pT_(own_free)(trie);
+	block->prev = 0, block->size = block->capacity = size;
+	trie->block = block, trie->used = size;
+	return 1;
+}
+#		endif /* own --> */
+
 /** Zeroed data (not all-bits-zero) is initialized. @return An idle tree.
  @order \Theta(1) @allow */
 static struct t_(trie) t_(trie)(void)
 	{ struct t_(trie) trie = { 0 }; return trie; }
 
-#		if 0 /* Fixme? */
-/** Initializes `trie` from an `array` of pointers-to-`<T>` of `array_size`.
- @return Success. @throws[realloc] @order \O(`array_size`) @allow
- @fixme Write this function, somehow. */
-static int T_(from_array)(struct T_(trie) *const trie,
-	pT_(type) *const*const array, const size_t array_size) {
-	return assert(trie && array && array_size),
-		pT_(init)(trie, array, array_size);
-}
-#		endif
-
 /** Returns any initialized `trie` (can be null) to idle.
  @order \O(|`trie`|) @allow */
 static void t_(trie_)(struct t_(trie) *const trie) {
-	if(!trie || !trie->trunk) return; /* Null or idle. */
+	if(!trie) return; /* Null. */
+#		ifdef TRIE_OWN
+	pT_(own_free)(trie);
+#		endif
+	if(!trie->trunk) return; /* Idle. */
 	if(trie->trunk->leaves) pT_(clear_r)(trie->trunk); /* Contents. */
 	free(trie->trunk); /* Empty. */
 	*trie = t_(trie)();
@@ -786,6 +2389,13 @@ static void T_(clear)(struct t_(trie) *const trie) {
 	if(!trie || !trie->trunk) return; /* Null or idle. */
 	if(trie->trunk->leaves) pT_(clear_r)(trie->trunk); /* Contents. */
 	trie->trunk->leaves = 0; /* Keep the resources for hysteresis. */
+#		ifdef TRIE_OWN
+	if(trie->block) { /* Keep the latest block. */
+		struct pT_(block) *const block = trie->block;
+		trie->block = block->prev, pT_(own_free)(trie);
+		block->prev = 0, block->size = 0, trie->block = block;
+	}
+#		endif
 }
 
 #		if defined(TREE_ENTRY) || !defined(TRIE_KEY) /* <!-- pointer */
@@ -840,11 +2450,29 @@ static enum trie_result T_(get)(const struct t_(trie) *const trie,
 #		endif /* enum? --> */
 
 #		ifndef TRIE_ENTRY /* <!-- set */
-/** Adds `key` to `trie` (which must both exist) if it doesn't exist. */
+/** Adds `key` to `trie` (which must both exist) if it doesn't exist. With
+ `TRIE_OWN`, it is a copy of `key` that is added. */
 static enum trie_result T_(add)(struct t_(trie) *const trie,
 	const pT_(key) key) {
+#		ifndef TRIE_KEY_BYTES
 	assert(trie && t_(string)(key));
+#		else
+	assert(trie);
+#		endif
+#		ifdef TRIE_OWN
+	{
+		const size_t size = strlen(key) + 1;
+		char *const copy = pT_(own_reserve)(trie, size);
+		enum trie_result result;
+		if(!copy) return TRIE_ERROR;
+		memcpy(copy, key, size);
+		if((result = pT_(add)(trie, copy, 0)) == TRIE_ABSENT)
+			trie->block->size += size, trie->used += size;
+		return result;
+	}
+#		else
 	return pT_(add)(trie, key, 0);
+#		endif
 }
 #		else /* set --><!-- entry */
 /** Adds `key` to `trie` if it doesn't exist already.
@@ -866,9 +2494,13 @@ static enum trie_result T_(add)(struct t_(trie) *const trie,
 	const pT_(key) key, pT_(entry) **const put_entry_here) {
 	enum trie_result result;
 	struct pT_(ref) r;
+#		ifndef TRIE_KEY_BYTES
 	assert(trie && t_(string)(key) && put_entry_here);
+#		else
+	assert(trie && put_entry_here);
+#		endif
 	if(result = pT_(add)(trie, key, &r))
-		*put_entry_here = &r.bough->leaf[r.lf].as_entry;
+		*put_entry_here = &pT_(leaf)(r.bough)[r.lf].as_entry;
 	return result;
 }
 #		endif /* entry --> */
@@ -880,19 +2512,1182 @@ static enum trie_result T_(add)(struct t_(trie) *const trie,
  of the strings.
  @order \O(\log |`trie`|) @allow */
 static int T_(remove)(struct t_(trie) *const trie,
-	const char *const string)
-	{ return trie && string && pT_(remove)(trie, string); }
+	const char *const string) {
+#		ifdef TRIE_OWN
+	size_t size;
+	if(!trie || !string) return 0;
+	size = strlen(string) + 1; /* `string` may be in the arena. */
+	if(!pT_(remove)(trie, string)) return 0;
+	if((trie->garbage += size) > trie->used / 2) {
+		const int e = errno; /* Failing to compact is not failing to remove. */
+		if(!pT_(own_compact)(trie)) errno = e;
+	}
+	return 1;
+#		else
+	return trie && string && pT_(remove)(trie, string);
+#		endif
+}
 
-#		if 0 /* fixme: Haven't figured out the best way to do this. */
-/** @return The number of elements in `it`. */
-static size_t pT_(size_r)(const struct pT_(iterator) *const it) {
-	return it->end.lf - it->cur.lf; /* Fixme. */
+/** Replaces the contents of `trie` with `array` of `array_size` entries,
+ which is sorted in-place if it isn't already. Instead of adding one at a time,
+ the bits where adjacent keys differ are computed once, and the boughs are
+ filled bottom-up, which moves and splits nothing. Of duplicate keys, the first
+ is used.
+ @return Success, otherwise `trie` is unchanged. @throws[malloc]
+ @throws[EILSEQ] The string has a distinguishing run of bytes with a
+ neighbouring string that is too long. @order \O(|`array`|) if it's sorted,
+ otherwise that of `qsort`. @allow */
+static int T_(from_array)(struct t_(trie) *const trie,
+	pT_(entry) *const array, const size_t array_size) {
+	struct pT_(build) *build = 0;
+	struct pT_(bough) *trunk = 0;
+	size_t *unique = 0, *stack, n, i;
+#		ifdef TRIE_OWN
+	struct t_(trie) owned = t_(trie)();
+#		endif
+	assert(trie && (array || !array_size));
+	for(i = 1; i < array_size; i++)
+		if(pT_(compare)(array + i - 1, array + i) > 0) break;
+	if(i < array_size) qsort(array, array_size, sizeof *array, &pT_(compare));
+	if(!array_size) { T_(clear)(trie); return 1; }
+	/* The unique keys and a stack; branches are one less than the leaves. */
+	if(array_size > (size_t)-1 / 2 / sizeof *unique)
+		{ errno = ERANGE; goto catch; }
+	if(!(unique = malloc(sizeof *unique * 2 * array_size)) || (array_size > 1
+		&& !(build = malloc(sizeof *build * (array_size - 1))))) goto catch;
+	stack = unique + array_size;
+	for(n = 0, i = 0; i < array_size; i++) {
+		/* Where it differs from the last. */
+		if(n && !pT_(build_diff)(pT_(entry_string)(array + unique[n - 1]),
+			pT_(entry_string)(array + i), &build[n - 1].bit)) continue;
+		unique[n++] = i;
+	}
+	if(n == 1) {
+		if(!(trunk = pT_(new_bough)(1))) goto catch;
+		trunk->leaves = 1;
+#		ifdef TRIE_COUNT
+		pT_(size)(trunk)[0] = 1;
+#		endif
+#		ifdef TRIE_SCORE
+		pT_(best)(trunk)[0].stale = 1;
+#		endif
+		pT_(links_clear)(trunk);
+		pT_(leaf)(trunk)[0].as_entry = array[unique[0]];
+	} else {
+		const size_t root = pT_(build_tree)(build, n, stack);
+		if(!pT_(build_cut_r)(build, root, 0)) { errno = EILSEQ; goto catch; }
+		if(!(trunk = pT_(build_bough_r)(build, array, unique, root, 0)))
+			goto catch;
+	}
+#		ifdef TRIE_OWN
+	owned.trunk = trunk; /* Copy the keys from `array`. */
+	if(!pT_(own_compact)(&owned))
+		{ pT_(clear_r)(trunk), free(trunk); goto catch; }
+	free(build), free(unique);
+	t_(trie_)(trie), *trie = owned;
+#		else
+	free(build), free(unique);
+	t_(trie_)(trie), trie->trunk = trunk;
+#		endif
+	return 1;
+catch:
+	if(!errno) errno = ERANGE; /* `malloc` only has to set it in POSIX. */
+	free(build), free(unique);
+	return 0;
+}
+
+/** Partitions `array` of `array_size` entries in-place by the first byte of
+ the keys; the keys that start with `i` are `[start[i], start[i + 1])` of
+ `array`, with `start` having `UCHAR_MAX + 2` elements. The partitions are
+ independent sub-tries, and can be built with <fn:<T>from_array>, perhaps on
+ different threads, and then put together with <fn:<T>join>.
+ @order \O(|`array`|) @allow */
+static void T_(partition)(pT_(entry) *const array, const size_t array_size,
+	size_t *const start) {
+	size_t next[UCHAR_MAX + 1], i;
+	unsigned b;
+	assert((array || !array_size) && start);
+	for(b = 0; b <= UCHAR_MAX + 1; b++) start[b] = 0;
+	for(i = 0; i < array_size; i++)
+		start[(unsigned char)*pT_(entry_string)(array + i) + 1]++;
+	for(b = 1; b <= UCHAR_MAX + 1; b++) start[b] += start[b - 1];
+	for(b = 0; b <= UCHAR_MAX; b++) next[b] = start[b];
+	/* Every entry that is out of place is swapped into its partition. */
+	for(b = 0; b <= UCHAR_MAX; b++) while(next[b] < start[b + 1]) {
+		pT_(entry) e = array[next[b]];
+		unsigned c;
+		while((c = (unsigned char)*pT_(entry_string)(&e)) != b) {
+			const pT_(entry) swap = array[next[c]];
+			array[next[c]++] = e, e = swap;
+		}
+		array[next[b]++] = e;
+	}
 }
-/** Counts the of the items in `it`. @order \O(|`it`|)
- @fixme Doesn't work at all. */
-static size_t T_(trie_size)(const struct T_(trie_iterator) *const it)
-	{ return assert(it), pT_(size_r)(&it->_); }
+
+/** Replaces the contents of `trie` with `parts` of `parts_size` tries, which
+ are moved, leaving them idle. The keys of each part must be before the keys
+ of the next, and the first branch of a part must be after where it differs
+ from its neighbours, as it is with the partitions of <fn:<T>partition>.
+ Only the boughs on top of the parts are new.
+ @return Success, otherwise `trie` and `parts` are unchanged.
+ @throws[EDOM] The parts are out of order, overlap, or are not independent.
+ @throws[EILSEQ] The parts have a distinguishing run of bytes that is too
+ long. @throws[malloc] @order \O(`parts_size`) @allow */
+static int T_(join)(struct t_(trie) *const trie, struct t_(trie) *const parts,
+	const size_t parts_size) {
+	struct pT_(build) *build = 0;
+	struct pT_(bough) *trunk = 0, **link = 0;
+	pT_(entry) *array = 0;
+	size_t *unique = 0, *stack, *part, m, i, j;
+	const char *last = 0;
+	assert(trie && (parts || !parts_size));
+	for(m = 0, i = 0; i < parts_size; i++) {
+		assert(parts + i != trie);
+		if(parts[i].trunk && parts[i].trunk->leaves) m++;
+	}
+	if(m > (size_t)-1 / 3 / sizeof *unique) { errno = ERANGE; goto catch; }
+	if(m && (!(unique = malloc(sizeof *unique * 3 * m))
+		|| !(link = malloc(sizeof *link * m))
+		|| !(array = malloc(sizeof *array * m))
+		|| (m > 1 && !(build = malloc(sizeof *build * (m - 1))))))
+		goto catch;
+	stack = unique + m, part = stack + m;
+	for(j = 0, i = 0; i < parts_size; i++) {
+		struct pT_(bough) *const bough = parts[i].trunk;
+		struct pT_(ref) first, end;
+		const char *string;
+		if(!bough || !bough->leaves) continue;
+		assert(bough->leaves > 1 || !trie_bmp_test(&bough->bmp, 0));
+		first.bough = bough, first.lf = 0, pT_(lower_entry)(&first);
+		unique[j] = j, part[j] = i, link[j] = bough->leaves > 1 ? bough : 0;
+		array[j] = pT_(leaf)(first.bough)[first.lf].as_entry; /* Placeholder. */
+		string = pT_(ref_to_string)(&first);
+		if(j) { /* Where it differs from the last of the previous part. */
+			size_t *const diff = &build[j - 1].bit;
+			if(!pT_(build_diff)(last, string, diff)
+				|| !TRIE_QUERY(string, *diff)
+				|| (link[j - 1] && pT_(branch)(link[j - 1])[0].skip <= *diff)
+				|| (link[j] && pT_(branch)(bough)[0].skip <= *diff))
+				{ errno = EDOM; goto catch; }
+		}
+		end.bough = bough, end.lf = bough->leaves - 1u, pT_(higher_entry)(&end);
+		last = pT_(ref_to_string)(&end);
+		j++;
+	}
+	assert(j == m);
+	if(m == 1) {
+		trunk = parts[part[0]].trunk;
+	} else if(m > 1) {
+		const size_t root = pT_(build_tree)(build, m, stack);
+		if(!pT_(build_cut_r)(build, root, 0)) { errno = EILSEQ; goto catch; }
+		if(!(trunk = pT_(build_bough_r)(build, array, unique, root, 0)))
+			goto catch;
+		/* The first branch of a part was from the start of the key. */
+		for(j = 0; j < m; j++) if(link[j]) {
+			const size_t parent = !j ? build[0].bit : j == m - 1
+				? build[j - 1].bit : build[j - 1].bit > build[j].bit
+				? build[j - 1].bit : build[j].bit;
+			pT_(branch)(link[j])[0].skip
+				= (unsigned char)(pT_(branch)(link[j])[0].skip - parent - 1);
+		}
+		j = 0, pT_(join_link_r)(trunk, link, &j);
+		for(j = 0; j < m; j++)
+			if(!link[j]) free(parts[part[j]].trunk), parts[part[j]].trunk = 0;
+	}
+	free(build), free(array), free(link), free(unique);
+	t_(trie_)(trie), trie->trunk = trunk;
+	for(i = 0; i < parts_size; i++) {
+		if(trunk && parts[i].trunk && parts[i].trunk->leaves)
+			parts[i].trunk = 0; /* Moved. */
+#		ifdef TRIE_OWN
+		if(parts[i].block) { /* Move the arena. */
+			struct pT_(block) *tail = parts[i].block;
+			while(tail->prev) tail = tail->prev;
+			tail->prev = trie->block, trie->block = parts[i].block;
+			trie->used += parts[i].used, trie->garbage += parts[i].garbage;
+			parts[i].block = 0;
+		}
 #		endif
+		t_(trie_)(parts + i);
+	}
+	return 1;
+catch:
+	if(!errno) errno = ERANGE; /* `malloc` only has to set it in POSIX. */
+	free(build), free(array), free(link), free(unique);
+	return 0;
+}
+
+#		ifdef TRIE_PARALLEL /* <!-- parallel */
+/* The partitions `[begin, end)` that a thread builds into `parts`. */
+struct pT_(work) {
+	pT_(entry) *array;
+	const size_t *start;
+	struct t_(trie) *parts;
+	unsigned begin, end;
+	int error;
+	pthread_t thread;
+};
+/** Builds the `param` work. Thread entry point. */
+static void *pT_(work)(void *const param) {
+	struct pT_(work) *const w = param;
+	unsigned b;
+	for(b = w->begin; b < w->end; b++) if(w->start[b] != w->start[b + 1]
+		&& !T_(from_array)(w->parts + b, w->array + w->start[b],
+		w->start[b + 1] - w->start[b])) { w->error = errno; break; }
+	return 0;
+}
+/** Only with `TRIE_PARALLEL`. Equivalent to <fn:<T>from_array>, but `array`
+ is split with <fn:<T>partition>, and the partitions are divided evenly
+ between up to `threads` POSIX threads, which build them independently; they
+ are put together with <fn:<T>join>. If a thread can not be started, the work
+ is done in this one.
+ @return Success, otherwise `trie` is unchanged. @throws[malloc]
+ @throws[EILSEQ] The string has a distinguishing run of bytes with a
+ neighbouring string that is too long.
+ @order \O(|`array`| / `threads`) if it's sorted, otherwise that of `qsort`
+ on the partitions. @allow */
+static int T_(parallel_from_array)(struct t_(trie) *const trie,
+	pT_(entry) *const array, const size_t array_size, const unsigned threads) {
+	struct pT_(work) *work = 0;
+	struct t_(trie) *parts = 0;
+	size_t start[UCHAR_MAX + 2];
+	unsigned t, b;
+	int error = 0;
+	assert(trie && (array || !array_size));
+	/* Small arrays are not worth it. */
+	if(threads <= 1 || array_size <= TRIE_ORDER)
+		return T_(from_array)(trie, array, array_size);
+	if(!(work = malloc(sizeof *work * threads))
+		|| !(parts = malloc(sizeof *parts * (UCHAR_MAX + 1)))) goto catch;
+	for(b = 0; b <= UCHAR_MAX; b++) parts[b] = t_(trie)();
+	T_(partition)(array, array_size, start);
+	/* Each thread gets about the same number of entries. */
+	for(b = 0, t = 0; t < threads; t++) {
+		work[t].array = array, work[t].start = start, work[t].parts = parts;
+		work[t].begin = b, work[t].error = 0;
+		while(b <= UCHAR_MAX && start[b] < array_size * (t + 1) / threads) b++;
+		work[t].end = t + 1 == threads ? UCHAR_MAX + 1 : b;
+	}
+	for(t = 1; t < threads; t++) if(pthread_create(&work[t].thread, 0,
+		&pT_(work), work + t)) pT_(work)(work + t), work[t].end = work[t].begin;
+	pT_(work)(work);
+	for(t = 1; t < threads; t++)
+		if(work[t].end != work[t].begin) pthread_join(work[t].thread, 0);
+	for(t = 0; t < threads; t++) if(work[t].error) error = work[t].error;
+	if(error) { errno = error; goto catch; }
+	if(!T_(join)(trie, parts, UCHAR_MAX + 1)) goto catch;
+	free(parts), free(work);
+	return 1;
+catch:
+	if(!errno) errno = ERANGE; /* `malloc` only has to set it in POSIX. */
+	if(parts) for(b = 0; b <= UCHAR_MAX; b++) t_(trie_)(parts + b);
+	free(parts), free(work);
+	return 0;
+}
+#		endif /* parallel --> */
+
+#		ifdef TRIE_CONCURRENT /* <!-- concurrent */
+/** Takes the versions that no one reads off the oldest of `c`, up to the
+ current one. Must hold the lock of `c`. @return The first of them, linked by
+ `next`, or null. */
+static struct pT_(version) *pT_(unlink)(struct T_(concurrent) *const c) {
+	struct pT_(version) *const first = c->oldest, *v = first, *last = 0;
+#			ifdef TRIE_ATOMIC
+	while(v != TRIE_LOAD(&c->current) && !TRIE_LOAD(&v->readers))
+#			else
+	while(v != c->current && !v->readers)
+#			endif
+		last = v, v = v->next;
+	if(!last) return 0;
+	last->next = 0, c->oldest = v;
+	return first;
+}
+
+/** Frees the boughs that only the versions in `unlinked` could see, without
+ the lock of `c`; then they are spares. */
+static void pT_(reclaim)(struct T_(concurrent) *const c,
+	struct pT_(version) *const unlinked) {
+	struct pT_(version) *v, *last = 0;
+	size_t i;
+	if(!unlinked) return;
+	for(v = unlinked; v; last = v, v = v->next) {
+		for(i = 0; i < v->retired.size; i++) free(v->retired.data[i]);
+		free(v->retired.data);
+		v->retired.data = 0, v->retired.size = v->retired.capacity = 0;
+	}
+	pthread_mutex_lock(&c->lock);
+	last->next = c->spare, c->spare = unlinked;
+	pthread_mutex_unlock(&c->lock);
+}
+
+/** `v` of `c` was let go by a reader. If it was the last, and `v` is old,
+ the versions no one reads are reclaimed. */
+static void pT_(let_go)(struct T_(concurrent) *const c,
+	struct pT_(version) *const v) {
+	struct pT_(version) *unlinked;
+#			ifdef TRIE_ATOMIC
+	if(TRIE_SUB(&v->readers, 1) != 1 || v == TRIE_LOAD(&c->current)) return;
+	pthread_mutex_lock(&c->lock);
+#			else
+	pthread_mutex_lock(&c->lock);
+	assert(v->readers);
+	if(--v->readers || v == c->current)
+		{ pthread_mutex_unlock(&c->lock); return; }
+#			endif
+	unlinked = pT_(unlink)(c);
+	pthread_mutex_unlock(&c->lock);
+	pT_(reclaim)(c, unlinked);
+}
+
+/** Sets up `c` as an empty trie with a version that readers can acquire.
+ @return Success, otherwise `c` is not initialized.
+ @throws[malloc, pthread_mutex_init] @allow */
+static int T_(concurrent)(struct T_(concurrent) *const c) {
+	struct pT_(version) *v;
+	int e;
+	assert(c);
+	if(!(v = malloc(sizeof *v))) { if(!errno) errno = ERANGE; return 0; }
+	if(e = pthread_mutex_init(&c->lock, 0)) { free(v); errno = e; return 0; }
+	v->trie = c->trie = t_(trie)(), v->readers = 0, v->next = 0;
+	v->retired.data = 0, v->retired.size = v->retired.capacity = 0;
+	c->writer.retired = v->retired, c->writer.generation = 1;
+	c->oldest = v, c->spare = 0, c->current = v;
+	return 1;
+}
+
+/** Destroys `c`, which can be null, once no one is reading it. @allow */
+static void T_(concurrent_)(struct T_(concurrent) *const c) {
+	struct pT_(version) *v, *next;
+	size_t i;
+	if(!c || !c->oldest) return;
+	assert(!c->current->readers);
+	/* Everything is unreachable; the current version is the writer's. */
+	for(v = c->oldest; v; v = next) {
+		next = v->next;
+		for(i = 0; i < v->retired.size; i++) free(v->retired.data[i]);
+		free(v->retired.data), free(v);
+	}
+	for(v = c->spare; v; v = next) next = v->next, free(v);
+	for(i = 0; i < c->writer.retired.size; i++)
+		free(c->writer.retired.data[i]);
+	free(c->writer.retired.data);
+	t_(trie_)(&c->trie);
+	pthread_mutex_destroy(&c->lock);
+	c->oldest = c->spare = 0;
+}
+
+/** Copies the path of `string` in the writer's trie of `c` so that it can be
+ changed without readers seeing it. */
+static int pT_(concurrent_begin)(struct T_(concurrent) *const c,
+	const char *const string) {
+	c->trie.writer = &c->writer;
+	if(pT_(copy_path)(&c->trie, string)) return 1;
+	c->trie.writer = 0;
+	return 0;
+}
+
+#			ifndef TRIE_ENTRY /* <!-- set */
+/** Only the writer of `c`. Adds `key` like <fn:<T>add>, but readers don't see
+ it until <fn:<T>publish>.
+ @return One of `TRIE_ERROR`, `TRIE_ABSENT`, or `TRIE_PRESENT`.
+ @throws[EILSEQ, malloc] @order \O(\log |`trie`|) @allow */
+static enum trie_result T_(concurrent_add)(struct T_(concurrent) *const c,
+	const pT_(key) key) {
+	enum trie_result result;
+#			ifdef TRIE_KEY_BYTES
+	const char *const string = (const char *)&key;
+#			else
+	const char *const string = t_(string)(key);
+#			endif
+	assert(c && string);
+	if(!pT_(concurrent_begin)(c, string)) return TRIE_ERROR;
+	result = T_(add)(&c->trie, key);
+	c->trie.writer = 0;
+	return result;
+}
+#			else /* set --><!-- entry */
+/** Only the writer of `c`. Adds `key` like <fn:<T>add>, and the entry is
+ filled in before <fn:<T>publish>, when readers see it.
+ @return One of `TRIE_ERROR`, `TRIE_ABSENT`, or `TRIE_PRESENT`.
+ @throws[EILSEQ, malloc] @order \O(\log |`trie`|) @allow */
+static enum trie_result T_(concurrent_add)(struct T_(concurrent) *const c,
+	const pT_(key) key, pT_(entry) **const put_entry_here) {
+	enum trie_result result;
+#			ifdef TRIE_KEY_BYTES
+	const char *const string = (const char *)&key;
+#			else
+	const char *const string = t_(string)(key);
+#			endif
+	assert(c && string && put_entry_here);
+	if(!pT_(concurrent_begin)(c, string)) return TRIE_ERROR;
+	result = T_(add)(&c->trie, key, put_entry_here);
+	c->trie.writer = 0;
+	return result;
+}
+#			endif /* entry --> */
+
+/** Only the writer of `c`. Removes `string` like <fn:<T>remove>, but readers
+ see it until <fn:<T>publish>.
+ @return Success. @throws[EILSEQ, malloc] @order \O(\log |`trie`|) @allow */
+static int T_(concurrent_remove)(struct T_(concurrent) *const c,
+	const char *const string) {
+	int success;
+	assert(c);
+	if(!string || !pT_(concurrent_begin)(c, string)) return 0;
+	success = T_(remove)(&c->trie, string);
+	c->trie.writer = 0;
+	return success;
+}
+
+/** Only the writer of `c`. The changes since the last time become the
+ version that <fn:<T>acquire> gives readers; readers that already have an
+ older version continue to see it. The versions that no one reads any more
+ are reclaimed.
+ @return Success, otherwise the changes are not visible yet.
+ @throws[malloc] @order \O(1) amortized @allow */
+static int T_(publish)(struct T_(concurrent) *const c) {
+	struct pT_(version) *v, *unlinked, *current;
+	assert(c && c->current);
+	current = c->current;
+	if(c->trie.trunk == current->trie.trunk && !c->writer.retired.size)
+		return 1; /* Nothing changed. */
+	pthread_mutex_lock(&c->lock);
+	if(v = c->spare) c->spare = v->next;
+	pthread_mutex_unlock(&c->lock);
+	if(!v) {
+		if(!(v = malloc(sizeof *v))) { if(!errno) errno = ERANGE; return 0; }
+		v->readers = 0; /* A spare keeps its count; readers may be backing out. */
+		v->retired.data = 0, v->retired.size = v->retired.capacity = 0;
+	}
+	v->trie = c->trie, v->next = 0;
+	pthread_mutex_lock(&c->lock);
+	current->retired = c->writer.retired, current->next = v;
+#			ifdef TRIE_ATOMIC
+	TRIE_STORE(&c->current, v);
+#			else
+	c->current = v;
+#			endif
+	unlinked = pT_(unlink)(c);
+	pthread_mutex_unlock(&c->lock);
+	pT_(reclaim)(c, unlinked);
+	c->writer.retired.data = 0;
+	c->writer.retired.size = c->writer.retired.capacity = 0;
+	c->writer.generation++;
+	return 1;
+}
+
+/** Any thread. With atomics, a reader counts itself in the version without
+ the lock; otherwise, the lock is only held to count it. The lookups are
+ without locking. @return A read-only trie of the latest version of `c`, to
+ give back with <fn:<T>release>. Only the functions that don't change it,
+ (not <fn:<T>top>,) are safe. @order \O(1) @allow */
+static const struct t_(trie) *T_(acquire)(struct T_(concurrent) *const c) {
+	struct pT_(version) *v;
+	assert(c);
+#			ifdef TRIE_ATOMIC
+	for( ; ; ) {
+		v = TRIE_LOAD(&c->current), assert(v);
+		TRIE_ADD(&v->readers, 1);
+		/* Else it was replaced, and may be reclaimed, before it counted. */
+		if(v == TRIE_LOAD(&c->current)) return &v->trie;
+		pT_(let_go)(c, v);
+	}
+#			else
+	pthread_mutex_lock(&c->lock);
+	assert(c->current);
+	(v = c->current)->readers++;
+	pthread_mutex_unlock(&c->lock);
+	return &v->trie;
+#			endif
+}
+
+/** Gives back `trie` that was acquired from `c`. The last reader of an old
+ version frees the boughs that were replaced, outside of the lock. @allow */
+static void T_(release)(struct T_(concurrent) *const c,
+	const struct t_(trie) *const trie) {
+	struct pT_(version) *const v = (struct pT_(version) *)trie; /* First. */
+	assert(c && v);
+	pT_(let_go)(c, v);
+}
+#		endif /* concurrent --> */
+
+#		ifdef TRIE_COUNT /* <!-- count */
+/** @return The number of entries in `trie`, which can be null, adding up the
+ counts of the trunk. @order \O(`TRIE_ORDER`) @allow */
+static size_t T_(count)(const struct t_(trie) *const trie) {
+	return trie && trie->trunk && trie->trunk->leaves
+		? pT_(sum)(trie->trunk, 0, trie->trunk->leaves - 1u) : 0;
+}
+#			ifndef TRIE_KEY_BYTES
+/** @return The number of entries in `trie` that start with `prefix`, (both can
+ be null,) without going through them.
+ @order \O(\log |`trie`|), but the last bough is added up in
+ \O(`TRIE_ORDER`). @allow */
+static size_t T_(prefix_count)(const struct t_(trie) *const trie,
+	const char *const prefix) {
+	struct pT_(bough) *bough;
+	struct pT_(ref) ref;
+	unsigned lf0, lf1;
+	if(!trie || !prefix
+		|| !pT_(prefix_leaves)(trie, prefix, &bough, &lf0, &lf1)) return 0;
+	ref.bough = bough, ref.lf = lf0, pT_(lower_entry)(&ref);
+	return trie_is_prefix(prefix, pT_(ref_to_string)(&ref))
+		? pT_(sum)(bough, lf0, lf1) : 0;
+}
+#			endif
+/** @return The number of entries in `trie` that are less than `string`, which
+ need not be in `trie`; this is the index when it is. (Both can be null.) Like
+ <fn:<pT>add>, it finds the first bit different from a key in the trie, then
+ everything on the left of that path is less.
+ @order \O(`TRIE_ORDER` \log |`trie`|), adding up the counts on the left in
+ every bough on the path. @allow */
+static size_t T_(rank)(const struct t_(trie) *const trie,
+	const char *const string) {
+	struct pT_(bough) *bough;
+	size_t bit, diff, rank;
+	unsigned br0, br1, lf;
+	if(!trie || !string || !(bough = trie->trunk) || !bough->leaves) return 0;
+	diff = pT_(diff)(trie, string);
+	/* Go down again, up to the difference, counting the left sides. */
+	for(rank = 0, bit = 0; ; bough = pT_(leaf)(bough)[lf].as_link) {
+		br0 = 0, br1 = bough->leaves - 1, lf = 0;
+		while(br0 < br1) {
+			const struct trie_branch *const branch = pT_(branch)(bough) + br0;
+			if(diff <= (bit += branch->skip)) goto subtree;
+			if(!TRIE_QUERY(string, bit))
+				br1 = ++br0 + branch->left;
+			else
+				rank += pT_(sum)(bough, lf, lf + branch->left),
+				br0 += branch->left + 1, lf += branch->left + 1;
+			bit++;
+		}
+		if(!trie_bmp_test(&bough->bmp, lf)) break;
+	}
+subtree: /* The keys under here all have the same bit as `sample`. */
+	if(diff != (size_t)-1 && TRIE_QUERY(string, diff))
+		rank += pT_(sum)(bough, lf, lf + br1 - br0);
+	return rank;
+}
+/** @return A cursor in `trie` starting at the entry with `rank` entries less
+ than it, to the end, or one that doesn't exist if `rank` is not less than the
+ count. @order \O(`TRIE_ORDER` \log |`trie`|), going through the counts in
+ every bough on the path. @allow */
+static struct T_(cursor) T_(select)(const struct t_(trie) *const trie,
+	size_t rank) {
+	struct pT_(bough) *bough;
+	struct pT_(ref) ref;
+	unsigned lf;
+	ref.bough = 0;
+	if(!trie || !(bough = trie->trunk)) return pT_(to_end)(trie, ref);
+	for( ; ; bough = pT_(leaf)(bough)[lf].as_link) {
+		const size_t *const size = pT_(size)(bough);
+		for(lf = 0; lf < bough->leaves && size[lf] <= rank; lf++)
+			rank -= size[lf];
+		/* Only the trunk can run out, and then it's not less than the count. */
+		if(lf == bough->leaves)
+			{ assert(bough == trie->trunk); return pT_(to_end)(trie, ref); }
+		if(!trie_bmp_test(&bough->bmp, lf)) break;
+	}
+	ref.bough = bough, ref.lf = lf;
+	return pT_(to_end)(trie, ref);
+}
+#		endif /* count --> */
+
+#		ifdef TRIE_IMAGE /* <!-- image */
+/** @return The length of the key `string` in an image. */
+static size_t pT_(image_length)(const char *const string) {
+#			ifdef TRIE_KEY_BYTES
+	(void)string;
+	return TRIE_KEY_BYTES;
+#			else
+	return strlen(string) + 1;
+#			endif
+}
+
+/** Writes the boughs under `bough`, then `bough`, to `fp`. `words` is the
+ number written so far, and `keys` the size of the keys before. @return
+ Success. The place of `bough` in words is stored in `place`.
+ @throws[fwrite, ERANGE] */
+static int pT_(image_save_r)(struct pT_(bough) *const bough, FILE *const fp,
+	size_t *const words, size_t *const keys, size_t *const place) {
+	trie_image_uint w[1 + TRIE_IMAGE_BRANCHES(TRIE_ORDER) + TRIE_ORDER], *leaf;
+	const size_t size = 1 + TRIE_IMAGE_BRANCHES(bough->leaves) + bough->leaves;
+	unsigned lf;
+	assert(bough && bough->leaves && fp && words && keys && place);
+	memset(w, 0, sizeof *w * size); /* Don't write uninitialized memory. */
+	w[0] = bough->leaves, leaf = w + size - bough->leaves;
+	memcpy(w + 1, pT_(branch)(bough),
+		sizeof(struct trie_branch) * (bough->leaves - 1u));
+	for(lf = 0; lf < bough->leaves; lf++) {
+		size_t n;
+		if(trie_bmp_test(&bough->bmp, lf)) {
+			if(!pT_(image_save_r)(pT_(leaf)(bough)[lf].as_link,
+				fp, words, keys, &n))
+				return 0;
+		} else {
+			struct pT_(ref) ref;
+			ref.bough = bough, ref.lf = lf;
+			n = *keys, *keys += pT_(image_length)(pT_(ref_to_string)(&ref));
+		}
+		if(*keys >= TRIE_IMAGE_LINK) { errno = ERANGE; return 0; }
+		leaf[lf] = (trie_image_uint)n;
+	}
+	if(*words + size >= TRIE_IMAGE_LINK) { errno = ERANGE; return 0; }
+	/* The children are before; now that its place is known, they are relative
+	 to it. */
+	for(lf = 0; lf < bough->leaves; lf++) if(trie_bmp_test(&bough->bmp, lf))
+		leaf[lf] = (trie_image_uint)((*words - leaf[lf]) | TRIE_IMAGE_LINK);
+	if(fwrite(w, sizeof *w, size, fp) != size) return 0;
+	*place = *words, *words += size;
+	return 1;
+}
+/** @return The branches of `bough` in an image. */
+static const struct trie_branch *pT_(image_branch)(const trie_image_uint
+	*const bough)
+	{ return (const struct trie_branch *)(const void *)(bough + 1); }
+/** @return Whether leaf `lf` of `bough` in an image is a link. */
+static int pT_(image_is_link)(const trie_image_uint *const bough,
+	const unsigned lf) {
+	assert(bough && lf < bough[0]);
+	return !!(bough[1 + TRIE_IMAGE_BRANCHES(bough[0]) + lf] & TRIE_IMAGE_LINK);
+}
+/** @return The value of leaf `lf` of `bough` in an image, without the link
+ flag. */
+static size_t pT_(image_leaf)(const trie_image_uint *const bough,
+	const unsigned lf) {
+	assert(bough && lf < bough[0]);
+	return bough[1 + TRIE_IMAGE_BRANCHES(bough[0]) + lf] & ~TRIE_IMAGE_LINK;
+}
+/** @return The bough linked from `lf` of `bough` in an image. */
+static const trie_image_uint *pT_(image_link)(const trie_image_uint
+	*const bough, const unsigned lf) {
+	assert(pT_(image_is_link)(bough, lf));
+	return bough - pT_(image_leaf)(bough, lf);
+}
+/** @return The key string at `ref` in `image`. */
+static const char *pT_(image_string)(const struct T_(image) *const image,
+	const struct pT_(image_ref) *const ref)
+	{ return image->keys + pT_(image_leaf)(ref->bough, ref->lf); }
+/** <fn:<pT>lower_entry> in an image. */
+static void pT_(image_lower)(struct pT_(image_ref) *const ref) {
+	while(pT_(image_is_link)(ref->bough, ref->lf))
+		ref->bough = pT_(image_link)(ref->bough, ref->lf), ref->lf = 0;
+}
+/** <fn:<pT>higher_entry> in an image. */
+static void pT_(image_higher)(struct pT_(image_ref) *const ref) {
+	while(pT_(image_is_link)(ref->bough, ref->lf))
+		ref->bough = pT_(image_link)(ref->bough, ref->lf),
+		ref->lf = (unsigned)ref->bough[0] - 1;
+}
+
+/** Checks the branches `br0` to `br1` of a bough in an image are a tree, and
+ stores the bits from `bit` that it takes to get to each leaf from `lf` in
+ `bits`. @return Success. */
+static int pT_(image_valid_branch_r)(const struct trie_branch *const branches,
+	const unsigned br0, const unsigned br1, const unsigned lf,
+	const size_t bit, size_t *const bits) {
+	const struct trie_branch *branch;
+	if(br0 >= br1) return bits[lf] = bit, 1;
+	branch = branches + br0;
+	if(branch->left > br1 - br0 - 1) return 0;
+	return pT_(image_valid_branch_r)(branches, br0 + 1, br0 + 1 + branch->left,
+		lf, bit + branch->skip + 1, bits)
+		&& pT_(image_valid_branch_r)(branches, br0 + 1 + branch->left, br1,
+		lf + branch->left + 1, bit + branch->skip + 1, bits);
+}
+/** Checks the `words` words of boughs in an image before `keys_size` bytes of
+ `keys`, with the root at `root`, in one pass: every bough fits, its branches
+ are a tree, the keys are in the blob, and the links go exactly to the
+ sub-trees that were written before, as <fn:<pT>image_save_r> does.
+ @return Success. @throws[EILSEQ, realloc] */
+static int pT_(image_valid)(const trie_image_uint *const word,
+	const size_t words, const char *const keys, const size_t keys_size,
+	const size_t root) {
+	/* The sub-trees that are not linked yet: their place, and the bits that
+	 the longest path in them takes. */
+	struct { size_t place, bits; } *stack = 0, *fresh;
+	size_t size = 0, capacity = 0, w, end;
+	int is_valid = 0;
+#			ifdef TRIE_KEY_BYTES
+	(void)keys;
+	end = keys_size >= TRIE_KEY_BYTES ? keys_size - TRIE_KEY_BYTES + 1 : 0;
+#			else
+	/* A key must be terminated before the end. */
+	for(end = keys_size; end && keys[end - 1]; end--);
+#			endif
+	for(w = 0; w < words; ) {
+		const trie_image_uint *const bough = word + w;
+		size_t bits[TRIE_ORDER], need = 0, links = 0, i;
+		unsigned lf;
+		if(!bough[0] || bough[0] > TRIE_ORDER
+			|| 1 + TRIE_IMAGE_BRANCHES(bough[0]) + bough[0] > words - w
+			|| !pT_(image_valid_branch_r)(pT_(image_branch)(bough), 0,
+			(unsigned)bough[0] - 1, 0, 0, bits)) goto catch;
+		for(lf = 0; lf < bough[0]; lf++) if(pT_(image_is_link)(bough, lf))
+			links++;
+		else if(pT_(image_leaf)(bough, lf) >= end) goto catch;
+		if(links > size) goto catch;
+		/* The links are to the last sub-trees, in order. */
+		for(i = size - links, lf = 0; lf < bough[0]; lf++) {
+			if(!pT_(image_is_link)(bough, lf)) {
+				if(need < bits[lf]) need = bits[lf];
+				continue;
+			}
+			if(w - stack[i].place != pT_(image_leaf)(bough, lf)) goto catch;
+			if(need < bits[lf] + stack[i].bits) need = bits[lf] + stack[i].bits;
+			i++;
+		}
+		size -= links;
+		if(size >= capacity) {
+			capacity = capacity ? 2 * capacity : 16;
+			if(!(fresh = realloc(stack, sizeof *stack * capacity)))
+				{ if(!errno) errno = ERANGE; free(stack); return 0; }
+			stack = fresh;
+		}
+		stack[size].place = w, stack[size].bits = need, size++;
+		w += 1 + TRIE_IMAGE_BRANCHES(bough[0]) + bough[0];
+	}
+	/* The last one written is the root, and it has all the others. */
+	if(!(is_valid = size == 1 && stack[0].place == root
+#			ifdef TRIE_KEY_BYTES
+		&& stack[0].bits <= TRIE_KEY_BYTES * CHAR_BIT
+#			endif
+		)) errno = EILSEQ;
+	free(stack);
+	return is_valid;
+catch:
+	errno = EILSEQ;
+	free(stack);
+	return 0;
+}
+
+/** Only with `TRIE_IMAGE`. Writes `trie`, (which can be null,) to `fp`: the
+ boughs with children first and leaves as 32-bit offsets, the keys in order,
+ and a trailer. Any entry other than the key is not saved; the image is only
+ for the same instantiation on the same platform.
+ @return Success. @throws[fwrite, ERANGE] The image would be more than 2GB.
+ @order \Theta(|`trie`|) @allow */
+static int T_(image_save)(const struct t_(trie) *const trie, FILE *const fp) {
+	struct pT_(image_trailer) trailer;
+	size_t words = 0, keys = 0, root = 0;
+	const char zero[sizeof(trie_image_uint)] = { 0 };
+	assert(fp);
+	memset(&trailer, 0, sizeof trailer);
+	if(trie && trie->trunk && trie->trunk->leaves) {
+		struct T_(cursor) cur;
+		struct pT_(ref) first;
+		if(!pT_(image_save_r)(trie->trunk, fp, &words, &keys, &root)) return 0;
+		/* In the same order that they were counted. */
+		first.bough = trie->trunk, first.lf = 0, pT_(lower_entry)(&first);
+		for(cur = pT_(to_end)(trie, first); T_(exists)(&cur); T_(next)(&cur)) {
+			const char *const string = pT_(ref_to_string)(&cur.start);
+			const size_t length = pT_(image_length)(string);
+			if(fwrite(string, 1, length, fp) != length) return 0;
+		}
+	}
+	/* The trailer is aligned. */
+	if(fwrite(zero, 1, (sizeof zero - keys % sizeof zero) % sizeof zero, fp)
+		!= (sizeof zero - keys % sizeof zero) % sizeof zero) return 0;
+	keys += (sizeof zero - keys % sizeof zero) % sizeof zero;
+	memcpy(trailer.magic, "boxtrie", sizeof trailer.magic);
+	trailer.words = (trie_image_uint)words;
+	trailer.keys = (trie_image_uint)keys;
+	trailer.root = (trie_image_uint)root;
+#			ifdef TRIE_KEY_BYTES
+	trailer.key_bytes = TRIE_KEY_BYTES;
+#			endif
+	return fwrite(&trailer, sizeof trailer, 1, fp) == 1;
+}
+
+/** Only with `TRIE_IMAGE`. Sets up `image` to read the trie in `data` of
+ `size` bytes that was written by <fn:<T>image_save>; for example, a file
+ that is `mmap`ed. Nothing is copied: `data` must stay valid and be aligned
+ for a word, and the image is read in-place.
+ @return Success. @throws[EILSEQ] `data` is not an image of this type; every
+ offset in it is checked. @throws[realloc]
+ @order \Theta(`size`) @allow */
+static int T_(image)(struct T_(image) *const image, const void *const data,
+	const size_t size) {
+	const char *const bytes = data;
+	const struct pT_(image_trailer) *trailer;
+	assert(image);
+	if(!data || size < sizeof *trailer
+		|| (size - sizeof *trailer) % sizeof(trie_image_uint)) goto catch;
+	trailer = (const void *)(bytes + size - sizeof *trailer);
+	if(memcmp(trailer->magic, "boxtrie", sizeof trailer->magic)
+		|| trailer->words >= TRIE_IMAGE_LINK || trailer->keys >= TRIE_IMAGE_LINK
+		|| size - sizeof *trailer
+		!= sizeof(trie_image_uint) * trailer->words + trailer->keys
+		|| (trailer->words ? trailer->root >= trailer->words : !!trailer->root)
+#			ifdef TRIE_KEY_BYTES
+		|| trailer->key_bytes != TRIE_KEY_BYTES
+#			else
+		|| trailer->key_bytes
+#			endif
+		) goto catch;
+	if(trailer->words && !pT_(image_valid)(data, trailer->words,
+		bytes + sizeof(trie_image_uint) * trailer->words, trailer->keys,
+		trailer->root)) return 0;
+	image->root = trailer->words ? (const trie_image_uint *)data + trailer->root
+		: 0;
+	image->keys = bytes + sizeof(trie_image_uint) * trailer->words;
+	return 1;
+catch:
+	errno = EILSEQ;
+	return 0;
+}
+
+/** Only with `TRIE_IMAGE`. @return The key in `image` that is the same as
+ `string`, or null. @order \O(|`string`|) @allow */
+static const char *T_(image_get)(const struct T_(image) *const image,
+	const char *const string) {
+	struct pT_(image_ref) ref;
+	const char *key;
+	size_t bit, byte;
+	assert(image && string);
+	if(!(ref.bough = image->root)) return 0;
+	for(bit = 0, byte = 0; ; ref.bough = pT_(image_link)(ref.bough, ref.lf)) {
+		const struct trie_branch *const branches = pT_(image_branch)(ref.bough);
+		unsigned br0 = 0, br1 = (unsigned)ref.bough[0] - 1;
+		ref.lf = 0;
+		while(br0 < br1) {
+			const struct trie_branch *const branch = branches + br0;
+			if(!pT_(is_long)(string, &byte, (bit += branch->skip) / CHAR_BIT))
+				return 0; /* Too short. */
+			if(!TRIE_QUERY(string, bit))
+				br1 = ++br0 + branch->left;
+			else
+				br0 += branch->left + 1, ref.lf += branch->left + 1;
+			bit++;
+		}
+		if(!pT_(image_is_link)(ref.bough, ref.lf)) break;
+	}
+	key = pT_(image_string)(image, &ref);
+	return pT_(key_compare)(key, string) ? 0 : key;
+}
+
+/** Only with `TRIE_IMAGE`. @return A cursor on all the keys of `image`.
+ @order \O(\log |`image`|) @allow */
+static struct T_(image_cursor) T_(image_begin)(const struct T_(image) *const
+	image) {
+	struct T_(image_cursor) cur;
+	assert(image);
+	if(!(cur.image = image->root ? image : 0)) return cur;
+	cur.start.bough = cur.end.bough = image->root;
+	cur.start.lf = 0, pT_(image_lower)(&cur.start);
+	cur.end.lf = (unsigned)image->root[0] - 1, pT_(image_higher)(&cur.end);
+	return cur;
+}
+
+#			ifndef TRIE_KEY_BYTES
+/** Only with `TRIE_IMAGE`. @return A cursor on the keys of `image` that start
+ with `prefix`. @order \O(|`prefix`|) @allow */
+static struct T_(image_cursor) T_(image_prefix)(const struct T_(image) *const
+	image, const char *const prefix) {
+	struct T_(image_cursor) cur;
+	const trie_image_uint *bough;
+	size_t bit, byte;
+	unsigned br0, br1, lf;
+	assert(image && prefix);
+	cur.image = 0;
+	if(!(bough = image->root)) return cur;
+	for(bit = 0, byte = 0; ; bough = pT_(image_link)(bough, lf)) {
+		const struct trie_branch *const branches = pT_(image_branch)(bough);
+		br0 = 0, br1 = (unsigned)bough[0] - 1, lf = 0;
+		while(br0 < br1) {
+			const struct trie_branch *const branch = branches + br0;
+			/* _Sic_; '\0' is _not_ included for partial match. */
+			if(!trie_is_long(prefix, &byte,
+				(bit += branch->skip) / CHAR_BIT + 1)) goto finally;
+			if(!TRIE_QUERY(prefix, bit))
+				br1 = ++br0 + branch->left;
+			else
+				br0 += branch->left + 1, lf += branch->left + 1;
+			bit++;
+		}
+		if(!pT_(image_is_link)(bough, lf)) break;
+	}
+finally:
+	cur.start.bough = cur.end.bough = bough;
+	cur.start.lf = lf, pT_(image_lower)(&cur.start);
+	cur.end.lf = lf + br1 - br0, pT_(image_higher)(&cur.end);
+	/* Make sure actually a prefix by choosing one of the words and testing. */
+	if(trie_is_prefix(prefix, pT_(image_string)(image, &cur.start)))
+		cur.image = image;
+	return cur;
+}
+#			endif
+
+/** Only with `TRIE_IMAGE`. @return Whether `cur` points to a key. @allow */
+static int T_(image_exists)(const struct T_(image_cursor) *const cur)
+	{ return cur && cur->image; }
+
+/** Only with `TRIE_IMAGE`. @return The key at `cur` that
+ <fn:<T>image_exists>; it points into the image. @allow */
+static const char *T_(image_key)(const struct T_(image_cursor) *const cur)
+	{ return assert(cur && cur->image),
+	pT_(image_string)(cur->image, &cur->start); }
+
+/** Only with `TRIE_IMAGE`. Moves `cur` to the next key, if there is one.
+ @order \O(\log |`image`|) @allow */
+static void T_(image_next)(struct T_(image_cursor) *const cur) {
+	assert(cur);
+	if(!cur->image) return;
+	/* Stop when getting to the end of the range. */
+	if(cur->start.bough == cur->end.bough && cur->start.lf >= cur->end.lf)
+		{ cur->image = 0; return; }
+	if(cur->start.lf + 1 < cur->start.bough[0]) {
+		cur->start.lf++; /* It's in the same bough. */
+	} else { /* Going to go off the end; go down again from the root. */
+		const char *const sample = pT_(image_string)(cur->image, &cur->start);
+		const trie_image_uint *const old = cur->start.bough,
+			*next = cur->image->root;
+		const size_t length = pT_(image_length)(sample);
+		size_t bit = 0;
+		cur->start.bough = 0;
+		while(next != old) {
+			const struct trie_branch *const branches = pT_(image_branch)(next);
+			unsigned br0 = 0, br1 = (unsigned)next[0] - 1, lf = 0;
+			while(br0 < br1) {
+				const struct trie_branch *const branch = branches + br0;
+				/* The key is shorter than the path; not from this image. */
+				if((bit += branch->skip) / CHAR_BIT >= length)
+					{ cur->image = 0; return; }
+				if(!TRIE_QUERY(sample, bit))
+					br1 = ++br0 + branch->left;
+				else
+					br0 += branch->left + 1, lf += branch->left + 1;
+				bit++;
+			}
+			if(lf + 1 < next[0])
+				cur->start.bough = next, cur->start.lf = lf + 1;
+			next = pT_(image_link)(next, lf);
+		}
+		if(!cur->start.bough) { cur->image = 0; return; }
+	}
+	pT_(image_lower)(&cur->start);
+}
+#		endif /* image --> */
+
+#		ifdef TRIE_SCORE /* <!-- score */
+/** Only with `TRIE_SCORE`. Modifying the trie does this automatically; this
+ is needed when the score of an entry is changed in place. Marks the best
+ scores that `string` in `trie` contributes to as stale; if it's not in
+ `trie`, does nothing. @order \O(\log |`trie`|) @allow */
+static void T_(invalidate)(struct t_(trie) *const trie,
+	const char *const string) {
+	struct pT_(ref) ref;
+	if(trie && string && pT_(get)(trie, string, &ref))
+		pT_(touch_path)(trie, string, 0);
+}
+#			ifndef TRIE_KEY_BYTES
+/** Only with `TRIE_SCORE`. Fills `top` with up to `k` of the entries in `trie`
+ that start with `prefix`, in order of descending score. It is best-first:
+ boughs are only opened when the best score under them is one of the highest,
+ using the scores cached beside the leaves of the bough that links to them;
+ stale ones are recomputed. Leaves are only pushed when they beat the `k`-th
+ best entry that has been seen.
+ @return The number of entries in `top`, which is `k` unless there are fewer
+ entries with `prefix`. If zero, `errno` may be set. @throws[realloc]
+ @order \O(k \log k) times the order, amortized over modifications @allow */
+static size_t T_(top)(struct t_(trie) *const trie, const char *const prefix,
+	pT_(remit) *const top, const size_t k) {
+	struct pT_(top_search) search;
+	struct pT_(bough) *bough;
+	struct pT_(ref) ref;
+	unsigned lf0, lf1;
+	size_t n = 0;
+	assert(!k || top);
+	if(!trie || !prefix || !k
+		|| !pT_(prefix_leaves)(trie, prefix, &bough, &lf0, &lf1)) return 0;
+	ref.bough = bough, ref.lf = lf0, pT_(lower_entry)(&ref);
+	if(!trie_is_prefix(prefix, pT_(ref_to_string)(&ref))) return 0;
+	search.heap = pT_(top_heap)(), search.floor = pT_(floor_heap)();
+	search.k = k;
+	if(!pT_(top_push)(&search, bough, lf0, lf1)) goto catch;
+	while(n < k && pT_(top_heap_size)(&search.heap)) {
+		const struct pT_(top) best = pT_(top_heap_pop)(&search.heap);
+		if(trie_bmp_test(&best.bough->bmp, best.lf)) {
+			bough = pT_(leaf)(best.bough)[best.lf].as_link;
+			if(!pT_(top_push)(&search, bough, 0, bough->leaves - 1u))
+				goto catch;
+		} else {
+			ref.bough = best.bough, ref.lf = best.lf;
+			top[n++] = pT_(ref_to_remit)(&ref);
+		}
+	}
+	pT_(top_heap_)(&search.heap), pT_(floor_heap_)(&search.floor);
+	return n;
+catch:
+	if(!errno) errno = ERANGE;
+	pT_(top_heap_)(&search.heap), pT_(floor_heap_)(&search.floor);
+	return 0;
+}
+#			endif
+#		endif /* score --> */
+
+#		ifdef TRIE_AUTOMATON /* <!-- automaton */
+/** @return The child of state `s` in `a` on `byte`, or zero. */
+static unsigned pT_(automaton_child)(const struct T_(automaton) *const a,
+	const unsigned s, const unsigned char byte) {
+	const struct pT_(state) *const state = a->state + s;
+	unsigned lo = state->child, hi = state->child + state->children;
+	while(lo < hi) {
+		const unsigned mid = lo + (hi - lo) / 2;
+		if(a->state[mid].label < byte) lo = mid + 1; else hi = mid;
+	}
+	return lo < state->child + state->children && a->state[lo].label == byte
+		? lo : 0;
+}
+
+/** Only with `TRIE_AUTOMATON`. Destroys `a`, (which can be null,) and sets it
+ to idle. @allow */
+static void T_(automaton_)(struct T_(automaton) *const a) {
+	if(!a) return;
+	free(a->state), free(a->delta), free(a->pattern);
+	a->state = 0, a->states = a->dense = 0, a->delta = 0, a->pattern = 0;
+}
+
+/** Only with `TRIE_AUTOMATON`. Compiles the keys of `trie` into `a`, which
+ is overwritten and must be destroyed by <fn:<T>automaton_>. The empty key is
+ not a pattern. The patterns are the keys of `trie`, so it must not change
+ while `a` is used.
+ @return Success, otherwise `a` is idle. @throws[malloc]
+ @throws[ERANGE] There are more states than fit in `unsigned`.
+ @order \O(|`keys`|) @allow */
+static int T_(automaton)(struct T_(automaton) *const a,
+	const struct t_(trie) *const trie) {
+	struct pT_(state) *dfs = 0, *state;
+	unsigned *path = 0, *map = 0, i, s;
+	size_t patterns = 0, bytes = 0, longest = 0, d;
+	const char *previous = "";
+	assert(a);
+	a->state = 0, a->states = a->dense = 0, a->delta = 0, a->pattern = 0;
+	if(trie && trie->trunk && trie->trunk->leaves) { /* Count. */
+		struct T_(cursor) cur;
+		struct pT_(ref) first;
+		first.bough = trie->trunk, first.lf = 0, pT_(lower_entry)(&first);
+		for(cur = pT_(to_end)(trie, first); T_(exists)(&cur); T_(next)(&cur)) {
+			const size_t length = strlen(pT_(ref_to_string)(&cur.start));
+			if(!length) continue;
+			patterns++, bytes += length;
+			if(longest < length) longest = length;
+		}
+	}
+	if(bytes >= UINT_MAX) { errno = ERANGE; goto catch; }
+	/* At most, every byte is a state. */
+	if(!(dfs = malloc(sizeof *dfs * (bytes + 1)))
+		|| !(map = malloc(sizeof *map * (bytes + 1)))
+		|| !(path = malloc(sizeof *path * (longest + 2)))
+		|| (patterns && !(a->pattern = malloc(sizeof *a->pattern * patterns))))
+		goto catch;
+	dfs[0].depth = 0, dfs[0].pattern = 0, dfs[0].fail = 0, dfs[0].label = 0;
+	a->states = 1, path[0] = 0;
+	if(patterns) { /* In order, the new states of a key are after the common
+		prefix with the previous key: a depth-first, pre-order, prefix tree. */
+		struct T_(cursor) cur;
+		struct pT_(ref) first;
+		first.bough = trie->trunk, first.lf = 0, pT_(lower_entry)(&first);
+		patterns = 0;
+		for(cur = pT_(to_end)(trie, first); T_(exists)(&cur); T_(next)(&cur)) {
+			const char *const key = pT_(ref_to_string)(&cur.start);
+			size_t common;
+			if(!*key) continue;
+			for(common = 0; key[common] == previous[common]; common++);
+			for(d = common + 1; key[d - 1] != '\0'; d++) {
+				struct pT_(state) *const fresh = dfs + a->states;
+				fresh->fail = path[d - 1]; /* The parent, for now. */
+				fresh->depth = (unsigned)d, fresh->pattern = 0;
+				fresh->label = (unsigned char)key[d - 1];
+				path[d] = a->states++;
+			}
+			dfs[path[d - 1]].pattern = (unsigned)++patterns;
+			a->pattern[patterns - 1] = previous = key;
+		}
+	}
+	/* A stable sort by depth is breadth-first with siblings together. */
+	for(d = 0; d <= longest + 1; d++) path[d] = 0;
+	for(i = 0; i < a->states; i++) path[dfs[i].depth + 1]++;
+	for(d = 1; d <= longest + 1; d++) path[d] += path[d - 1];
+	for(i = 0; i < a->states; i++) map[i] = path[dfs[i].depth]++;
+	if(!(a->state = state = malloc(sizeof *state * a->states))) goto catch;
+	for(i = 0; i < a->states; i++) {
+		struct pT_(state) *const to = state + map[i];
+		*to = dfs[i], to->fail = map[to->fail];
+		to->output = 0, to->child = 0, to->children = 0;
+	}
+	free(dfs), dfs = 0, free(map), map = 0, free(path), path = 0;
+	for(i = 1; i < a->states; i++) {
+		struct pT_(state) *const parent = state + state[i].fail;
+		if(!parent->children++) parent->child = i;
+	}
+	/* Failure links are breadth-first; the parent is in `fail` until then. */
+	for(i = 1; i < a->states; i++) {
+		unsigned f = state[state[i].fail].fail, child = 0;
+		if(state[i].depth > 1) for( ; ; f = state[f].fail)
+			if((child = pT_(automaton_child)(a, f, state[i].label)) || !f)
+				break;
+		f = state[i].fail = child;
+		state[i].output = state[f].pattern ? f : state[f].output;
+	}
+	/* The states closest to the root have every transition. Breadth-first,
+	 the failure of a state is before it, so its row is already filled. */
+	a->dense = a->states < TRIE_DENSE ? a->states : TRIE_DENSE;
+	if(!(a->delta = malloc(sizeof *a->delta * (UCHAR_MAX + 1) * a->dense)))
+		goto catch;
+	for(s = 0; s < a->dense; s++) for(i = 0; i <= UCHAR_MAX; i++) {
+		const unsigned child = pT_(automaton_child)(a, s, (unsigned char)i);
+		a->delta[s * (UCHAR_MAX + 1) + i] = child || !s ? child
+			: a->delta[state[s].fail * (UCHAR_MAX + 1) + i];
+	}
+	return 1;
+catch:
+	if(!errno) errno = ERANGE;
+	free(dfs), free(map), free(path);
+	T_(automaton_)(a);
+	return 0;
+}
+
+/** Only with `TRIE_AUTOMATON`. @return A scan of text with `a` from the
+ start. @allow */
+static struct T_(scan) T_(scan)(const struct T_(automaton) *const a) {
+	struct T_(scan) scan;
+	scan.automaton = a, scan.state = 0, scan.offset = 0;
+	return scan;
+}
+
+/** Only with `TRIE_AUTOMATON`. Continues `scan` with the next `size` bytes of
+ `text`; the patterns may straddle the pieces. For every pattern that ends in
+ `text`, `found` (if non-null) is called with it, the offset of its start from
+ the start of the scan, and `param`.
+ @return The number of patterns found in `text`.
+ @order \O(|`text`| + |`found`|) @allow */
+static size_t T_(scan_next)(struct T_(scan) *const scan,
+	const char *const text, const size_t size, const pT_(scan_fn) found,
+	void *const param) {
+	const struct T_(automaton) *a;
+	const struct pT_(state) *state;
+	unsigned s, t;
+	size_t i, count = 0;
+	if(!scan || !(a = scan->automaton) || !a->states) return 0;
+	assert(text || !size);
+	state = a->state, s = scan->state;
+	for(i = 0; i < size; i++) {
+		const unsigned char byte = (unsigned char)text[i];
+		for( ; ; s = state[s].fail) {
+			if(s < a->dense) { s = a->delta[s * (UCHAR_MAX + 1) + byte]; break; }
+			if((t = pT_(automaton_child)(a, s, byte))) { s = t; break; }
+		}
+		for(t = state[s].pattern ? s : state[s].output; t; t = state[t].output) {
+			count++;
+			if(found) found(a->pattern[state[t].pattern - 1],
+				scan->offset + i + 1 - state[t].depth, param);
+		}
+	}
+	scan->state = s, scan->offset += size;
+	return count;
+}
+#		endif /* automaton --> */
 
 #		define BOX_PRIVATE_AGAIN
 #		include "box.h"
@@ -907,12 +3702,74 @@ static void pT_(unused_base)(void) {
 #		else
 	T_(match)(0, 0, 0); T_(get)(0, 0, 0);
 #		endif
-#		ifdef TRIE_ENTRY
+#		ifdef TRIE_KEY_BYTES
+	{ pT_(key) k; memset(&k, 0, sizeof k);
+#			ifdef TRIE_ENTRY
+	T_(add)(0, k, 0);
+#				ifdef TRIE_CONCURRENT
+	T_(concurrent_add)(0, k, 0);
+#				endif
+#			else
+	T_(add)(0, k);
+#				ifdef TRIE_CONCURRENT
+	T_(concurrent_add)(0, k);
+#				endif
+#			endif
+	}
+#		elif defined TRIE_ENTRY
 	T_(add)(0, 0, 0);
+#			ifdef TRIE_CONCURRENT
+	T_(concurrent_add)(0, 0, 0);
+#			endif
 #		else
 	T_(add)(0, 0);
+#			ifdef TRIE_CONCURRENT
+	T_(concurrent_add)(0, 0);
+#			endif
+#		endif
+#		ifndef TRIE_KEY_BYTES
+	T_(prefix)(0, 0); T_(prefixes)(0, 0); T_(prefixes_exists)(0);
+	T_(prefixes_entry)(0); T_(prefixes_next)(0); T_(fuzzy)(0, 0, 0, 0, 0);
+#			if defined(TREE_ENTRY) || !defined(TRIE_KEY)
+	T_(longest)(0, 0);
+#			else
+	T_(longest)(0, 0, 0);
+#			endif
+#		endif
+	T_(remove)(0, 0); T_(entry)(0); T_(from_array)(0, 0, 0);
+	T_(partition)(0, 0, 0); T_(join)(0, 0, 0);
+#		ifdef TRIE_PARALLEL
+	T_(parallel_from_array)(0, 0, 0, 0);
+#		endif
+#		ifdef TRIE_CONCURRENT
+	T_(concurrent)(0); T_(concurrent_)(0); T_(concurrent_remove)(0, 0);
+	T_(publish)(0); T_(acquire)(0); T_(release)(0, 0);
+#		endif
+	T_(lower)(0, 0); T_(upper)(0, 0); T_(range)(0, 0, 0);
+#		ifdef TRIE_IMAGE
+	T_(image_save)(0, 0); T_(image)(0, 0, 0); T_(image_get)(0, 0);
+	T_(image_begin)(0); T_(image_exists)(0); T_(image_key)(0);
+	T_(image_next)(0);
+#			ifndef TRIE_KEY_BYTES
+	T_(image_prefix)(0, 0);
+#			endif
+#		endif
+#		ifdef TRIE_SCORE
+	T_(invalidate)(0, 0);
+#			ifndef TRIE_KEY_BYTES
+	T_(top)(0, 0, 0, 0);
+#			endif
+#		endif
+#		ifdef TRIE_AUTOMATON
+	T_(automaton)(0, 0); T_(automaton_)(0); T_(scan)(0);
+	T_(scan_next)(0, 0, 0, 0, 0);
+#		endif
+#		ifdef TRIE_COUNT
+	T_(count)(0); T_(rank)(0, 0); T_(select)(0, 0);
+#			ifndef TRIE_KEY_BYTES
+	T_(prefix_count)(0, 0);
+#			endif
 #		endif
-	T_(remove)(0, 0); T_(entry)(0); T_(prefix)(0, 0);
 	pT_(unused_base_coda)();
 }
 static void pT_(unused_base_coda)(void) { pT_(unused_base)(); }
@@ -1006,6 +3863,30 @@ encode:
 #	ifdef TRIE_KEY
 #		undef TRIE_KEY
 #	endif
+#	ifdef TRIE_KEY_BYTES
+#		undef TRIE_KEY_BYTES
+#	endif
+#	ifdef TRIE_COUNT
+#		undef TRIE_COUNT
+#	endif
+#	ifdef TRIE_SCORE
+#		undef TRIE_SCORE
+#	endif
+#	ifdef TRIE_IMAGE
+#		undef TRIE_IMAGE
+#	endif
+#	ifdef TRIE_OWN
+#		undef TRIE_OWN
+#	endif
+#	ifdef TRIE_AUTOMATON
+#		undef TRIE_AUTOMATON
+#	endif
+#	ifdef TRIE_PARALLEL
+#		undef TRIE_PARALLEL
+#	endif
+#	ifdef TRIE_CONCURRENT
+#		undef TRIE_CONCURRENT
+#	endif
 #	ifdef TRIE_HAS_TO_STRING
 #		undef TRIE_HAS_TO_STRING
 #	endif
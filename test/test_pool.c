@@ -1,5 +1,6 @@
 /** Unit test. */
 
+#define _DEFAULT_SOURCE /* `mmap`, `madvise`, `mincore`. */
 #include "../src/orcish.h"
 #include <stdlib.h> /* EXIT_ malloc free rand */
 #include <stdio.h>  /* fprintf */
@@ -26,6 +27,7 @@ static void colour_filler(enum colour *const c)
 	{ *c = (unsigned)rand() / (RAND_MAX / colour_size + 1); }
 #define POOL_NAME colour
 #define POOL_TYPE enum colour
+#define POOL_BITMAP /* Iterate over all. */
 #define POOL_TO_STRING
 #define POOL_TEST
 #include "../src/pool.h"
@@ -38,6 +40,7 @@ static void str4_filler(struct str4 *const s)
 	{ orcish(s->value, sizeof s->value); }
 #define POOL_NAME str4
 #define POOL_TYPE struct str4
+#define POOL_MMAP /* Slabs in pages. */
 #define POOL_TEST
 #define POOL_TO_STRING
 #include "../src/pool.h"
@@ -51,6 +54,7 @@ static void int_filler(int *const i)
 	{ return (*a > *b) - (*b > *a); }*/
 #define POOL_NAME int
 #define POOL_TYPE int
+#define POOL_MAGAZINE /* Shared between threads. */
 #define POOL_TEST
 #define POOL_TO_STRING
 #include "../src/pool.h"
@@ -64,6 +68,7 @@ static void keyval_to_string(const struct keyval *const kv,
 	char (*const a)[12]) { sprintf(*a, "%d_%.7s", kv->key, kv->value); }
 #define POOL_NAME keyval
 #define POOL_TYPE struct keyval
+#define POOL_FREE_LIST /* Removed items are reused in any order. */
 #define POOL_TEST
 #define POOL_TO_STRING
 #include "../src/pool.h"
@@ -77,6 +82,204 @@ static void header_filler(enum colour *const c) { colour_filler(c); }
 #include "header_pool.h"
 
 
+/* Small aligned slabs, so there are many of them. */
+#define POOL_NAME slab
+#define POOL_TYPE struct keyval
+#define POOL_ALIGNED 256
+#include "../src/pool.h"
+
+static void aligned_test(void) {
+	struct slab_pool pool = slab_pool();
+	struct keyval *item[2000];
+	size_t i, j, size = 0, most = 0;
+	int success;
+	printf("Aligned slabs:\n");
+	/* It only reserves a slab at a time. */
+	success = slab_pool_buffer(&pool, 256), assert(!success && errno == ERANGE);
+	errno = 0;
+	success = slab_pool_buffer(&pool, 2), assert(success);
+	/* Grow and shrink at random, each with a number to check. */
+	for(i = 0; i < 100000; i++) {
+		const int is_new = size < sizeof item / sizeof *item
+			&& (!size || (unsigned)rand() % 1000 < 1000 - 400 * (i / 50000));
+		if(is_new) {
+			item[size] = slab_pool_new(&pool), assert(item[size]);
+			item[size]->key = (int)i, size++;
+		} else {
+			struct keyval **const x = item + (unsigned)rand() % size;
+			success = slab_pool_remove(&pool, *x), assert(success);
+			*x = item[--size];
+		}
+		if(pool.slots.size > most) most = pool.slots.size;
+		if(i % 1000) continue;
+		for(j = 0; j < pool.slots.size; j++) assert(pool.slots.data[j].slab
+			&& (j == 0 || pool.slots.data[j].size));
+		for(j = 0; j < size; j++) assert(item[j]->key >= 0 && item[j]->key
+			<= (int)i);
+	}
+	printf("At most %lu slabs.\n", (unsigned long)most);
+	assert(most > 20);
+	while(size) success = slab_pool_remove(&pool, item[--size]),
+		assert(success);
+	/* Slab-zero is cut out of a block with the spares. */
+	assert(pool.slots.size == 1 && !pool.slots.data[0].size && pool.spare);
+	slab_pool_(&pool);
+	assert(!pool.spare);
+}
+
+/* Slabs in pages, so their pages can be given back. */
+#define POOL_NAME paged
+#define POOL_TYPE struct keyval
+#define POOL_MMAP
+#include "../src/pool.h"
+
+static void mmap_test(void) {
+	struct paged_pool pool = paged_pool();
+	struct keyval **item = 0;
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE), items = 100000,
+		stride = 4 * page / sizeof **item;
+	unsigned char *core = 0;
+	size_t i, j, size = 0, live = 0, resident = 0, total = 0;
+	int success;
+	printf("Mapped slabs:\n");
+	item = malloc(sizeof *item * items), assert(item);
+	for(i = 0; i < items; i++) item[i] = paged_pool_new(&pool),
+		assert(item[i]), item[i]->key = (int)i;
+	assert(pool.slots.size > 2);
+	/* Keep every `stride`, so most pages are empty. */
+	for(i = 0; i < items; i++) if(i % stride)
+		success = paged_pool_remove(&pool, item[i]), assert(success);
+	else item[size++] = item[i];
+	for(i = 0; i < size; i++) assert(item[i]->key == (int)(i * stride));
+	/* The secondary slabs only count pages with live items on them. */
+	for(j = 1; j < pool.slots.size; j++) {
+		const struct private_paged_pool_slot *const slot = pool.slots.data + j;
+		const size_t pages = (slot->capacity * sizeof *slot->slab + page - 1)
+			/ page;
+		assert(slot->page && slot->size);
+		core = realloc(core, pages), assert(core);
+		success = !mincore(slot->slab, pages * page, core), assert(success);
+		for(i = 0; i < pages; i++) {
+			if(slot->page[i]) live++;
+			if(core[i] & 1) assert(slot->page[i]), resident++;
+		}
+		total += pages;
+	}
+	printf("%lu of %lu pages live, %lu resident.\n", (unsigned long)live,
+		(unsigned long)total, (unsigned long)resident);
+	assert(live <= total / 2 && resident <= live);
+	while(size) success = paged_pool_remove(&pool, item[--size]),
+		assert(success);
+	/* Slab-zero keeps a few pages past the end. */
+	assert(pool.slots.size == 1 && !pool.slots.data[0].size
+		&& pool.resident0 < 16 * page);
+	free(core), free(item);
+	paged_pool_(&pool);
+}
+
+/* Each magazine takes a refill, uses some, and drains the rest back as holes in
+ slab-zero; the next refill can need a new slab while they are there. */
+static void magazine_hole_test(void) {
+	struct int_pool_depot depot;
+	struct int_pool_magazine m;
+	int *item[1000];
+	size_t size = 0, i, k;
+	int success;
+	success = int_pool_depot(&depot), assert(success);
+	for(k = 0; size < sizeof item / sizeof *item; k++) {
+		m = int_pool_magazine(&depot);
+		for(i = 0; i < k % 31 + 1 && size < sizeof item / sizeof *item; i++)
+			item[size] = int_pool_magazine_new(&m), assert(item[size]),
+			*item[size] = (int)size, size++;
+		int_pool_magazine_(&m);
+	}
+	/* None were given out twice. */
+	for(i = 0; i < size; i++) assert(*item[i] == (int)i);
+	m = int_pool_magazine(&depot);
+	for(i = 0; i < size; i++)
+		success = int_pool_magazine_remove(&m, item[i]), assert(success);
+	int_pool_magazine_(&m);
+	assert(!depot.pool.slots.size
+		|| depot.pool.slots.size == 1 && !depot.pool.slots.data[0].size);
+	int_pool_depot_(&depot);
+}
+
+/* Each thread allocates in its magazine, then removes the other's. */
+#define MAGAZINE_THREADS 2
+#define MAGAZINE_ITEMS 10000
+struct magazine_work {
+	struct int_pool_magazine magazine;
+	int *item[MAGAZINE_ITEMS];
+	unsigned id;
+	int is_remove, error;
+	pthread_t thread;
+};
+static struct magazine_work magazine_work[MAGAZINE_THREADS];
+/** Allocates or removes in the `param` work. Thread entry point. */
+static void *magazine_work_thread(void *const param) {
+	struct magazine_work *const w = param;
+	const struct magazine_work *const other
+		= magazine_work + (w->id + 1) % MAGAZINE_THREADS;
+	size_t i;
+	for(i = 0; i < MAGAZINE_ITEMS; i++) {
+		if(w->is_remove) {
+			/* Cross-thread: it was allocated in the other magazine. */
+			assert(*other->item[i] == (int)(other->id * MAGAZINE_ITEMS + i));
+			if(!int_pool_magazine_remove(&w->magazine, other->item[i]))
+				{ w->error = 1; break; }
+		} else {
+			if(!(w->item[i] = int_pool_magazine_new(&w->magazine)))
+				{ w->error = 1; break; }
+			*w->item[i] = (int)(w->id * MAGAZINE_ITEMS + i);
+			/* Churn some through the magazine. */
+			if(i % 3 == 0) {
+				if(!int_pool_magazine_remove(&w->magazine, w->item[i])
+					|| !(w->item[i] = int_pool_magazine_new(&w->magazine)))
+					{ w->error = 1; break; }
+				*w->item[i] = (int)(w->id * MAGAZINE_ITEMS + i);
+			}
+		}
+	}
+	return 0;
+}
+
+static void magazine_test(void) {
+	struct int_pool_depot depot;
+	unsigned t;
+	int is_remove, success;
+	printf("Magazines:\n");
+	success = int_pool_depot(&depot), assert(success);
+	for(t = 0; t < MAGAZINE_THREADS; t++) magazine_work[t].id = t,
+		magazine_work[t].error = 0,
+		magazine_work[t].magazine = int_pool_magazine(&depot);
+	for(is_remove = 0; is_remove <= 1; is_remove++) {
+		for(t = 0; t < MAGAZINE_THREADS; t++) {
+			magazine_work[t].is_remove = is_remove;
+			if(pthread_create(&magazine_work[t].thread, 0,
+				&magazine_work_thread, magazine_work + t))
+				magazine_work_thread(magazine_work + t),
+				magazine_work[t].thread = pthread_self();
+		}
+		for(t = 0; t < MAGAZINE_THREADS; t++) {
+			if(!pthread_equal(magazine_work[t].thread, pthread_self()))
+				pthread_join(magazine_work[t].thread, 0);
+			assert(!magazine_work[t].error);
+		}
+		/* No two threads got the same one. */
+		if(!is_remove) for(t = 0; t < MAGAZINE_THREADS; t++) {
+			size_t i;
+			for(i = 0; i < MAGAZINE_ITEMS; i++) assert(*magazine_work[t].item[i]
+				== (int)(t * MAGAZINE_ITEMS + i));
+		}
+	}
+	/* Giving everything back leaves the pool empty. */
+	for(t = 0; t < MAGAZINE_THREADS; t++)
+		int_pool_magazine_(&magazine_work[t].magazine);
+	assert(!depot.pool.slots.size
+		|| depot.pool.slots.size == 1 && !depot.pool.slots.data[0].size);
+	int_pool_depot_(&depot);
+}
+
 /** For paper. */
 static void special(void) {
 	struct colour_pool pool = colour_pool();
@@ -111,6 +314,10 @@ int main(void) {
 	colour_pool_test();
 	str4_pool_test();
 	int_pool_test();
+	magazine_test();
+	magazine_hole_test();
+	aligned_test();
+	mmap_test();
 	keyval_pool_test();
 	header_pool_test();
 	special();
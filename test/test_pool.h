@@ -37,6 +37,35 @@ static void pT_(valid_state)(const struct t_(pool) *const pool) {
 		for(i = 0; i < pool->free0.as_array.size; i++)
 			assert(pool->free0.as_array.data[i] < pool->slots.data[0].size);
 	}
+#	ifdef POOL_FREE_LIST
+	{ /* So is the free-list, and it's the right length. */
+		size_t f;
+		assert(!pool->free0.as_array.size);
+		for(i = 0, f = pool->free_head; f; f = pT_(free_next)(pool, f - 1), i++)
+			assert(f - 1 < pool->slots.data[0].size);
+		assert(i == pool->free_size);
+	}
+#	endif
+#	ifdef POOL_BITMAP
+	{ /* The bitmaps have the live items, and the cursor goes over them all. */
+		struct T_(cursor) cur;
+		size_t j, live = 0, bits, seen = 0;
+		for(i = 0; i < pool->slots.size; i++) {
+			const struct pT_(slot) *const slot = pool->slots.data + i;
+			assert(slot->bmp && (i || slot->capacity == pool->capacity0));
+			for(bits = j = 0; j < slot->capacity; j++)
+				if(POOL_AT(slot->bmp, j)) assert(i || j < slot->size), bits++;
+			assert(bits == (i ? slot->size
+				: slot->size - pT_(free0_size)(pool)));
+			live += bits;
+		}
+		for(cur = T_(begin)(pool); T_(exists)(&cur); T_(next)(&cur)) {
+			assert(POOL_AT(cur.slot->bmp, cur.i));
+			seen++;
+		}
+		assert(seen == live);
+	}
+#	endif
 }
 
 static void pT_(test_states)(void) {
@@ -137,14 +166,14 @@ static void pT_(test_states)(void) {
 	}
 	T_(graph_fn)(&pool, "graph/pool/" QUOTE(POOL_NAME) "-10-remove.gv");
 	assert(pool.slots.size == 1 && pool.slots.data[0].size == size[2]
-		&& pool.capacity0 == size[2] && pool.free0.as_array.size == i);
+		&& pool.capacity0 == size[2] && pT_(free0_size)(&pool) == i);
 
 	/* Add at random to an already removed. */
 	while(i) t = T_(new)(&pool), assert(t),
 		t_(filler)(t), pT_(valid_state)(&pool), i--;
 	T_(graph_fn)(&pool, "graph/pool/" QUOTE(POOL_NAME) "-11-replace.gv");
 	assert(pool.slots.size == 1 && pool.slots.data[0].size == size[2]
-		&& pool.capacity0 == size[2] && pool.free0.as_array.size == 0);
+		&& pool.capacity0 == size[2] && !pT_(free0_size)(&pool));
 
 	printf("Destructor:\n");
 	t_(pool_)(&pool);
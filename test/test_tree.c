@@ -85,6 +85,7 @@ static void order3_to_string(const unsigned x, char (*const z)[12])
 #define TREE_KEY unsigned
 #define TREE_TEST
 #define TREE_ORDER 3
+#define TREE_IMAGE
 #define TREE_TO_STRING
 #include "../src/tree.h"
 
@@ -573,6 +574,7 @@ static void pair_to_string(const unsigned k, const unsigned *const v,
 #define TREE_NAME pair
 #define TREE_KEY unsigned
 #define TREE_VALUE unsigned
+#define TREE_IMAGE
 #define TREE_TEST
 #define TREE_TO_STRING
 #include "../src/tree.h"
@@ -774,6 +776,176 @@ static void typical_to_string(const unsigned k,
 #include "../src/tree.h"
 
 
+/* Strings with a short inline prefix: a lot of ties are resolved by `less`. */
+static char name_storage[2048][12];
+static size_t name_next;
+static int name_less(const char *const a, const char *const b)
+	{ return strcmp(a, b) > 0; }
+static unsigned short name_prefix(const char *const a) {
+	const unsigned char *const u = (const unsigned char *)a;
+	return (unsigned short)(u[0] ? u[0] << 8 | u[1] : 0);
+}
+static void name_filler(const char **const x) {
+	char *const name = name_storage[name_next++ % (sizeof name_storage
+		/ sizeof *name_storage)];
+	orcish(name, sizeof *name_storage);
+	*x = name;
+}
+static void name_to_string(const char *const x, char (*const z)[12])
+	{ sprintf(*z, "%.11s", x); }
+#define TREE_NAME name
+#define TREE_KEY const char *
+#define TREE_PREFIX unsigned short
+#define TREE_ORDER 4
+#define TREE_TO_STRING
+#define TREE_TEST
+#include "../src/tree.h"
+
+
+/* Cloned and freed by multiple threads. */
+static int parallel_less(const unsigned a, const unsigned b) { return a > b; }
+static void parallel_filler(unsigned *x) { int_filler(x); }
+static void parallel_to_string(const unsigned x, char (*const z)[12])
+	{ int_to_string(x, z); }
+#define TREE_NAME parallel
+#define TREE_KEY unsigned
+#define TREE_ORDER 3
+#define TREE_PARALLEL
+#define TREE_TO_STRING
+#define TREE_TEST
+#include "../src/tree.h"
+
+
+/* Reservations are intervals of time with a weight, augmented by the maximum
+ end and the sum of the weights. */
+struct interval { unsigned start, end; };
+struct reservation_summary { unsigned end; unsigned long weight; };
+static int reservation_less(const struct interval a, const struct interval b)
+	{ return a.start > b.start || a.start == b.start && a.end > b.end; }
+static void reservation_identity(struct reservation_summary *const s)
+	{ s->end = 0, s->weight = 0; }
+static void reservation_augment(struct reservation_summary *const s,
+	const struct interval k, const unsigned *const v)
+	{ if(k.end > s->end) s->end = k.end; s->weight += *v; }
+static void reservation_merge(struct reservation_summary *const s,
+	const struct reservation_summary *const t)
+	{ if(t->end > s->end) s->end = t->end; s->weight += t->weight; }
+static void reservation_filler(struct interval *const k, unsigned *const v) {
+	k->start = (unsigned)rand() / (RAND_MAX / 1000 + 1);
+	k->end = k->start + (unsigned)rand() / (RAND_MAX / 50 + 1);
+	*v = (unsigned)rand() / (RAND_MAX / 100 + 1);
+}
+static void reservation_to_string(const struct interval k,
+	const unsigned *const v, char (*const z)[12])
+	{ sprintf(*z, "%u-%u", k.start % 10000, k.end % 10000); (void)v; }
+#define TREE_NAME reservation
+#define TREE_KEY struct interval
+#define TREE_VALUE unsigned
+#define TREE_AUGMENT struct reservation_summary
+#define TREE_ORDER 5
+#define TREE_TO_STRING
+#define TREE_TEST
+#include "../src/tree.h"
+
+/** Whether the maximum end is at least the start in `param`. */
+static int reservation_keep(const struct reservation_summary *const s,
+	void *const param)
+	{ return s->end >= ((const struct interval *)param)->start; }
+/** Checks that the entries are delivered in order. */
+static void reservation_visit(const struct reservation_tree_cursor *const cur,
+	void *const param) {
+	const struct interval *const q = param, k = reservation_tree_key(cur);
+	assert(k.start <= q->end && k.end >= q->start);
+}
+
+/** This tests the augmented queries against a linear scan. */
+static void reservation(void) {
+	struct reservation_tree tree = reservation_tree(),
+		copy = reservation_tree();
+	struct { struct interval k; unsigned v; int in; } rnd[500];
+	const size_t rnd_size = sizeof rnd / sizeof *rnd;
+	size_t i, j, n = 0;
+	unsigned *v;
+	for(i = 0; i < rnd_size; i++)
+		reservation_filler(&rnd[i].k, &rnd[i].v), rnd[i].in = 0;
+	for(j = 0; j < 4 * rnd_size; j++) {
+		const struct reservation_summary *whole;
+		struct interval q, lo, hi;
+		struct reservation_summary range;
+		unsigned long weight;
+		unsigned end;
+		size_t found, count;
+		i = (unsigned)rand() / (RAND_MAX / rnd_size + 1);
+		if(rand() & 1) { /* Toggle. */
+			if(rnd[i].in) {
+				const int ret = reservation_tree_remove(&tree, rnd[i].k);
+				assert(ret);
+				rnd[i].in = 0, n--;
+			} else {
+				switch(reservation_tree_assign(&tree, rnd[i].k, &v)) {
+				case TREE_ERROR: goto catch;
+				case TREE_PRESENT: break; /* Duplicate. */
+				case TREE_ABSENT: *v = rnd[i].v, rnd[i].in = 1, n++; break;
+				}
+			}
+		} else if(rnd[i].in) { /* Modify the value in place. */
+			struct reservation_tree_cursor cur
+				= reservation_tree_more(&tree, rnd[i].k);
+			assert(reservation_tree_exists(&cur));
+			v = reservation_tree_value(&cur);
+			*v = rnd[i].v = (rnd[i].v + 7) % 100;
+			reservation_tree_invalidate(&tree, rnd[i].k);
+		}
+		if(j == rnd_size) { /* Bulk-load a copy. */
+			struct reservation_tree_cursor cur;
+			for(cur = reservation_tree_begin(&tree);
+				reservation_tree_exists(&cur); reservation_tree_next(&cur)) {
+				if(!reservation_tree_bulk_assign(&copy,
+					reservation_tree_key(&cur), &v)) goto catch;
+				*v = *reservation_tree_value(&cur);
+			}
+			if(!reservation_tree_bulk_finish(&copy)) goto catch;
+			reservation_tree_(&tree);
+			tree = copy, copy = reservation_tree();
+		} else if(j == 2 * rnd_size) { /* Clone a copy. */
+			if(!reservation_tree_clone(&copy, &tree)) goto catch;
+			reservation_tree_(&tree);
+			tree = copy, copy = reservation_tree();
+		}
+		/* Whole. */
+		for(end = 0, weight = 0, i = 0; i < rnd_size; i++) if(rnd[i].in)
+			{ if(rnd[i].k.end > end) end = rnd[i].k.end; weight += rnd[i].v; }
+		whole = reservation_tree_summary(&tree);
+		assert(n ? whole && whole->end == end && whole->weight == weight
+			: !whole);
+		/* Range of starts in `[q.start, q.end]`. */
+		q.start = (unsigned)rand() / (RAND_MAX / 1000 + 1);
+		q.end = q.start + (unsigned)rand() / (RAND_MAX / 200 + 1);
+		lo.start = q.start, lo.end = 0, hi.start = q.end, hi.end = UINT_MAX;
+		for(end = 0, weight = 0, i = 0; i < rnd_size; i++)
+			if(rnd[i].in && q.start <= rnd[i].k.start && rnd[i].k.start <= q.end)
+			{ if(rnd[i].k.end > end) end = rnd[i].k.end; weight += rnd[i].v; }
+		reservation_tree_summarize(&tree, lo, hi, &range);
+		assert(range.end == end && range.weight == weight);
+		/* Overlap with `q`. */
+		for(count = 0, i = 0; i < rnd_size; i++) if(rnd[i].in
+			&& rnd[i].k.start <= q.end && rnd[i].k.end >= q.start) count++;
+		found = reservation_tree_overlap(&tree, hi,
+			&reservation_keep, &reservation_visit, &q);
+		assert(found == count);
+		private_reservation_tree_valid(&tree);
+	}
+	printf("Reservations: %lu.\n", (unsigned long)n);
+	goto finally;
+catch:
+	perror("reservation");
+	assert(0);
+finally:
+	reservation_tree_(&tree);
+	reservation_tree_(&copy);
+}
+
+
 /* Test inclusion in a header. */
 static int header_less(const char a, const char b) { return a > b; }
 static void header_to_string(const char x, char (*const z)[12])
@@ -800,6 +972,10 @@ int main(void) {
 	loop_tree_test();
 	loop();
 	typical_tree_test();
+	name_tree_test();
+	parallel_tree_test();
+	reservation();
+	reservation_tree_test();
 	header_tree_test();
 	return EXIT_SUCCESS;
 }
@@ -31,12 +31,50 @@ typedef void (*pT_(action_fn))(pT_(key) *, pT_(value) *);
 typedef void (*pT_(action_fn))(pT_(key) *);
 #	endif
 
+#	ifdef TREE_PREFIX
+/** Makes sure the cached prefixes of `sub` agree with the keys. */
+static void pT_(valid_prefix_r)(const struct pT_(subtree) sub) {
+	unsigned i;
+	for(i = 0; i < sub.bough->size; i++)
+		assert(sub.bough->prefix[i] == t_(prefix)(sub.bough->key[i]));
+	if(sub.height > 1) {
+		struct pT_(subtree) child;
+		child.height = sub.height - 1;
+		for(i = 0; i <= sub.bough->size; i++)
+			child.bough = pT_(as_branch_c)(sub.bough)->child[i],
+			pT_(valid_prefix_r)(child);
+	}
+}
+#	endif
+
+#	ifdef TREE_AUGMENT
+/** Makes sure that every bough below one with an up-to-date summary in `sub`
+ is also up-to-date. */
+static void pT_(valid_augment_r)(const struct pT_(subtree) sub) {
+	unsigned i;
+	struct pT_(subtree) child;
+	if(sub.height <= 1) return;
+	child.height = sub.height - 1;
+	for(i = 0; i <= sub.bough->size; i++) {
+		child.bough = pT_(as_branch_c)(sub.bough)->child[i];
+		assert(sub.bough->stale || !child.bough->stale);
+		pT_(valid_augment_r)(child);
+	}
+}
+#	endif
+
 /** Makes sure the `tree` is in a valid state. */
 static void pT_(valid)(const struct t_(tree) *const tree) {
 	if(!tree) return; /* Null. */
 	if(!tree->trunk.bough)
 		{ assert(!tree->trunk.height); return; } /* Idle. */
 	if(!tree->trunk.height) { return; } /* Empty. */
+#	ifdef TREE_PREFIX
+	pT_(valid_prefix_r)(tree->trunk);
+#	endif
+#	ifdef TREE_AUGMENT
+	pT_(valid_augment_r)(tree->trunk);
+#	endif
 	/*...*/
 }
 
@@ -157,6 +195,10 @@ static void pT_(test)(void) {
 	printf("Finalize again. This should be idempotent.\n");
 	T_(bulk_finish)(&tree);
 	T_(graph_fn)(&tree, "graph/tree/" QUOTE(TREE_NAME) "-bulk-finish.gv");
+	pT_(valid)(&tree);
+#	ifdef TREE_AUGMENT
+	T_(summary)(&tree), assert(!tree.trunk.bough->stale), pT_(valid)(&tree);
+#	endif
 	printf("Tree: %s.\n", T_(to_string)(&tree));
 
 	/* Iteration; checksum. */
@@ -272,6 +314,163 @@ static void pT_(test)(void) {
 	}
 	printf("Number of entries in the tree: %lu/%lu.\n",
 		(unsigned long)n_unique, (unsigned long)test_size);
+	pT_(valid)(&tree);
+#	ifdef TREE_AUGMENT
+	T_(summary)(&tree), assert(!tree.trunk.bough->stale), pT_(valid)(&tree);
+#	endif
+	{ /* Merges against look-ups; half of the keys are shared. */
+		struct t_(tree) other = t_(tree)(), result = t_(tree)();
+		struct T_(cursor) c, c1;
+		size_t n_a = T_(count)(&tree), n_b, n_ab = 0, n;
+		unsigned op;
+		int success = 0;
+		for(i = 0; i < test_size; i++) {
+			pT_(key) x;
+#	ifdef TREE_VALUE
+			pT_(value) y;
+			t_(filler)(&x, &y);
+			if(!(i & 1)) x = test[i].key;
+			if(!T_(assign)(&other, x, &v)) assert(0);
+			*v = y;
+#	else
+			t_(filler)(&x);
+			if(!(i & 1)) x = test[i].key;
+			if(!T_(add)(&other, x)) assert(0);
+#	endif
+		}
+		n_b = T_(count)(&other);
+		for(c = T_(begin)(&tree); T_(exists)(&c); T_(next)(&c))
+			if(T_(contains)(&other, T_(key)(&c))) n_ab++;
+#	ifdef TREE_PARALLEL
+		for(op = 0; op < 6; op++) {
+#	else
+		for(op = 0; op < 3; op++) {
+#	endif
+			switch(op) {
+			case 0: success = T_(union)(&result, &tree, &other); break;
+			case 1: success = T_(intersection)(&result, &tree, &other); break;
+			case 2: success = T_(difference)(&result, &tree, &other); break;
+#	ifdef TREE_PARALLEL
+			case 3: success = T_(parallel_union)(&result, &tree, &other, 3);
+				break;
+			case 4: success
+				= T_(parallel_intersection)(&result, &tree, &other, 3); break;
+			case 5: success
+				= T_(parallel_difference)(&result, &tree, &other, 3); break;
+#	endif
+			}
+			assert(success), pT_(valid)(&result);
+			for(n = 0, c = T_(begin)(&result); T_(exists)(&c); T_(next)(&c)) {
+				const pT_(key) x = T_(key)(&c);
+				const int in_a = T_(contains)(&tree, x),
+					in_b = T_(contains)(&other, x);
+				assert(op % 3 == 0 ? in_a || in_b
+					: op % 3 == 1 ? in_a && in_b : in_a && !in_b);
+#	ifdef TREE_VALUE
+				c1 = T_(more)(in_a ? &tree : &other, x);
+				assert(!memcmp(T_(value)(&c), T_(value)(&c1),
+					sizeof(pT_(value))));
+#	else
+				(void)c1;
+#	endif
+				n++;
+			}
+			assert(n == (op % 3 == 0 ? n_a + n_b - n_ab
+				: op % 3 == 1 ? n_ab : n_a - n_ab));
+		}
+		success = T_(difference)(&result, &tree, &tree), assert(success);
+		assert(!T_(count)(&result));
+		success = T_(union)(&result, 0, &tree), assert(success);
+		assert(T_(count)(&result) == n_a);
+		t_(tree_)(&result), t_(tree_)(&other);
+	}
+#	ifdef TREE_PARALLEL
+	{ /* Twice: into an idle tree, then over the copy. */
+		struct t_(tree) copy = t_(tree)();
+		struct T_(cursor) c0, c1;
+		int success;
+		success = T_(parallel_clone)(&copy, &tree, 3), assert(success);
+		success = T_(parallel_clone)(&copy, &tree, 4), assert(success);
+		pT_(valid)(&copy);
+		for(c0 = T_(begin)(&tree), c1 = T_(begin)(&copy); T_(exists)(&c0);
+			T_(next)(&c0), T_(next)(&c1)) {
+			assert(T_(exists)(&c1)
+				&& !t_(less)(T_(key)(&c0), T_(key)(&c1))
+				&& !t_(less)(T_(key)(&c1), T_(key)(&c0)));
+		}
+		assert(!T_(exists)(&c1));
+		assert(T_(count)(&copy) == n_unique);
+		T_(parallel_clear)(&copy, 3);
+		assert(copy.trunk.bough && !copy.trunk.height);
+		t_(tree_)(&copy);
+	}
+#	endif
+#	ifdef TREE_IMAGE
+	{ /* Round-trip through a file and read the pages in-place. */
+		struct T_(image) image;
+		struct T_(image_cursor) ic;
+		struct T_(cursor) c0, c1;
+		FILE *fp;
+		long size;
+		void *data;
+		int success;
+		fp = tmpfile(), assert(fp);
+		success = T_(image_save)(&tree, fp), assert(success);
+		size = ftell(fp), assert(size > 0), rewind(fp);
+		data = malloc((size_t)size), assert(data);
+		success = fread(data, 1, (size_t)size, fp) == (size_t)size;
+		assert(success), fclose(fp);
+		success = T_(image)(&image, data, (size_t)size - 1), assert(!success);
+		assert(errno == EILSEQ), errno = 0;
+		if(tree.trunk.height > 1) { /* A child out of the image. */
+			struct pT_(page) *const root = &((union pT_(image_page) *)data)
+				[(size_t)size / sizeof *image.page - 2].page;
+			const size_t child = root->child[0];
+			root->child[0] = (size_t)size;
+			success = T_(image)(&image, data, (size_t)size), assert(!success);
+			assert(errno == EILSEQ), errno = 0;
+			root->child[0] = child;
+		}
+		success = T_(image)(&image, data, (size_t)size), assert(success);
+		for(c0 = T_(begin)(&tree), ic = T_(image_begin)(&image);
+			T_(exists)(&c0); T_(next)(&c0), T_(image_next)(&ic)) {
+			assert(T_(image_exists)(&ic)
+				&& !t_(less)(T_(key)(&c0), T_(image_key)(&ic))
+				&& !t_(less)(T_(image_key)(&ic), T_(key)(&c0)));
+#		ifdef TREE_VALUE
+			assert(!memcmp(T_(value)(&c0), T_(image_value)(&ic),
+				sizeof(pT_(value))));
+#		endif
+		}
+		assert(!T_(image_exists)(&ic));
+		for(i = 0; i < test_size; i++) {
+			const pT_(key) x = test[i].key;
+			assert(T_(image_contains)(&image, x) == T_(contains)(&tree, x));
+			c0 = T_(less)(&tree, x), ic = T_(image_less)(&image, x);
+			assert(T_(exists)(&c0) == T_(image_exists)(&ic));
+			if(T_(exists)(&c0)) assert(!t_(less)(T_(key)(&c0),
+				T_(image_key)(&ic)) && !t_(less)(T_(image_key)(&ic),
+				T_(key)(&c0)));
+			c1 = T_(more)(&tree, x), ic = T_(image_more)(&image, x);
+			assert(T_(exists)(&c1) == T_(image_exists)(&ic));
+			if(T_(exists)(&c1)) assert(!t_(less)(T_(key)(&c1),
+				T_(image_key)(&ic)) && !t_(less)(T_(image_key)(&ic),
+				T_(key)(&c1)));
+		}
+		free(data);
+		/* An empty tree is only a trailer. */
+		fp = tmpfile(), assert(fp);
+		success = T_(image_save)(&empty, fp), assert(success);
+		size = ftell(fp), assert(size == sizeof *image.page), rewind(fp);
+		data = malloc((size_t)size), assert(data);
+		success = fread(data, 1, (size_t)size, fp) == (size_t)size;
+		assert(success), fclose(fp);
+		success = T_(image)(&image, data, (size_t)size), assert(success);
+		ic = T_(image_begin)(&image), assert(!T_(image_exists)(&ic));
+		assert(!T_(image_contains)(&image, test[0].key));
+		free(data);
+	}
+#	endif
 
 	/* Delete all. Removal invalidates iterator. */
 	for(cur = T_(begin)(&tree), i = 0; T_(exists)(&cur); ) {
@@ -350,6 +549,7 @@ static void pT_(test)(void) {
 	i = T_(count)(&tree);
 	printf("remove every 2nd: %lu\n", (unsigned long)i);
 	assert(i == n_unique);
+	pT_(valid)(&tree);
 
 	printf("clear, destroy\n");
 	T_(clear)(&tree);
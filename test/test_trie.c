@@ -33,6 +33,11 @@ static void str_filler(const char **const key) {
 }
 #define TRIE_NAME str
 #define TRIE_KEY_TO_STRING /* Uses the keys as strings. For test. */
+#define TRIE_COUNT /* Keeps the size of sub-tries. */
+#define TRIE_IMAGE /* Saves and reads an image. */
+#define TRIE_AUTOMATON /* Finds the keys in text. */
+#define TRIE_PARALLEL /* Builds between threads. */
+#define TRIE_CONCURRENT /* Readers between threads. */
 #define TRIE_TEST
 #include "../src/trie.h"
 
@@ -54,15 +59,13 @@ static void contrived_test(void) {
 	/* Info about offsets. */
 	printf("offset in <str>tree:\n"
 		" leaves: %lu\n"
-		" branch: %lu\n"
 		" bmp: %lu\n"
-		" leaf: %lu\n"
-		" whole struct: %lu\n",
+		" smallest bough: %lu\n"
+		" whole bough: %lu\n",
 		(unsigned long)offsetof(struct private_str_trie_bough, leaves),
-		(unsigned long)offsetof(struct private_str_trie_bough, branch),
 		(unsigned long)offsetof(struct private_str_trie_bough, bmp),
-		(unsigned long)offsetof(struct private_str_trie_bough, leaf),
-		(unsigned long)sizeof(struct private_str_trie_bough));
+		(unsigned long)private_str_trie_bough_size(2),
+		(unsigned long)private_str_trie_bough_size(TRIE_ORDER));
 	assert(CHAR_BIT == 8 && ' ' ^ '!' == 1); /* Assumed UTF-8 for tests. */
 	errno = 0;
 
@@ -78,6 +81,14 @@ static void contrived_test(void) {
 	success = str_trie_remove(&t, "aaaaaaa aaaaaaa aaaaaaa aaaaaaa!");
 	assert(!success && errno == EILSEQ), errno = 0;
 	str_trie_graph_all(&t, "graph/trie/contrived-max.gv", 0);
+	{ /* The same limit in bulk; on failure, it's unchanged. */
+		const char *too_long[] = { "aaaaaaa aaaaaaa aaaaaaa aaaaaaa ä",
+			"aaaaaaa aaaaaaa aaaaaaa aaaaaaa " };
+		success = str_trie_from_array(&t, too_long, 2);
+		assert(!success && errno == EILSEQ), errno = 0;
+		assert(str_trie_get(&t, "aaaaaaa aaaaaaa aaaaaaa aaaaaaa!"));
+		assert(!strcmp(too_long[0], "aaaaaaa aaaaaaa aaaaaaa aaaaaaa "));
+	}
 	str_trie_clear(&t);
 
 	/* Insert all words. */
@@ -146,10 +157,164 @@ static void contrived_test(void) {
 		str_trie_graph_all(&t, "graph/trie/contrived-delete.gv", i);
 	}
 	assert(!count_insert);
+	{ /* The trunk goes up in size classes, and back down on removal. */
+		const char *const few[] = { "a", "b", "c" };
+		static char more[100][8];
+		for(i = 0; i < sizeof more / sizeof *more; i++)
+			sprintf(more[i], "w%u", i);
+		for(i = 0; i < sizeof few / sizeof *few; i++)
+			r = str_trie_add(&t, few[i]), assert(r == TRIE_ABSENT);
+		assert(t.trunk->leaves == 3 && t.trunk->capacity == 4);
+		for(i = 0; i < sizeof more / sizeof *more; i++)
+			r = str_trie_add(&t, more[i]), assert(r == TRIE_ABSENT);
+		assert(t.trunk->capacity == 128);
+		for(i = 0; i < 70; i++)
+			success = str_trie_remove(&t, more[i]), assert(success);
+		assert(t.trunk->capacity == 128); /* Hysteresis. */
+		for(i = 70; i < 80; i++)
+			success = str_trie_remove(&t, more[i]), assert(success);
+		assert(t.trunk->leaves == 23 && t.trunk->capacity == 32);
+		str_trie_clear(&t);
+		for(i = 0; i < sizeof few / sizeof *few; i++)
+			r = str_trie_add(&t, few[i]), assert(r == TRIE_ABSENT);
+		assert(t.trunk->capacity == 32); /* Keeps the trunk. */
+		success = str_trie_remove(&t, "a"), assert(success);
+		assert(t.trunk->leaves == 2 && t.trunk->capacity == 2);
+	}
+	str_trie_(&t);
+}
+
+/** Keys that are prefixes of strings; like routing on the bits of addresses
+ as text, and checked against trying all the keys. */
+static void longest_test(void) {
+	const char *const routes[] = { "", "10", "1010", "10100", "101001", "11",
+		"110", "0", "0110101" };
+	const char *const inputs[] = { "1010011", "10101", "1", "", "0110", "111",
+		"0110101", "01101011", "2" };
+	static char words[500][32];
+	struct str_trie t = str_trie();
+	struct str_trie_cursor cur;
+	struct str_trie_prefixes_cursor p;
+	const char *longest;
+	size_t i, j, len;
+	int success;
+	printf("Longest prefix:\n");
+	assert(!str_trie_longest(&t, "10"));
+	p = str_trie_prefixes(&t, "10"), assert(!str_trie_prefixes_exists(&p));
+	for(i = 0; i < sizeof routes / sizeof *routes; i++)
+		success = str_trie_add(&t, routes[i]) == TRIE_ABSENT, assert(success);
+	assert(!strcmp(str_trie_longest(&t, "1010011"), "101001"));
+	assert(!strcmp(str_trie_longest(&t, "10101"), "1010"));
+	assert(!strcmp(str_trie_longest(&t, "01101011"), "0110101"));
+	assert(!strcmp(str_trie_longest(&t, "2"), ""));
+	/* All of them, in order, against what's there. */
+	for(i = 0; i < sizeof inputs / sizeof *inputs; i++) {
+		j = 0, len = 0;
+		for(p = str_trie_prefixes(&t, inputs[i]); str_trie_prefixes_exists(&p);
+			str_trie_prefixes_next(&p), j++) {
+			const char *const key = str_trie_prefixes_entry(&p);
+			assert(!strncmp(key, inputs[i], strlen(key)));
+			assert(!j || strlen(key) > len), len = strlen(key);
+		}
+		for(cur = str_trie_begin(&t); str_trie_exists(&cur); str_trie_next(&cur))
+		{
+			const char *const key = str_trie_entry(&cur);
+			if(!strncmp(key, inputs[i], strlen(key))) j--;
+		}
+		assert(!j);
+	}
+	/* Random words and their prefixes. */
+	str_trie_clear(&t);
+	for(i = 0; i < sizeof words / sizeof *words; i++) {
+		if(i % 2) {
+			memcpy(words[i], words[i - 1], sizeof *words);
+			words[i][(unsigned)rand() % (strlen(words[i]) + 1)] = '\0';
+		} else {
+			orcish(words[i], sizeof *words);
+		}
+		if(!str_trie_add(&t, words[i])) { perror("longest"); assert(0); }
+	}
+	for(i = 0; i < sizeof words / sizeof *words; i++) {
+		char input[48];
+		sprintf(input, "%s%s", words[i], i % 3 ? "x" : "");
+		for(longest = 0, j = 0; j < sizeof words / sizeof *words; j++)
+			if(!strncmp(words[j], input, strlen(words[j])) && (!longest
+			|| strlen(words[j]) > strlen(longest))) longest = words[j];
+		assert(longest && !strcmp(str_trie_longest(&t, input), longest));
+	}
 	str_trie_(&t);
 }
 
 
+/* Words with popularity for autocomplete. The best under a prefix are found
+ without going through them all. */
+struct popular { const char *word; unsigned popularity; };
+static const char *popular_key(const struct popular *const p)
+	{ return p->word; }
+static unsigned popular_score(const struct popular *const p)
+	{ return p->popularity; }
+#define TRIE_NAME popular
+#define TRIE_ENTRY struct popular
+#define TRIE_SCORE unsigned
+#include "../src/trie.h"
+static int popular_descend(const void *const a, const void *const b) {
+	const unsigned x = *(const unsigned *)a, y = *(const unsigned *)b;
+	return (x < y) - (y < x);
+}
+static void popular_test(void) {
+	static char words[500][16];
+	struct popular pop[sizeof words / sizeof *words], *e, *best[10];
+	const size_t pop_size = sizeof pop / sizeof *pop,
+		k = sizeof best / sizeof *best;
+	const char *const prefixes[] = { "", "A", "B", "Gr", "Ash", "Zzz" };
+	struct popular_trie trie = popular_trie();
+	size_t i, j, n, p;
+	printf("Top popular:\n");
+	errno = 0;
+	assert(!popular_trie_top(&trie, "", best, k));
+	for(n = 0, i = 0; i < pop_size; i++) {
+		orcish(words[i], sizeof *words);
+		switch(popular_trie_add(&trie, words[i], &e)) {
+		case TRIE_ERROR: perror("popular"); assert(0); return;
+		case TRIE_PRESENT: continue;
+		case TRIE_ABSENT: break;
+		}
+		e->word = words[i], e->popularity = (unsigned)rand() % 1000;
+		pop[n++] = *e;
+	}
+	for(i = 0; i <= 100; i++) {
+		for(p = 0; p < sizeof prefixes / sizeof *prefixes; p++) {
+			/* Brute force: sorted popularities of all with the prefix. */
+			const size_t len = strlen(prefixes[p]),
+				got = popular_trie_top(&trie, prefixes[p], best, k);
+			unsigned all[sizeof pop / sizeof *pop];
+			size_t all_size = 0;
+			for(j = 0; j < n; j++) if(!strncmp(pop[j].word, prefixes[p], len))
+				all[all_size++] = pop[j].popularity;
+			qsort(all, all_size, sizeof *all, &popular_descend);
+			assert(got == (all_size < k ? all_size : k));
+			for(j = 0; j < got; j++) {
+				assert(!strncmp(best[j]->word, prefixes[p], len));
+				assert(best[j]->popularity == all[j]);
+			}
+		}
+		if(i == 100) break;
+		/* Change some, in place, and remove others. */
+		j = (size_t)rand() % n;
+		if(i % 2) {
+			int success = popular_trie_remove(&trie, pop[j].word);
+			assert(success && !errno);
+			pop[j] = pop[--n];
+			if(!n) break;
+		} else {
+			e = popular_trie_get(&trie, pop[j].word), assert(e);
+			e->popularity = pop[j].popularity = (unsigned)rand() % 1000;
+			popular_trie_invalidate(&trie, pop[j].word);
+		}
+	}
+	popular_trie_(&trie);
+}
+
 /* Set of `enum colour`. The set is necessarily alphabetically ordered, and can
  efficiently tell which colour names are starting with a prefix. This stores
  2 bytes overhead and an `enum colour` for each in the set. It forwards one
@@ -179,6 +344,295 @@ static void colour_filler(enum colour *const c)
 #define TRIE_TEST
 #include "../src/trie.h"
 
+/* Spelling correction; the keys that are a few edits away. */
+static unsigned levenshtein(const char *const a, const char *const b) {
+	unsigned row[64], diag, i, j;
+	const unsigned a_len = (unsigned)strlen(a), b_len = (unsigned)strlen(b);
+	assert(b_len < sizeof row / sizeof *row);
+	for(j = 0; j <= b_len; j++) row[j] = j;
+	for(i = 1; i <= a_len; i++) {
+		for(diag = row[0], row[0] = i, j = 1; j <= b_len; j++) {
+			const unsigned up = row[j];
+			unsigned d = diag + (a[i - 1] != b[j - 1]);
+			if(row[j] + 1 < d) d = row[j] + 1;
+			if(row[j - 1] + 1 < d) d = row[j - 1] + 1;
+			row[j] = d, diag = up;
+		}
+	}
+	return row[b_len];
+}
+struct fuzzy_found { const char *query, *last; size_t count; };
+static void fuzzy_visit(const char *const key, const unsigned distance,
+	void *const param) {
+	struct fuzzy_found *const found = param;
+	assert(levenshtein(key, found->query) == distance);
+	assert(!found->last || strcmp(found->last, key) < 0); /* In order. */
+	found->last = key, found->count++;
+}
+static void fuzzy_test(void) {
+	const char *const fixed[] = { "", "a", "at", "act", "cat", "cart", "cast",
+		"coat", "cut", "scat", "dog", "catalogue" };
+	static char words[500][16];
+	char query[16];
+	struct str_trie t = str_trie();
+	struct fuzzy_found found;
+	size_t i, j, brute;
+	unsigned d;
+	int success;
+	printf("Fuzzy:\n");
+	errno = 0;
+	assert(!str_trie_fuzzy(&t, "cat", 2, 0, 0));
+	for(i = 0; i < sizeof fixed / sizeof *fixed; i++)
+		success = str_trie_add(&t, fixed[i]), assert(success);
+	assert(str_trie_fuzzy(&t, "cat", 0, 0, 0) == 1);
+	/* at, cat, cart, cast, coat, cut, scat; "act" is two substitutions. */
+	assert(str_trie_fuzzy(&t, "cat", 1, 0, 0) == 7);
+	assert(str_trie_fuzzy(&t, "", 1, 0, 0) == 2);
+	for(i = 0; i < sizeof words / sizeof *words; i++) {
+		orcish(words[i], sizeof *words);
+		success = str_trie_add(&t, words[i]), assert(success);
+	}
+	for(i = 0; i < 100; i++) {
+		/* A word with a letter changed, or another of the words. */
+		strcpy(query, words[(size_t)rand() % (sizeof words / sizeof *words)]);
+		if(i & 1) query[(size_t)rand() % strlen(query)] = 'e';
+		for(d = 0; d <= 2; d++) {
+			for(brute = 0, j = 0; j < sizeof words / sizeof *words; j++)
+				/* Only the first of the duplicates is in the trie. */
+				if(levenshtein(words[j], query) <= d
+				&& str_trie_get(&t, words[j]) == words[j]) brute++;
+			for(j = 0; j < sizeof fixed / sizeof *fixed; j++)
+				if(levenshtein(fixed[j], query) <= d) brute++;
+			found.query = query, found.last = 0, found.count = 0;
+			assert(str_trie_fuzzy(&t, query, d, &fuzzy_visit, &found)
+				== brute && found.count == brute);
+		}
+	}
+	assert(!errno);
+	str_trie_(&t);
+}
+
+struct scan_found { const char *text; size_t count; };
+/** Every pattern that the scan finds is in the text. */
+static void scan_visit(const char *const pattern, const size_t offset,
+	void *const param) {
+	struct scan_found *const found = param;
+	assert(!strncmp(found->text + offset, pattern, strlen(pattern)));
+	found->count++;
+}
+
+static void automaton_test(void) {
+	const char *const classic[] = { "he", "she", "his", "hers", "" };
+	static char text[4096];
+	struct str_trie t = str_trie();
+	struct str_trie_automaton a;
+	struct str_trie_scan scan;
+	struct scan_found found;
+	struct str_trie_cursor cur;
+	size_t i, brute, piece;
+	int success;
+	printf("Aho-Corasick:\n");
+	errno = 0;
+	/* Empty. */
+	success = str_trie_automaton(&a, &t), assert(success);
+	scan = str_trie_scan(&a);
+	assert(!str_trie_scan_next(&scan, "ushers", 6, 0, 0));
+	str_trie_automaton_(&a);
+	/* "ushers" has "she", "he", and "hers"; "" is not a pattern. */
+	for(i = 0; i < sizeof classic / sizeof *classic; i++)
+		success = str_trie_add(&t, classic[i]), assert(success);
+	success = str_trie_automaton(&a, &t), assert(success);
+	found.text = "ushers", found.count = 0;
+	scan = str_trie_scan(&a);
+	assert(str_trie_scan_next(&scan, "ush", 3, &scan_visit, &found) == 0);
+	assert(str_trie_scan_next(&scan, "ers", 3, &scan_visit, &found) == 3);
+	assert(found.count == 3);
+	str_trie_automaton_(&a);
+	/* Random words in random text, in random pieces, against brute force. */
+	for(i = 0; i < 2000; i++) {
+		const char *key;
+		char *k;
+		str_filler(&key), k = (char *)key;
+		/* Short and lower-case for more matches, some inside others. */
+		if(strlen(k) > 2 + i % 5) k[2 + i % 5] = '\0';
+		for( ; *k; k++) if(*k >= 'A' && *k <= 'Z') *k = (char)(*k - 'A' + 'a');
+		success = str_trie_add(&t, key), assert(success);
+	}
+	for(i = 0; i + 1 < sizeof text; i++)
+		text[i] = "aeiouthrsnlgk "[(unsigned)rand() % 14];
+	text[i] = '\0';
+	success = str_trie_automaton(&a, &t), assert(success);
+	assert(a.dense < a.states); /* Both kinds of states. */
+	for(brute = 0, cur = str_trie_begin(&t); str_trie_exists(&cur);
+		str_trie_next(&cur)) {
+		const char *const key = str_trie_entry(&cur), *at;
+		if(!*key) continue;
+		for(at = text; (at = strstr(at, key)); at++) brute++;
+	}
+	found.text = text, found.count = 0;
+	scan = str_trie_scan(&a);
+	for(i = 0; i < sizeof text - 1; i += piece) {
+		piece = (size_t)rand() % 64;
+		if(piece > sizeof text - 1 - i) piece = sizeof text - 1 - i;
+		str_trie_scan_next(&scan, text + i, piece, &scan_visit, &found);
+	}
+	printf("%lu matches in random text.\n", (unsigned long)found.count);
+	assert(found.count == brute && brute);
+	str_trie_automaton_(&a);
+	assert(!errno);
+	str_trie_(&t);
+}
+
+/* One writer flips between the keys of a pair; readers must always see
+ exactly one of each. */
+#define CONCURRENT_PAIRS 1000
+static char concurrent_key[2 * CONCURRENT_PAIRS][12];
+struct concurrent_reader { struct str_trie_concurrent *c; unsigned rounds; };
+/** Checks versions of the trie. Thread entry point. */
+static void *concurrent_read(void *const param) {
+	struct concurrent_reader *const r = param;
+	unsigned round, i;
+	for(round = 0; round < r->rounds; round++) {
+		const struct str_trie *const t = str_trie_acquire(r->c);
+		struct str_trie_cursor cur;
+		size_t count = 0;
+		for(cur = str_trie_begin(t); str_trie_exists(&cur); str_trie_next(&cur))
+			count++;
+		assert(count == CONCURRENT_PAIRS
+			&& str_trie_count(t) == CONCURRENT_PAIRS);
+		for(i = 0; i < CONCURRENT_PAIRS; i += 1 + round % 7)
+			assert(!str_trie_get(t, concurrent_key[2 * i])
+			!= !str_trie_get(t, concurrent_key[2 * i + 1]));
+		str_trie_release(r->c, t);
+	}
+	return 0;
+}
+
+static void concurrent_test(void) {
+	struct str_trie_concurrent c;
+	struct concurrent_reader reader;
+	const struct str_trie *old, *fresh;
+	struct str_trie_cursor cur;
+	pthread_t thread;
+	size_t i;
+	int success, threaded;
+	printf("Concurrent:\n");
+	errno = 0;
+	for(i = 0; i < 2 * CONCURRENT_PAIRS; i++)
+		sprintf(concurrent_key[i], "pair%lu", (unsigned long)i);
+	success = str_trie_concurrent(&c), assert(success);
+	old = str_trie_acquire(&c), assert(!str_trie_get(old, "pair0"));
+	/* Nothing is seen until it's published. */
+	for(i = 0; i < CONCURRENT_PAIRS; i++) assert(str_trie_concurrent_add(&c,
+		concurrent_key[2 * i + (size_t)rand() % 2]) == TRIE_ABSENT);
+	/* Boughs made since the publish are changed in place, not copied. */
+	assert(!c.writer.retired.size);
+	fresh = str_trie_acquire(&c);
+	assert(str_trie_count(&c.trie) == CONCURRENT_PAIRS
+		&& !str_trie_count(fresh));
+	str_trie_release(&c, fresh);
+	success = str_trie_publish(&c), assert(success);
+	fresh = str_trie_acquire(&c);
+	assert(!str_trie_count(old) && str_trie_count(fresh) == CONCURRENT_PAIRS);
+	/* The old version is reclaimed when the last reader lets it go. */
+	str_trie_release(&c, old);
+	assert(c.oldest == c.current);
+	/* Removing keeps the version that is held. */
+	cur = str_trie_begin(fresh);
+	success = str_trie_concurrent_remove(&c, str_trie_entry(&cur));
+	assert(success);
+	success = str_trie_publish(&c), assert(success);
+	assert(str_trie_count(fresh) == CONCURRENT_PAIRS
+		&& str_trie_count(&c.current->trie) == CONCURRENT_PAIRS - 1);
+	assert(c.oldest != c.current);
+	str_trie_release(&c, fresh);
+	assert(c.oldest == c.current);
+	/* Put it back, then flip pairs while a thread reads. */
+	for(i = 0; i < CONCURRENT_PAIRS; i++)
+		if(!str_trie_get(&c.trie, concurrent_key[2 * i])
+		&& !str_trie_get(&c.trie, concurrent_key[2 * i + 1]))
+		assert(str_trie_concurrent_add(&c, concurrent_key[2 * i])
+		== TRIE_ABSENT);
+	success = str_trie_publish(&c), assert(success);
+	reader.c = &c, reader.rounds = 200;
+	threaded = !pthread_create(&thread, 0, &concurrent_read, &reader);
+	for(i = 0; i < 20000; i++) {
+		const size_t pair = (size_t)rand() % CONCURRENT_PAIRS,
+			in = str_trie_get(&c.trie, concurrent_key[2 * pair]) ? 0 : 1;
+		success = str_trie_concurrent_remove(&c, concurrent_key[2 * pair + in]);
+		assert(success);
+		assert(str_trie_concurrent_add(&c, concurrent_key[2 * pair + !in])
+			== TRIE_ABSENT);
+		success = str_trie_publish(&c), assert(success);
+	}
+	if(threaded) pthread_join(thread, 0);
+	else concurrent_read(&reader);
+	assert(c.oldest == c.current);
+	concurrent_read(&reader);
+	assert(!errno);
+	str_trie_concurrent_(&c);
+}
+
+/* The trie has its own copy of the keys, so they need not be kept. */
+static void own_filler(const char **const key) { str_filler(key); }
+#define TRIE_NAME own
+#define TRIE_KEY_TO_STRING
+#define TRIE_OWN
+#define TRIE_TEST
+#include "../src/trie.h"
+
+static void own_test(void) {
+	const char *const fixed[] = { "b", "a", "c", "a" };
+	char buffer[32];
+	const char *array[sizeof fixed / sizeof *fixed];
+	struct own_trie t = own_trie();
+	const char *got;
+	size_t i;
+	int success;
+	printf("Owned keys:\n");
+	errno = 0;
+	/* The same buffer for every key. */
+	for(i = 0; i < 1000; i++) {
+		sprintf(buffer, "key%lu", (unsigned long)i);
+		assert(own_trie_add(&t, buffer) == TRIE_ABSENT);
+		assert(own_trie_add(&t, buffer) == TRIE_PRESENT);
+	}
+	strcpy(buffer, "key0");
+	assert((got = own_trie_get(&t, buffer)) && got != buffer);
+	/* Removing three-quarters compacts the arena to one block. */
+	for(i = 0; i < 1000; i++) if(i % 4) {
+		sprintf(buffer, "key%lu", (unsigned long)i);
+		success = own_trie_remove(&t, buffer), assert(success);
+	}
+	assert(t.block && !t.block->prev && t.used >= 2 * t.garbage);
+	for(i = 0; i < 1000; i++) {
+		sprintf(buffer, "key%lu", (unsigned long)i);
+		got = own_trie_get(&t, buffer);
+		assert(i % 4 ? !got : got && !strcmp(got, buffer));
+	}
+	/* The arena is freed when it's empty. */
+	for(i = 0; i < 1000; i += 4) {
+		sprintf(buffer, "key%lu", (unsigned long)i);
+		success = own_trie_remove(&t, buffer), assert(success);
+	}
+	assert(!t.block && !t.used && !t.garbage);
+	/* Bulk-loading copies the keys, the first of duplicates. */
+	for(i = 0; i < sizeof fixed / sizeof *fixed; i++) array[i] = fixed[i];
+	success = own_trie_from_array(&t, array, sizeof array / sizeof *array);
+	assert(success && t.used == 6);
+	for(i = 0; i < 3; i++) {
+		buffer[0] = (char)('a' + i), buffer[1] = '\0';
+		got = own_trie_get(&t, buffer);
+		assert(got && !strcmp(got, buffer)
+			&& got >= (const char *)(t.block + 1)
+			&& got < (const char *)(t.block + 1) + t.used);
+	}
+	own_trie_clear(&t);
+	assert(t.block && !t.used && !own_trie_get(&t, "a"));
+	assert(!errno);
+	own_trie_(&t);
+}
+
 static void fixed_colour_test(void) {
 	struct colour_trie trie = colour_trie();
 	struct colour_trie_cursor cur;
@@ -435,12 +889,133 @@ static void unicode_trie_delimit(void) {
 }
 
 
+/* Network addresses are fixed-width keys. There is no null terminator, so
+ zeros are allowed anywhere, and the order is that of the big-endian number. */
+struct ipv4 { unsigned char octet[4]; };
+#define TRIE_NAME ipv4
+#define TRIE_KEY struct ipv4
+#define TRIE_KEY_BYTES 4
+#define TRIE_COUNT
+#define TRIE_IMAGE
+#include "../src/trie.h"
+static struct ipv4 ipv4(const unsigned long address) {
+	struct ipv4 a;
+	a.octet[0] = (unsigned char)(address >> 24 & 0xff);
+	a.octet[1] = (unsigned char)(address >> 16 & 0xff);
+	a.octet[2] = (unsigned char)(address >> 8 & 0xff);
+	a.octet[3] = (unsigned char)(address & 0xff);
+	return a;
+}
+static void ipv4_test(void) {
+	struct ipv4_trie trie = ipv4_trie(), bulk = ipv4_trie();
+	struct ipv4_trie_cursor cur;
+	struct ipv4 a[1000], e;
+	const size_t a_size = sizeof a / sizeof *a;
+	size_t i, n;
+	int success;
+	printf("IPv4 addresses:\n");
+	/* All zeros and a zero in every octet; the rest random. */
+	a[0] = ipv4(0), a[1] = ipv4(0x0a000000), a[2] = ipv4(0x0a000001),
+		a[3] = ipv4(0x0a000100), a[4] = ipv4(0xffffffff);
+	for(i = 5; i < a_size; i++) a[i] = ipv4((unsigned long)rand() << 16
+		^ (unsigned long)rand() & 0xffffffff);
+	for(i = 0; i < a_size; i++) {
+		const enum trie_result r = ipv4_trie_add(&trie, a[i]);
+		assert(r == TRIE_ABSENT || i >= 5 && r == TRIE_PRESENT);
+	}
+	assert(ipv4_trie_add(&trie, a[1]) == TRIE_PRESENT);
+	for(i = 0; i < a_size; i++) {
+		const enum trie_result r
+			= ipv4_trie_get(&trie, (const char *)a[i].octet, &e);
+		assert(r == TRIE_PRESENT && !memcmp(&e, a + i, sizeof e));
+	}
+	e = ipv4(0x0a000002);
+	assert(ipv4_trie_get(&trie, (const char *)e.octet, 0) == TRIE_ABSENT);
+	/* In numerical order. */
+	for(n = 0, cur = ipv4_trie_begin(&trie); ipv4_trie_exists(&cur);
+		n++, ipv4_trie_next(&cur)) {
+		const struct ipv4 b = ipv4_trie_entry(&cur);
+		assert(!n || memcmp(&e, &b, sizeof e) < 0);
+		e = b;
+	}
+	printf("%lu unique of %lu.\n", (unsigned long)n, (unsigned long)a_size);
+	assert(ipv4_trie_count(&trie) == n);
+	for(i = 0, cur = ipv4_trie_begin(&trie); ipv4_trie_exists(&cur);
+		i++, ipv4_trie_next(&cur)) {
+		const struct ipv4 b = ipv4_trie_entry(&cur);
+		struct ipv4_trie_cursor sel = ipv4_trie_select(&trie, i);
+		assert(ipv4_trie_rank(&trie, (const char *)b.octet) == i);
+		assert(ipv4_trie_exists(&sel) && !memcmp(&b, (e = ipv4_trie_entry(&sel),
+			&e), sizeof b));
+	}
+	e = ipv4(0x0a000002); /* Between 10.0.0.1 and 10.0.1.0. */
+	assert(ipv4_trie_rank(&trie, (const char *)e.octet)
+		== ipv4_trie_rank(&trie, (const char *)a[3].octet));
+	cur = ipv4_trie_lower(&trie, (const char *)e.octet);
+	assert(ipv4_trie_exists(&cur)
+		&& !memcmp(&a[3], (e = ipv4_trie_entry(&cur), &e), sizeof e));
+	{ /* Subnet 10.0.0.0/16. */
+		const struct ipv4 lo = ipv4(0x0a000000), hi = ipv4(0x0a010000);
+		for(n = 0, cur = ipv4_trie_range(&trie, (const char *)lo.octet,
+			(const char *)hi.octet); ipv4_trie_exists(&cur);
+			n++, ipv4_trie_next(&cur));
+		assert(n == ipv4_trie_rank(&trie, (const char *)hi.octet)
+			- ipv4_trie_rank(&trie, (const char *)lo.octet) && n >= 3);
+	}
+	{ /* The image has the same keys, fixed-width. */
+		struct ipv4_trie_image image;
+		struct ipv4_trie_image_cursor ic;
+		FILE *fp = tmpfile();
+		long size;
+		void *data;
+		assert(fp);
+		success = ipv4_trie_image_save(&trie, fp), assert(success);
+		size = ftell(fp), assert(size > 0), rewind(fp);
+		data = malloc((size_t)size), assert(data);
+		success = fread(data, 1, (size_t)size, fp) == (size_t)size;
+		assert(success), fclose(fp);
+		success = ipv4_trie_image(&image, data, (size_t)size), assert(success);
+		for(i = 0; i < a_size; i++) {
+			const char *const key
+				= ipv4_trie_image_get(&image, (const char *)a[i].octet);
+			assert(key && !memcmp(key, a[i].octet, sizeof a[i].octet));
+		}
+		e = ipv4(0x0a000002);
+		assert(!ipv4_trie_image_get(&image, (const char *)e.octet));
+		for(i = 0, ic = ipv4_trie_image_begin(&image);
+			ipv4_trie_image_exists(&ic); i++, ipv4_trie_image_next(&ic));
+		assert(i == ipv4_trie_count(&trie));
+		free(data);
+	}
+	success = ipv4_trie_from_array(&bulk, a, a_size), assert(success);
+	for(i = 0; i < a_size; i += 2) {
+		if(ipv4_trie_get(&trie, (const char *)a[i].octet, 0) == TRIE_ABSENT)
+			continue; /* Random duplicate. */
+		success = ipv4_trie_remove(&trie, (const char *)a[i].octet);
+		assert(success);
+		success = ipv4_trie_remove(&bulk, (const char *)a[i].octet);
+		assert(success);
+	}
+	for(i = 0; i < a_size; i++) assert(ipv4_trie_get(&trie,
+		(const char *)a[i].octet, 0) == ipv4_trie_get(&bulk,
+		(const char *)a[i].octet, 0));
+	assert(ipv4_trie_get(&trie, (const char *)a[1].octet, 0) == TRIE_PRESENT);
+	ipv4_trie_(&trie), ipv4_trie_(&bulk);
+}
+
 int main(void) {
 	unsigned seed = (unsigned)clock();
 	srand(seed), rand(), printf("Seed %u.\n", seed);
 	errno = 0;
 	str_trie_test(), str32_deque_clear(&str_storage);
 	contrived_test(), str32_deque_clear(&str_storage);
+	longest_test();
+	popular_test();
+	fuzzy_test();
+	automaton_test(), str32_deque_clear(&str_storage);
+	concurrent_test();
+	own_trie_test(), str32_deque_clear(&str_storage);
+	own_test();
 	fixed_colour_test();
 	colour_trie_test();
 	str8_trie_test();
@@ -450,5 +1025,6 @@ int main(void) {
 	header_trie_test();
 	article_test();
 	unicode_trie_delimit();
+	ipv4_test();
 	return EXIT_SUCCESS;
 }
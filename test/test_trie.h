@@ -21,18 +21,18 @@ static void pT_(print)(const struct pT_(bough) *const tree) {
 	assert(tree);
 	printf("%s:\n"
 		"left ", orcify(tree));
-	for(b = 0; b < tree->bsize; b++) branch = tree->branch + b,
+	for(b = 0; b < tree->bsize; b++) branch = pT_(branch)(tree) + b,
 		printf("%s%u", b ? ", " : "", branch->left);
 	printf("\n"
 		"skip ");
-	for(b = 0; b < tree->bsize; b++) branch = tree->branch + b,
+	for(b = 0; b < tree->bsize; b++) branch = pT_(branch)(tree) + b,
 		printf("%s%u", b ? ", " : "", branch->skip);
 	printf("\n"
 		"leaves ");
 	for(i = 0; i <= tree->bsize; i++)
 		printf("%s%s", i ? ", " : "", trie_bmp_test(&tree->bmp, i)
-			? orcify(tree->leaf[i].as_link)
-			: pT_(key_string)(pT_(entry_key)(tree->leaf[i].as_entry)));
+			? orcify(pT_(leaf)(tree)[i].as_link)
+			: pT_(key_string)(pT_(entry_key)(pT_(leaf)(tree)[i].as_entry)));
 	printf("\n");
 }
 #	endif
@@ -42,15 +42,27 @@ static void pT_(valid_bough)(/*const*/ struct pT_(bough) *const bough) {
 	unsigned i;
 	int cmp = 0;
 	const char *str1 = 0;
-	assert(bough && bough->leaves <= TRIE_ORDER);
+	assert(bough && bough->leaves <= bough->capacity
+		&& bough->capacity <= TRIE_ORDER);
 	for(i = 0; i < bough->leaves - 1; i++)
-		assert(bough->branch[i].left < bough->leaves - 1 - i);
+		assert(pT_(branch)(bough)[i].left < bough->leaves - 1 - i);
 	for(i = 0; i < bough->leaves; i++) {
 		if(trie_bmp_test(&bough->bmp, i)) {
-			pT_(valid_bough)(bough->leaf[i].as_link);
+			pT_(valid_bough)(pT_(leaf)(bough)[i].as_link);
+#	ifdef TRIE_COUNT
+			{ /* The count beside the link is all the entries under it. */
+				const struct pT_(bough) *const link
+					= pT_(leaf)(bough)[i].as_link;
+				assert(pT_(size)(bough)[i]
+					== pT_(sum)(link, 0, link->leaves - 1u));
+			}
+#	endif
 		} else {
 			const char *str2;
 			struct pT_(ref) ref;
+#	ifdef TRIE_COUNT
+			assert(pT_(size)(bough)[i] == 1);
+#	endif
 			ref.bough = bough, ref.lf = i;
 			str2 = pT_(ref_to_string)(&ref);
 			if(str1) cmp = strcmp(str1, str2), assert(cmp < 0);
@@ -197,6 +209,255 @@ static void pT_(test)(void) {
 	printf("Counted by letter %lu elements, checksum %lu.\n",
 		(unsigned long)count, (unsigned long)unique);
 	assert(count == unique);
+#	ifdef TRIE_COUNT
+	{ /* Counting without going through them. */
+		struct T_(cursor) cur, sel;
+		char letter[2];
+		assert(T_(count)(&trie) == unique);
+		for(i = 1; i < letter_counts_size; i++) {
+			size_t less = 0;
+			letter[0] = (char)i, letter[1] = '\0';
+			assert(T_(prefix_count)(&trie, letter) == letter_counts[i]);
+			for(cur = T_(begin)(&trie); T_(exists)(&cur); T_(next)(&cur))
+				if(strcmp(pT_(ref_to_string)(&cur.start), letter) < 0) less++;
+			assert(T_(rank)(&trie, letter) == less);
+		}
+		assert(T_(prefix_count)(&trie, "") == unique);
+		for(count = 0, cur = T_(begin)(&trie); T_(exists)(&cur);
+			count++, T_(next)(&cur)) {
+			const char *const string = pT_(ref_to_string)(&cur.start);
+			assert(T_(rank)(&trie, string) == count);
+			sel = T_(select)(&trie, count), assert(T_(exists)(&sel));
+			assert(sel.start.bough == cur.start.bough
+				&& sel.start.lf == cur.start.lf);
+		}
+		assert(count == unique);
+		sel = T_(select)(&trie, count), assert(!T_(exists)(&sel));
+	}
+#	endif
+	{ /* Lower, upper, and range cursors against going through them all. */
+		struct T_(cursor) cur, lo, up, in;
+		char a[8];
+		for(i = 0; i < tests_size; i += 5) {
+			/* Truncated keys are mostly not in the trie. */
+			const char *const b
+				= pT_(entry_string)(&tests[(3 * i + 1) % tests_size].entry);
+			const char *first_lo = 0, *first_up = 0;
+			size_t in_range = 0, n;
+			strncpy(a, pT_(entry_string)(&tests[i].entry), i % sizeof a);
+			a[i % sizeof a] = '\0';
+			for(cur = T_(begin)(&trie); T_(exists)(&cur); T_(next)(&cur)) {
+				const char *const s = pT_(ref_to_string)(&cur.start);
+				if(!first_lo && strcmp(s, a) >= 0) first_lo = s;
+				if(!first_up && strcmp(s, a) > 0) first_up = s;
+				if(strcmp(s, a) >= 0 && strcmp(s, b) < 0) in_range++;
+			}
+			lo = T_(lower)(&trie, a), up = T_(upper)(&trie, a);
+			assert(first_lo ? T_(exists)(&lo)
+				&& !strcmp(pT_(ref_to_string)(&lo.start), first_lo)
+				: !T_(exists)(&lo));
+			assert(first_up ? T_(exists)(&up)
+				&& !strcmp(pT_(ref_to_string)(&up.start), first_up)
+				: !T_(exists)(&up));
+			for(n = 0, in = T_(range)(&trie, a, b); T_(exists)(&in);
+				T_(next)(&in)) {
+				const char *const s = pT_(ref_to_string)(&in.start);
+				assert(strcmp(s, a) >= 0 && strcmp(s, b) < 0);
+				n++;
+			}
+			assert(n == in_range);
+		}
+	}
+#	ifdef TRIE_IMAGE
+	{ /* Round-trip through a file and read it in-place. */
+		struct T_(image) image;
+		struct T_(image_cursor) ic;
+		struct T_(cursor) c0;
+		struct t_(trie) empty = t_(trie)();
+		FILE *fp;
+		long size;
+		void *data;
+		char letter[2];
+		int success;
+		fp = tmpfile(), assert(fp);
+		success = T_(image_save)(&trie, fp), assert(success);
+		size = ftell(fp), assert(size > 0), rewind(fp);
+		data = malloc((size_t)size), assert(data);
+		success = fread(data, 1, (size_t)size, fp) == (size_t)size;
+		assert(success), fclose(fp);
+		success = T_(image)(&image, data, (size_t)size - 4), assert(!success);
+		assert(errno == EILSEQ), errno = 0;
+		success = T_(image)(&image, data, (size_t)size), assert(success);
+		{ /* Offsets that go outside are caught when it is set up. */
+			const struct pT_(image_trailer) *const trailer = (const void *)
+				((const char *)data + (size_t)size - sizeof *trailer);
+			trie_image_uint *const bad = malloc((size_t)size), *root;
+			assert(bad && trailer->words);
+			memcpy(bad, data, (size_t)size);
+			root = bad + trailer->root;
+			root[1 + TRIE_IMAGE_BRANCHES(root[0]) + root[0] - 1]
+				= trailer->keys;
+			success = T_(image)(&image, bad, (size_t)size), assert(!success);
+			assert(errno == EILSEQ), errno = 0;
+			memcpy(bad, data, (size_t)size);
+			root = bad + trailer->root;
+			root[1 + TRIE_IMAGE_BRANCHES(root[0])] = TRIE_IMAGE_LINK
+				| (trailer->root + 1);
+			success = T_(image)(&image, bad, (size_t)size), assert(!success);
+			assert(errno == EILSEQ), errno = 0;
+			memcpy(bad, data, (size_t)size), bad[0] = 0;
+			success = T_(image)(&image, bad, (size_t)size), assert(!success);
+			assert(errno == EILSEQ), errno = 0;
+			free(bad);
+		}
+		success = T_(image)(&image, data, (size_t)size), assert(success);
+		for(c0 = T_(begin)(&trie), ic = T_(image_begin)(&image);
+			T_(exists)(&c0); T_(next)(&c0), T_(image_next)(&ic)) {
+			assert(T_(image_exists)(&ic) && !strcmp(T_(image_key)(&ic),
+				pT_(ref_to_string)(&c0.start)));
+		}
+		assert(!T_(image_exists)(&ic));
+		for(i = 0; i < tests_size; i++) {
+			const char *const string = pT_(entry_string)(&tests[i].entry),
+				*const key = T_(image_get)(&image, string);
+			assert(key && !strcmp(key, string));
+		}
+		assert(!T_(image_get)(&image, "\x7f not a key"));
+		for(i = 1; i < letter_counts_size; i++) {
+			unsigned n = 0;
+			letter[0] = (char)i, letter[1] = '\0';
+			for(ic = T_(image_prefix)(&image, letter); T_(image_exists)(&ic);
+				T_(image_next)(&ic), n++)
+				assert(T_(image_key)(&ic)[0] == (char)i);
+			assert(n == letter_counts[i]);
+		}
+		free(data);
+		/* An empty trie is only a trailer. */
+		fp = tmpfile(), assert(fp);
+		success = T_(image_save)(&empty, fp), assert(success);
+		size = ftell(fp), assert(size > 0), rewind(fp);
+		data = malloc((size_t)size), assert(data);
+		success = fread(data, 1, (size_t)size, fp) == (size_t)size;
+		assert(success), fclose(fp);
+		success = T_(image)(&image, data, (size_t)size), assert(success);
+		ic = T_(image_begin)(&image), assert(!T_(image_exists)(&ic));
+		assert(!T_(image_get)(&image, ""));
+		free(data);
+	}
+#	endif
+	{ /* Bulk-load the same entries, unsorted, and compare. */
+		struct t_(trie) bulk = t_(trie)();
+		struct T_(cursor) c0, c1;
+		pT_(entry) array[sizeof tests / sizeof *tests];
+		int success;
+		for(i = 0; i < tests_size; i++) array[i] = tests[i].entry;
+		success = T_(from_array)(&bulk, array, tests_size), assert(success);
+		pT_(valid)(&bulk);
+		T_(graph_all)(&bulk, "graph/trie/" QUOTE(TRIE_NAME) "-bulk.gv", 0);
+		for(c0 = T_(prefix)(&trie, ""), c1 = T_(prefix)(&bulk, "");
+			T_(exists)(&c0); T_(next)(&c0), T_(next)(&c1)) {
+			assert(T_(exists)(&c1));
+			assert(!strcmp(pT_(ref_to_string)(&c0.start),
+				pT_(ref_to_string)(&c1.start)));
+		}
+		assert(!T_(exists)(&c1));
+		/* It's sorted now, and it's a regular trie that can be modified. */
+		success = T_(from_array)(&bulk, array, tests_size), assert(success);
+		for(i = 0; i < tests_size; i++) if(tests[i].is_in) {
+			const char *const string = pT_(entry_string)(&tests[i].entry);
+			success = T_(remove)(&bulk, string), assert(success);
+		}
+		assert(!bulk.trunk->leaves);
+		success = T_(from_array)(&bulk, array, 1), assert(success);
+		assert(bulk.trunk->leaves == 1), pT_(valid)(&bulk);
+		t_(trie_)(&bulk);
+	}
+	{ /* Partition, build the parts independently, and join. */
+		struct t_(trie) joined = t_(trie)(), parts[UCHAR_MAX + 1];
+		struct T_(cursor) c0, c1;
+		pT_(entry) array[sizeof tests / sizeof *tests];
+		size_t start[UCHAR_MAX + 2], nonempty = 0;
+		unsigned b;
+		int success;
+		for(i = 0; i < tests_size; i++) array[i] = tests[i].entry;
+		T_(partition)(array, tests_size, start);
+		assert(start[0] == 0 && start[UCHAR_MAX + 1] == tests_size);
+		for(b = 0; b <= UCHAR_MAX; b++) {
+			parts[b] = t_(trie)();
+			for(i = start[b]; i < start[b + 1]; i++)
+				assert((unsigned char)*pT_(entry_string)(array + i) == b);
+			if(start[b] == start[b + 1]) continue;
+			success = T_(from_array)(parts + b, array + start[b],
+				start[b + 1] - start[b]), assert(success);
+			nonempty++;
+		}
+		if(nonempty > 1) { /* Out of order. */
+			struct t_(trie) swap;
+			size_t lo, hi;
+			for(lo = 0; !parts[lo].trunk; lo++);
+			for(hi = UCHAR_MAX; !parts[hi].trunk; hi--);
+			swap = parts[lo], parts[lo] = parts[hi], parts[hi] = swap;
+			success = T_(join)(&joined, parts, UCHAR_MAX + 1);
+			assert(!success && errno == EDOM && !joined.trunk), errno = 0;
+			swap = parts[lo], parts[lo] = parts[hi], parts[hi] = swap;
+		}
+		success = T_(join)(&joined, parts, UCHAR_MAX + 1), assert(success);
+		for(b = 0; b <= UCHAR_MAX; b++) assert(!parts[b].trunk);
+		pT_(valid)(&joined);
+		T_(graph_all)(&joined, "graph/trie/" QUOTE(TRIE_NAME) "-joined.gv", 1);
+		/* It iterates the same as the trie that was added one at a time. */
+		for(c0 = T_(prefix)(&trie, ""), c1 = T_(prefix)(&joined, "");
+			T_(exists)(&c0); T_(next)(&c0), T_(next)(&c1)) {
+			assert(T_(exists)(&c1));
+			assert(!strcmp(pT_(ref_to_string)(&c0.start),
+				pT_(ref_to_string)(&c1.start)));
+		}
+		assert(!T_(exists)(&c1));
+		for(i = 0; i < tests_size; i++) if(tests[i].is_in) {
+			const char *const string = pT_(entry_string)(&tests[i].entry);
+			assert(pT_(get)(&joined, string, &c0.start));
+		}
+		t_(trie_)(&joined);
+	}
+#	ifdef TRIE_PARALLEL
+	{ /* The same, but between threads. */
+		struct t_(trie) par = t_(trie)();
+		struct T_(cursor) c0, c1;
+		pT_(entry) array[sizeof tests / sizeof *tests];
+		int success;
+		for(i = 0; i < tests_size; i++) array[i] = tests[i].entry;
+		success = T_(parallel_from_array)(&par, array, tests_size, 3);
+		assert(success), pT_(valid)(&par);
+		for(c0 = T_(prefix)(&trie, ""), c1 = T_(prefix)(&par, "");
+			T_(exists)(&c0); T_(next)(&c0), T_(next)(&c1)) {
+			assert(T_(exists)(&c1));
+			assert(!strcmp(pT_(ref_to_string)(&c0.start),
+				pT_(ref_to_string)(&c1.start)));
+		}
+		assert(!T_(exists)(&c1));
+		t_(trie_)(&par);
+	}
+#	endif
+	{ /* Removing down to a few; the boughs are joined back into the trunk. */
+		size_t left = unique;
+		unsigned lf;
+		int success;
+		for(i = 0; i < tests_size && left > 10; i++) if(tests[i].is_in) {
+			const char *const string = pT_(entry_string)(&tests[i].entry);
+			success = T_(remove)(&trie, string), assert(success);
+			tests[i].is_in = 0, left--;
+		}
+		pT_(valid)(&trie);
+		T_(graph_all)(&trie, "graph/trie/" QUOTE(TRIE_NAME) "-joined.gv", 0);
+		assert(trie.trunk->leaves == left);
+		for(lf = 0; lf < trie.trunk->leaves; lf++)
+			assert(!trie_bmp_test(&trie.trunk->bmp, lf));
+		for(i = 0; i < tests_size; i++) if(tests[i].is_in) {
+			const char *const string = pT_(entry_string)(&tests[i].entry);
+			struct pT_(ref) ref;
+			assert(pT_(get)(&trie, string, &ref));
+		}
+	}
 	T_(clear)(&trie);
 	{
 		struct T_(cursor) cur = T_(prefix)(&trie, "");
@@ -0,0 +1,125 @@
+/* Removing every item of a pool in random order: the default, which finds the
+ slab with a binary search of the slabs in order, against aligned slabs, which
+ are found by masking. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+struct item { size_t a[4]; };
+#define POOL_NAME sorted
+#define POOL_TYPE struct item
+#include "../../../../src/pool.h"
+#define POOL_NAME aligned
+#define POOL_TYPE struct item
+#define POOL_ALIGNED 4096
+#include "../../../../src/pool.h"
+
+#include <time.h>
+/** Returns a processor-time difference in milliseconds from `then`. */
+static double diff_ms(const clock_t then)
+	{ return (double)(clock() - then) / (CLOCKS_PER_SEC / 1000.0); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** Shuffles `item` of `size`. */
+static void shuffle(struct item **const item, const size_t size) {
+	size_t i;
+	for(i = size - 1; i; i--) {
+		const size_t j = (size_t)rand() % (i + 1);
+		struct item *const temp = item[i];
+		item[i] = item[j], item[j] = temp;
+	}
+}
+
+/* Both are the same but for the type. */
+#define REMOVE_FN(name) \
+/** Fills `pool` with `size` in `item`, and times removing all of them in \
+ random order into `m`. @return The slabs when full, or zero on error. */ \
+static size_t name##_remove(struct name##_pool *const pool, \
+	struct item **const item, const size_t size, struct measure *const m) { \
+	size_t i, slabs; \
+	clock_t t; \
+	for(i = 0; i < size; i++) \
+		if(!(item[i] = name##_pool_new(pool))) return 0; \
+	slabs = pool->slots.size; \
+	shuffle(item, size); \
+	t = clock(); \
+	for(i = 0; i < size; i++) if(!name##_pool_remove(pool, item[i])) return 0; \
+	m_add(m, 1000000.0 * diff_ms(t) / (double)size); \
+	name##_pool_(pool); \
+	return slabs; \
+}
+REMOVE_FN(sorted)
+REMOVE_FN(aligned)
+
+int main(void) {
+	const char *const name = "aligned";
+	const size_t replicas = 5;
+	struct sorted_pool sorted = sorted_pool();
+	struct aligned_pool aligned = aligned_pool();
+	struct item **item = 0;
+	struct measure ms, ma;
+	size_t size, i, sorted_slabs = 0, aligned_slabs = 0;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!(fp = fopen("graph/aligned.tsv", "w"))) goto catch;
+	fprintf(fp, "# remove all in random order\n# <items>\t<sorted (ns)>\t<sd>"
+		"\t<slabs>\t<aligned (ns)>\t<sd>\t<slabs>\n");
+	for(size = 1000; size <= 4000000; size *= 4) {
+		if(!(item = realloc(item, sizeof *item * size))) goto catch;
+		m_reset(&ms), m_reset(&ma);
+		for(i = 0; i < replicas; i++) {
+			if(!(sorted_slabs = sorted_remove(&sorted, item, size, &ms))
+				|| !(aligned_slabs = aligned_remove(&aligned, item, size, &ma)))
+				goto catch;
+		}
+		printf("%lu items: sorted %.1f ns, %lu slabs;"
+			" aligned %.1f ns, %lu slabs.\n", (unsigned long)size,
+			m_mean(&ms), (unsigned long)sorted_slabs,
+			m_mean(&ma), (unsigned long)aligned_slabs);
+		fprintf(fp, "%lu\t%f\t%f\t%lu\t%f\t%f\t%lu\n", (unsigned long)size,
+			m_mean(&ms), m_stddev(&ms), (unsigned long)sorted_slabs,
+			m_mean(&ma), m_stddev(&ma), (unsigned long)aligned_slabs);
+	}
+	if(!(gnu = fopen("graph/aligned.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"items\"\n"
+		"set ylabel \"time per remove, t (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"sorted\", \\\n"
+		"\"graph/%s.tsv\" using 1:5:6 with errorlines title \"aligned\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	sorted_pool_(&sorted), aligned_pool_(&aligned);
+	free(item);
+	return ret;
+}
@@ -0,0 +1,135 @@
+/* Going over all the live items of a pool with a bitmap cursor, against an
+ array of pointers to them that the caller keeps, as the fraction that are
+ live goes down. The items are removed at random. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+struct item { size_t a[4]; };
+#define POOL_NAME item
+#define POOL_TYPE struct item
+#define POOL_BITMAP
+#include "../../../../src/pool.h"
+
+#include <time.h>
+/** Returns a processor-time difference in milliseconds from `then`. */
+static double diff_ms(const clock_t then)
+	{ return (double)(clock() - then) / (CLOCKS_PER_SEC / 1000.0); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** So the sums are not optimized away. */
+static size_t sink;
+
+/** Orders `a` and `b` by when they were made. */
+static int made(const void *const a, const void *const b) {
+	const size_t x = (*(struct item *const *)a)->a[0],
+		y = (*(struct item *const *)b)->a[0];
+	return (x > y) - (x < y);
+}
+
+/** Fills `pool` with `size`, then removes all but `live` at random. The rest
+ are kept in `item` in the order they were made. @return Success. */
+static int fill(struct item_pool *const pool, struct item **const item,
+	const size_t size, const size_t live) {
+	size_t i;
+	for(i = 0; i < size; i++) {
+		if(!(item[i] = item_pool_new(pool))) return 0;
+		item[i]->a[0] = i;
+	}
+	for(i = size - 1; i; i--) {
+		const size_t j = (size_t)rand() % (i + 1);
+		struct item *const temp = item[i];
+		item[i] = item[j], item[j] = temp;
+	}
+	for(i = live; i < size; i++) if(!item_pool_remove(pool, item[i])) return 0;
+	qsort(item, live, sizeof *item, &made);
+	return 1;
+}
+
+int main(void) {
+	const char *const name = "bitmap";
+	const size_t size = 1000000, replicas = 5, passes = 10;
+	const double fractions[] = { 1.0, 0.5, 0.2, 0.1, 0.05, 0.02, 0.01, 0.005,
+		0.002, 0.001 };
+	struct item_pool pool = item_pool();
+	struct item **item = 0;
+	struct measure mb, ma;
+	size_t f, i, p, live, sum;
+	clock_t t;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!(item = malloc(sizeof *item * size))) goto catch;
+	if(!(fp = fopen("graph/bitmap.tsv", "w"))) goto catch;
+	fprintf(fp, "# go over the live of %lu items\n# <live fraction>"
+		"\t<bitmap (ns)>\t<sd>\t<array (ns)>\t<sd>\n", (unsigned long)size);
+	for(f = 0; f < sizeof fractions / sizeof *fractions; f++) {
+		live = (size_t)(fractions[f] * (double)size);
+		m_reset(&mb), m_reset(&ma);
+		for(i = 0; i < replicas; i++) {
+			struct item_pool_cursor cur;
+			if(!fill(&pool, item, size, live)) goto catch;
+			t = clock();
+			for(p = 0; p < passes; p++) {
+				for(sum = 0, cur = item_pool_begin(&pool);
+					item_pool_exists(&cur); item_pool_next(&cur))
+					sum += item_pool_entry(&cur)->a[0];
+				sink += sum;
+			}
+			m_add(&mb, 1000000.0 * diff_ms(t) / (double)(passes * live));
+			t = clock();
+			for(p = 0; p < passes; p++) {
+				size_t j;
+				for(sum = 0, j = 0; j < live; j++) sum += item[j]->a[0];
+				sink += sum;
+			}
+			m_add(&ma, 1000000.0 * diff_ms(t) / (double)(passes * live));
+			item_pool_(&pool);
+		}
+		printf("%.3f live: bitmap %.2f ns, array %.2f ns per item.\n",
+			fractions[f], m_mean(&mb), m_mean(&ma));
+		fprintf(fp, "%f\t%f\t%f\t%f\t%f\n", fractions[f],
+			m_mean(&mb), m_stddev(&mb), m_mean(&ma), m_stddev(&ma));
+	}
+	if(!(gnu = fopen("graph/bitmap.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"fraction live\"\n"
+		"set ylabel \"time per live item, t (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"bitmap\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"array\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	item_pool_(&pool);
+	free(item);
+	return ret;
+}
@@ -0,0 +1,140 @@
+/* Steady-state churn in a pool: with a number of live items, remove a quarter
+ at random and allocate them again. The default free-heap against the free-list.
+ Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+struct item { size_t a[4]; };
+#define POOL_NAME heap
+#define POOL_TYPE struct item
+#include "../../../../src/pool.h"
+#define POOL_NAME list
+#define POOL_TYPE struct item
+#define POOL_FREE_LIST
+#include "../../../../src/pool.h"
+
+#include <time.h>
+/** Returns a processor-time difference in milliseconds from `then`. */
+static double diff_ms(const clock_t then)
+	{ return (double)(clock() - then) / (CLOCKS_PER_SEC / 1000.0); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+#define CHURN 4000000
+
+/* A linear congruential generator is cheaper than `rand`. */
+static unsigned long lcg_state;
+static size_t lcg(const size_t n) {
+	lcg_state = lcg_state * 6364136223846793005ul + 1442695040888963407ul;
+	return (size_t)(lcg_state >> 33) % n;
+}
+
+/* Both are the same but for the type. */
+#define CHURN_FN(name) \
+/** Fills `pool` to `live` in `item`, then churns it: a quarter are removed \
+ at random and then allocated again. @return The slabs at the end, or zero \
+ on error. */ \
+static size_t name##_churn(struct name##_pool *const pool, \
+	struct item **const item, const size_t live) { \
+	const size_t batch = live / 4 ? live / 4 : 1; \
+	size_t i, j, slabs; \
+	for(i = 0; i < live; i++) \
+		if(!(item[i] = name##_pool_new(pool))) return 0; \
+	for(i = 0; i < CHURN; i += batch) { \
+		/* Move the victims to the end. */ \
+		for(j = 0; j < batch; j++) { \
+			struct item **const x = item + lcg(live - j), \
+				**const end = item + live - j - 1, *const temp = *x; \
+			if(!name##_pool_remove(pool, temp)) return 0; \
+			*x = *end, *end = temp; \
+		} \
+		for(j = live - batch; j < live; j++) { \
+			if(!(item[j] = name##_pool_new(pool))) return 0; \
+			item[j]->a[0] = i; \
+		} \
+	} \
+	slabs = pool->slots.size; \
+	name##_pool_(pool); \
+	return slabs; \
+}
+CHURN_FN(heap)
+CHURN_FN(list)
+
+int main(void) {
+	const char *const name = "free_list";
+	const size_t replicas = 5;
+	struct heap_pool heap = heap_pool();
+	struct list_pool list = list_pool();
+	struct item **item = 0;
+	struct measure mh, ml;
+	size_t live, i, heap_slabs = 0, list_slabs = 0;
+	unsigned long seed;
+	clock_t t;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!(fp = fopen("graph/free_list.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu churn, remove a quarter at random and allocate\n"
+		"# <live>\t<heap (ms)>\t<sd>\t<slabs>\t<list (ms)>\t<sd>\t<slabs>\n",
+		(unsigned long)CHURN);
+	for(live = 100; live <= 1000000; live *= 10) {
+		if(!(item = realloc(item, sizeof *item * live))) goto catch;
+		m_reset(&mh), m_reset(&ml);
+		for(i = 0; i < replicas; i++) {
+			seed = (unsigned long)rand();
+			lcg_state = seed, t = clock();
+			if(!(heap_slabs = heap_churn(&heap, item, live))) goto catch;
+			m_add(&mh, diff_ms(t));
+			lcg_state = seed, t = clock();
+			if(!(list_slabs = list_churn(&list, item, live))) goto catch;
+			m_add(&ml, diff_ms(t));
+		}
+		printf("%lu live: heap %.1f ms, %lu slabs; list %.1f ms, %lu slabs.\n",
+			(unsigned long)live, m_mean(&mh), (unsigned long)heap_slabs,
+			m_mean(&ml), (unsigned long)list_slabs);
+		fprintf(fp, "%lu\t%f\t%f\t%lu\t%f\t%f\t%lu\n", (unsigned long)live,
+			m_mean(&mh), m_stddev(&mh), (unsigned long)heap_slabs,
+			m_mean(&ml), m_stddev(&ml), (unsigned long)list_slabs);
+	}
+	if(!(gnu = fopen("graph/free_list.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"live items\"\n"
+		"set ylabel \"time for %lu churn, t (ms)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"free-heap\", \\\n"
+		"\"graph/%s.tsv\" using 1:5:6 with errorlines title \"free-list\"\n",
+		name, (unsigned long)CHURN, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	heap_pool_(&heap), list_pool_(&list);
+	free(item);
+	return ret;
+}
@@ -0,0 +1,193 @@
+/* Alloc-free pairs per millisecond with the number of threads: the pool behind
+ one mutex, magazines in front of a shared depot, and `malloc`. Each thread
+ keeps a window of live items, and frees the oldest to allocate. Run from this
+ directory. */
+
+#define _POSIX_C_SOURCE 200112L /* `clock_gettime`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+struct item { size_t a[4]; };
+#define POOL_NAME item
+#define POOL_TYPE struct item
+#define POOL_MAGAZINE
+#include "../../../../src/pool.h"
+
+#include <time.h>
+/** Returns a wall-clock difference in milliseconds from `then`; `clock` is
+ processor time, which would count every thread. */
+static double diff_ms(const struct timespec *const then) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 1000.0 * (double)(now.tv_sec - then->tv_sec)
+		+ (double)(now.tv_nsec - then->tv_nsec) / 1000000.0;
+}
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+#define WINDOW 256
+#define PAIRS 2000000
+
+#define ALLOCATOR(X) X(LOCKED, "pool with mutex"), X(MAGAZINE, "magazines"), \
+	X(MALLOC, "malloc")
+#define PARAM(A, B) A
+#define STRINGISE(A, B) B
+enum allocator { ALLOCATOR(PARAM) };
+static const char *const allocator_name[] = { ALLOCATOR(STRINGISE) };
+
+/* Shared between the threads. */
+struct shared { struct item_pool_depot depot; enum allocator allocator; };
+/* The work of one thread. */
+struct work {
+	struct shared *shared;
+	struct item *window[WINDOW];
+	int error;
+	pthread_t thread;
+};
+
+/** Allocates one with the allocator of `s`. */
+static struct item *work_new(struct shared *const s,
+	struct item_pool_magazine *const m) {
+	struct item *item = 0;
+	switch(s->allocator) {
+	case LOCKED:
+		pthread_mutex_lock(&s->depot.lock);
+		item = item_pool_new(&s->depot.pool);
+		pthread_mutex_unlock(&s->depot.lock);
+		break;
+	case MAGAZINE: item = item_pool_magazine_new(m); break;
+	case MALLOC: item = malloc(sizeof *item); break;
+	}
+	if(item) item->a[0] = 1;
+	return item;
+}
+/** Frees `item` with the allocator of `s`. */
+static int work_remove(struct shared *const s,
+	struct item_pool_magazine *const m, struct item *const item) {
+	int success = 1;
+	switch(s->allocator) {
+	case LOCKED:
+		pthread_mutex_lock(&s->depot.lock);
+		success = item_pool_remove(&s->depot.pool, item);
+		pthread_mutex_unlock(&s->depot.lock);
+		break;
+	case MAGAZINE: success = item_pool_magazine_remove(m, item); break;
+	case MALLOC: free(item); break;
+	}
+	return success;
+}
+
+/** Frees the oldest and allocates a new one, `PAIRS` times. Thread entry
+ point. */
+static void *work(void *const param) {
+	struct work *const w = param;
+	struct item_pool_magazine m = item_pool_magazine(&w->shared->depot);
+	size_t i;
+	for(i = 0; i < WINDOW; i++)
+		if(!(w->window[i] = work_new(w->shared, &m))) goto catch;
+	for(i = 0; i < PAIRS; i++) {
+		struct item **const slot = w->window + i % WINDOW;
+		if(!work_remove(w->shared, &m, *slot)
+			|| !(*slot = work_new(w->shared, &m))) goto catch;
+	}
+	for(i = 0; i < WINDOW; i++)
+		if(!work_remove(w->shared, &m, w->window[i])) goto catch;
+	item_pool_magazine_(&m);
+	return 0;
+catch:
+	w->error = errno ? errno : ERANGE;
+	item_pool_magazine_(&m);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	const char *const name = "magazine";
+	const size_t replicas = 5;
+	const unsigned max_threads = argc > 1 ? (unsigned)atoi(argv[1]) : 8;
+	struct shared s;
+	struct work *w = 0;
+	struct measure m;
+	unsigned threads, t, started;
+	size_t i;
+	struct timespec clock;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE, is_depot = 0, error;
+	errno = 0;
+	if(!(w = malloc(sizeof *w * max_threads))) goto catch;
+	if(!item_pool_depot(&s.depot)) goto catch;
+	is_depot = 1;
+	if(!(fp = fopen("graph/magazine.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu pairs per thread, a window of %lu\n"
+		"# <threads>", (unsigned long)PAIRS, (unsigned long)WINDOW);
+	for(s.allocator = 0; s.allocator <= MALLOC; s.allocator++)
+		fprintf(fp, "\t<%s (1/ms)>\t<sd>", allocator_name[s.allocator]);
+	fprintf(fp, "\n");
+	for(threads = 1; threads <= max_threads; threads *= 2) {
+		fprintf(fp, "%u", threads);
+		for(s.allocator = 0; s.allocator <= MALLOC; s.allocator++) {
+			m_reset(&m);
+			for(i = 0; i < replicas; i++) {
+				clock_gettime(CLOCK_MONOTONIC, &clock);
+				for(started = 0; started < threads; started++) {
+					w[started].shared = &s, w[started].error = 0;
+					if(pthread_create(&w[started].thread, 0, &work,
+						w + started)) break;
+				}
+				for(error = 0, t = 0; t < started; t++) {
+					pthread_join(w[t].thread, 0);
+					if(w[t].error) error = w[t].error;
+				}
+				if(started < threads) error = EAGAIN;
+				if(error) { errno = error; goto catch; }
+				m_add(&m, (double)PAIRS * threads / diff_ms(&clock));
+			}
+			printf("%u threads, %s: %.0f pairs/ms.\n", threads,
+				allocator_name[s.allocator], m_mean(&m));
+			fprintf(fp, "\t%f\t%f", m_mean(&m), m_stddev(&m));
+		}
+		fprintf(fp, "\n");
+	}
+	if(!(gnu = fopen("graph/magazine.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x 2\n"
+		"set xlabel \"threads\"\n"
+		"set ylabel \"alloc-free pairs (1/ms)\"\n"
+		"plot", name);
+	for(s.allocator = 0; s.allocator <= MALLOC; s.allocator++)
+		fprintf(gnu, "%s \"graph/%s.tsv\" using 1:%u:%u with errorlines"
+		" title \"%s\"", s.allocator ? "," : "", name, 2 * s.allocator + 2,
+		2 * s.allocator + 3, allocator_name[s.allocator]);
+	fprintf(gnu, "\n");
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	if(is_depot) item_pool_depot_(&s.depot);
+	free(w);
+	return ret;
+}
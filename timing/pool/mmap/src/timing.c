@@ -0,0 +1,190 @@
+/* Resident memory over time, of the default pool against one that maps its
+ slabs and gives back the pages with nothing live on them. The pool grows to
+ `items`, then shrinks to a tenth; the items die in runs of those that were
+ allocated together, in random order of runs. Each is in a child process, so
+ it starts fresh. Run from this directory. */
+
+#define _DEFAULT_SOURCE /* `fork`, `mmap`, `madvise`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+struct item { size_t a[8]; };
+#define POOL_NAME heap
+#define POOL_TYPE struct item
+#include "../../../../src/pool.h"
+#define POOL_NAME mapped
+#define POOL_TYPE struct item
+#define POOL_MMAP
+#include "../../../../src/pool.h"
+
+#include <time.h>
+/** Returns a processor-time difference in milliseconds from `then`. */
+static double diff_ms(const clock_t then)
+	{ return (double)(clock() - then) / (CLOCKS_PER_SEC / 1000.0); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+#define STEPS 20 /* Each of growing and shrinking. */
+static const size_t items = 1 << 20, run = 64;
+
+/** @return The resident memory in bytes right now, or zero. */
+static size_t resident(void) {
+	FILE *fp = fopen("/proc/self/statm", "r");
+	unsigned long size, pages = 0;
+	if(!fp) return 0;
+	if(fscanf(fp, "%lu %lu", &size, &pages) != 2) pages = 0;
+	fclose(fp);
+	return (size_t)pages * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/** The results of a child. */
+struct sample { size_t live[2 * STEPS + 1], rss[2 * STEPS + 1]; double ms; };
+
+/** Shuffles the runs of `item` that are `run` long. */
+static void shuffle(struct item **const item) {
+	const size_t runs = items / run;
+	size_t i, j;
+	for(i = runs - 1; i; i--) {
+		const size_t r = (size_t)rand() % (i + 1);
+		for(j = 0; j < run; j++) {
+			struct item *const temp = item[i * run + j];
+			item[i * run + j] = item[r * run + j], item[r * run + j] = temp;
+		}
+	}
+}
+
+/* Both are the same but for the type. */
+#define WORK_FN(name) \
+/** Grows and shrinks a pool, with `item` as scratch, into `s`. \
+ @return Success. */ \
+static int name##_work(struct item **const item, struct sample *const s) { \
+	struct name##_pool pool = name##_pool(); \
+	const size_t before = resident(), step = items / STEPS, \
+		drop = (items - items / 10) / STEPS; \
+	size_t i, j, k = 0, size = 0; \
+	clock_t t = clock(); \
+	int success = 0; \
+	s->live[k] = 0, s->rss[k++] = 0; \
+	for(i = 0; i < STEPS; i++) { \
+		for(j = 0; j < step; j++) { \
+			if(!(item[size] = name##_pool_new(&pool))) goto finally; \
+			item[size]->a[0] = size, size++; \
+		} \
+		s->live[k] = size, s->rss[k++] = resident() - before; \
+	} \
+	shuffle(item); \
+	for(i = 0; i < STEPS; i++) { \
+		for(j = 0; j < drop; j++) \
+			if(!name##_pool_remove(&pool, item[--size])) goto finally; \
+		s->live[k] = size, s->rss[k++] = resident() - before; \
+	} \
+	s->ms = diff_ms(t); \
+	success = 1; \
+finally: \
+	name##_pool_(&pool); \
+	return success; \
+}
+WORK_FN(heap)
+WORK_FN(mapped)
+
+/** Runs `is_mapped` in a child process into `s`. @return Success. */
+static int child(const int is_mapped, struct item **const item,
+	struct sample *const s) {
+	int fd[2], status, success = 0;
+	pid_t pid;
+	if(pipe(fd) == -1) return 0;
+	if((pid = fork()) == -1) { close(fd[0]), close(fd[1]); return 0; }
+	if(!pid) { /* Child. */
+		close(fd[0]);
+		if(!(is_mapped ? mapped_work(item, s) : heap_work(item, s))
+			|| write(fd[1], s, sizeof *s) != sizeof *s) _exit(EXIT_FAILURE);
+		_exit(EXIT_SUCCESS);
+	}
+	close(fd[1]);
+	if(read(fd[0], s, sizeof *s) == sizeof *s) success = 1;
+	close(fd[0]);
+	waitpid(pid, &status, 0);
+	return success && WIFEXITED(status) && !WEXITSTATUS(status);
+}
+
+int main(void) {
+	const char *const name = "mmap";
+	const size_t replicas = 5;
+	struct item **item = 0;
+	struct sample s;
+	struct measure rss[2][2 * STEPS + 1], ms[2];
+	size_t live[2 * STEPS + 1], i, k;
+	int e;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!(item = malloc(sizeof *item * items))) goto catch;
+	/* Touch it before forking, so it is not counted. */
+	memset(item, 0, sizeof *item * items);
+	for(e = 0; e < 2; e++) {
+		m_reset(ms + e);
+		for(k = 0; k <= 2 * STEPS; k++) m_reset(rss[e] + k);
+	}
+	for(i = 0; i < replicas; i++) for(e = 0; e < 2; e++) {
+		if(!child(e, item, &s)) goto catch;
+		m_add(ms + e, s.ms);
+		for(k = 0; k <= 2 * STEPS; k++)
+			live[k] = s.live[k], m_add(rss[e] + k, s.rss[k] / 1e6);
+	}
+	printf("%lu items of %lu bytes: heap %.1f ms, mapped %.1f ms.\n",
+		(unsigned long)items, (unsigned long)sizeof(struct item),
+		m_mean(ms + 0), m_mean(ms + 1));
+	printf("At a tenth: heap %.1f MB, mapped %.1f MB resident.\n",
+		m_mean(rss[0] + 2 * STEPS), m_mean(rss[1] + 2 * STEPS));
+	if(!(fp = fopen("graph/mmap.tsv", "w"))) goto catch;
+	fprintf(fp, "# grow to %lu, then shrink to a tenth in runs of %lu\n"
+		"# <step>\t<live>\t<heap (MB)>\t<sd>\t<mapped (MB)>\t<sd>\n",
+		(unsigned long)items, (unsigned long)run);
+	for(k = 0; k <= 2 * STEPS; k++) fprintf(fp, "%lu\t%lu\t%f\t%f\t%f\t%f\n",
+		(unsigned long)k, (unsigned long)live[k], m_mean(rss[0] + k),
+		m_stddev(rss[0] + k), m_mean(rss[1] + k), m_stddev(rss[1] + k));
+	if(!(gnu = fopen("graph/mmap.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set xlabel \"step\"\n"
+		"set ylabel \"resident (MB)\"\n"
+		"set y2label \"live items\"\n"
+		"set y2tics\n"
+		"plot \"graph/%s.tsv\" using 1:3:4 with errorlines title \"heap\", \\\n"
+		"\"graph/%s.tsv\" using 1:5:6 with errorlines title \"mapped\", \\\n"
+		"\"graph/%s.tsv\" using 1:2 axes x1y2 with lines title \"live\"\n",
+		name, name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	free(item);
+	return ret;
+}
@@ -0,0 +1,157 @@
+/* Union, intersection, and difference of two sets of the same size, half of
+ the keys shared: merged with cursors into bulk-loading, against iterating one
+ and looking up or adding every key in the other. Run from this directory. */
+
+#define _POSIX_C_SOURCE 200112L /* `clock_gettime`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+static int set_less(const unsigned a, const unsigned b) { return a > b; }
+#define TREE_NAME set
+#define TREE_KEY unsigned
+#define TREE_PARALLEL
+#include "../../../../src/tree.h"
+
+#include <time.h>
+/** Returns a wall-clock difference in milliseconds from `then`; `clock` is
+ processor time, which would count every thread. */
+static double diff_ms(const struct timespec *const then) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 1000.0 * (double)(now.tv_sec - then->tv_sec)
+		+ (double)(now.tv_nsec - then->tv_nsec) / 1000000.0;
+}
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The way it was done before: a full descent for every key. */
+static int per_key(struct set_tree *const result, const struct set_tree *const a,
+	const struct set_tree *const b, const unsigned op) {
+	struct set_tree_cursor cur;
+	set_tree_clear(result);
+	if(op == 0 && !set_tree_clone(result, a)) return 0;
+	for(cur = set_tree_begin(op == 0 ? b : a); set_tree_exists(&cur);
+		set_tree_next(&cur)) {
+		const unsigned x = set_tree_key(&cur);
+		if((op == 0 || (op == 1) == set_tree_contains(b, x))
+			&& !set_tree_add(result, x)) return 0;
+	}
+	return 1;
+}
+
+static int merge(struct set_tree *const result, const struct set_tree *const a,
+	const struct set_tree *const b, const unsigned op) {
+	switch(op) {
+	case 0: return set_tree_union(result, a, b);
+	case 1: return set_tree_intersection(result, a, b);
+	default: return set_tree_difference(result, a, b);
+	}
+}
+
+static unsigned threads = 4;
+static int parallel(struct set_tree *const result,
+	const struct set_tree *const a, const struct set_tree *const b,
+	const unsigned op) {
+	switch(op) {
+	case 0: return set_tree_parallel_union(result, a, b, threads);
+	case 1: return set_tree_parallel_intersection(result, a, b, threads);
+	default: return set_tree_parallel_difference(result, a, b, threads);
+	}
+}
+
+#define EXPS X(PER_KEY, per_key), X(MERGE, merge), X(PARALLEL, parallel)
+
+int main(int argc, char **argv) {
+	typedef int (*exp_fn)(struct set_tree *, const struct set_tree *,
+		const struct set_tree *, unsigned);
+	const char *const name = "algebra", *const op_names[]
+		= { "union", "intersection", "difference" };
+	const size_t replicas = 5;
+#define X(n, m) #n
+	const char *const exp_names[] = { EXPS };
+#undef X
+#define X(n, m) &m
+	const exp_fn exp[] = { EXPS };
+#undef X
+	const size_t exp_size = sizeof exp / sizeof *exp;
+	size_t sizes[] = { 1000, 10000, 100000, 1000000 }, s, e, r, i;
+	struct set_tree a = set_tree(), b = set_tree(), result = set_tree();
+	unsigned op;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(argc > 1) threads = (unsigned)atoi(argv[1]);
+	if(!(fp = fopen("graph/algebra.tsv", "w"))) goto catch;
+	fprintf(fp, "# %u threads\n# <keys>", threads);
+	for(op = 0; op < 3; op++) for(e = 0; e < exp_size; e++)
+		fprintf(fp, "\t<%s %s (ns/key)>\t<sd>", exp_names[e], op_names[op]);
+	fprintf(fp, "\n");
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s];
+		/* Every third number is in `a`, every second in `b`. */
+		set_tree_clear(&a), set_tree_clear(&b);
+		for(i = 0; i < n; i++) if(!set_tree_bulk_add(&a, (unsigned)i * 3)
+			|| !set_tree_bulk_add(&b, (unsigned)i * 2)) goto catch;
+		set_tree_bulk_finish(&a), set_tree_bulk_finish(&b);
+		fprintf(fp, "%lu", (unsigned long)n);
+		for(op = 0; op < 3; op++) {
+			size_t expect = 0;
+			for(e = 0; e < exp_size; e++) {
+				struct measure m;
+				m_reset(&m);
+				for(r = 0; r < replicas; r++) {
+					struct timespec t;
+					clock_gettime(CLOCK_MONOTONIC, &t);
+					if(!exp[e](&result, &a, &b, op)) goto catch;
+					m_add(&m, 1000000.0 * diff_ms(&t) / (double)(2 * n));
+					if(!e && !r) expect = set_tree_count(&result);
+					else if(set_tree_count(&result) != expect)
+						{ errno = EDOM; goto catch; }
+				}
+				printf("%lu keys: %s %s %.1f ns/key.\n", (unsigned long)n,
+					exp_names[e], op_names[op], m_mean(&m));
+				fprintf(fp, "\t%f\t%f", m_mean(&m), m_stddev(&m));
+			}
+		}
+		fprintf(fp, "\n");
+	}
+	if(!(gnu = fopen("graph/algebra.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"keys in each\"\n"
+		"set ylabel \"intersection, t (ns/key)\"\n"
+		"plot \"graph/%s.tsv\" using 1:8:9 with errorlines title \"per-key\", \\\n"
+		"\"graph/%s.tsv\" using 1:10:11 with errorlines title \"merge\", \\\n"
+		"\"graph/%s.tsv\" using 1:12:13 with errorlines title \"parallel\"\n",
+		name, name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	set_tree_(&a), set_tree_(&b), set_tree_(&result);
+	return ret;
+}
@@ -0,0 +1,194 @@
+/* Compares queries on reservations, intervals of time with a weight, in an
+ augmented tree to scanning an array. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+/** The horizon of the start times. */
+#define HORIZON 1000000u
+
+struct interval { unsigned start, end; };
+struct reservation { struct interval i; unsigned weight; };
+struct span_summary { unsigned end; unsigned long weight; };
+static int span_less(const struct interval a, const struct interval b)
+	{ return a.start > b.start || a.start == b.start && a.end > b.end; }
+static void span_identity(struct span_summary *const s)
+	{ s->end = 0, s->weight = 0; }
+static void span_augment(struct span_summary *const s,
+	const struct interval k, const unsigned *const v)
+	{ if(k.end > s->end) s->end = k.end; s->weight += *v; }
+static void span_merge(struct span_summary *const s,
+	const struct span_summary *const t)
+	{ if(t->end > s->end) s->end = t->end; s->weight += t->weight; }
+#define TREE_NAME span
+#define TREE_KEY struct interval
+#define TREE_VALUE unsigned
+#define TREE_AUGMENT struct span_summary
+#include "../../../../src/tree.h"
+
+/** Whether the maximum end is at least the start of the query, `param`. */
+static int span_keep(const struct span_summary *const s, void *const param)
+	{ return s->end >= ((const struct interval *)param)->start; }
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+static unsigned rnd(const unsigned n)
+	{ return (unsigned)(((double)rand() * RAND_MAX + rand())
+	/ ((double)RAND_MAX * RAND_MAX + RAND_MAX + 1) * n); }
+static void fill(struct reservation *const r) {
+	r->i.start = rnd(HORIZON);
+	r->i.end = r->i.start + rnd(HORIZON / 1000);
+	r->weight = rnd(100);
+}
+
+#define EXPS X(SCAN), X(TREE)
+
+/** Queries `q` overlap and range sum with `no` queries on `n` reservations. */
+static int experiment(const size_t n, const size_t no,
+	double *const overlap, double *const sum) {
+	struct reservation *const a = malloc(sizeof *a * n);
+	struct span_tree tree = span_tree();
+	struct interval *const q = malloc(sizeof *q * no);
+	size_t i, j, check[2] = { 0, 0 };
+	unsigned long check_sum[2] = { 0, 0 };
+	clock_t t;
+	int success = 0;
+	if(!a || !q) goto catch;
+	for(i = 0; i < n; i++) {
+		unsigned *v;
+		fill(a + i);
+		if(!span_tree_assign(&tree, a[i].i, &v)) goto catch;
+		*v = a[i].weight; /* Duplicates are unlikely, and only the first. */
+	}
+	for(j = 0; j < no; j++)
+		q[j].start = rnd(HORIZON), q[j].end = q[j].start + rnd(HORIZON / 100);
+	span_tree_summary(&tree); /* Not timing the summary construction. */
+
+	/* Overlap. */
+	t = clock();
+	for(j = 0; j < no; j++) for(i = 0; i < n; i++)
+		if(a[i].i.start <= q[j].end && a[i].i.end >= q[j].start) check[0]++;
+	overlap[0] = diff_us(t) / no;
+	t = clock();
+	for(j = 0; j < no; j++) {
+		struct interval hi;
+		hi.start = q[j].end, hi.end = UINT_MAX;
+		check[1] += span_tree_overlap(&tree, hi, &span_keep, 0, q + j);
+	}
+	overlap[1] = diff_us(t) / no;
+
+	/* Sum of weight with start in the range. */
+	t = clock();
+	for(j = 0; j < no; j++) for(i = 0; i < n; i++)
+		if(q[j].start <= a[i].i.start && a[i].i.start <= q[j].end)
+		check_sum[0] += a[i].weight;
+	sum[0] = diff_us(t) / no;
+	t = clock();
+	for(j = 0; j < no; j++) {
+		struct interval lo, hi;
+		struct span_summary s;
+		lo.start = q[j].start, lo.end = 0;
+		hi.start = q[j].end, hi.end = UINT_MAX;
+		span_tree_summarize(&tree, lo, hi, &s);
+		check_sum[1] += s.weight;
+	}
+	sum[1] = diff_us(t) / no;
+
+	/* With duplicates, the scan might have more. */
+	if(check[0] < check[1] || check_sum[0] < check_sum[1])
+		{ fprintf(stderr, "Mismatch.\n"); errno = EDOM; goto catch; }
+	success = 1;
+	goto finally;
+catch:
+	perror("experiment");
+finally:
+	span_tree_(&tree);
+	free(a), free(q);
+	return success;
+}
+
+int main(void) {
+	const char *const name = "augment";
+	const size_t replicas = 5;
+#define X(n) #n
+	const char *const exp_names[] = { EXPS };
+#undef X
+	const size_t exp_size = sizeof exp_names / sizeof *exp_names;
+	const size_t sizes[] = { 1000, 10000, 100000, 1000000 };
+	size_t s, e, r;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(!(fp = fopen("graph/augment.tsv", "w"))) goto catch;
+	fprintf(fp, "# <reservations>");
+	for(e = 0; e < exp_size; e++)
+		fprintf(fp, "\t<%s overlap (us)>\t<sd>\t<%s sum (us)>\t<sd>",
+		exp_names[e], exp_names[e]);
+	fprintf(fp, "\n");
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s], no = 10000000 / n + 10;
+		struct measure overlap[2], sum[2];
+		for(e = 0; e < exp_size; e++) m_reset(overlap + e), m_reset(sum + e);
+		for(r = 0; r < replicas; r++) {
+			double o[2], m[2];
+			if(!experiment(n, no, o, m)) goto catch;
+			for(e = 0; e < exp_size; e++)
+				m_add(overlap + e, o[e]), m_add(sum + e, m[e]);
+		}
+		fprintf(fp, "%lu", (unsigned long)n);
+		for(e = 0; e < exp_size; e++) {
+			printf("%s %lu reservations: overlap %.3f us, sum %.3f us.\n",
+				exp_names[e], (unsigned long)n,
+				m_mean(overlap + e), m_mean(sum + e));
+			fprintf(fp, "\t%f\t%f\t%f\t%f", m_mean(overlap + e),
+				m_stddev(overlap + e), m_mean(sum + e), m_stddev(sum + e));
+		}
+		fprintf(fp, "\n");
+	}
+	if(!(gnu = fopen("graph/augment.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set logscale y\n"
+		"set xlabel \"reservations\"\n"
+		"set ylabel \"query, t (us)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"scan overlap\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"scan sum\", \\\n"
+		"\"graph/%s.tsv\" using 1:6:7 with errorlines title \"tree overlap\", \\\n"
+		"\"graph/%s.tsv\" using 1:8:9 with errorlines title \"tree sum\"\n",
+		name, name, name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	return ret;
+}
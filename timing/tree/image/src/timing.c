@@ -0,0 +1,188 @@
+/* Cold start of a saved map: rebuilding a tree from a flat file of entries
+ against mapping an image of the tree and reading it in-place. Run from this
+ directory; it writes scratch files in `graph`. */
+
+#define _POSIX_C_SOURCE 200112L /* `clock_gettime`, `mmap`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+static int map_less(const unsigned a, const unsigned b) { return a > b; }
+#define TREE_NAME map
+#define TREE_KEY unsigned
+#define TREE_VALUE unsigned
+#define TREE_IMAGE
+#include "../../../../src/tree.h"
+
+#include <time.h>
+/** Returns a wall-clock difference in milliseconds from `then`; the start-up
+ of a mapping is mostly waiting, which `clock` would not see. */
+static double diff_ms(const struct timespec *const then) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 1000.0 * (double)(now.tv_sec - then->tv_sec)
+		+ (double)(now.tv_nsec - then->tv_nsec) / 1000000.0;
+}
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+static const char *const flat_fn = "graph/image-flat.bin",
+	*const image_fn = "graph/image-tree.bin";
+/** Number of lookups after start-up. */
+static const size_t looks = 1000;
+
+/** Writes `n` entries, every third key, as a flat file and as an image. */
+static int write_files(const size_t n) {
+	struct map_tree tree = map_tree();
+	FILE *fp = 0;
+	unsigned e[2], *v;
+	size_t i;
+	int success = 0;
+	if(!(fp = fopen(flat_fn, "wb"))) goto finally;
+	for(i = 0; i < n; i++) {
+		e[0] = (unsigned)i * 3, e[1] = (unsigned)i;
+		if(fwrite(e, sizeof e, 1, fp) != 1
+			|| map_tree_bulk_assign(&tree, e[0], &v) == TREE_ERROR) goto finally;
+		*v = e[1];
+	}
+	map_tree_bulk_finish(&tree);
+	if(fclose(fp) == EOF) { fp = 0; goto finally; }
+	if(!(fp = fopen(image_fn, "wb")) || !map_tree_image_save(&tree, fp))
+		goto finally;
+	success = 1;
+finally:
+	if(fp) fclose(fp);
+	map_tree_(&tree);
+	return success;
+}
+
+/** Reads the flat file and rebuilds the tree, then looks up. */
+static int exp_rebuild(const size_t n, double *const start, double *const look)
+{
+	struct map_tree tree = map_tree();
+	struct timespec t;
+	FILE *fp;
+	unsigned e[2], *v;
+	size_t i, sum = 0;
+	int success = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	if(!(fp = fopen(flat_fn, "rb"))) return 0;
+	while(fread(e, sizeof e, 1, fp) == 1) {
+		if(map_tree_bulk_assign(&tree, e[0], &v) == TREE_ERROR) goto finally;
+		*v = e[1];
+	}
+	if(ferror(fp)) goto finally;
+	map_tree_bulk_finish(&tree);
+	*start = diff_ms(&t);
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for(i = 0; i < looks; i++)
+		sum += map_tree_get_or(&tree, (unsigned)(rand() % (n * 3)), 0);
+	*look = diff_ms(&t);
+	success = sum != (size_t)-1;
+finally:
+	fclose(fp);
+	map_tree_(&tree);
+	return success;
+}
+
+/** Maps the image and reads it in-place, then looks up. */
+static int exp_image(const size_t n, double *const start, double *const look)
+{
+	struct map_tree_image image;
+	struct timespec t;
+	struct stat st;
+	void *data = MAP_FAILED;
+	size_t i, sum = 0;
+	int fd, success = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	if((fd = open(image_fn, O_RDONLY)) == -1) return 0;
+	if(fstat(fd, &st) == -1 || (data = mmap(0, (size_t)st.st_size, PROT_READ,
+		MAP_PRIVATE, fd, 0)) == MAP_FAILED
+		|| !map_tree_image(&image, data, (size_t)st.st_size)) goto finally;
+	*start = diff_ms(&t);
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for(i = 0; i < looks; i++) sum
+		+= map_tree_image_get_or(&image, (unsigned)(rand() % (n * 3)), 0);
+	*look = diff_ms(&t);
+	success = sum != (size_t)-1;
+finally:
+	if(data != MAP_FAILED) munmap(data, (size_t)st.st_size);
+	close(fd);
+	return success;
+}
+
+int main(void) {
+	const char *const name = "image";
+	const size_t replicas = 5;
+	size_t sizes[] = { 1000, 10000, 100000, 1000000, 10000000 }, s, r;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(!(fp = fopen("graph/image.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu lookups\n# <entries>\t<rebuild start (ms)>\t<sd>"
+		"\t<rebuild look (ms)>\t<sd>\t<image start (ms)>\t<sd>"
+		"\t<image look (ms)>\t<sd>\n", (unsigned long)looks);
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s];
+		struct measure start[2], look[2];
+		unsigned e;
+		if(!write_files(n)) goto catch;
+		for(e = 0; e < 2; e++) m_reset(start + e), m_reset(look + e);
+		for(r = 0; r < replicas; r++) {
+			double a, l;
+			if(!exp_rebuild(n, &a, &l)) goto catch;
+			m_add(start + 0, a), m_add(look + 0, l);
+			if(!exp_image(n, &a, &l)) goto catch;
+			m_add(start + 1, a), m_add(look + 1, l);
+		}
+		printf("%lu entries: rebuild %.3f ms + %.3f ms, image %.3f ms + %.3f ms.\n",
+			(unsigned long)n, m_mean(start + 0), m_mean(look + 0),
+			m_mean(start + 1), m_mean(look + 1));
+		fprintf(fp, "%lu", (unsigned long)n);
+		for(e = 0; e < 2; e++) fprintf(fp, "\t%f\t%f\t%f\t%f",
+			m_mean(start + e), m_stddev(start + e),
+			m_mean(look + e), m_stddev(look + e));
+		fprintf(fp, "\n");
+	}
+	remove(flat_fn), remove(image_fn);
+	if(!(gnu = fopen("graph/image.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale xy\n"
+		"set xlabel \"entries\"\n"
+		"set ylabel \"start-up, t (ms)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"rebuild\", \\\n"
+		"\"graph/%s.tsv\" using 1:6:7 with errorlines title \"image\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	return ret;
+}
@@ -0,0 +1,100 @@
+/* Scaling of cloning and clearing a big tree with the number of threads. Run
+ from this directory. */
+
+#define _POSIX_C_SOURCE 200112L /* `clock_gettime`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+static int big_less(const unsigned a, const unsigned b) { return a > b; }
+#define TREE_NAME big
+#define TREE_KEY unsigned
+#define TREE_PARALLEL
+#include "../../../../src/tree.h"
+
+#include <time.h>
+/** Returns a wall-clock difference in milliseconds from `then`; `clock` is
+ processor time, which would count every thread. */
+static double diff_ms(const struct timespec *const then) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 1000.0 * (double)(now.tv_sec - then->tv_sec)
+		+ (double)(now.tv_nsec - then->tv_nsec) / 1000000.0;
+}
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+int main(int argc, char **argv) {
+	const char *const name = "parallel";
+	const size_t replicas = 5;
+	const unsigned max_threads = argc > 1 ? (unsigned)atoi(argv[1]) : 8;
+	const size_t size = argc > 2 ? (size_t)atol(argv[2]) : 10000000;
+	struct big_tree source = big_tree(), copy = big_tree();
+	unsigned threads;
+	size_t i, r;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	for(i = 0; i < size; i++)
+		if(!big_tree_bulk_add(&source, (unsigned)i)) goto catch;
+	big_tree_bulk_finish(&source);
+	if(!(fp = fopen("graph/parallel.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu keys\n# <threads>\t<clone (ms)>\t<sd>\t<clear (ms)>\t<sd>\n",
+		(unsigned long)size);
+	for(threads = 1; threads <= max_threads; threads *= 2) {
+		struct measure clone, clear;
+		m_reset(&clone), m_reset(&clear);
+		for(r = 0; r < replicas; r++) {
+			struct timespec t;
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			if(!big_tree_parallel_clone(&copy, &source, threads)) goto catch;
+			m_add(&clone, diff_ms(&t));
+			if(big_tree_count(&copy) != size)
+				{ errno = EDOM; goto catch; }
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			big_tree_parallel_clear(&copy, threads);
+			m_add(&clear, diff_ms(&t));
+		}
+		printf("%u threads: clone %.1f ms, clear %.1f ms.\n",
+			threads, m_mean(&clone), m_mean(&clear));
+		fprintf(fp, "%u\t%f\t%f\t%f\t%f\n", threads, m_mean(&clone),
+			m_stddev(&clone), m_mean(&clear), m_stddev(&clear));
+	}
+	if(!(gnu = fopen("graph/parallel.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x 2\n"
+		"set xlabel \"threads\"\n"
+		"set ylabel \"time, t (ms)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"clone\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"clear\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	big_tree_(&source), big_tree_(&copy);
+	return ret;
+}
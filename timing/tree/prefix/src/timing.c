@@ -0,0 +1,190 @@
+/* Compares string keys in a tree, with and without an inline prefix, to the
+ trie on an English dictionary. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+static int str_less(const char *const a, const char *const b)
+	{ return strcmp(a, b) > 0; }
+#define TREE_NAME str
+#define TREE_KEY const char *
+#include "../../../../src/tree.h"
+
+static int norm_less(const char *const a, const char *const b)
+	{ return strcmp(a, b) > 0; }
+/** Up to `sizeof(unsigned long)` bytes packed big-endian; nulls pad. */
+static unsigned long norm_prefix(const char *const a) {
+	const unsigned char *u = (const unsigned char *)a;
+	unsigned long p = 0;
+	unsigned i;
+	for(i = 0; i < sizeof p; i++) { p = p << 8 | *u; if(*u) u++; }
+	return p;
+}
+#define TREE_NAME norm
+#define TREE_KEY const char *
+#define TREE_PREFIX unsigned long
+#include "../../../../src/tree.h"
+
+#define TRIE_NAME word
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The dictionary, one word per line. */
+static struct { char *buffer; const char **words; size_t size; } dict;
+
+static void dict_(void) { free(dict.buffer), free(dict.words); }
+/** Loads and shuffles the dictionary. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+#define EXPS X(TREE, str_tree), X(PREFIX, norm_tree), X(TRIE, word_trie)
+
+#define EXP_TREE(name) \
+static void exp_##name(const size_t n, double *const add, double *const look) \
+{ \
+	struct name tree = name(); \
+	clock_t t; \
+	size_t i; \
+	t = clock(); \
+	for(i = 0; i < n; i++) if(!name##_add(&tree, dict.words[i])) \
+		{ perror("add"); exit(EXIT_FAILURE); } \
+	*add = diff_us(t); \
+	t = clock(); \
+	for(i = 0; i < n; i++) if(!name##_contains(&tree, dict.words[n - 1 - i])) \
+		{ fprintf(stderr, "missing\n"); exit(EXIT_FAILURE); } \
+	*look = diff_us(t); \
+	name##_(&tree); \
+}
+EXP_TREE(str_tree)
+EXP_TREE(norm_tree)
+
+static void exp_word_trie(const size_t n, double *const add, double *const look)
+{
+	struct word_trie trie = word_trie();
+	clock_t t;
+	size_t i;
+	t = clock();
+	for(i = 0; i < n; i++) if(!word_trie_add(&trie, dict.words[i]))
+		{ perror("add"); exit(EXIT_FAILURE); }
+	*add = diff_us(t);
+	t = clock();
+	for(i = 0; i < n; i++) if(!word_trie_get(&trie, dict.words[n - 1 - i]))
+		{ fprintf(stderr, "missing\n"); exit(EXIT_FAILURE); }
+	*look = diff_us(t);
+	word_trie_(&trie);
+}
+
+int main(void) {
+	typedef void (*exp_fn)(size_t, double *, double *);
+	const char *const name = "prefix";
+	const size_t replicas = 5;
+#define X(n, m) #n
+	const char *const exp_names[] = { EXPS };
+#undef X
+#define X(n, m) &exp_##m
+	const exp_fn exp[] = { EXPS };
+#undef X
+	const size_t exp_size = sizeof exp / sizeof *exp;
+	size_t sizes[] = { 1000, 10000, 100000, 0 }, s, e, r;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	sizes[sizeof sizes / sizeof *sizes - 1] = dict.size;
+	if(!(fp = fopen("graph/prefix.tsv", "w"))) goto catch;
+	fprintf(fp, "# <words>");
+	for(e = 0; e < exp_size; e++)
+		fprintf(fp, "\t<%s add (ns/op)>\t<sd>\t<%s look (ns/op)>\t<sd>",
+		exp_names[e], exp_names[e]);
+	fprintf(fp, "\n");
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s];
+		fprintf(fp, "%lu", (unsigned long)n);
+		for(e = 0; e < exp_size; e++) {
+			struct measure add, look;
+			m_reset(&add), m_reset(&look);
+			for(r = 0; r < replicas; r++) {
+				double a, l;
+				exp[e](n, &a, &l);
+				m_add(&add, 1000.0 * a / n), m_add(&look, 1000.0 * l / n);
+			}
+			printf("%s %lu words: add %.1f ns, look %.1f ns.\n", exp_names[e],
+				(unsigned long)n, m_mean(&add), m_mean(&look));
+			fprintf(fp, "\t%f\t%f\t%f\t%f", m_mean(&add), m_stddev(&add),
+				m_mean(&look), m_stddev(&look));
+		}
+		fprintf(fp, "\n");
+	}
+	if(!(gnu = fopen("graph/prefix.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"words\"\n"
+		"set ylabel \"lookup, t (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 1:4:5 with errorlines title \"tree\", \\\n"
+		"\"graph/%s.tsv\" using 1:8:9 with errorlines title \"tree prefix\", \\\n"
+		"\"graph/%s.tsv\" using 1:12:13 with errorlines title \"trie\"\n",
+		name, name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	dict_();
+	return ret;
+}
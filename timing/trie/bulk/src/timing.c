@@ -0,0 +1,182 @@
+/* Loading a trie from an English dictionary one word at a time against
+ building it in bulk from an array, shuffled and already sorted. Run from this
+ directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The dictionary, one word per line, and scratch space for a copy. */
+static struct { char *buffer; const char **words, **copy; size_t size; } dict;
+
+static void dict_(void)
+	{ free(dict.buffer), free(dict.words), free(dict.copy); }
+/** Loads and shuffles the dictionary. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))
+		|| !(dict.copy = malloc(sizeof *dict.copy * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+static int compare(const void *const a, const void *const b)
+	{ return strcmp(*(const char *const *)a, *(const char *const *)b); }
+
+/** Checks that all the first `n` words are in `trie`, then frees it. */
+static void check(struct word_trie *const trie, const size_t n) {
+	size_t i;
+	for(i = 0; i < n; i++) if(!word_trie_get(trie, dict.words[i]))
+		{ fprintf(stderr, "missing\n"); exit(EXIT_FAILURE); }
+	word_trie_(trie);
+}
+
+#define EXPS X(ADD, add), X(SHUFFLED, shuffled), X(SORTED, sorted)
+
+static double exp_add(const size_t n) {
+	struct word_trie trie = word_trie();
+	clock_t t;
+	size_t i;
+	double us;
+	t = clock();
+	for(i = 0; i < n; i++) if(!word_trie_add(&trie, dict.words[i]))
+		{ perror("add"); exit(EXIT_FAILURE); }
+	us = diff_us(t);
+	check(&trie, n);
+	return us;
+}
+
+static double exp_shuffled(const size_t n) {
+	struct word_trie trie = word_trie();
+	clock_t t;
+	double us;
+	memcpy(dict.copy, dict.words, sizeof *dict.copy * n);
+	t = clock();
+	if(!word_trie_from_array(&trie, dict.copy, n))
+		{ perror("from_array"); exit(EXIT_FAILURE); }
+	us = diff_us(t);
+	check(&trie, n);
+	return us;
+}
+
+static double exp_sorted(const size_t n) {
+	struct word_trie trie = word_trie();
+	clock_t t;
+	double us;
+	memcpy(dict.copy, dict.words, sizeof *dict.copy * n);
+	qsort(dict.copy, n, sizeof *dict.copy, &compare);
+	t = clock();
+	if(!word_trie_from_array(&trie, dict.copy, n))
+		{ perror("from_array"); exit(EXIT_FAILURE); }
+	us = diff_us(t);
+	check(&trie, n);
+	return us;
+}
+
+int main(void) {
+	typedef double (*exp_fn)(size_t);
+	const char *const name = "bulk";
+	const size_t replicas = 5;
+#define X(n, m) #n
+	const char *const exp_names[] = { EXPS };
+#undef X
+#define X(n, m) &exp_##m
+	const exp_fn exp[] = { EXPS };
+#undef X
+	const size_t exp_size = sizeof exp / sizeof *exp;
+	size_t sizes[] = { 1000, 10000, 100000, 0 }, s, e, r;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	sizes[sizeof sizes / sizeof *sizes - 1] = dict.size;
+	if(!(fp = fopen("graph/bulk.tsv", "w"))) goto catch;
+	fprintf(fp, "# <words>");
+	for(e = 0; e < exp_size; e++)
+		fprintf(fp, "\t<%s (ns/word)>\t<sd>", exp_names[e]);
+	fprintf(fp, "\n");
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s];
+		fprintf(fp, "%lu", (unsigned long)n);
+		for(e = 0; e < exp_size; e++) {
+			struct measure m;
+			m_reset(&m);
+			for(r = 0; r < replicas; r++) m_add(&m, 1000.0 * exp[e](n) / n);
+			printf("%s %lu words: %.1f ns/word.\n", exp_names[e],
+				(unsigned long)n, m_mean(&m));
+			fprintf(fp, "\t%f\t%f", m_mean(&m), m_stddev(&m));
+		}
+		fprintf(fp, "\n");
+	}
+	if(!(gnu = fopen("graph/bulk.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"words\"\n"
+		"set ylabel \"load, t (ns/word)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"add\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"shuffled array\", \\\n"
+		"\"graph/%s.tsv\" using 1:6:7 with errorlines title \"sorted array\"\n",
+		name, name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	dict_();
+	return ret;
+}
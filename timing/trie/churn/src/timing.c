@@ -0,0 +1,152 @@
+/* Churns a trie of English words, removing down to a tenth and adding back
+ again, and reports the memory and lookup speed against a trie built fresh
+ from the same words. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#define TRIE_NAME word
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+
+static int compare(const void *const a, const void *const b)
+	{ return strcmp(*(const char *const *)a, *(const char *const *)b); }
+
+/** The dictionary, one word per line, and scratch space for a copy. */
+static struct { char *buffer; const char **words, **copy; size_t size; } dict;
+
+static void dict_(void)
+	{ free(dict.buffer), free(dict.words), free(dict.copy); }
+/** Loads the unique words of the dictionary and shuffles them. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))
+		|| !(dict.copy = malloc(sizeof *dict.copy * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	/* Removing one of a duplicate would remove both. */
+	qsort(dict.words, dict.size, sizeof *dict.words, &compare);
+	for(w = 1, i = 1; i < dict.size; i++)
+		if(strcmp(dict.words[w - 1], dict.words[i]))
+		dict.words[w++] = dict.words[i];
+	dict.size = w;
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+/** @return The bytes in boughs under `bough`. This is peeking at the
+ implementation, so the bough is whatever <../../../../src/trie.h> says. */
+static size_t boughs(const struct private_word_trie_bough *const bough) {
+	size_t count = private_word_trie_bough_size(bough->capacity);
+	unsigned i;
+	for(i = 0; i < bough->leaves; i++) if(trie_bmp_test(&bough->bmp, i))
+		count += boughs(private_word_trie_leaf(bough)[i].as_link);
+	return count;
+}
+
+/** @return Bytes per word for the `size` words in `trie`. */
+static double bytes(const struct word_trie *const trie, const size_t size)
+	{ return (double)boughs(trie->trunk) / (double)size; }
+
+/** @return Lookups per second of the `size` words at the front of the
+ dictionary in `trie`. */
+static double looks(const struct word_trie *const trie, const size_t size) {
+	const size_t looks = 1000000;
+	clock_t t = clock();
+	size_t i;
+	double us;
+	for(i = 0; i < looks; i++) if(!word_trie_get(trie, dict.words[i % size]))
+		{ fprintf(stderr, "missing\n"); exit(EXIT_FAILURE); }
+	us = diff_us(t);
+	return us > 0 ? 1000000.0 * (double)looks / us : 0;
+}
+
+int main(void) {
+	const char *const name = "churn";
+	const size_t epochs = 18;
+	struct word_trie trie = word_trie(), fresh = word_trie();
+	size_t size, step, e, i;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	if(!(fp = fopen("graph/churn.tsv", "w"))) goto catch;
+	fprintf(fp, "# <epoch>\t<words>\t<churned (B/word)>\t<fresh (B/word)>"
+		"\t<churned (look/s)>\t<fresh (look/s)>\n");
+	/* The words at the front are in the trie. */
+	size = dict.size, step = dict.size / 10;
+	for(i = 0; i < size; i++) if(!word_trie_add(&trie, dict.words[i]))
+		goto catch;
+	for(e = 0; e <= epochs; e++) {
+		double b[2], l[2];
+		if(e) { /* Remove from the back down to a tenth, then add it back. */
+			const size_t target = e <= epochs / 2 ? size - step : size + step;
+			if(target < size) for(i = target; i < size; i++) {
+				if(!word_trie_remove(&trie, dict.words[i])) goto catch;
+			} else for(i = size; i < target; i++) {
+				if(!word_trie_add(&trie, dict.words[i])) goto catch;
+			}
+			size = target;
+			/* Change which are removed next time. */
+			for(i = size; i > 1; i--) {
+				const size_t j = (size_t)rand() % i;
+				const char *const temp = dict.words[i - 1];
+				dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+			}
+		}
+		memcpy(dict.copy, dict.words, sizeof *dict.copy * size);
+		if(!word_trie_from_array(&fresh, dict.copy, size)) goto catch;
+		b[0] = bytes(&trie, size), b[1] = bytes(&fresh, size);
+		l[0] = looks(&trie, size), l[1] = looks(&fresh, size);
+		printf("Epoch %lu, %lu words: churned %.1f B/word %.0f look/s,"
+			" fresh %.1f B/word %.0f look/s.\n", (unsigned long)e,
+			(unsigned long)size, b[0], l[0], b[1], l[1]);
+		fprintf(fp, "%lu\t%lu\t%f\t%f\t%f\t%f\n", (unsigned long)e,
+			(unsigned long)size, b[0], b[1], l[0], l[1]);
+	}
+	if(!(gnu = fopen("graph/churn.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set xlabel \"epoch\"\n"
+		"set ylabel \"memory (B/word)\"\n"
+		"plot \"graph/%s.tsv\" using 1:3 with linespoints title \"churned\", \\\n"
+		"\"graph/%s.tsv\" using 1:4 with linespoints title \"fresh\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	word_trie_(&trie), word_trie_(&fresh);
+	dict_();
+	return ret;
+}
@@ -0,0 +1,214 @@
+/* Scaling of lookups with the number of reader threads, while one writer
+ changes the trie and publishes every change. The keys are dictionary words
+ with numbers. Run from this directory. It only shows scaling with as many
+ processors as readers; on one processor, the threads take turns, and the
+ numbers are the overhead, not how readers scale. */
+
+#define _POSIX_C_SOURCE 200112L /* `clock_gettime`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#define TRIE_CONCURRENT
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a wall-clock difference in milliseconds from `then`; `clock` is
+ processor time, which would count every thread. */
+static double diff_ms(const struct timespec *const then) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 1000.0 * (double)(now.tv_sec - then->tv_sec)
+		+ (double)(now.tv_nsec - then->tv_nsec) / 1000000.0;
+}
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+static const char *const dict_fn = "../../../test/Tutte_le_parole_inglesi.txt";
+
+/** Reads the whole file `fn` into `*buffer`. @return The size or zero. */
+static size_t slurp(const char *const fn, char **const buffer) {
+	FILE *fp;
+	long length;
+	size_t size = 0;
+	*buffer = 0;
+	if(!(fp = fopen(fn, "rb"))) return 0;
+	if(!fseek(fp, 0, SEEK_END) && (length = ftell(fp)) >= 0
+		&& !fseek(fp, 0, SEEK_SET) && (*buffer = malloc((size_t)length + 1))
+		&& fread(*buffer, 1, (size_t)length, fp) == (size_t)length)
+		(*buffer)[size = (size_t)length] = '\0';
+	fclose(fp);
+	return size;
+}
+
+/* Shared between the writer and the readers. */
+struct shared {
+	struct word_trie_concurrent trie;
+	const char **keys;
+	size_t size, lookups, batch;
+	pthread_mutex_t lock;
+	unsigned done;
+};
+/* A reader thread. */
+struct reader {
+	struct shared *shared;
+	unsigned seed;
+	size_t found;
+	pthread_t thread;
+};
+
+/** Looks up random keys, holding a version for a batch at a time. Thread entry
+ point. */
+static void *reader(void *const param) {
+	struct reader *const r = param;
+	struct shared *const s = r->shared;
+	size_t i, j;
+	for(i = 0; i < s->lookups; i += s->batch) {
+		const struct word_trie *const t = word_trie_acquire(&s->trie);
+		for(j = 0; j < s->batch; j++) {
+			r->seed = r->seed * 1103515245u + 12345u;
+			if(word_trie_get(t, s->keys[(r->seed >> 8) % s->size])) r->found++;
+		}
+		word_trie_release(&s->trie, t);
+	}
+	pthread_mutex_lock(&s->lock), s->done++, pthread_mutex_unlock(&s->lock);
+	return 0;
+}
+
+/** Replaces random keys with ones that are not in the trie until `readers`
+ are done. @return The number of updates, or zero on error. */
+static size_t writer(struct shared *const s, const unsigned readers,
+	size_t *const next) {
+	size_t updates = 0;
+	unsigned done;
+	do {
+		const size_t i = (size_t)rand() % s->size;
+		if(!word_trie_concurrent_remove(&s->trie, s->keys[i])
+			|| word_trie_concurrent_add(&s->trie, s->keys[s->size + *next])
+			!= TRIE_ABSENT || !word_trie_publish(&s->trie)) return 0;
+		/* The removed key goes to the end of the ones that are out. */
+		{
+			const char *const temp = s->keys[i];
+			s->keys[i] = s->keys[s->size + *next];
+			s->keys[s->size + *next] = temp;
+		}
+		*next = (*next + 1) % s->size, updates++;
+		pthread_mutex_lock(&s->lock), done = s->done,
+			pthread_mutex_unlock(&s->lock);
+	} while(done < readers);
+	return updates;
+}
+
+int main(int argc, char **argv) {
+	const char *const name = "concurrent";
+	const size_t replicas = 3;
+	const unsigned max_threads = argc > 1 ? (unsigned)atoi(argv[1]) : 8;
+	const size_t size = argc > 2 ? (size_t)atol(argv[2]) : 200000;
+	struct shared s;
+	struct reader *r = 0;
+	struct measure m, w;
+	char *buffer = 0, *keys = 0, *a, *b;
+	const char **words = 0;
+	size_t i, n = 0, length, next = 0, updates;
+	unsigned threads, t, started;
+	struct timespec clock;
+	double ms;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE, is_trie = 0, is_lock = 0;
+	errno = 0;
+	s.keys = 0, s.size = size, s.lookups = 1000000, s.batch = 64, s.done = 0;
+	if(!slurp(dict_fn, &buffer)) goto catch;
+	for(a = buffer; (a = strchr(a, '\n')); a++) n++;
+	/* Half are in the trie, half are waiting to replace them. */
+	if(!n || !(words = malloc(sizeof *words * n))
+		|| !(s.keys = malloc(sizeof *s.keys * size * 2))
+		|| !(keys = malloc(size * 2 * 32))
+		|| !(r = malloc(sizeof *r * max_threads))) goto catch;
+	for(i = 0, a = buffer; (b = strchr(a, '\n')); a = b + 1)
+		*b = '\0', words[i++] = a;
+	for(a = keys, i = 0; i < size * 2; i++) {
+		const char *const word = words[(size_t)rand() % n];
+		if((length = strlen(word)) > 20) length = 20;
+		memcpy(a, word, length);
+		sprintf(a + length, "%lu", (unsigned long)i);
+		s.keys[i] = a, a += strlen(a) + 1;
+	}
+	if(!word_trie_concurrent(&s.trie)) goto catch;
+	is_trie = 1;
+	if((errno = pthread_mutex_init(&s.lock, 0))) goto catch;
+	is_lock = 1;
+	for(i = 0; i < size; i++)
+		if(word_trie_concurrent_add(&s.trie, s.keys[i]) != TRIE_ABSENT)
+			goto catch;
+	if(!word_trie_publish(&s.trie)) goto catch;
+	if(!(fp = fopen("graph/concurrent.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu keys, %lu lookups per reader in batches of %lu\n"
+		"# <readers>\t<lookups (1/ms)>\t<sd>\t<updates (1/ms)>\t<sd>\n",
+		(unsigned long)size, (unsigned long)s.lookups, (unsigned long)s.batch);
+	for(threads = 1; threads <= max_threads; threads *= 2) {
+		m_reset(&m), m_reset(&w);
+		for(i = 0; i < replicas; i++) {
+			s.done = 0;
+			clock_gettime(CLOCK_MONOTONIC, &clock);
+			for(started = 0; started < threads; started++) {
+				r[started].shared = &s, r[started].found = 0;
+				r[started].seed = (unsigned)rand();
+				if(pthread_create(&r[started].thread, 0, &reader,
+					r + started)) break;
+			}
+			if(started < threads) { s.done = threads; errno = EAGAIN; }
+			updates = writer(&s, started, &next);
+			for(t = 0; t < started; t++) pthread_join(r[t].thread, 0);
+			if(!updates || started < threads) goto catch;
+			ms = diff_ms(&clock);
+			m_add(&m, (double)(s.lookups * threads) / ms);
+			m_add(&w, (double)updates / ms);
+		}
+		printf("%u readers: %.0f lookups/ms, writer %.1f updates/ms.\n",
+			threads, m_mean(&m), m_mean(&w));
+		fprintf(fp, "%u\t%f\t%f\t%f\t%f\n", threads, m_mean(&m), m_stddev(&m),
+			m_mean(&w), m_stddev(&w));
+	}
+	if(!(gnu = fopen("graph/concurrent.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x 2\n"
+		"set xlabel \"readers\"\n"
+		"set ylabel \"throughput (1/ms)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines"
+		" title \"lookups\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"updates\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	if(is_lock) pthread_mutex_destroy(&s.lock);
+	if(is_trie) word_trie_concurrent_(&s.trie);
+	free(r), free(keys), free(s.keys), free(words), free(buffer);
+	return ret;
+}
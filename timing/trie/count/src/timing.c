@@ -0,0 +1,144 @@
+/* Counting the words that start with a prefix, from one letter, which are very
+ popular, to most of a word, which are mostly one. <fn:<T>prefix_count> adds
+ up the counts kept in the boughs instead of going through them all. Run from
+ this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#define TRIE_COUNT
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The dictionary, one word per line. */
+static struct { char *buffer; const char **words; size_t size; } dict;
+
+static void dict_(void) { free(dict.buffer), free(dict.words); }
+/** Loads and shuffles the dictionary. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+int main(void) {
+	const char *const name = "count";
+	const size_t replicas = 5, samples = 10000;
+	struct word_trie trie = word_trie();
+	size_t len, r, i;
+	unsigned long check = 0;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	for(i = 0; i < dict.size; i++)
+		if(!word_trie_add(&trie, dict.words[i])) goto catch;
+	if(!(fp = fopen("graph/count.tsv", "w"))) goto catch;
+	fprintf(fp, "# <prefix length>\t<words (mean)>\t<count (ns)>\t<sd>"
+		"\t<iterate (ns)>\t<sd>\n");
+	for(len = 1; len <= 8; len++) {
+		struct measure count, iterate;
+		size_t words = 0;
+		char (*prefix)[9] = 0;
+		if(!(prefix = malloc(sizeof *prefix * samples))) goto catch;
+		/* Prefixes of random words, so they are weighted by popularity. */
+		for(i = 0; i < samples; i++) {
+			strncpy(prefix[i], dict.words[(size_t)rand() % dict.size], len);
+			prefix[i][len] = '\0';
+			words += word_trie_prefix_count(&trie, prefix[i]);
+		}
+		m_reset(&count), m_reset(&iterate);
+		for(r = 0; r < replicas; r++) {
+			clock_t t = clock();
+			for(i = 0; i < samples; i++)
+				check += word_trie_prefix_count(&trie, prefix[i]);
+			m_add(&count, 1000.0 * diff_us(t) / samples);
+			t = clock();
+			for(i = 0; i < samples; i++) {
+				struct word_trie_cursor cur;
+				for(cur = word_trie_prefix(&trie, prefix[i]);
+					word_trie_exists(&cur); word_trie_next(&cur)) check--;
+			}
+			m_add(&iterate, 1000.0 * diff_us(t) / samples);
+		}
+		free(prefix);
+		printf("Prefix length %lu, %.1f words: count %.1f ns,"
+			" iterate %.1f ns.\n", (unsigned long)len, (double)words / samples,
+			m_mean(&count), m_mean(&iterate));
+		fprintf(fp, "%lu\t%f\t%f\t%f\t%f\t%f\n", (unsigned long)len,
+			(double)words / samples, m_mean(&count), m_stddev(&count),
+			m_mean(&iterate), m_stddev(&iterate));
+	}
+	if(check) { errno = EDOM; goto catch; } /* They must be the same. */
+	if(!(gnu = fopen("graph/count.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale xy\n"
+		"set xlabel \"words with the prefix (mean)\"\n"
+		"set ylabel \"time per prefix (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 2:3:4 with errorlines title \"count\", \\\n"
+		"\"graph/%s.tsv\" using 2:5:6 with errorlines title \"iterate\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	word_trie_(&trie);
+	dict_();
+	return ret;
+}
@@ -0,0 +1,171 @@
+/* Spelling correction: the words within an edit distance of a misspelled
+ word. <fn:<T>fuzzy> goes down the trie and prunes where the prefix is already
+ too far; brute force is the same distance on every word. Run from this
+ directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The dictionary, one word per line. */
+static struct { char *buffer; const char **words; size_t size; } dict;
+
+static void dict_(void) { free(dict.buffer), free(dict.words); }
+/** Loads and shuffles the dictionary. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+/** Brute force @return The Levenshtein distance between `a` and `b`, where
+ `b` is shorter than 64, but no more than `bound + 1`. */
+static unsigned levenshtein(const char *const a, const char *const b,
+	const unsigned bound) {
+	unsigned row[64], diag, i, j, low;
+	const unsigned a_len = (unsigned)strlen(a), b_len = (unsigned)strlen(b);
+	for(j = 0; j <= b_len; j++) row[j] = j;
+	for(i = 1; i <= a_len; i++) {
+		for(low = row[0] = i, diag = i - 1, j = 1; j <= b_len; j++) {
+			const unsigned up = row[j];
+			unsigned d = diag + (a[i - 1] != b[j - 1]);
+			if(row[j] + 1 < d) d = row[j] + 1;
+			if(row[j - 1] + 1 < d) d = row[j - 1] + 1;
+			if((row[j] = d) < low) low = d;
+			diag = up;
+		}
+		if(low > bound) return bound + 1;
+	}
+	return row[b_len];
+}
+
+static void count_visit(const char *const key, const unsigned distance,
+	void *const param) { (void)key, (void)distance, ++*(size_t *)param; }
+
+int main(void) {
+	const char *const name = "fuzzy";
+	const size_t replicas = 5, samples = 1000, brute_samples = 10;
+	struct word_trie trie = word_trie();
+	char (*query)[64] = 0;
+	size_t i, j, r;
+	unsigned distance;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	for(i = 0; i < dict.size; i++)
+		if(!word_trie_add(&trie, dict.words[i])) goto catch;
+	/* Misspell random words with one substitution. */
+	if(!(query = malloc(sizeof *query * samples))) goto catch;
+	for(i = 0; i < samples; i++) {
+		size_t len;
+		do strncpy(query[i], dict.words[(size_t)rand() % dict.size],
+			sizeof *query - 1), query[i][sizeof *query - 1] = '\0';
+		while(!(len = strlen(query[i])));
+		query[i][(size_t)rand() % len] = (char)('a' + rand() % 26);
+	}
+	if(!(fp = fopen("graph/fuzzy.tsv", "w"))) goto catch;
+	fprintf(fp, "# <distance>\t<words found (mean)>\t<trie (queries/s)>\t<sd>"
+		"\t<brute (queries/s)>\t<sd>\n");
+	for(distance = 1; distance <= 2; distance++) {
+		struct measure trie_m, brute_m;
+		size_t found = 0, brute = 0;
+		m_reset(&trie_m), m_reset(&brute_m);
+		for(r = 0; r < replicas; r++) {
+			clock_t t = clock();
+			for(found = 0, i = 0; i < samples; i++)
+				word_trie_fuzzy(&trie, query[i], distance, &count_visit, &found);
+			if(errno) goto catch;
+			m_add(&trie_m, samples / (diff_us(t) / 1000000.0));
+			t = clock();
+			for(brute = 0, i = 0; i < brute_samples; i++)
+				for(j = 0; j < dict.size; j++)
+					if(levenshtein(dict.words[j], query[i], distance)
+					<= distance) brute++;
+			m_add(&brute_m, brute_samples / (diff_us(t) / 1000000.0));
+		}
+		printf("Distance %u, %.1f words: trie %.0f queries/s,"
+			" brute force %.1f queries/s.\n", distance,
+			(double)found / samples, m_mean(&trie_m), m_mean(&brute_m));
+		fprintf(fp, "%u\t%f\t%f\t%f\t%f\t%f\n", distance,
+			(double)found / samples, m_mean(&trie_m), m_stddev(&trie_m),
+			m_mean(&brute_m), m_stddev(&brute_m));
+	}
+	if(!(gnu = fopen("graph/fuzzy.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale y\n"
+		"set style data histogram\n"
+		"set style histogram errorbars\n"
+		"set style fill solid border -1\n"
+		"set xlabel \"edit distance\"\n"
+		"set ylabel \"queries per second\"\n"
+		"plot \"graph/%s.tsv\" using 3:4:xtic(1) title \"trie\", \\\n"
+		"\"graph/%s.tsv\" using 5:6 title \"brute force\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	free(query);
+	word_trie_(&trie);
+	dict_();
+	return ret;
+}
@@ -0,0 +1,209 @@
+/* A static dictionary that is shipped as a file: building a trie from the
+ words at start-up against mapping an image of the trie and reading it
+ in-place. The sizes are the words and the boughs, against the file. Run from
+ this directory; it writes a scratch file in `graph`. */
+
+#define _POSIX_C_SOURCE 200112L /* `clock_gettime`, `mmap`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#define TRIE_IMAGE
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a wall-clock difference in milliseconds from `then`; the start-up
+ of a mapping is mostly waiting, which `clock` would not see. */
+static double diff_ms(const struct timespec *const then) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 1000.0 * (double)(now.tv_sec - then->tv_sec)
+		+ (double)(now.tv_nsec - then->tv_nsec) / 1000000.0;
+}
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+static const char *const dict_fn = "../../../test/Tutte_le_parole_inglesi.txt",
+	*const image_fn = "graph/image-trie.bin";
+/** Number of lookups after start-up. */
+static const size_t looks = 100000;
+/** The words that are looked up, the same for both. */
+static const char **look_words;
+
+/** @return The maximum resident memory in bytes. */
+static size_t resident(void) {
+	struct rusage r;
+	return getrusage(RUSAGE_SELF, &r) ? 0 : (size_t)r.ru_maxrss * 1024;
+}
+
+/** Reads the whole file `fn` into `*buffer`. @return The size or zero. */
+static size_t slurp(const char *const fn, char **const buffer) {
+	FILE *fp;
+	long length;
+	size_t size = 0;
+	*buffer = 0;
+	if(!(fp = fopen(fn, "rb"))) return 0;
+	if(!fseek(fp, 0, SEEK_END) && (length = ftell(fp)) >= 0
+		&& !fseek(fp, 0, SEEK_SET) && (*buffer = malloc((size_t)length + 1))
+		&& fread(*buffer, 1, (size_t)length, fp) == (size_t)length)
+		(*buffer)[size = (size_t)length] = '\0';
+	fclose(fp);
+	return size;
+}
+
+/** Splits `buffer` into lines and adds them to `trie`. @return Success. */
+static int build(struct word_trie *const trie, char *const buffer) {
+	char *a, *b;
+	for(a = buffer; (b = strchr(a, '\n')); a = b + 1)
+		if(*b = '\0', !word_trie_add(trie, a)) return 0;
+	return 1;
+}
+
+/** Reads the dictionary and builds the trie, then looks up. */
+static int exp_build(double *const start, double *const look) {
+	struct word_trie trie = word_trie();
+	struct timespec t;
+	char *buffer;
+	size_t i, found = 0;
+	int success = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	if(!slurp(dict_fn, &buffer) || !build(&trie, buffer)) goto finally;
+	*start = diff_ms(&t);
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for(i = 0; i < looks; i++) if(word_trie_get(&trie, look_words[i])) found++;
+	*look = diff_ms(&t);
+	success = found == looks;
+finally:
+	word_trie_(&trie);
+	free(buffer);
+	return success;
+}
+
+/** Maps the image and reads it in-place, then looks up. */
+static int exp_image(double *const start, double *const look,
+	size_t *const size) {
+	struct word_trie_image image;
+	struct timespec t;
+	struct stat st;
+	void *data = MAP_FAILED;
+	size_t i, found = 0;
+	int fd, success = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	if((fd = open(image_fn, O_RDONLY)) == -1) return 0;
+	if(fstat(fd, &st) == -1 || (data = mmap(0, (size_t)st.st_size, PROT_READ,
+		MAP_PRIVATE, fd, 0)) == MAP_FAILED
+		|| !word_trie_image(&image, data, (size_t)st.st_size)) goto finally;
+	*start = diff_ms(&t);
+	*size = (size_t)st.st_size;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for(i = 0; i < looks; i++)
+		if(word_trie_image_get(&image, look_words[i])) found++;
+	*look = diff_ms(&t);
+	success = found == looks;
+finally:
+	if(data != MAP_FAILED) munmap(data, (size_t)st.st_size);
+	close(fd);
+	return success;
+}
+
+int main(void) {
+	const char *const name = "image";
+	const size_t replicas = 5;
+	struct word_trie trie = word_trie();
+	struct measure start[2], look[2];
+	char *buffer = 0, *a, *b;
+	const char **words = 0;
+	size_t i, n = 0, size[2] = { 0, 0 }, before;
+	unsigned e;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	/* The image and the words to look up. The first time the trie is built,
+	 the memory it takes is new, the words and the boughs. */
+	if(!(size[0] = slurp(dict_fn, &buffer))) goto catch;
+	for(a = buffer; (a = strchr(a, '\n')); a++) n++;
+	if(!n || !(words = malloc(sizeof *words * n))
+		|| !(look_words = malloc(sizeof *look_words * looks))) goto catch;
+	for(i = 0, a = buffer; (b = strchr(a, '\n')); a = b + 1)
+		*b = '\0', words[i++] = a;
+	for(i = 0; i < looks; i++) look_words[i] = words[(size_t)rand() % n];
+	before = resident();
+	for(i = 0; i < n; i++) if(!word_trie_add(&trie, words[i])) goto catch;
+	size[0] += resident() - before;
+	if(!(fp = fopen(image_fn, "wb"))) goto catch;
+	if(!word_trie_image_save(&trie, fp)) goto catch;
+	if(fclose(fp) == EOF) { fp = 0; goto catch; }
+	fp = 0;
+	word_trie_(&trie);
+	for(e = 0; e < 2; e++) m_reset(start + e), m_reset(look + e);
+	for(i = 0; i < replicas; i++) {
+		double s, l;
+		if(!exp_build(&s, &l)) goto catch;
+		m_add(start + 0, s), m_add(look + 0, l);
+		if(!exp_image(&s, &l, size + 1)) goto catch;
+		m_add(start + 1, s), m_add(look + 1, l);
+	}
+	remove(image_fn);
+	printf("%lu words, %lu lookups:\n"
+		"build %.3f ms + %.3f ms, %.1f MB;\n"
+		"image %.3f ms + %.3f ms, %.1f MB.\n",
+		(unsigned long)n, (unsigned long)looks,
+		m_mean(start + 0), m_mean(look + 0), size[0] / 1e6,
+		m_mean(start + 1), m_mean(look + 1), size[1] / 1e6);
+	if(!(fp = fopen("graph/image.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu words, %lu lookups\n# <which>\t<start (ms)>\t<sd>"
+		"\t<look (ms)>\t<sd>\t<size (MB)>\n", (unsigned long)n,
+		(unsigned long)looks);
+	for(e = 0; e < 2; e++) fprintf(fp, "%s\t%f\t%f\t%f\t%f\t%f\n",
+		e ? "image" : "build", m_mean(start + e), m_stddev(start + e),
+		m_mean(look + e), m_stddev(look + e), size[e] / 1e6);
+	if(!(gnu = fopen("graph/image.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale y\n"
+		"set style data histogram\n"
+		"set style histogram errorbars\n"
+		"set style fill solid border -1\n"
+		"set ylabel \"t (ms)\"\n"
+		"plot \"graph/%s.tsv\" using 2:3:xtic(1) title \"start-up\", \\\n"
+		"\"graph/%s.tsv\" using 4:5 title \"lookups\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	word_trie_(&trie);
+	free(look_words);
+	free(words);
+	free(buffer);
+	return ret;
+}
@@ -0,0 +1,173 @@
+/* Integer keys in a trie with fixed-width keys, against a hash table and a
+ B-tree, which are the usual containers for them. The keys are random 32-bit
+ numbers; the trie stores them big-endian, so it iterates in numerical order,
+ like the tree. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+/** The bytes of a 32-bit number, most significant first. */
+struct be32 { unsigned char byte[4]; };
+static struct be32 be32(const unsigned long x) {
+	struct be32 b;
+	b.byte[0] = (unsigned char)(x >> 24 & 0xff);
+	b.byte[1] = (unsigned char)(x >> 16 & 0xff);
+	b.byte[2] = (unsigned char)(x >> 8 & 0xff);
+	b.byte[3] = (unsigned char)(x & 0xff);
+	return b;
+}
+#define TRIE_NAME be32
+#define TRIE_KEY struct be32
+#define TRIE_KEY_BYTES 4
+#include "../../../../src/trie.h"
+
+/** <https://github.com/skeeto/hash-prospector>. */
+static unsigned long num_hash(const unsigned long x) {
+	unsigned long h = x & 0xffffffff;
+	h ^= h >> 16, h = h * 0x7feb352dlu & 0xffffffff;
+	h ^= h >> 15, h = h * 0x846ca68blu & 0xffffffff;
+	return h ^ h >> 16;
+}
+static int num_is_equal(const unsigned long a, const unsigned long b)
+	{ return a == b; }
+#define TABLE_NAME num
+#define TABLE_KEY unsigned long
+#define TABLE_UINT unsigned long
+#define TABLE_IS_EQUAL
+#include "../../../../src/table.h"
+
+static int num_less(const unsigned long a, const unsigned long b)
+	{ return a > b; }
+#define TREE_NAME num
+#define TREE_KEY unsigned long
+#include "../../../../src/tree.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/* The containers that are being compared. */
+#define PARAM(X) X(TRIE), X(TABLE), X(TREE)
+#define X(n) n
+enum { PARAM(X) };
+#undef X
+#define X(n) #n
+static const char *const names[] = { PARAM(X) };
+#undef X
+
+int main(void) {
+	const char *const name = "integer";
+	const size_t replicas = 5;
+	size_t sizes[] = { 100, 1000, 10000, 100000, 1000000 }, s, r, i, c;
+	const size_t max = sizes[sizeof sizes / sizeof *sizes - 1];
+	unsigned long *keys = 0, found = 0;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!(keys = malloc(sizeof *keys * max))) goto catch;
+	for(i = 0; i < max; i++)
+		keys[i] = ((unsigned long)rand() << 16 ^ (unsigned long)rand())
+		& 0xffffffff;
+	if(!(fp = fopen("graph/integer.tsv", "w"))) goto catch;
+	fprintf(fp, "# <keys>");
+	for(c = 0; c < sizeof names / sizeof *names; c++) fprintf(fp,
+		"\t<%s add (ns/key)>\t<sd>\t<%s look (ns/key)>\t<sd>",
+		names[c], names[c]);
+	fprintf(fp, "\n");
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s];
+		struct measure add[sizeof names / sizeof *names],
+			look[sizeof names / sizeof *names];
+		for(c = 0; c < sizeof names / sizeof *names; c++)
+			m_reset(add + c), m_reset(look + c);
+		for(r = 0; r < replicas; r++) {
+			struct be32_trie trie = be32_trie();
+			struct num_table table = num_table();
+			struct num_tree tree = num_tree();
+			clock_t t;
+			t = clock();
+			for(i = 0; i < n; i++)
+				if(!be32_trie_add(&trie, be32(keys[i]))) goto catch;
+			m_add(add + TRIE, 1000.0 * diff_us(t) / n);
+			t = clock();
+			for(i = 0; i < n; i++) {
+				const struct be32 b = be32(keys[i]);
+				found += be32_trie_get(&trie, (const char *)b.byte, 0)
+					== TRIE_PRESENT;
+			}
+			m_add(look + TRIE, 1000.0 * diff_us(t) / n);
+			t = clock();
+			for(i = 0; i < n; i++)
+				if(!num_table_try(&table, keys[i])) goto catch;
+			m_add(add + TABLE, 1000.0 * diff_us(t) / n);
+			t = clock();
+			for(i = 0; i < n; i++) found += num_table_contains(&table, keys[i]);
+			m_add(look + TABLE, 1000.0 * diff_us(t) / n);
+			t = clock();
+			for(i = 0; i < n; i++)
+				if(!num_tree_add(&tree, keys[i])) goto catch;
+			m_add(add + TREE, 1000.0 * diff_us(t) / n);
+			t = clock();
+			for(i = 0; i < n; i++) found += num_tree_contains(&tree, keys[i]);
+			m_add(look + TREE, 1000.0 * diff_us(t) / n);
+			be32_trie_(&trie), num_table_(&table), num_tree_(&tree);
+		}
+		printf("%lu keys:", (unsigned long)n);
+		fprintf(fp, "%lu", (unsigned long)n);
+		for(c = 0; c < sizeof names / sizeof *names; c++) {
+			printf(" %s add %.1f look %.1f ns/key;", names[c],
+				m_mean(add + c), m_mean(look + c));
+			fprintf(fp, "\t%f\t%f\t%f\t%f", m_mean(add + c), m_stddev(add + c),
+				m_mean(look + c), m_stddev(look + c));
+		}
+		printf("\n");
+		fprintf(fp, "\n");
+	}
+	printf("(Found %lu.)\n", found);
+	if(!(gnu = fopen("graph/integer.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"keys\"\n"
+		"set ylabel \"time per key (ns)\"\n"
+		"plot", name);
+	for(c = 0; c < sizeof names / sizeof *names; c++) fprintf(gnu,
+		"%s \"graph/%s.tsv\" using 1:%lu with linespoints title \"%s add\","
+		" \"graph/%s.tsv\" using 1:%lu with linespoints title \"%s look\"",
+		c ? ", \\\n" : "", name, (unsigned long)(2 + 4 * c), names[c],
+		name, (unsigned long)(4 + 4 * c), names[c]);
+	fprintf(gnu, "\n");
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	free(keys);
+	return ret;
+}
@@ -0,0 +1,8 @@
+set term postscript eps enhanced color
+set output "graph/length.eps"
+set grid
+set logscale x
+set xlabel "key length (bytes)"
+set ylabel "lookup, t (ns)"
+plot "graph/length.tsv" using 1:2:3 with errorlines title "match", \
+"graph/length.tsv" using 1:4:5 with errorlines title "get"
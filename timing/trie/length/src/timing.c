@@ -0,0 +1,114 @@
+/* Lookups in a trie by key length. The keys are like paths: 15 segments of
+ text that are the same in all keys, each followed by one of two characters,
+ in all combinations, so the trie skips the common text between decisions all
+ the way to the end. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME path
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/* The common text in a segment is a prefix of this; it must fit in a skip. */
+static const char text[] = "/a/long/and/common/directory/n";
+#define SEGMENTS 15
+
+/** Fills `key` with segments of `common` bytes of text and the bits of
+ `number`. */
+static void path(char *key, const size_t common, const size_t number) {
+	size_t s;
+	for(s = 0; s < SEGMENTS; s++) {
+		memcpy(key, text, common), key += common;
+		*key++ = number >> s & 1 ? 'b' : 'a';
+	}
+	*key = '\0';
+}
+
+int main(void) {
+	const char *const name = "length";
+	const size_t replicas = 5, keys = 1 << SEGMENTS, looks = 1000000;
+	size_t common[] = { 0, 1, 3, 7, 15, 30 }, s, r, i;
+	char *buffer = 0;
+	const char **key = 0;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(!(key = malloc(sizeof *key * keys))) goto catch;
+	if(!(fp = fopen("graph/length.tsv", "w"))) goto catch;
+	fprintf(fp, "# <key length>\t<match (ns)>\t<sd>\t<get (ns)>\t<sd>\n");
+	for(s = 0; s < sizeof common / sizeof *common; s++) {
+		const size_t length = SEGMENTS * (common[s] + 1);
+		struct path_trie trie = path_trie();
+		struct measure match, get;
+		char *b;
+		free(buffer);
+		if(!(buffer = malloc((length + 1) * keys))) goto catch;
+		for(b = buffer, i = 0; i < keys; i++, b += length + 1) {
+			path(b, common[s], i), key[i] = b;
+			if(!path_trie_add(&trie, b)) goto catch;
+		}
+		m_reset(&match), m_reset(&get);
+		for(r = 0; r < replicas; r++) {
+			size_t found = 0;
+			clock_t t = clock();
+			for(i = 0; i < looks; i++)
+				if(path_trie_match(&trie, key[i % keys])) found++;
+			m_add(&match, 1000.0 * diff_us(t) / looks);
+			t = clock();
+			for(i = 0; i < looks; i++)
+				if(path_trie_get(&trie, key[i % keys])) found++;
+			m_add(&get, 1000.0 * diff_us(t) / looks);
+			if(found != 2 * looks) { errno = EDOM; goto catch; }
+		}
+		printf("Key length %lu: match %.1f ns, get %.1f ns.\n",
+			(unsigned long)length, m_mean(&match), m_mean(&get));
+		fprintf(fp, "%lu\t%f\t%f\t%f\t%f\n", (unsigned long)length,
+			m_mean(&match), m_stddev(&match), m_mean(&get), m_stddev(&get));
+		path_trie_(&trie);
+	}
+	if(!(gnu = fopen("graph/length.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"key length (bytes)\"\n"
+		"set ylabel \"lookup, t (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"match\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"get\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	free(buffer), free(key);
+	return ret;
+}
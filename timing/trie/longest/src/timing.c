@@ -0,0 +1,118 @@
+/* Longest-prefix match on a rule table like routing: rules are addresses as
+ text of 8 to 32 binary digits, and the inputs are random 32-digit addresses.
+ A single walk with <fn:<T>longest> is against trying every length with
+ <fn:<T>get>, longest first. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME rule
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** Address of 32 binary digits. */
+struct address { char bit[33]; };
+static void address_random(struct address *const a) {
+	unsigned i;
+	for(i = 0; i < 32; i++) a->bit[i] = rand() & 1 ? '1' : '0';
+	a->bit[32] = '\0';
+}
+
+int main(void) {
+	const char *const name = "longest";
+	const size_t replicas = 5, inputs = 100000;
+	size_t sizes[] = { 1000, 10000, 100000, 1000000 }, s, r, i;
+	const size_t max = sizes[sizeof sizes / sizeof *sizes - 1];
+	struct address *rules = 0, *input = 0;
+	unsigned long found = 0;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!(rules = malloc(sizeof *rules * max))
+		|| !(input = malloc(sizeof *input * inputs))) goto catch;
+	for(i = 0; i < max; i++) { /* Biased towards the longer rules. */
+		address_random(rules + i);
+		rules[i].bit[8 + (unsigned)rand() % 25] = '\0';
+	}
+	for(i = 0; i < inputs; i++) address_random(input + i);
+	if(!(fp = fopen("graph/longest.tsv", "w"))) goto catch;
+	fprintf(fp, "# <rules>\t<longest (ns/input)>\t<sd>"
+		"\t<every get (ns/input)>\t<sd>\n");
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s];
+		struct rule_trie trie = rule_trie();
+		struct measure longest, every;
+		m_reset(&longest), m_reset(&every);
+		for(i = 0; i < n; i++)
+			if(!rule_trie_add(&trie, rules[i].bit)) goto catch;
+		for(r = 0; r < replicas; r++) {
+			clock_t t = clock();
+			for(i = 0; i < inputs; i++)
+				if(rule_trie_longest(&trie, input[i].bit)) found++;
+			m_add(&longest, 1000.0 * diff_us(t) / inputs);
+			t = clock();
+			for(i = 0; i < inputs; i++) {
+				struct address a = input[i];
+				unsigned len = 32;
+				for( ; ; len--) {
+					a.bit[len] = '\0';
+					if(rule_trie_get(&trie, a.bit)) { found++; break; }
+					if(!len) break;
+				}
+			}
+			m_add(&every, 1000.0 * diff_us(t) / inputs);
+		}
+		rule_trie_(&trie);
+		printf("%lu rules: longest %.1f ns, every get %.1f ns.\n",
+			(unsigned long)n, m_mean(&longest), m_mean(&every));
+		fprintf(fp, "%lu\t%f\t%f\t%f\t%f\n", (unsigned long)n,
+			m_mean(&longest), m_stddev(&longest),
+			m_mean(&every), m_stddev(&every));
+	}
+	printf("(Found %lu.)\n", found);
+	if(!(gnu = fopen("graph/longest.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"rules\"\n"
+		"set ylabel \"time per input (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"longest\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"every get\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	free(rules), free(input);
+	return ret;
+}
@@ -0,0 +1,227 @@
+/* Keys that the caller keeps, each allocated on its own, against the trie
+ having its own copy in an arena. The words are added in random order, or,
+ for the arena, also bulk-loaded in order. The sizes are the peak resident
+ memory of the words and the boughs, measured in a child process each; the
+ bulk-load includes its temporary arrays. Run from this directory. */
+
+#define _POSIX_C_SOURCE 200112L /* `fork`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME pointer
+#include "../../../../src/trie.h"
+
+#define TRIE_NAME own
+#define TRIE_OWN
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+static const char *const dict_fn = "../../../test/Tutte_le_parole_inglesi.txt";
+/** Number of lookups. */
+static const size_t looks = 1000000;
+/** The words in random order, the words that are looked up, and the words
+ in order for bulk-loading. */
+static const char **shuffle_words, **look_words, **sort_words;
+static size_t words_size;
+
+enum experiment { POINTER, OWN, OWN_BULK };
+static const char *const experiment_names[] = { "pointer", "own", "own bulk" };
+
+/** @return The maximum resident memory in bytes. */
+static size_t resident(void) {
+	struct rusage r;
+	return getrusage(RUSAGE_SELF, &r) ? 0 : (size_t)r.ru_maxrss * 1024;
+}
+
+/** Reads the whole file `fn` into `*buffer`. @return The size or zero. */
+static size_t slurp(const char *const fn, char **const buffer) {
+	FILE *fp;
+	long length;
+	size_t size = 0;
+	*buffer = 0;
+	if(!(fp = fopen(fn, "rb"))) return 0;
+	if(!fseek(fp, 0, SEEK_END) && (length = ftell(fp)) >= 0
+		&& !fseek(fp, 0, SEEK_SET) && (*buffer = malloc((size_t)length + 1))
+		&& fread(*buffer, 1, (size_t)length, fp) == (size_t)length)
+		(*buffer)[size = (size_t)length] = '\0';
+	fclose(fp);
+	return size;
+}
+
+/** The caller's copies of the words for the pointer trie. */
+static char **copies;
+
+/** Builds `e` in either `p` or `o`. @return Success. */
+static int build(const enum experiment e, struct pointer_trie *const p,
+	struct own_trie *const o) {
+	size_t i;
+	switch(e) {
+	case POINTER:
+		for(i = 0; i < words_size; i++) {
+			const size_t size = strlen(shuffle_words[i]) + 1;
+			if(!(copies[i] = malloc(size))) return 0;
+			memcpy(copies[i], shuffle_words[i], size);
+			if(!pointer_trie_add(p, copies[i])) return 0;
+		}
+		return 1;
+	case OWN:
+		for(i = 0; i < words_size; i++)
+			if(!own_trie_add(o, shuffle_words[i])) return 0;
+		return 1;
+	case OWN_BULK:
+		return own_trie_from_array(o, sort_words, words_size);
+	}
+	return 0;
+}
+
+/** Frees `p`, `o`, and the copies. */
+static void destroy(struct pointer_trie *const p, struct own_trie *const o) {
+	size_t i;
+	pointer_trie_(p), own_trie_(o);
+	for(i = 0; i < words_size; i++) free(copies[i]), copies[i] = 0;
+}
+
+/** @return The resident memory that `e` takes, in a child process, so it is
+ the first time it is allocated, or zero. */
+static size_t footprint(const enum experiment e) {
+	int fd[2], status;
+	size_t size = 0;
+	pid_t pid;
+	if(pipe(fd) == -1) return 0;
+	if((pid = fork()) == -1) { close(fd[0]), close(fd[1]); return 0; }
+	if(!pid) { /* Child. */
+		struct pointer_trie p = pointer_trie();
+		struct own_trie o = own_trie();
+		const size_t before = resident();
+		close(fd[0]);
+		if(build(e, &p, &o)) size = resident() - before;
+		if(write(fd[1], &size, sizeof size) != sizeof size) _exit(EXIT_FAILURE);
+		_exit(EXIT_SUCCESS);
+	}
+	close(fd[1]);
+	if(read(fd[0], &size, sizeof size) != sizeof size) size = 0;
+	close(fd[0]);
+	waitpid(pid, &status, 0);
+	return size;
+}
+
+/** Builds `e` and looks up. @return The time in milliseconds or a negative
+ number. */
+static double look(const enum experiment e) {
+	struct pointer_trie p = pointer_trie();
+	struct own_trie o = own_trie();
+	clock_t t;
+	size_t i, found = 0;
+	double ms = -1.0;
+	if(!build(e, &p, &o)) goto finally;
+	t = clock();
+	if(e == POINTER) {
+		for(i = 0; i < looks; i++)
+			if(pointer_trie_get(&p, look_words[i])) found++;
+	} else {
+		for(i = 0; i < looks; i++) if(own_trie_get(&o, look_words[i])) found++;
+	}
+	if(found == looks) ms = 1000.0 * (double)(clock() - t) / CLOCKS_PER_SEC;
+finally:
+	destroy(&p, &o);
+	return ms;
+}
+
+int main(void) {
+	const char *const name = "own";
+	const size_t replicas = 5;
+	struct measure m[3];
+	size_t size[3];
+	char *buffer = 0, *a, *b;
+	size_t i, n = 0;
+	unsigned e;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!slurp(dict_fn, &buffer)) goto catch;
+	for(a = buffer; (a = strchr(a, '\n')); a++) n++;
+	if(!n || !(sort_words = malloc(sizeof *sort_words * n))
+		|| !(shuffle_words = malloc(sizeof *shuffle_words * n))
+		|| !(copies = calloc(n, sizeof *copies))
+		|| !(look_words = malloc(sizeof *look_words * looks))) goto catch;
+	for(i = 0, a = buffer; (b = strchr(a, '\n')); a = b + 1)
+		*b = '\0', sort_words[i++] = a;
+	words_size = n;
+	memcpy(shuffle_words, sort_words, sizeof *sort_words * n);
+	for(i = n - 1; i; i--) {
+		const size_t j = (size_t)rand() % (i + 1);
+		const char *const temp = shuffle_words[i];
+		shuffle_words[i] = shuffle_words[j], shuffle_words[j] = temp;
+	}
+	for(i = 0; i < looks; i++) look_words[i] = sort_words[(size_t)rand() % n];
+	for(e = 0; e < 3; e++) {
+		if(!(size[e] = footprint((enum experiment)e))) goto catch;
+		m_reset(m + e);
+	}
+	for(i = 0; i < replicas; i++) for(e = 0; e < 3; e++) {
+		const double ms = look((enum experiment)e);
+		if(ms < 0) goto catch;
+		m_add(m + e, ms);
+	}
+	printf("%lu words, %lu lookups:\n", (unsigned long)n, (unsigned long)looks);
+	for(e = 0; e < 3; e++) printf("%s %.1f ms, %.1f MB.\n",
+		experiment_names[e], m_mean(m + e), size[e] / 1e6);
+	if(!(fp = fopen("graph/own.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu words, %lu lookups\n# <which>\t<look (ms)>\t<sd>"
+		"\t<size (MB)>\n", (unsigned long)n, (unsigned long)looks);
+	for(e = 0; e < 3; e++) fprintf(fp, "\"%s\"\t%f\t%f\t%f\n",
+		experiment_names[e], m_mean(m + e), m_stddev(m + e), size[e] / 1e6);
+	if(!(gnu = fopen("graph/own.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set style data histogram\n"
+		"set style histogram errorbars\n"
+		"set style fill solid border -1\n"
+		"set ylabel \"t (ms)\"\n"
+		"set y2label \"size (MB)\"\n"
+		"set y2tics\n"
+		"plot \"graph/%s.tsv\" using 2:3:xtic(1) title \"lookups\", \\\n"
+		"\"graph/%s.tsv\" using 4:(0) axes x1y2 title \"size\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	free(look_words);
+	free(copies);
+	free(shuffle_words);
+	free(sort_words);
+	free(buffer);
+	return ret;
+}
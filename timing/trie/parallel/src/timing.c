@@ -0,0 +1,149 @@
+/* Scaling of building a big trie from an array with the number of threads,
+ against adding one at a time. The keys are dictionary words with numbers,
+ shuffled. Run from this directory. */
+
+#define _POSIX_C_SOURCE 200112L /* `clock_gettime`. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#define TRIE_PARALLEL
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a wall-clock difference in milliseconds from `then`; `clock` is
+ processor time, which would count every thread. */
+static double diff_ms(const struct timespec *const then) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 1000.0 * (double)(now.tv_sec - then->tv_sec)
+		+ (double)(now.tv_nsec - then->tv_nsec) / 1000000.0;
+}
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+static const char *const dict_fn = "../../../test/Tutte_le_parole_inglesi.txt";
+
+/** Reads the whole file `fn` into `*buffer`. @return The size or zero. */
+static size_t slurp(const char *const fn, char **const buffer) {
+	FILE *fp;
+	long length;
+	size_t size = 0;
+	*buffer = 0;
+	if(!(fp = fopen(fn, "rb"))) return 0;
+	if(!fseek(fp, 0, SEEK_END) && (length = ftell(fp)) >= 0
+		&& !fseek(fp, 0, SEEK_SET) && (*buffer = malloc((size_t)length + 1))
+		&& fread(*buffer, 1, (size_t)length, fp) == (size_t)length)
+		(*buffer)[size = (size_t)length] = '\0';
+	fclose(fp);
+	return size;
+}
+
+/** @return Whether `a` and `b` iterate the same keys. */
+static int same(const struct word_trie *const a, const struct word_trie *const b) {
+	struct word_trie_cursor c0 = word_trie_begin(a), c1 = word_trie_begin(b);
+	for( ; word_trie_exists(&c0); word_trie_next(&c0), word_trie_next(&c1))
+		if(!word_trie_exists(&c1)
+			|| strcmp(word_trie_entry(&c0), word_trie_entry(&c1))) return 0;
+	return !word_trie_exists(&c1);
+}
+
+int main(int argc, char **argv) {
+	const char *const name = "parallel";
+	const size_t replicas = 3;
+	const unsigned max_threads = argc > 1 ? (unsigned)atoi(argv[1]) : 8;
+	const size_t size = argc > 2 ? (size_t)atol(argv[2]) : 2000000;
+	struct word_trie trie = word_trie(), sequential = word_trie();
+	struct measure m;
+	char *buffer = 0, *keys = 0, *a, *b;
+	const char **words = 0, **shuffle = 0, **array = 0;
+	size_t i, n = 0, length;
+	unsigned threads;
+	struct timespec t;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!slurp(dict_fn, &buffer)) goto catch;
+	for(a = buffer; (a = strchr(a, '\n')); a++) n++;
+	if(!n || !(words = malloc(sizeof *words * n))
+		|| !(shuffle = malloc(sizeof *shuffle * size))
+		|| !(array = malloc(sizeof *array * size))
+		|| !(keys = malloc(size * 32))) goto catch;
+	for(i = 0, a = buffer; (b = strchr(a, '\n')); a = b + 1)
+		*b = '\0', words[i++] = a;
+	/* The number makes them unique. */
+	for(a = keys, i = 0; i < size; i++) {
+		const char *const word = words[(size_t)rand() % n];
+		if((length = strlen(word)) > 20) length = 20;
+		memcpy(a, word, length);
+		sprintf(a + length, "%lu", (unsigned long)i);
+		shuffle[i] = a, a += strlen(a) + 1;
+	}
+	for(i = size - 1; i; i--) {
+		const size_t j = (size_t)rand() % (i + 1);
+		const char *const temp = shuffle[i];
+		shuffle[i] = shuffle[j], shuffle[j] = temp;
+	}
+	if(!(fp = fopen("graph/parallel.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu keys\n# <threads>\t<build (ms)>\t<sd>\n",
+		(unsigned long)size);
+	/* One at a time, as a reference. */
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for(i = 0; i < size; i++)
+		if(!word_trie_add(&sequential, shuffle[i])) goto catch;
+	printf("%lu keys: add %.1f ms.\n", (unsigned long)size, diff_ms(&t));
+	fprintf(fp, "0\t%f\t0\n", diff_ms(&t));
+	for(threads = 1; threads <= max_threads; threads *= 2) {
+		m_reset(&m);
+		for(i = 0; i < replicas; i++) {
+			memcpy(array, shuffle, sizeof *array * size);
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			if(!word_trie_parallel_from_array(&trie, array, size, threads))
+				goto catch;
+			m_add(&m, diff_ms(&t));
+			if(!same(&trie, &sequential)) { errno = EDOM; goto catch; }
+		}
+		printf("%u threads: from array %.1f ms.\n", threads, m_mean(&m));
+		fprintf(fp, "%u\t%f\t%f\n", threads, m_mean(&m), m_stddev(&m));
+	}
+	if(!(gnu = fopen("graph/parallel.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x 2\n"
+		"set xlabel \"threads\"\n"
+		"set ylabel \"time, t (ms)\"\n"
+		"plot \"graph/%s.tsv\" every ::1 using 1:2:3 with errorlines"
+		" title \"from array\"\n",
+		name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	word_trie_(&trie), word_trie_(&sequential);
+	free(keys), free(array), free(shuffle), free(words), free(buffer);
+	return ret;
+}
@@ -0,0 +1,164 @@
+/* Range scans on a sorted index of the dictionary, [a, b), where there are a
+ number of words in between, in a trie with <fn:<T>range> and in a B-tree with
+ <fn:<T>more>. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#include "../../../../src/trie.h"
+
+static int word_less(const char *const a, const char *const b)
+	{ return strcmp(a, b) > 0; }
+#define TREE_NAME word
+#define TREE_KEY const char *
+#include "../../../../src/tree.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The dictionary, one word per line. */
+static struct { char *buffer; const char **words; size_t size; } dict;
+
+static void dict_(void) { free(dict.buffer), free(dict.words); }
+/** Loads and shuffles the dictionary. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+static int sort_words(const void *const a, const void *const b)
+	{ return strcmp(*(const char *const *)a, *(const char *const *)b); }
+
+int main(void) {
+	const char *const name = "range";
+	const size_t replicas = 5, samples = 10000;
+	struct word_trie trie = word_trie();
+	struct word_tree tree = word_tree();
+	const char **sorted = 0;
+	size_t width, r, i, unique;
+	unsigned long check = 0;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	for(i = 0; i < dict.size; i++) {
+		if(!word_trie_add(&trie, dict.words[i])) goto catch;
+		if(!word_tree_add(&tree, dict.words[i])) goto catch;
+	}
+	/* The bounds are picked from the words in order. */
+	if(!(sorted = malloc(sizeof *sorted * dict.size))) goto catch;
+	memcpy(sorted, dict.words, sizeof *sorted * dict.size);
+	qsort(sorted, dict.size, sizeof *sorted, &sort_words);
+	for(unique = 0, i = 0; i < dict.size; i++)
+		if(!unique || strcmp(sorted[unique - 1], sorted[i]))
+			sorted[unique++] = sorted[i];
+	if(!(fp = fopen("graph/range.tsv", "w"))) goto catch;
+	fprintf(fp, "# <words>\t<trie (ns)>\t<sd>\t<tree (ns)>\t<sd>\n");
+	for(width = 1; width <= 100000 && width < unique; width *= 10) {
+		struct measure trie_m, tree_m;
+		const char *(*bound)[2] = 0;
+		if(!(bound = malloc(sizeof *bound * samples))) goto catch;
+		for(i = 0; i < samples; i++) {
+			const size_t j = (size_t)rand() % (unique - width);
+			bound[i][0] = sorted[j], bound[i][1] = sorted[j + width];
+		}
+		m_reset(&trie_m), m_reset(&tree_m);
+		for(r = 0; r < replicas; r++) {
+			clock_t t = clock();
+			for(i = 0; i < samples; i++) {
+				struct word_trie_cursor cur;
+				for(cur = word_trie_range(&trie, bound[i][0], bound[i][1]);
+					word_trie_exists(&cur); word_trie_next(&cur)) check++;
+			}
+			m_add(&trie_m, 1000.0 * diff_us(t) / samples);
+			t = clock();
+			for(i = 0; i < samples; i++) {
+				struct word_tree_cursor cur;
+				for(cur = word_tree_more(&tree, bound[i][0]);
+					word_tree_exists(&cur)
+					&& strcmp(word_tree_key(&cur), bound[i][1]) < 0;
+					word_tree_next(&cur)) check--;
+			}
+			m_add(&tree_m, 1000.0 * diff_us(t) / samples);
+		}
+		free(bound);
+		printf("Range of %lu words: trie %.1f ns, tree %.1f ns.\n",
+			(unsigned long)width, m_mean(&trie_m), m_mean(&tree_m));
+		fprintf(fp, "%lu\t%f\t%f\t%f\t%f\n", (unsigned long)width,
+			m_mean(&trie_m), m_stddev(&trie_m),
+			m_mean(&tree_m), m_stddev(&tree_m));
+	}
+	if(check) { errno = EDOM; goto catch; } /* They must be the same. */
+	if(!(gnu = fopen("graph/range.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale xy\n"
+		"set xlabel \"words in the range\"\n"
+		"set ylabel \"time per range (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"trie\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"tree\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	word_trie_(&trie);
+	word_tree_(&tree);
+	free(sorted);
+	dict_();
+	return ret;
+}
@@ -0,0 +1,151 @@
+/* Scanning a log for many literal patterns at once with an Aho-Corasick
+ automaton compiled from the keys of a trie. The patterns are random words of
+ the dictionary; the log is lines of words and numbers, supplied in pieces.
+ Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#define TRIE_AUTOMATON
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+static const char *const dict_fn = "../../../test/Tutte_le_parole_inglesi.txt";
+/** The size of the log and of the pieces that it is scanned in. */
+static const size_t log_size = 32 << 20, piece_size = 64 << 10;
+
+/** Reads the whole file `fn` into `*buffer`. @return The size or zero. */
+static size_t slurp(const char *const fn, char **const buffer) {
+	FILE *fp;
+	long length;
+	size_t size = 0;
+	*buffer = 0;
+	if(!(fp = fopen(fn, "rb"))) return 0;
+	if(!fseek(fp, 0, SEEK_END) && (length = ftell(fp)) >= 0
+		&& !fseek(fp, 0, SEEK_SET) && (*buffer = malloc((size_t)length + 1))
+		&& fread(*buffer, 1, (size_t)length, fp) == (size_t)length)
+		(*buffer)[size = (size_t)length] = '\0';
+	fclose(fp);
+	return size;
+}
+
+/** @return The MB/s scanning `log` with `a`; `matches` is set. */
+static double scan(const struct word_trie_automaton *const a,
+	const char *const log, size_t *const matches) {
+	struct word_trie_scan s = word_trie_scan(a);
+	size_t i;
+	clock_t t = clock();
+	double sec;
+	*matches = 0;
+	for(i = 0; i < log_size; i += piece_size) *matches += word_trie_scan_next(&s,
+		log + i, log_size - i < piece_size ? log_size - i : piece_size, 0, 0);
+	sec = (double)(clock() - t) / CLOCKS_PER_SEC;
+	return sec > 0 ? log_size / 1e6 / sec : (double)NAN;
+}
+
+int main(void) {
+	const char *const name = "scan";
+	const size_t replicas = 5, pattern_sizes[] = { 1000, 10000, 100000 };
+	const unsigned experiments = sizeof pattern_sizes / sizeof *pattern_sizes;
+	struct word_trie trie = word_trie();
+	struct word_trie_automaton a = { 0 };
+	struct measure m;
+	char *buffer = 0, *log = 0, *a0, *b0;
+	const char **words = 0;
+	size_t i, n = 0, matches = 0, l, size;
+	unsigned e;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!slurp(dict_fn, &buffer)) goto catch;
+	for(a0 = buffer; (a0 = strchr(a0, '\n')); a0++) n++;
+	if(!n || !(words = malloc(sizeof *words * n))
+		|| !(log = malloc(log_size))) goto catch;
+	for(i = 0, a0 = buffer; (b0 = strchr(a0, '\n')); a0 = b0 + 1)
+		*b0 = '\0', words[i++] = a0;
+	/* Lines of a timestamp, a level, and some words. */
+	for(l = 0; l < log_size; ) {
+		char line[256];
+		unsigned w, words_on_line = 3 + (unsigned)rand() % 8;
+		size_t length = (size_t)sprintf(line, "%08lu %s",
+			(unsigned long)rand(), rand() % 10 ? "info" : "warn");
+		for(w = 0; w < words_on_line; w++) {
+			const char *const word = words[(size_t)rand() % n];
+			if(length + strlen(word) + 2 > sizeof line) break;
+			line[length++] = ' ';
+			strcpy(line + length, word), length += strlen(word);
+		}
+		line[length++] = '\n';
+		if(length > log_size - l) length = log_size - l;
+		memcpy(log + l, line, length), l += length;
+	}
+	if(!(fp = fopen("graph/scan.tsv", "w"))) goto catch;
+	fprintf(fp, "# %lu MB log in %lu KB pieces\n# <patterns>\t<MB/s>\t<sd>"
+		"\t<states>\t<matches>\n", (unsigned long)(log_size >> 20),
+		(unsigned long)(piece_size >> 10));
+	printf("%lu MB log:\n", (unsigned long)(log_size >> 20));
+	for(e = 0; e < experiments; e++) {
+		word_trie_clear(&trie);
+		for(size = 0; size < pattern_sizes[e]; ) {
+			const enum trie_result r = word_trie_add(&trie,
+				words[(size_t)rand() % n]);
+			if(r == TRIE_ERROR) goto catch;
+			if(r == TRIE_ABSENT) size++;
+		}
+		if(!word_trie_automaton(&a, &trie)) goto catch;
+		m_reset(&m);
+		for(i = 0; i < replicas; i++) m_add(&m, scan(&a, log, &matches));
+		printf("%lu patterns, %u states: %.1f MB/s, %lu matches.\n",
+			(unsigned long)pattern_sizes[e], a.states, m_mean(&m),
+			(unsigned long)matches);
+		fprintf(fp, "%lu\t%f\t%f\t%u\t%lu\n", (unsigned long)pattern_sizes[e],
+			m_mean(&m), m_stddev(&m), a.states, (unsigned long)matches);
+		word_trie_automaton_(&a);
+	}
+	if(!(gnu = fopen("graph/scan.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale x\n"
+		"set xlabel \"patterns\"\n"
+		"set ylabel \"throughput (MB/s)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"scan\"\n",
+		name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	word_trie_automaton_(&a);
+	word_trie_(&trie);
+	free(log);
+	free(words);
+	free(buffer);
+	return ret;
+}
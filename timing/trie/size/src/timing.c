@@ -0,0 +1,135 @@
+/* Memory of tries of English words at different sizes, with boughs in size
+ classes against every bough having `TRIE_ORDER` leaves, and the time it takes
+ to add. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+#define TRIE_NAME word
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The dictionary, one word per line. */
+static struct { char *buffer; const char **words; size_t size; } dict;
+
+static void dict_(void) { free(dict.buffer), free(dict.words); }
+/** Loads and shuffles the dictionary. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+/** Adds up the bytes under `bough` in `classes`, and as if they were all full
+ in `full`. This is peeking at the implementation, so the bough is whatever
+ <../../../../src/trie.h> says. */
+static void boughs(const struct private_word_trie_bough *const bough,
+	size_t *const classes, size_t *const full) {
+	unsigned i;
+	*classes += private_word_trie_bough_size(bough->capacity);
+	*full += private_word_trie_bough_size(TRIE_ORDER);
+	for(i = 0; i < bough->leaves; i++) if(trie_bmp_test(&bough->bmp, i))
+		boughs(private_word_trie_leaf(bough)[i].as_link, classes, full);
+}
+
+int main(void) {
+	const char *const name = "size";
+	const size_t replicas = 5;
+	size_t sizes[] = { 1, 10, 100, 1000, 10000, 100000 }, s, r, i;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	if(!(fp = fopen("graph/size.tsv", "w"))) goto catch;
+	fprintf(fp, "# <words>\t<classes (B/word)>\t<full (B/word)>"
+		"\t<add (ns/word)>\t<sd>\n");
+	for(s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+		const size_t n = sizes[s];
+		size_t classes = 0, full = 0;
+		struct measure add;
+		m_reset(&add);
+		for(r = 0; r < replicas; r++) {
+			struct word_trie trie = word_trie();
+			clock_t t = clock();
+			for(i = 0; i < n; i++) if(!word_trie_add(&trie, dict.words[i]))
+				goto catch;
+			m_add(&add, 1000.0 * diff_us(t) / n);
+			if(!r) boughs(trie.trunk, &classes, &full);
+			word_trie_(&trie);
+		}
+		printf("%lu words: size classes %.1f B/word, full %.1f B/word,"
+			" add %.1f ns/word.\n", (unsigned long)n,
+			(double)classes / n, (double)full / n, m_mean(&add));
+		fprintf(fp, "%lu\t%f\t%f\t%f\t%f\n", (unsigned long)n,
+			(double)classes / n, (double)full / n,
+			m_mean(&add), m_stddev(&add));
+	}
+	if(!(gnu = fopen("graph/size.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale xy\n"
+		"set xlabel \"words\"\n"
+		"set ylabel \"memory (B/word)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2 with linespoints title \"classes\", \\\n"
+		"\"graph/%s.tsv\" using 1:3 with linespoints title \"full\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	dict_();
+	return ret;
+}
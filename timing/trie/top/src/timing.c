@@ -0,0 +1,174 @@
+/* Autocomplete: the ten most popular words that start with a short prefix.
+ <fn:<T>top> goes best-first on the scores cached in the boughs; the
+ alternative is going through every word with the prefix and keeping the ten
+ best. Run from this directory. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#ifndef NAN /* <https://stackoverflow.com/questions/5714131/nan-literal-in-c> */
+#define NAN (0. / 0.)
+#endif
+
+/* Word frequencies are roughly <Zipf, 1949>; the shuffled index is the rank. */
+struct word { const char *word; unsigned popularity; };
+static const char *word_key(const struct word *const w) { return w->word; }
+static unsigned word_score(const struct word *const w)
+	{ return w->popularity; }
+#define TRIE_NAME word
+#define TRIE_ENTRY struct word
+#define TRIE_SCORE unsigned
+#include "../../../../src/trie.h"
+
+#include <time.h>
+/** Returns a time difference in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+/** On-line numerically stable first-order statistics, <Welford, 1962, Note>. */
+struct measure { size_t count; double mean, ssdm; };
+static void m_reset(struct measure *const m)
+	{ m->count = 0, m->mean = m->ssdm = 0; }
+static void m_add(struct measure *const m, const double replica) {
+	const size_t n = ++m->count;
+	const double delta = replica - m->mean;
+	m->mean += delta / n;
+	m->ssdm += delta * (replica - m->mean);
+}
+static double m_mean(const struct measure *const m)
+	{ return m->count ? m->mean : (double)NAN; }
+static double m_sample_variance(const struct measure *const m)
+	{ return m->count > 1 ? m->ssdm / (m->count - 1) : (double)NAN; }
+static double m_stddev(const struct measure *const m)
+	{ return sqrt(m_sample_variance(m)); }
+
+/** The dictionary, one word per line. */
+static struct { char *buffer; const char **words; size_t size; } dict;
+
+static void dict_(void) { free(dict.buffer), free(dict.words); }
+/** Loads and shuffles the dictionary. */
+static int dict_load(const char *const fn) {
+	FILE *fp = 0;
+	long length;
+	size_t i, w;
+	char *a;
+	if(!(fp = fopen(fn, "rb")) || fseek(fp, 0, SEEK_END)
+		|| (length = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)
+		|| !(dict.buffer = malloc((size_t)length + 1))
+		|| fread(dict.buffer, 1, (size_t)length, fp) != (size_t)length)
+		goto catch;
+	dict.buffer[length] = '\0';
+	for(dict.size = 0, a = dict.buffer; *a; a++) if(*a == '\n') dict.size++;
+	if(!(dict.words = malloc(sizeof *dict.words * dict.size))) goto catch;
+	for(w = 0, a = dict.buffer; w < dict.size; a++) {
+		dict.words[w++] = a;
+		a = strchr(a, '\n'), *a = '\0';
+	}
+	for(i = dict.size; i > 1; i--) { /* Fisher-Yates. */
+		const size_t j = (size_t)rand() % i;
+		const char *const temp = dict.words[i - 1];
+		dict.words[i - 1] = dict.words[j], dict.words[j] = temp;
+	}
+	fclose(fp);
+	return 1;
+catch:
+	if(fp) fclose(fp);
+	dict_();
+	return 0;
+}
+
+#define K 10
+
+/** Keeps the best `K` in `best`, sorted descending, of `size`. */
+static size_t scan_top(struct word_trie *const trie, const char *const prefix,
+	struct word **const best) {
+	struct word_trie_cursor cur;
+	size_t size = 0, j;
+	for(cur = word_trie_prefix(trie, prefix);
+		word_trie_exists(&cur); word_trie_next(&cur)) {
+		struct word *const w = word_trie_entry(&cur);
+		if(size == K && best[K - 1]->popularity >= w->popularity) continue;
+		if(size < K) size++;
+		for(j = size - 1; j && best[j - 1]->popularity < w->popularity; j--)
+			best[j] = best[j - 1];
+		best[j] = w;
+	}
+	return size;
+}
+
+int main(void) {
+	const char *const name = "top";
+	const size_t replicas = 5, samples = 10000;
+	struct word_trie trie = word_trie();
+	struct word *best[K], *e;
+	size_t len, r, i;
+	unsigned long check = 0;
+	FILE *fp = 0, *gnu = 0;
+	int ret = EXIT_FAILURE;
+	errno = 0;
+	if(!dict_load("../../../test/Tutte_le_parole_inglesi.txt")) goto catch;
+	for(i = 0; i < dict.size; i++) {
+		switch(word_trie_add(&trie, dict.words[i], &e)) {
+		case TRIE_ERROR: goto catch;
+		case TRIE_PRESENT: continue;
+		case TRIE_ABSENT: break;
+		}
+		e->word = dict.words[i];
+		e->popularity = (unsigned)(dict.size / (i + 1));
+	}
+	if(!(fp = fopen("graph/top.tsv", "w"))) goto catch;
+	fprintf(fp, "# <prefix length>\t<top (ns)>\t<sd>\t<scan (ns)>\t<sd>\n");
+	for(len = 1; len <= 3; len++) {
+		struct measure top, scan;
+		char (*prefix)[4] = 0;
+		if(!(prefix = malloc(sizeof *prefix * samples))) goto catch;
+		/* Prefixes of random words, so they are weighted by popularity. */
+		for(i = 0; i < samples; i++) {
+			strncpy(prefix[i], dict.words[(size_t)rand() % dict.size], len);
+			prefix[i][len] = '\0';
+		}
+		m_reset(&top), m_reset(&scan);
+		for(r = 0; r < replicas; r++) {
+			clock_t t = clock();
+			for(i = 0; i < samples; i++) {
+				size_t n = word_trie_top(&trie, prefix[i], best, K);
+				while(n) check += best[--n]->popularity;
+			}
+			m_add(&top, 1000.0 * diff_us(t) / samples);
+			t = clock();
+			for(i = 0; i < samples; i++) {
+				size_t n = scan_top(&trie, prefix[i], best);
+				while(n) check -= best[--n]->popularity;
+			}
+			m_add(&scan, 1000.0 * diff_us(t) / samples);
+		}
+		free(prefix);
+		printf("Prefix length %lu: top %.1f ns, scan %.1f ns.\n",
+			(unsigned long)len, m_mean(&top), m_mean(&scan));
+		fprintf(fp, "%lu\t%f\t%f\t%f\t%f\n", (unsigned long)len,
+			m_mean(&top), m_stddev(&top), m_mean(&scan), m_stddev(&scan));
+	}
+	if(check) { errno = EDOM; goto catch; } /* They must be the same. */
+	if(!(gnu = fopen("graph/top.gnu", "w"))) goto catch;
+	fprintf(gnu, "set term postscript eps enhanced color\n"
+		"set output \"graph/%s.eps\"\n"
+		"set grid\n"
+		"set logscale y\n"
+		"set xtics 1\n"
+		"set xlabel \"prefix length\"\n"
+		"set ylabel \"time per prefix (ns)\"\n"
+		"plot \"graph/%s.tsv\" using 1:2:3 with errorlines title \"top\", \\\n"
+		"\"graph/%s.tsv\" using 1:4:5 with errorlines title \"scan\"\n",
+		name, name, name);
+	ret = EXIT_SUCCESS;
+	goto finally;
+catch:
+	perror(name);
+finally:
+	if(fp) fclose(fp);
+	if(gnu) fclose(gnu);
+	word_trie_(&trie);
+	dict_();
+	return ret;
+}